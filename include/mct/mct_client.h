@@ -34,6 +34,9 @@ typedef struct
     MctClientMode mode;    /**< mode MctClientMode */
     int send_serial_header;    /**< (Boolean) Send MCT messages with serial header */
     int resync_serial_header;  /**< (Boolean) Resync to serial header on all connection */
+    uint32_t multicast_seq;    /**< expected sequence number of the next multicast datagram */
+    int multicast_seq_valid;   /**< (Boolean) multicast_seq is known */
+    uint32_t multicast_lost;   /**< number of lost multicast datagrams */
 } MctClient;
 
 #   ifdef __cplusplus
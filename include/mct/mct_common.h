@@ -20,6 +20,7 @@
 #   if !defined(_MSC_VER)
 #      include <unistd.h>
 #      include <time.h>
+#      include <sys/uio.h>
 #   endif
 
 #   if defined(__GNUC__)
@@ -349,6 +350,11 @@ extern const char mctSerialHeader[MCT_ID_SIZE];
  */
 extern char mctSerialHeaderChar[MCT_ID_SIZE];
 
+/**
+ * The definition of the multicast header pattern containing the characters "DLM" + 0x01.
+ */
+extern const char mctMulticastHeader[MCT_ID_SIZE];
+
 #if defined MCT_DAEMON_USE_FIFO_IPC || defined MCT_LIB_USE_FIFO_IPC
 /**
  * The common base-path of the mct-daemon-fifo and application-generated fifos
@@ -372,6 +378,16 @@ typedef struct
     char ecu[MCT_ID_SIZE];     /**< The ECU id is added, if it is not already in the MCT message itself */
 } MCT_PACKED MctStorageHeader;
 
+/**
+ * The header of each UDP multicast datagram sent by the daemon.
+ * It is followed by one or more complete MCT messages without storage header.
+ */
+typedef struct
+{
+    char pattern[MCT_ID_SIZE];  /**< This pattern should be DLM0x01 */
+    uint32_t seq;               /**< sequence number of the datagram, big endian */
+} MCT_PACKED MctMulticastHeader;
+
 /**
  * The structure of the MCT standard header. This header is used in each MCT message.
  */
@@ -411,6 +427,7 @@ typedef struct sMctMessage
 {
     /* flags */
     int8_t found_serialheader;
+    int8_t is_view;        /**< standard/extended header and payload point into the parsed buffer */
 
     /* offsets */
     int32_t resync_offset;
@@ -695,6 +712,75 @@ typedef struct
     char node_id[MCT_ENTRY_MAX];               /**< list of passive node IDs */
 } MCT_PACKED MctServicePassiveNodeConnectionInfo;
 
+/**
+ * Kinds of connections reported by MCT Service Get Metrics
+ */
+#define MCT_SERVICE_METRICS_APPLICATION 1 /**< connection of an application, counters of received messages */
+#define MCT_SERVICE_METRICS_TCP         2 /**< TCP client, counters of sent messages */
+#define MCT_SERVICE_METRICS_SERIAL      3 /**< serial client, counters of sent messages */
+#define MCT_SERVICE_METRICS_UDP         4 /**< UDP multicast, counters of sent datagrams */
+#define MCT_SERVICE_METRICS_LOGSTORAGE  5 /**< offline logstorage device, counters of stored messages */
+
+#define MCT_SERVICE_METRICS_CONNECTIONS_MAX 64  /**< connections reported in one response */
+#define MCT_SERVICE_METRICS_CONTEXTS_MAX    256 /**< contexts reported in one response */
+
+/**
+ * The structure of MCT Service Get Metrics request
+ */
+typedef struct
+{
+    uint32_t service_id;            /**< service ID */
+    uint32_t context_offset;        /**< index of the first context to be reported */
+} MCT_PACKED MctServiceGetMetrics;
+
+/**
+ * Counters of one connection of MCT Service Get Metrics
+ */
+typedef struct
+{
+    uint8_t kind;                   /**< MCT_SERVICE_METRICS_* */
+    int32_t handle;                 /**< file descriptor of the connection, index of a logstorage device */
+    char apid[MCT_ID_SIZE];         /**< application id, only for applications */
+    uint64_t messages;              /**< received or sent messages */
+    uint64_t bytes;                 /**< received or sent bytes */
+    uint64_t errors;                /**< parse errors of received data */
+    uint64_t dropped;               /**< messages which could not be sent */
+    uint32_t queue_depth;           /**< bytes not yet sent by the kernel or written by a logstorage writer thread */
+} MCT_PACKED MctServiceMetricsConnection;
+
+/**
+ * Counters of one context of MCT Service Get Metrics
+ */
+typedef struct
+{
+    char apid[MCT_ID_SIZE];         /**< application id */
+    char ctid[MCT_ID_SIZE];         /**< context id */
+    uint64_t messages;              /**< received log messages */
+    uint64_t bytes;                 /**< received bytes */
+} MCT_PACKED MctServiceMetricsContext;
+
+/**
+ * The structure of MCT Service Get Metrics response.
+ * It is followed by num_connections MctServiceMetricsConnection and
+ * num_contexts MctServiceMetricsContext entries.
+ */
+typedef struct
+{
+    uint32_t service_id;            /**< service ID */
+    uint8_t status;                 /**< response status */
+    uint32_t buffer_used;           /**< used bytes of the client ringbuffer */
+    uint32_t buffer_size;           /**< allocated bytes of the client ringbuffer */
+    uint32_t buffer_max_size;       /**< maximum bytes of the client ringbuffer */
+    uint32_t buffer_messages;       /**< messages in the client ringbuffer */
+    uint64_t overflow_counter;      /**< messages discarded because the client ringbuffer was full */
+    uint64_t evicted_counter[8];    /**< messages evicted from the client ringbuffer per log level */
+    uint64_t spool_size;            /**< bytes in the disk spool */
+    uint16_t num_connections;       /**< number of connection entries */
+    uint32_t total_contexts;        /**< number of registered contexts */
+    uint32_t context_offset;        /**< index of the first reported context */
+    uint16_t num_contexts;          /**< number of context entries */
+} MCT_PACKED MctServiceGetMetricsResponse;
+
 /**
  * Structure to store filter parameters.
  * ID are maximal four characters. Unused values are filled with zeros.
@@ -751,13 +837,29 @@ typedef struct
     int32_t totalBytesRcvd;   /**< total number of received bytes */
     char *buffer;         /**< pointer to receiver buffer */
     char *buf;            /**< pointer to position within receiver buffer */
-    char *backup_buf;     /** pointer to the buffer with partial messages if any **/
+    int ring;             /**< buffer is mapped twice, data wrapping at its end stays contiguous */
     int fd;               /**< connection handle */
     MctReceiverType type;     /**< type of connection handle */
     int32_t buffersize;       /**< size of receiver buffer */
     struct sockaddr_in addr;  /**< socket address information */
 } MctReceiver;
 
+/**
+ * One segment of a dynamic buffer. Entries never span two segments.
+ */
+#   define MCT_BUFFER_PRIORITY_MAX 8 /**< number of entry priorities, 0 is the most important one */
+
+typedef struct MctBufferSegment
+{
+    struct MctBufferSegment *next; /**< next newer segment */
+    unsigned char *mem;            /**< data area, allocated behind this structure */
+    uint32_t size;                 /**< size of data area */
+    uint32_t read;                 /**< offset of oldest entry */
+    uint32_t write;                /**< offset behind newest entry */
+    int count;                     /**< number of entries */
+    int priority_count[MCT_BUFFER_PRIORITY_MAX]; /**< number of entries per priority */
+} MctBufferSegment;
+
 typedef struct
 {
     unsigned char *shm; /* pointer to beginning of shared memory */
@@ -767,6 +869,11 @@ typedef struct
     uint32_t min_size;     /**< Minimum size of buffer */
     uint32_t max_size;     /**< Maximum size of buffer */
     uint32_t step_size;    /**< Step size of buffer */
+
+    MctBufferSegment *first; /**< oldest segment of dynamic buffer, NULL for static buffer */
+    MctBufferSegment *last;  /**< newest segment of dynamic buffer */
+    int count;               /**< number of entries of dynamic buffer */
+    int priority_count[MCT_BUFFER_PRIORITY_MAX]; /**< number of entries per priority of dynamic buffer */
 } MctBuffer;
 
 typedef struct
@@ -782,6 +889,7 @@ typedef struct
 {
     char head[4];
     unsigned char status;
+    unsigned char priority;
     int size;
 } MctBufferBlockHead;
 
@@ -1010,6 +1118,21 @@ MctReturnValue mct_message_filter_check(MctMessage *msg, MctFilter *filter, int
  */
 int mct_message_read(MctMessage *msg, uint8_t *buffer, unsigned int length, int resync, int verbose);
 
+/**
+ * Parse message from memory buffer without copying it.
+ * Only the storage header is held by the message structure, the standard
+ * header, the extended header and the payload pointers refer to the buffer,
+ * which must stay valid as long as the message is used.
+ * Message in buffer has no storage header.
+ * @param msg pointer to structure of organising access to MCT messages
+ * @param buffer pointer to memory buffer
+ * @param length length of message in buffer
+ * @param resync if set to true resync to serial header is enforced
+ * @param verbose if set to true verbose information is printed out.
+ * @return negative value if there was an error
+ */
+int mct_message_read_view(MctMessage *msg, uint8_t *buffer, unsigned int length, int resync, int verbose);
+
 /**
  * Get standard header extra parameters
  * @param msg pointer to structure of organising access to MCT messages
@@ -1206,7 +1329,8 @@ void mct_log_free(void);
  * @param receiver pointer to mct receiver structure
  * @param _fd handle to file/socket/fifo, fram which the data should be received
  * @param type specify whether received data is from socket or file/fifo
- * @param _buffersize size of data buffer for storing the received data
+ * @param _buffersize size of data buffer for storing the received data,
+ *                    may be rounded up to a multiple of the page size
  * @return negative value if there was an error
  */
 MctReturnValue mct_receiver_init(MctReceiver *receiver, int _fd, MctReceiverType type, int _buffersize);
@@ -1216,21 +1340,6 @@ MctReturnValue mct_receiver_init(MctReceiver *receiver, int _fd, MctReceiverType
  * @return negative value if there was an error
  */
 MctReturnValue mct_receiver_free(MctReceiver *receiver);
-/**
- * Initialising a mct receiver structure
- * @param receiver pointer to mct receiver structure
- * @param fd handle to file/socket/fifo, fram which the data should be received
- * @param type specify whether received data is from socket or file/fifo
- * @param buffer data buffer for storing the received data
- * @return negative value if there was an error and zero if success
- */
-MctReturnValue mct_receiver_init_global_buffer(MctReceiver *receiver, int fd, MctReceiverType type, char **buffer);
-/**
- * De-Initialize a mct receiver structure
- * @param receiver pointer to mct receiver structure
- * @return negative value if there was an error and zero if success
- */
-MctReturnValue mct_receiver_free_global_buffer(MctReceiver *receiver);
 /**
  * Receive data from socket or file/fifo using the mct receiver structure
  * @param receiver pointer to mct receiver structure
@@ -1245,7 +1354,8 @@ int mct_receiver_receive(MctReceiver *receiver);
  */
 MctReturnValue mct_receiver_remove(MctReceiver *receiver, int size);
 /**
- * Move data from last receive call to front of receive buffer
+ * Keep data from last receive call for the next receive call.
+ * Data is not moved if the receiver buffer is a ring buffer.
  * @param receiver pointer to mct receiver structure
  * @return negative value if there was an error
  */
@@ -1312,7 +1422,9 @@ MctReturnValue mct_buffer_init_static_client(MctBuffer *buf, const unsigned char
  * Initialize dynamic ringbuffer with a size of size.
  * Initialise as a client. Do not change counters.
  * Memory will be allocated starting with min_size.
- * If more memory is needed size is increased wit step_size.
+ * If more memory is needed a segment of step_size is appended, segments
+ * are released again as soon as they are read completely. Stored data is
+ * never moved.
  * The maximum size is max_size.
  * @param buf Pointer to ringbuffer structure
  * @param min_size Minimum size of buffer in bytes
@@ -1373,6 +1485,45 @@ MctReturnValue mct_buffer_push3(MctBuffer *buf,
                                 const unsigned char *data3,
                                 unsigned int size3);
 
+/**
+ * Write up to three entries to ringbuffer as one block with a priority.
+ * The priority is only used by mct_buffer_evict() of dynamic ringbuffers,
+ * mct_buffer_push3() stores entries with priority 0.
+ * @param buf Pointer to ringbuffer structure
+ * @param priority Priority of the block, 0 is the most important one
+ * @param data1 Pointer to data to be written to ringbuffer
+ * @param size1 Size of data in bytes to be written to ringbuffer
+ * @param data2 Pointer to data to be written to ringbuffer
+ * @param size2 Size of data in bytes to be written to ringbuffer
+ * @param data3 Pointer to data to be written to ringbuffer
+ * @param size3 Size of data in bytes to be written to ringbuffer
+ * @return negative value if there was an error
+ */
+MctReturnValue mct_buffer_push3_priority(MctBuffer *buf,
+                                         unsigned char priority,
+                                         const unsigned char *data1,
+                                         unsigned int size1,
+                                         const unsigned char *data2,
+                                         unsigned int size2,
+                                         const unsigned char *data3,
+                                         unsigned int size3);
+
+/**
+ * Remove entries less important than priority from a dynamic ringbuffer
+ * until an entry of size needed fits in.
+ * The least important entries are removed first, oldest first within the
+ * same priority. Entries of the given priority or more important ones are
+ * never removed.
+ * @param buf Pointer to ringbuffer structure
+ * @param priority Priority of the entry to be written
+ * @param needed Size of the entry to be written
+ * @param evicted Array of MCT_BUFFER_PRIORITY_MAX counters, the number of
+ *        removed entries is added per priority
+ * @return MCT_RETURN_OK if the entry fits now, MCT_RETURN_ERROR otherwise
+ */
+MctReturnValue mct_buffer_evict(MctBuffer *buf, unsigned char priority, int needed,
+                                unsigned int *evicted);
+
 /**
  * Read one entry from ringbuffer.
  * Remove it from ringbuffer.
@@ -1400,6 +1551,20 @@ int mct_buffer_copy(MctBuffer *buf, unsigned char *data, int max_size);
  */
 int mct_buffer_remove(MctBuffer *buf);
 
+/**
+ * Get the location of the oldest entries in the ringbuffer without copying them.
+ * Entry i is described by iov[2 * i] and iov[2 * i + 1], the second part is
+ * only non-empty if the entry wraps around the end of the ringbuffer.
+ * The entries are not removed, the iovecs stay valid until the ringbuffer is
+ * modified.
+ * @param buf Pointer to ringbuffer structure
+ * @param iov Array of at least 2 * max_count iovecs
+ * @param max_count Max number of entries
+ * @param max_size Max size of all entries in bytes, the first entry is always included
+ * @return number of entries, zero if no data available, negative value if there was an error
+ */
+int mct_buffer_get_vector(MctBuffer *buf, struct iovec *iov, int max_count, int max_size);
+
 /**
  * Print information about buffer and log to internal MCT log.
  * @param buf Pointer to ringbuffer structure
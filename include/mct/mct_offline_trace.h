@@ -2,6 +2,7 @@
 #define MCT_OFFLINE_TRACE_H
 
 #include <limits.h>
+#include <sys/uio.h>
 
 #include "mct_types.h"
 
@@ -18,6 +19,9 @@ typedef struct
     int maxSize;                 /**< (int) Maximum size of all trace files (Default: 4000000) */
     int filenameTimestampBased;  /**< (int) timestamp based or index based (Default: 1 Timestamp based) */
     int ohandle;
+    int compression;             /**< (int) write compressed blocks of messages, set before init (Default: 0) */
+    unsigned char *block;        /**< messages collected for the next compressed block */
+    int blockSize;               /**< size of messages collected for the next compressed block */
 } MctOfflineTrace;
 
 /**
@@ -70,6 +74,20 @@ extern MctReturnValue mct_offline_trace_write(MctOfflineTrace *trace,
                                               unsigned char *data3,
                                               int size3);
 
+/**
+ * Write a batch of messages into offline trace
+ * Same as mct_offline_trace_write for each message, but the messages going
+ * to the same log file are written with one call.
+ * @param trace pointer to offline trace structure
+ * @param iov three data blocks per message, as data1 to data3 of
+ *            mct_offline_trace_write, a block not used has size 0
+ * @param count number of messages, iov holds 3 * count entries
+ * @return negative value if there was an error
+ */
+extern MctReturnValue mct_offline_trace_write_vector(MctOfflineTrace *trace,
+                                                     const struct iovec *iov,
+                                                     int count);
+
 /**
  * Get size of currently used offline trace buffer
  * @return size in bytes
@@ -149,6 +149,7 @@ enum mct_user_services {
     MCT_SERVICE_ID_GET_BLOCK_MODE = 0xF0C,
     MCT_SERVICE_ID_SET_FILTER_LEVEL = 0xF0D,
     MCT_SERVICE_ID_GET_FILTER_STATUS = 0xF0E,
+    MCT_SERVICE_ID_GET_METRICS = 0xF0F,
     MCT_USER_SERVICE_ID_LAST_ENTRY
 };
 
@@ -12,6 +12,7 @@
 #include <sys/uio.h> /* writev() */
 
 #include "mct_common.h"
+#include "mct_index.h"
 
 #define COMMAND_SIZE        1024    /* Size of command */
 #define FILENAME_SIZE       1024    /* Size of filename */
@@ -46,6 +47,8 @@ void usage()
     printf("  -f filename   Enable filtering of messages\n");
     printf("  -b number     First messages to be handled\n");
     printf("  -e number     Last message to be handled\n");
+    printf("  -S time       Handle messages stored at or after time (seconds since 1970)\n");
+    printf("  -E time       Handle messages stored at or before time (seconds since 1970)\n");
     printf("  -w            Follow mct file while file is increasing\n");
     printf("  -t            Handling input compressed files (tar.gz)\n");
 }
@@ -109,6 +112,52 @@ void empty_dir(const char *dir)
         fprintf(stderr, "ERROR: Failed to stat %s with error %s\n", dir, strerror(errno));
 }
 
+/**
+ * Read all messages of a file which pass the filter and time range into the
+ * index of the file. Blocks of the file which cannot contain such messages
+ * according to the index file of the file are skipped.
+ */
+void read_messages(MctFile *file, MctIndex *mctindex, uint32_t start, uint32_t end, int vflag)
+{
+    MctIndexEntry *block = NULL;
+    uint64_t position = 0; /* start of current block */
+    int num = 0;
+    MctReturnValue ret;
+
+    while (1) {
+        if (mctindex != NULL) {
+            /* blocks follow each other from the start of the file */
+            while ((num < mctindex->num_blocks) &&
+                   (file->file_position >= position + mctindex->blocks[num].raw_size)) {
+                position += mctindex->blocks[num].raw_size;
+                num++;
+            }
+
+            block = (num < mctindex->num_blocks) ? &mctindex->blocks[num] : NULL;
+
+            if ((block != NULL) && (file->file_position == position) &&
+                !mct_index_entry_match(block, start, end, file->filter)) {
+                file->file_position += block->raw_size;
+                file->counter_total += (int)block->count;
+                continue;
+            }
+        }
+
+        ret = mct_file_read(file, vflag);
+
+        if (ret < MCT_RETURN_OK)
+            break;
+
+        /* drop message again if stored outside of time range */
+        if ((ret == MCT_RETURN_TRUE) &&
+            (((start != 0) && (file->msg.storageheader->seconds < start)) ||
+             ((end != 0) && (file->msg.storageheader->seconds > end)))) {
+            file->counter--;
+            file->position = file->counter - 1;
+        }
+    }
+}
+
 /**
  * Main function of tool.
  */
@@ -126,12 +175,16 @@ int main(int argc, char *argv[])
     char *bvalue = 0;
     char *evalue = 0;
     char *ovalue = 0;
+    uint32_t start_time = 0;
+    uint32_t end_time = 0;
 
     int index;
     int c;
 
     MctFile file;
     MctFilter filter;
+    MctIndex mctindex;
+    int use_index = 0;
 
     int ohandle = -1;
 
@@ -153,7 +206,7 @@ int main(int argc, char *argv[])
 
     opterr = 0;
 
-    while ((c = getopt (argc, argv, "vcashxmwtf:b:e:o:")) != -1) {
+    while ((c = getopt (argc, argv, "vcashxmwtf:b:e:o:S:E:")) != -1) {
         switch (c)
         {
         case 'v':
@@ -221,9 +274,20 @@ int main(int argc, char *argv[])
             ovalue = optarg;
             break;
         }
+        case 'S':
+        {
+            start_time = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        }
+        case 'E':
+        {
+            end_time = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        }
         case '?':
         {
-            if ((optopt == 'f') || (optopt == 'b') || (optopt == 'e') || (optopt == 'o'))
+            if ((optopt == 'f') || (optopt == 'b') || (optopt == 'e') || (optopt == 'o') ||
+                (optopt == 'S') || (optopt == 'E'))
                 fprintf (stderr, "Option -%c requires an argument.\n", optopt);
             else if (isprint (optopt))
                 fprintf (stderr, "Unknown option `-%c'.\n", optopt);
@@ -323,10 +387,39 @@ int main(int argc, char *argv[])
             argv[index] = tmp_filename;
         }
 
+        /* the index file of a log file tells which parts can be skipped */
+        use_index = (fvalue || start_time || end_time) &&
+            (mct_index_load(&mctindex, argv[index]) == MCT_RETURN_OK);
+
+        if (use_index && mctindex.has_summary &&
+            !mct_index_entry_match(&mctindex.summary, start_time, end_time, file.filter)) {
+            if (vflag)
+                printf("Skip %s, no message matches\n", argv[index]);
+
+            if (cflag) {
+                printf("Total number of messages: %u\n", mctindex.summary.count);
+                printf("Filtered number of messages: 0\n");
+            }
+
+            mct_index_free(&mctindex);
+            continue;
+        }
+
         /* load, analyze data file and create index list */
-        if (mct_file_open(&file, argv[index], vflag) >= MCT_RETURN_OK) {
-            while (mct_file_read(&file, vflag) >= MCT_RETURN_OK) {
+        if (mct_file_open(&file, argv[index], vflag) >= MCT_RETURN_OK)
+            read_messages(&file, use_index ? &mctindex : NULL, start_time, end_time, vflag);
+
+        if (use_index)
+            mct_index_free(&mctindex);
+
+        /* nothing to handle if no message passes filter and time range */
+        if ((file.counter == 0) && (fvalue || start_time || end_time)) {
+            if (cflag) {
+                printf("Total number of messages: %d\n", file.counter_total);
+                printf("Filtered number of messages: 0\n");
             }
+
+            continue;
         }
 
         if (aflag || sflag || xflag || mflag || ovalue) {
@@ -412,8 +505,7 @@ int main(int argc, char *argv[])
                 /* check for new messages if follow flag set */
                 if (wflag && (num == end)) {
                     while (1) {
-                        while (mct_file_read(&file, 0) >= 0){
-                        }
+                        read_messages(&file, NULL, start_time, end_time, 0);
 
                         if (end == (file.counter - 1)) {
                             /* Sleep if no new message was received */
@@ -435,7 +527,7 @@ int main(int argc, char *argv[])
         if (cflag) {
             printf("Total number of messages: %d\n", file.counter_total);
 
-            if (file.filter)
+            if (file.filter || start_time || end_time)
                 printf("Filtered number of messages: %d\n", file.counter);
         }
     }
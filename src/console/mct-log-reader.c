@@ -92,7 +92,7 @@ void usage()
     printf("  -S            Send message with serial header (Default: Without serial header)\n");
     printf("  -R            Enable resync serial header\n");
     printf("  -y            Serial device mode\n");
-    printf("  -u            UDP multicast mode\n");
+    printf("  -u            UDP multicast mode, hostname is the multicast group\n");
     printf("  -b baudrate   Serial device baudrate (Default: 115200)\n");
     printf("  -e ecuid      Set ECU ID (Default: RECV)\n");
     printf("  -o filename   Output messages in new MCT file\n");
@@ -519,6 +519,9 @@ int main(int argc, char *argv[])
         /* Mct Client Main Loop */
         mct_client_main_loop(&mctclient, &mctdata, mctdata.vflag);
 
+        if (mctdata.uflag && mctclient.multicast_lost)
+            fprintf(stderr, "WARNING: %u multicast datagrams lost\n", mctclient.multicast_lost);
+
         /* Mct Client Cleanup */
         mct_client_cleanup(&mctclient, mctdata.vflag);
     }
@@ -0,0 +1,431 @@
+#define pr_fmt(fmt) "Metrics: "fmt
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <getopt.h>
+#include <inttypes.h>
+
+#include "mct_common.h"
+#include "mct_protocol.h"
+#include "mct-control-common.h"
+
+#define MCT_METRICS_FORMAT_TABLE      0
+#define MCT_METRICS_FORMAT_PROMETHEUS 1
+
+static int output_format = MCT_METRICS_FORMAT_TABLE;
+
+/* copy of the last response, written by the listener thread */
+static uint8_t *response;
+
+/* counters collected from all responses */
+static MctServiceGetMetricsResponse totals;
+static MctServiceMetricsConnection *connections;
+static int num_connections;
+static MctServiceMetricsContext *contexts;
+static int num_contexts;
+
+static const char *const level_names[MCT_BUFFER_PRIORITY_MAX] = {
+    "default", "fatal", "error", "warn", "info", "debug", "verbose", "reserved"
+};
+
+/** @brief Keep the daemon answer to a get metrics request
+ *
+ * @param data    The textual answer
+ * @param payload The answer payload
+ * @param len     The answer payload length
+ * @return 0 on success, -1 otherwise.
+ */
+static int analyze_response(char *data, void *payload, int len)
+{
+    MctServiceGetMetricsResponse *resp = payload;
+
+    if ((data == NULL) || (payload == NULL))
+        return -1;
+
+    pr_verbose("Response received: '%.64s'\n", data);
+
+    if ((len < (int)sizeof(MctServiceGetMetricsResponse)) ||
+        (resp->service_id != MCT_SERVICE_ID_GET_METRICS)) {
+        pr_error("Unexpected response\n");
+        return -1;
+    }
+
+    if (resp->status != MCT_SERVICE_RESPONSE_OK) {
+        pr_error("Request failed with status %u\n", resp->status);
+        return -1;
+    }
+
+    if ((len < (int)(sizeof(MctServiceGetMetricsResponse) +
+                     sizeof(MctServiceMetricsConnection) * resp->num_connections +
+                     sizeof(MctServiceMetricsContext) * resp->num_contexts))) {
+        pr_error("Truncated response\n");
+        return -1;
+    }
+
+    free(response);
+    response = malloc((size_t)len);
+
+    if (response == NULL) {
+        pr_error("Cannot allocate memory for response\n");
+        return -1;
+    }
+
+    memcpy(response, payload, (size_t)len);
+
+    return 0;
+}
+
+/** @brief Request the counters of all contexts, page by page
+ *
+ * The counters of the daemon and its connections are taken from the first
+ * response, the contexts of all responses are appended.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int mct_metrics_collect(void)
+{
+    MctServiceGetMetrics req = { 0 };
+    MctControlMsgBody body = { 0 };
+    MctServiceGetMetricsResponse *resp = NULL;
+    MctServiceMetricsContext *tmp = NULL;
+    uint32_t offset = 0;
+
+    body.data = &req;
+    body.size = sizeof(req);
+
+    do {
+        req.service_id = MCT_SERVICE_ID_GET_METRICS;
+        req.context_offset = offset;
+
+        if (mct_control_send_message(&body, get_timeout()) != 0)
+            return -1;
+
+        resp = (MctServiceGetMetricsResponse *)response;
+
+        if (offset == 0) {
+            totals = *resp;
+            num_connections = resp->num_connections;
+            connections = calloc((size_t)num_connections + 1,
+                                 sizeof(MctServiceMetricsConnection));
+
+            if (connections == NULL)
+                return -1;
+
+            memcpy(connections, response + sizeof(MctServiceGetMetricsResponse),
+                   sizeof(MctServiceMetricsConnection) * (size_t)num_connections);
+        }
+
+        if (resp->num_contexts == 0)
+            break;
+
+        tmp = realloc(contexts, sizeof(MctServiceMetricsContext) *
+                      (size_t)(num_contexts + resp->num_contexts));
+
+        if (tmp == NULL)
+            return -1;
+
+        contexts = tmp;
+        memcpy(&contexts[num_contexts],
+               response + sizeof(MctServiceGetMetricsResponse) +
+               sizeof(MctServiceMetricsConnection) * resp->num_connections,
+               sizeof(MctServiceMetricsContext) * resp->num_contexts);
+        num_contexts += resp->num_contexts;
+        offset = resp->context_offset + resp->num_contexts;
+    } while (offset < resp->total_contexts);
+
+    return 0;
+}
+
+static const char *mct_metrics_kind_name(uint8_t kind)
+{
+    switch (kind) {
+    case MCT_SERVICE_METRICS_APPLICATION:
+        return "application";
+    case MCT_SERVICE_METRICS_TCP:
+        return "tcp";
+    case MCT_SERVICE_METRICS_SERIAL:
+        return "serial";
+    case MCT_SERVICE_METRICS_UDP:
+        return "udp";
+    case MCT_SERVICE_METRICS_LOGSTORAGE:
+        return "logstorage";
+    default:
+        return "unknown";
+    }
+}
+
+/** @brief Print the collected counters as table */
+static void mct_metrics_print_table(void)
+{
+    int i = 0;
+
+    printf("Ringbuffer: %u of %u bytes used (maximum %u), %u messages\n",
+           totals.buffer_used, totals.buffer_size, totals.buffer_max_size,
+           totals.buffer_messages);
+    printf("Spool: %" PRIu64 " bytes\n", totals.spool_size);
+    printf("Overflow: %" PRIu64 " messages discarded\n", totals.overflow_counter);
+    printf("Evicted:");
+
+    for (i = 1; i <= MCT_LOG_VERBOSE; i++)
+        printf(" %s %" PRIu64, level_names[i], totals.evicted_counter[i]);
+
+    printf("\n\n");
+
+    printf("%-12s %6s %-4s %12s %14s %8s %8s %8s\n",
+           "CONNECTION", "FD", "APID", "MESSAGES", "BYTES", "ERRORS", "DROPPED", "QUEUE");
+
+    for (i = 0; i < num_connections; i++)
+        printf("%-12s %6d %-4.4s %12" PRIu64 " %14" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8u\n",
+               mct_metrics_kind_name(connections[i].kind),
+               connections[i].handle,
+               connections[i].apid,
+               connections[i].messages,
+               connections[i].bytes,
+               connections[i].errors,
+               connections[i].dropped,
+               connections[i].queue_depth);
+
+    printf("\n%-4s %-4s %12s %14s\n", "APID", "CTID", "MESSAGES", "BYTES");
+
+    for (i = 0; i < num_contexts; i++)
+        printf("%-4.4s %-4.4s %12" PRIu64 " %14" PRIu64 "\n",
+               contexts[i].apid,
+               contexts[i].ctid,
+               contexts[i].messages,
+               contexts[i].bytes);
+}
+
+/** @brief Print a metric family header in Prometheus text format */
+static void mct_metrics_print_family(const char *name, const char *type, const char *help)
+{
+    printf("# HELP %s %s\n", name, help);
+    printf("# TYPE %s %s\n", name, type);
+}
+
+/** @brief Print the counter of all connections of one kind of metric */
+static void mct_metrics_print_connections(const char *name,
+                                          const char *help,
+                                          const char *type,
+                                          size_t field)
+{
+    int i = 0;
+    uint64_t value = 0;
+
+    mct_metrics_print_family(name, type, help);
+
+    for (i = 0; i < num_connections; i++) {
+        if (field == offsetof(MctServiceMetricsConnection, queue_depth))
+            value = connections[i].queue_depth;
+        else
+            memcpy(&value, (uint8_t *)&connections[i] + field, sizeof(value));
+
+        printf("%s{kind=\"%s\",fd=\"%d\",apid=\"%.4s\"} %" PRIu64 "\n",
+               name,
+               mct_metrics_kind_name(connections[i].kind),
+               connections[i].handle,
+               connections[i].apid,
+               value);
+    }
+}
+
+/** @brief Print the collected counters in Prometheus text format */
+static void mct_metrics_print_prometheus(void)
+{
+    int i = 0;
+
+    mct_metrics_print_family("mct_buffer_used_bytes", "gauge",
+                             "Used bytes of the client ringbuffer");
+    printf("mct_buffer_used_bytes %u\n", totals.buffer_used);
+    mct_metrics_print_family("mct_buffer_size_bytes", "gauge",
+                             "Allocated bytes of the client ringbuffer");
+    printf("mct_buffer_size_bytes %u\n", totals.buffer_size);
+    mct_metrics_print_family("mct_buffer_max_size_bytes", "gauge",
+                             "Maximum bytes of the client ringbuffer");
+    printf("mct_buffer_max_size_bytes %u\n", totals.buffer_max_size);
+    mct_metrics_print_family("mct_buffer_messages", "gauge",
+                             "Messages in the client ringbuffer");
+    printf("mct_buffer_messages %u\n", totals.buffer_messages);
+    mct_metrics_print_family("mct_spool_bytes", "gauge",
+                             "Bytes in the disk spool");
+    printf("mct_spool_bytes %" PRIu64 "\n", totals.spool_size);
+    mct_metrics_print_family("mct_buffer_overflow_messages_total", "counter",
+                             "Messages discarded because the client ringbuffer was full");
+    printf("mct_buffer_overflow_messages_total %" PRIu64 "\n", totals.overflow_counter);
+    mct_metrics_print_family("mct_buffer_evicted_messages_total", "counter",
+                             "Messages evicted from the client ringbuffer");
+
+    for (i = 0; i < MCT_BUFFER_PRIORITY_MAX; i++)
+        printf("mct_buffer_evicted_messages_total{level=\"%s\"} %" PRIu64 "\n",
+               level_names[i], totals.evicted_counter[i]);
+
+    mct_metrics_print_connections("mct_connection_messages_total",
+                                  "Messages received from an application or sent to a client",
+                                  "counter",
+                                  offsetof(MctServiceMetricsConnection, messages));
+    mct_metrics_print_connections("mct_connection_bytes_total",
+                                  "Bytes received from an application or sent to a client",
+                                  "counter",
+                                  offsetof(MctServiceMetricsConnection, bytes));
+    mct_metrics_print_connections("mct_connection_errors_total",
+                                  "Parse errors of data received from an application",
+                                  "counter",
+                                  offsetof(MctServiceMetricsConnection, errors));
+    mct_metrics_print_connections("mct_connection_dropped_messages_total",
+                                  "Messages which could not be sent to a client",
+                                  "counter",
+                                  offsetof(MctServiceMetricsConnection, dropped));
+    mct_metrics_print_connections("mct_connection_queue_bytes",
+                                  "Bytes queued in the kernel for the connection",
+                                  "gauge",
+                                  offsetof(MctServiceMetricsConnection, queue_depth));
+
+    mct_metrics_print_family("mct_context_messages_total", "counter",
+                             "Log messages received for a context");
+
+    for (i = 0; i < num_contexts; i++)
+        printf("mct_context_messages_total{apid=\"%.4s\",ctid=\"%.4s\"} %" PRIu64 "\n",
+               contexts[i].apid, contexts[i].ctid, contexts[i].messages);
+
+    mct_metrics_print_family("mct_context_bytes_total", "counter",
+                             "Bytes of log messages received for a context");
+
+    for (i = 0; i < num_contexts; i++)
+        printf("mct_context_bytes_total{apid=\"%.4s\",ctid=\"%.4s\"} %" PRIu64 "\n",
+               contexts[i].apid, contexts[i].ctid, contexts[i].bytes);
+}
+
+/** @brief Print out the application help
+ */
+static void usage(void)
+{
+    printf("Usage: mct-metrics [options]\n");
+    printf("Print the message counters of the MCT daemon\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -e --ecuid                 Set ECU ID (Default: %s)\n", MCT_CTRL_DEFAULT_ECUID);
+    printf("  -h --help                  Usage\n");
+    printf("  -p --prometheus            Print in Prometheus text format\n");
+    printf("  -t                         Specify connection timeout (Default: %ds)\n",
+           MCT_CTRL_TIMEOUT);
+    printf("  -v --verbose               Set verbose flag (Default:%d)\n", get_verbosity());
+    printf("  -C filename                MCT daemon configuration file (Default: " CONFIGURATION_FILES_DIR
+           "/mct.conf)\n");
+}
+
+static struct option long_options[] = {
+    {"ecuid",         required_argument,  0,  'e'},
+    {"help",          no_argument,        0,  'h'},
+    {"prometheus",    no_argument,        0,  'p'},
+    {"timeout",       required_argument,  0,  't'},
+    {"verbose",       no_argument,        0,  'v'},
+    {0,               0,                  0,  0}
+};
+
+/** @brief Parses the application arguments
+ *
+ * @param argc The amount of arguments
+ * @param argv The table of arguments
+ *
+ * @return 0 on success, -1 otherwise
+ */
+static int parse_args(int argc, char *argv[])
+{
+    int c = -1;
+    int long_index = 0;
+
+    while ((c = getopt_long(argc,
+                            argv,
+                            ":t:he:pvC:",
+                            long_options,
+                            &long_index)) != -1)
+        switch (c) {
+        case 't':
+            set_timeout((int) strtol(optarg, NULL, 10));
+            break;
+        case 'h':
+            usage();
+            return -1;
+        case 'e':
+            set_ecuid(optarg);
+            break;
+        case 'p':
+            output_format = MCT_METRICS_FORMAT_PROMETHEUS;
+            break;
+        case 'v':
+            set_verbosity(1);
+            pr_verbose("Now in verbose mode.\n");
+            break;
+        case 'C':
+            set_conf(optarg);
+            pr_verbose("Set %s to read options\n", optarg);
+            break;
+        case ':':
+            pr_error("Option -%c requires an argument.\n", optopt);
+            usage();
+            return -1;
+        case '?':
+
+            if (isprint(optopt))
+                pr_error("Unknown option -%c.\n", optopt);
+            else
+                pr_error("Unknown option character \\x%x.\n", optopt);
+
+            usage();
+            return -1;
+        default:
+            pr_error("Try %s -h for more information.\n", argv[0]);
+            return -1;
+        }
+
+    /* Retrieve ECUID from mct.conf */
+    if (*get_ecuid() == 0)
+        set_ecuid(NULL);
+
+    return 0;
+}
+
+/** @brief Entry point
+ *
+ * @param argc The amount of arguments
+ * @param argv The table of arguments
+ *
+ * @return 0 on success, -1 otherwise
+ */
+int main(int argc, char *argv[])
+{
+    int ret = 0;
+
+    set_timeout(MCT_CTRL_TIMEOUT);
+    set_send_serial_header(0);
+    set_resync_serial_header(0);
+
+    if (parse_args(argc, argv) != 0)
+        return -1;
+
+    if (mct_control_init(analyze_response, get_ecuid(), get_verbosity()) != 0) {
+        pr_error("Failed to initialize connection with the daemon.\n");
+        return -1;
+    }
+
+    ret = mct_metrics_collect();
+
+    mct_control_deinit();
+
+    if (ret != 0) {
+        pr_error("Failed to get metrics from the daemon.\n");
+    } else if (output_format == MCT_METRICS_FORMAT_PROMETHEUS) {
+        mct_metrics_print_prometheus();
+    } else {
+        mct_metrics_print_table();
+    }
+
+    free(response);
+    free(connections);
+    free(contexts);
+
+    return ret;
+}
@@ -13,10 +13,12 @@
 #include <errno.h>
 #include <pthread.h>
 #include <grp.h>
+#include <inttypes.h>
 
 #ifdef linux
 #include <sys/timerfd.h>
 #endif
+#include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #if defined(linux) && defined(__NR_statx)
@@ -37,6 +39,7 @@
 #include "mct_daemon_event_handler.h"
 #include "mct_daemon_offline_logstorage.h"
 #include "mct_daemon_filter.h"
+#include "mct_pattern.h"
 
 /**
  * \defgroup daemon MCT Daemon
@@ -44,11 +47,6 @@
  * \{
  */
 
-static int mct_daemon_log_internal(MctDaemon *daemon,
-                                   MctDaemonLocal *daemon_local,
-                                   char *str,
-                                   int verbose);
-
 static int mct_daemon_check_numeric_setting(char *token,
                                             char *value,
                                             unsigned long *data);
@@ -65,6 +63,7 @@ static char mct_timer_conn_types[MCT_TIMER_UNKNOWN + 1] = {
     [MCT_TIMER_PACKET] = MCT_CONNECTION_ONE_S_TIMER,
     [MCT_TIMER_ECU] = MCT_CONNECTION_SIXTY_S_TIMER,
     [MCT_TIMER_GATEWAY] = MCT_CONNECTION_GATEWAY_TIMER,
+    [MCT_TIMER_LOGSTORAGE] = MCT_CONNECTION_LOGSTORAGE_TIMER,
     [MCT_TIMER_UNKNOWN] = MCT_CONNECTION_TYPE_MAX
 };
 
@@ -72,6 +71,7 @@ static char mct_timer_names[MCT_TIMER_UNKNOWN + 1][32] = {
     [MCT_TIMER_PACKET] = "Timing packet",
     [MCT_TIMER_ECU] = "ECU version",
     [MCT_TIMER_GATEWAY] = "Gateway",
+    [MCT_TIMER_LOGSTORAGE] = "Logstorage sync",
     [MCT_TIMER_UNKNOWN] = "Unknown timer"
 };
 /**
@@ -211,6 +211,7 @@ int option_file_parser(MctDaemonLocal *daemon_local)
     daemon_local->flags.offlineTraceFileSize = 1000000;
     daemon_local->flags.offlineTraceMaxSize = 4000000;
     daemon_local->flags.offlineTraceFilenameTimestampBased = 1;
+    daemon_local->flags.offlineTraceCompression = 0;
     daemon_local->flags.loggingMode = MCT_LOG_TO_CONSOLE;
     daemon_local->flags.loggingLevel = LOG_INFO;
 
@@ -235,7 +236,27 @@ int option_file_parser(MctDaemonLocal *daemon_local)
     daemon_local->RingbufferMinSize = MCT_DAEMON_RINGBUFFER_MIN_SIZE;
     daemon_local->RingbufferMaxSize = MCT_DAEMON_RINGBUFFER_MAX_SIZE;
     daemon_local->RingbufferStepSize = MCT_DAEMON_RINGBUFFER_STEP_SIZE;
+    daemon_local->RingbufferSpoolSegmentSize = MCT_DAEMON_SPOOL_SEGMENT_SIZE;
+    daemon_local->RingbufferSpoolMaxSize = MCT_DAEMON_SPOOL_MAX_SIZE;
     daemon_local->daemonFifoSize = 0;
+    daemon_local->RecvBufSizeApp = MCT_DAEMON_RCVBUFSIZEAPP;
+    daemon_local->RecvBufSizeSocket = MCT_DAEMON_RCVBUFSIZESOCK;
+    daemon_local->RecvBufSizeSerial = MCT_DAEMON_RCVBUFSIZESERIAL;
+    daemon_local->AppReadBudgetMessages = MCT_DAEMON_APP_READ_BUDGET_MESSAGES;
+    daemon_local->AppReadBudgetBytes = MCT_DAEMON_APP_READ_BUDGET_BYTES;
+    daemon_local->OverloadControl = 0;
+    daemon_local->OverloadHighWatermark = MCT_DAEMON_OVERLOAD_HIGH_WATERMARK;
+    daemon_local->OverloadLowWatermark = MCT_DAEMON_OVERLOAD_LOW_WATERMARK;
+    daemon_local->OverloadThrottleLevel = MCT_DAEMON_OVERLOAD_THROTTLE_LEVEL;
+    daemon_local->OverloadContexts = MCT_DAEMON_OVERLOAD_CONTEXTS;
+    daemon_local->OverloadRestoreTime = MCT_DAEMON_OVERLOAD_RESTORE_TIME;
+    daemon_local->OverloadBlockMode = 0;
+    daemon_local->UDPConnectionSetup = 0;
+    strncpy(daemon_local->UDPMulticastIPAddress, MCT_DAEMON_UDP_MULTICAST_IP,
+            sizeof(daemon_local->UDPMulticastIPAddress) - 1);
+    daemon_local->UDPMulticastIPPort = MCT_DAEMON_UDP_MULTICAST_PORT;
+    daemon_local->UDPMulticastTTL = MCT_DAEMON_UDP_MULTICAST_TTL;
+    daemon_local->udp.sock = -1;
     daemon_local->flags.sendECUSoftwareVersion = 0;
     memset(daemon_local->flags.pathToECUSoftwareVersion, 0,
            sizeof(daemon_local->flags.pathToECUSoftwareVersion));
@@ -247,7 +268,11 @@ int option_file_parser(MctDaemonLocal *daemon_local)
     daemon_local->flags.offlineLogstorageMaxCounter = UINT_MAX;
     daemon_local->flags.offlineLogstorageMaxCounterIdx = 0;
     daemon_local->flags.offlineLogstorageOptionalCounter = false;
+    daemon_local->flags.offlineLogstorageQueueSize = MCT_DAEMON_LOGSTORAGE_QUEUE_SIZE;
+    daemon_local->flags.offlineLogstorageQueuePolicy = MCT_DAEMON_LOGSTORAGE_QUEUE_WAIT;
+    daemon_local->flags.offlineLogstorageSyncInterval = MCT_DAEMON_LOGSTORAGE_SYNC_INTERVAL;
     daemon_local->flags.blockModeAllowed = MCT_DAEMON_BLOCK_MODE_DISABLED;
+    daemon_local->flags.offlineLogstorageCacheDir[0] = 0;
     daemon_local->flags.offlineLogstorageCacheSize = 30000; /* 30MB */
     mct_daemon_logstorage_set_logstorage_cache_size(
         daemon_local->flags.offlineLogstorageCacheSize);
@@ -274,6 +299,7 @@ int option_file_parser(MctDaemonLocal *daemon_local)
     daemon_local->flags.enforceContextLLAndTS = 0; /* default is off */
     daemon_local->flags.ipNodes = NULL;
     daemon_local->flags.injectionMode = 1;
+    daemon_local->flags.persistanceStorageFormat = 1;
 
     /* open configuration file */
     if (daemon_local->flags.cvalue[0]) {
@@ -358,6 +384,8 @@ int option_file_parser(MctDaemonLocal *daemon_local)
                         strncpy(daemon_local->flags.ivalue, value, NAME_MAX);
                         daemon_local->flags.ivalue[NAME_MAX] = 0;
                         /*printf("Option: %s=%s\n",token,value); */
+                    } else if (strcmp(token, "PersistanceStorageFormat") == 0) {
+                        daemon_local->flags.persistanceStorageFormat = atoi(value);
                     } else if (strcmp(token, "LoggingMode") == 0) {
                         daemon_local->flags.loggingMode = atoi(value);
                         /*printf("Option: %s=%s\n",token,value); */
@@ -392,6 +420,97 @@ int option_file_parser(MctDaemonLocal *daemon_local)
                             fclose(pFile);
                             return -1;
                        }
+                    } else if (strcmp(token, "RingbufferSpoolDirectory") == 0) {
+                        strncpy(daemon_local->RingbufferSpoolDirectory, value,
+                                sizeof(daemon_local->RingbufferSpoolDirectory) - 1);
+                        daemon_local->RingbufferSpoolDirectory[sizeof(daemon_local->
+                                                                      RingbufferSpoolDirectory) - 1] = 0;
+                    } else if (strcmp(token, "RingbufferSpoolSegmentSize") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->RingbufferSpoolSegmentSize)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "RingbufferSpoolMaxSize") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->RingbufferSpoolMaxSize)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "ReceiveBufferSizeApp") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->RecvBufSizeApp)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "AppReadBudgetMessages") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->AppReadBudgetMessages)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "AppReadBudgetBytes") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->AppReadBudgetBytes)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "OverloadControl") == 0) {
+                        daemon_local->OverloadControl = atoi(value);
+                    } else if (strcmp(token, "OverloadHighWatermark") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->OverloadHighWatermark)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "OverloadLowWatermark") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->OverloadLowWatermark)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "OverloadThrottleLevel") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->OverloadThrottleLevel)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "OverloadContexts") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->OverloadContexts)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "OverloadRestoreTime") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->OverloadRestoreTime)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "OverloadBlockMode") == 0) {
+                        daemon_local->OverloadBlockMode = atoi(value);
+                    } else if (strcmp(token, "ReceiveBufferSizeSocket") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->RecvBufSizeSocket)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "UDPConnectionSetup") == 0) {
+                        daemon_local->UDPConnectionSetup = atoi(value);
+                    } else if (strcmp(token, "UDPMulticastIPAddress") == 0) {
+                        strncpy(daemon_local->UDPMulticastIPAddress, value,
+                                sizeof(daemon_local->UDPMulticastIPAddress) - 1);
+                        daemon_local->UDPMulticastIPAddress[sizeof(daemon_local->UDPMulticastIPAddress) - 1] = 0;
+                    } else if (strcmp(token, "UDPMulticastIPPort") == 0) {
+                        daemon_local->UDPMulticastIPPort = atoi(value);
+                    } else if (strcmp(token, "UDPMulticastTTL") == 0) {
+                        daemon_local->UDPMulticastTTL = atoi(value);
+                    } else if (strcmp(token, "ReceiveBufferSizeSerial") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->RecvBufSizeSerial)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
                     } else if (strcmp(token, "SharedMemorySize") == 0) {
                         daemon_local->flags.sharedMemorySize = atoi(value);
                         /*printf("Option: %s=%s\n",token,value); */
@@ -411,6 +530,9 @@ int option_file_parser(MctDaemonLocal *daemon_local)
                     } else if (strcmp(token, "OfflineTraceFileNameTimestampBased") == 0) {
                         daemon_local->flags.offlineTraceFilenameTimestampBased = atoi(value);
                         /*printf("Option: %s=%s\n",token,value); */
+                    } else if (strcmp(token, "OfflineTraceCompression") == 0) {
+                        daemon_local->flags.offlineTraceCompression = atoi(value);
+                        /*printf("Option: %s=%s\n",token,value); */
                     } else if (strcmp(token, "SendECUSoftwareVersion") == 0) {
                         daemon_local->flags.sendECUSoftwareVersion = atoi(value);
                         /*printf("Option: %s=%s\n",token,value); */
@@ -445,11 +567,32 @@ int option_file_parser(MctDaemonLocal *daemon_local)
                         daemon_local->flags.offlineLogstorageMaxCounterIdx = strlen(value);
                     } else if (strcmp(token, "OfflineLogstorageOptionalIndex") == 0) {
                         daemon_local->flags.offlineLogstorageOptionalCounter = atoi(value);
+                    } else if (strcmp(token, "OfflineLogstorageQueueSize") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->flags.offlineLogstorageQueueSize)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
+                    } else if (strcmp(token, "OfflineLogstorageQueuePolicy") == 0) {
+                        daemon_local->flags.offlineLogstorageQueuePolicy =
+                            atoi(value) ? MCT_DAEMON_LOGSTORAGE_QUEUE_WAIT : MCT_DAEMON_LOGSTORAGE_QUEUE_DROP;
+                    } else if (strcmp(token, "OfflineLogstorageSyncInterval") == 0) {
+                        if (mct_daemon_check_numeric_setting(token,
+                                value, &(daemon_local->flags.offlineLogstorageSyncInterval)) < 0) {
+                            fclose(pFile);
+                            return -1;
+                       }
                     } else if (strcmp(token, "OfflineLogstorageCacheSize") == 0) {
                         daemon_local->flags.offlineLogstorageCacheSize =
                             (unsigned int)atoi(value);
                         mct_daemon_logstorage_set_logstorage_cache_size(
                             daemon_local->flags.offlineLogstorageCacheSize);
+                    } else if (strcmp(token, "OfflineLogstorageCacheDir") == 0) {
+                        strncpy(daemon_local->flags.offlineLogstorageCacheDir,
+                                value,
+                                sizeof(daemon_local->flags.offlineLogstorageCacheDir) - 1);
+                        mct_daemon_logstorage_set_logstorage_cache_dir(
+                            daemon_local->flags.offlineLogstorageCacheDir);
                     } else if (strcmp(token, "ControlSocketPath") == 0) {
                         memset(
                             daemon_local->flags.ctrlSockPath,
@@ -781,6 +924,8 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    daemon.runtime_store.enabled = (daemon_local.flags.persistanceStorageFormat != 0);
+
     /*
      * Load mct-runtime.cfg if available.
      * This must be loaded before offline setup
@@ -818,6 +963,15 @@ int main(int argc, char *argv[])
         create_timer_fd(&daemon_local, 60, 60, MCT_TIMER_ECU);
     }
 
+    /* create fd for timer syncing logstorage files */
+    if ((daemon_local.flags.offlineLogstorageMaxDevices > 0) &&
+        (daemon_local.flags.offlineLogstorageSyncInterval > 0)) {
+        create_timer_fd_ms(&daemon_local,
+                           (int)daemon_local.flags.offlineLogstorageSyncInterval,
+                           (int)daemon_local.flags.offlineLogstorageSyncInterval,
+                           MCT_TIMER_LOGSTORAGE);
+    }
+
     /* For offline tracing we still can use the same states */
     /* as for socket sending. Using this trick we see the traces */
     /* In the offline trace AND in the socket stream. */
@@ -831,10 +985,7 @@ int main(int argc, char *argv[])
      * Check for app and ctx runtime cfg.
      * These cfg must be loaded after ecuId and num_user_lists are available
      */
-    if ((mct_daemon_applications_load(&daemon, daemon.runtime_application_cfg,
-                                      daemon_local.flags.vflag) == 0) &&
-        (mct_daemon_contexts_load(&daemon, daemon.runtime_context_cfg,
-                                  daemon_local.flags.vflag) == 0)) {
+    if (mct_daemon_runtime_config_load(&daemon, daemon_local.flags.vflag) == 0) {
         daemon.runtime_context_cfg_loaded = 1;
     }
 
@@ -917,6 +1068,9 @@ int mct_daemon_local_init_p1(MctDaemon *daemon, MctDaemonLocal *daemon_local, in
 
 int mct_daemon_local_init_p2(MctDaemon *daemon, MctDaemonLocal *daemon_local, int verbose)
 {
+    int i = 0;
+    MctLogStorageUserConfig file_config;
+
     PRINT_FUNCTION_VERBOSE(verbose);
 
     if ((daemon == 0) || (daemon_local == 0)) {
@@ -936,8 +1090,28 @@ int mct_daemon_local_init_p2(MctDaemon *daemon, MctDaemonLocal *daemon_local, in
         return -1;
     }
 
+    /* init ring buffer spool, messages are discarded on overflow without it */
+    if (daemon_local->RingbufferSpoolDirectory[0] &&
+        (mct_daemon_spool_init(&(daemon_local->spool),
+                               daemon_local->RingbufferSpoolDirectory,
+                               daemon_local->RingbufferSpoolSegmentSize,
+                               daemon_local->RingbufferSpoolMaxSize) != MCT_RETURN_OK)) {
+        mct_log(LOG_WARNING, "Could not initialize ring buffer spool\n");
+    }
+
+    /* overload control needs a low watermark below the high watermark */
+    if (daemon_local->OverloadControl &&
+        ((daemon_local->OverloadHighWatermark > 100) ||
+         (daemon_local->OverloadLowWatermark >= daemon_local->OverloadHighWatermark) ||
+         (daemon_local->OverloadThrottleLevel > MCT_LOG_VERBOSE))) {
+        mct_log(LOG_WARNING, "Invalid overload control settings, overload control disabled\n");
+        daemon_local->OverloadControl = 0;
+    }
+
     /* init offline trace */
     if (daemon_local->flags.offlineTraceDirectory[0]) {
+        daemon_local->offlineTrace.compression = daemon_local->flags.offlineTraceCompression;
+
         if (mct_offline_trace_init(&(daemon_local->offlineTrace),
                                    daemon_local->flags.offlineTraceDirectory,
                                    daemon_local->flags.offlineTraceFileSize,
@@ -962,6 +1136,49 @@ int mct_daemon_local_init_p2(MctDaemon *daemon, MctDaemonLocal *daemon_local, in
 
         memset(daemon->storage_handle, 0,
                (sizeof(MctLogStorage) * daemon_local->flags.offlineLogstorageMaxDevices));
+
+        daemon->storage_metrics = calloc((size_t)daemon_local->flags.offlineLogstorageMaxDevices,
+                                         sizeof(MctDaemonMetrics));
+
+        if (daemon->storage_metrics == NULL) {
+            mct_log(LOG_ERR, "Could not initialize offline logstorage\n");
+            return -1;
+        }
+
+        file_config.logfile_timestamp = daemon_local->flags.offlineLogstorageTimestamp;
+        file_config.logfile_delimiter = daemon_local->flags.offlineLogstorageDelimiter;
+        file_config.logfile_maxcounter = daemon_local->flags.offlineLogstorageMaxCounter;
+        file_config.logfile_optional_counter =
+            daemon_local->flags.offlineLogstorageOptionalCounter;
+        file_config.logfile_counteridxlen =
+            daemon_local->flags.offlineLogstorageMaxCounterIdx;
+
+        /* caches left by a crash are written to log files on connect */
+        for (i = 0; i < daemon_local->flags.offlineLogstorageMaxDevices; i++) {
+            daemon->storage_handle[i].uconfig = file_config;
+        }
+
+        if (daemon_local->flags.offlineLogstorageQueueSize > 0) {
+            daemon->storage_writer = calloc((size_t)daemon_local->flags.offlineLogstorageMaxDevices,
+                                            sizeof(MctDaemonLogStorageWriter));
+
+            if (daemon->storage_writer == NULL) {
+                mct_log(LOG_ERR, "Could not initialize offline logstorage writer\n");
+                return -1;
+            }
+
+            for (i = 0; i < daemon_local->flags.offlineLogstorageMaxDevices; i++) {
+                if (mct_daemon_logstorage_writer_init(&daemon->storage_writer[i],
+                                                      &daemon->storage_handle[i],
+                                                      &file_config,
+                                                      (uint32_t)daemon_local->flags.offlineLogstorageQueueSize,
+                                                      daemon_local->flags.offlineLogstorageQueuePolicy) !=
+                    MCT_RETURN_OK) {
+                    mct_log(LOG_ERR, "Could not start offline logstorage writer\n");
+                    return -1;
+                }
+            }
+        }
     }
 
     /* Set ECU id of daemon */
@@ -971,6 +1188,12 @@ int mct_daemon_local_init_p2(MctDaemon *daemon, MctDaemonLocal *daemon_local, in
         mct_set_id(daemon->ecuid, MCT_DAEMON_ECU_ID);
     }
 
+    /* Registered applications and contexts of the daemon ECU */
+    if (mct_daemon_init_user_information(daemon, daemon_local->flags.vflag) != MCT_RETURN_OK) {
+        mct_log(LOG_ERR, "Could not initialize user information\n");
+        return -1;
+    }
+
     /* Set flag for optional sending of serial header */
     daemon->sendserialheader = daemon_local->flags.lflag;
 
@@ -980,6 +1203,21 @@ int mct_daemon_local_init_p2(MctDaemon *daemon, MctDaemonLocal *daemon_local, in
         return -1;
     }
 
+    /* messages received in one iteration are forwarded as one batch */
+    if (mct_daemon_client_batch_init(&(daemon_local->batch),
+                                     MCT_DAEMON_BATCH_MAX_MESSAGES,
+                                     MCT_DAEMON_BATCH_BUFSIZE) != MCT_RETURN_OK) {
+        mct_log(LOG_WARNING, "Could not initialize message batch, messages are forwarded one by one\n");
+    }
+
+    /* staging buffer of buffered messages replayed to the clients */
+    daemon_local->replay.data = (uint8_t *)malloc(MCT_DAEMON_REPLAY_CHUNK_SIZE);
+
+    if (daemon_local->replay.data == NULL) {
+        mct_log(LOG_ERR, "Could not allocate replay buffer\n");
+        return -1;
+    }
+
     /* configure sending timing packets */
     if (daemon_local->flags.sendMessageTime) {
         daemon->timingpackets = 1;
@@ -1301,6 +1539,15 @@ int mct_daemon_local_connection_init(MctDaemon *daemon,
         return MCT_RETURN_ERROR;
     }
 
+    /* Init UDP multicast output, messages are still sent to all other clients without it */
+    if (daemon_local->UDPConnectionSetup &&
+        (mct_daemon_udp_init(&daemon_local->udp,
+                             daemon_local->UDPMulticastIPAddress,
+                             daemon_local->UDPMulticastIPPort,
+                             daemon_local->UDPMulticastTTL) != MCT_DAEMON_ERROR_OK)) {
+        mct_log(LOG_WARNING, "Could not initialize UDP multicast\n");
+    }
+
     return 0;
 }
 
@@ -1380,6 +1627,8 @@ int mct_daemon_local_ecu_version_init(MctDaemon *daemon, MctDaemonLocal *daemon_
 
 void mct_daemon_local_cleanup(MctDaemon *daemon, MctDaemonLocal *daemon_local, int verbose)
 {
+    int i = 0;
+
     PRINT_FUNCTION_VERBOSE(verbose);
 
     if ((daemon == 0) || (daemon_local == 0)) {
@@ -1392,6 +1641,11 @@ void mct_daemon_local_cleanup(MctDaemon *daemon, MctDaemonLocal *daemon_local, i
     mct_event_handler_cleanup_connections(&daemon_local->pEvent);
 
     mct_message_free(&(daemon_local->msg), daemon_local->flags.vflag);
+    mct_daemon_client_batch_free(&(daemon_local->batch));
+    free(daemon_local->replay.data);
+    daemon_local->replay.data = NULL;
+    mct_daemon_udp_close(&(daemon_local->udp));
+    mct_daemon_spool_free(&(daemon_local->spool));
 
     /* free shared memory */
     if (daemon_local->flags.offlineTraceDirectory[0]) {
@@ -1409,12 +1663,24 @@ void mct_daemon_local_cleanup(MctDaemon *daemon, MctDaemonLocal *daemon_local, i
     unlink(daemon_local->flags.appSockPath);
 #endif
     if (daemon_local->flags.offlineLogstorageMaxDevices > 0) {
+        /* write all queued messages and stop the writer threads */
+        if (daemon->storage_writer != NULL) {
+            for (i = 0; i < daemon_local->flags.offlineLogstorageMaxDevices; i++) {
+                mct_daemon_logstorage_writer_free(&daemon->storage_writer[i]);
+            }
+
+            free(daemon->storage_writer);
+            daemon->storage_writer = NULL;
+        }
+
         /* disconnect all logstorage devices */
         mct_daemon_logstorage_cleanup(daemon,
                                       daemon_local,
                                       daemon_local->flags.vflag);
 
         free(daemon->storage_handle);
+        free(daemon->storage_metrics);
+        daemon->storage_metrics = NULL;
     }
 
     if (daemon->ECUVersionString != NULL) {
@@ -1753,6 +2019,346 @@ int mct_daemon_process_client_connect(MctDaemon *daemon,
     return 0;
 }
 
+/**
+ * @brief Report the messages evicted from the full client ringbuffer
+ *
+ * The number of evicted messages per log level is logged and sent to the
+ * client as internal message, then the counters are reset.
+ *
+ * @param daemon pointer to MctDaemon structure
+ * @param daemon_local pointer to MctDaemonLocal structure
+ * @param verbose if set to true verbose information is printed out
+ */
+static void mct_daemon_report_evicted(MctDaemon *daemon,
+                                      MctDaemonLocal *daemon_local,
+                                      int verbose)
+{
+    char str[MCT_DAEMON_TEXTBUFSIZE];
+    unsigned int *evicted = daemon->evicted_counter;
+    unsigned int total = 0;
+    int i = 0;
+
+    for (i = 0; i < MCT_BUFFER_PRIORITY_MAX; i++) {
+        total += evicted[i];
+    }
+
+    if (total == 0) {
+        return;
+    }
+
+    snprintf(str, MCT_DAEMON_TEXTBUFSIZE,
+             "Buffer full: %u messages evicted (fatal %u, error %u, warn %u, info %u, debug %u, verbose %u)",
+             total, evicted[MCT_LOG_FATAL], evicted[MCT_LOG_ERROR], evicted[MCT_LOG_WARN],
+             evicted[MCT_LOG_INFO], evicted[MCT_LOG_DEBUG], evicted[MCT_LOG_VERBOSE]);
+
+    mct_vlog(LOG_WARNING, "%s\n", str);
+    mct_daemon_log_internal(daemon, daemon_local, str, verbose);
+
+    for (i = 0; i < MCT_BUFFER_PRIORITY_MAX; i++) {
+        daemon->evicted_total[i] += evicted[i];
+    }
+
+    memset(daemon->evicted_counter, 0, sizeof(daemon->evicted_counter));
+}
+
+/**
+ * @brief Get the load of the daemon for the overload control
+ *
+ * The load is the fill level of the client ringbuffer or of the fullest
+ * send queue of a TCP client in percent. If messages were lost since the
+ * last check, the load is 100.
+ *
+ * @param daemon pointer to MctDaemon structure
+ * @param daemon_local pointer to MctDaemonLocal structure
+ * @return load in percent
+ */
+static int mct_daemon_overload_load(MctDaemon *daemon, MctDaemonLocal *daemon_local)
+{
+    MctConnection *con = NULL;
+    uint64_t lost = 0;
+    int load = 0;
+    int queue = 0;
+    int sndbuf = 0;
+    socklen_t len = sizeof(sndbuf);
+    int i = 0;
+
+    lost = daemon->overflow_total + daemon->overflow_counter +
+        MCT_DAEMON_METRICS_GET(daemon_local->udp.metrics.dropped);
+
+    for (i = 0; i < MCT_BUFFER_PRIORITY_MAX; i++) {
+        lost += daemon->evicted_total[i] + daemon->evicted_counter[i];
+    }
+
+    if (daemon->client_ringbuffer.max_size > 0) {
+        load = (int)((uint64_t)mct_buffer_get_used_size(&daemon->client_ringbuffer) * 100 /
+                     daemon->client_ringbuffer.max_size);
+    }
+
+    for (con = daemon_local->pEvent.connections; con != NULL; con = con->next) {
+        if ((con->type != MCT_CONNECTION_CLIENT_MSG_TCP) || (con->receiver == NULL)) {
+            continue;
+        }
+
+        lost += MCT_DAEMON_METRICS_GET(con->metrics.dropped);
+        len = sizeof(sndbuf);
+
+        if ((ioctl(con->receiver->fd, TIOCOUTQ, &queue) == 0) &&
+            (getsockopt(con->receiver->fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, &len) == 0) &&
+            (sndbuf > 0) && ((int)((int64_t)queue * 100 / sndbuf) > load)) {
+            load = (int)((int64_t)queue * 100 / sndbuf);
+        }
+    }
+
+    if (lost > daemon_local->overload.lost) {
+        load = 100;
+    }
+
+    daemon_local->overload.lost = lost;
+
+    return load;
+}
+
+/**
+ * @brief Lower the log level of the noisiest contexts
+ *
+ * The contexts which logged the most messages since the last check are
+ * lowered to the throttle level, at most OverloadContexts per call. The
+ * message counters of all contexts are remembered for the next check.
+ *
+ * @param daemon pointer to MctDaemon structure
+ * @param daemon_local pointer to MctDaemonLocal structure
+ * @param user_list contexts of this ECU
+ * @param throttle whether contexts should be lowered or only counted
+ * @param verbose if set to true verbose information is printed out
+ * @return number of lowered contexts
+ */
+static int mct_daemon_overload_throttle(MctDaemon *daemon,
+                                        MctDaemonLocal *daemon_local,
+                                        MctDaemonRegisteredUsers *user_list,
+                                        int throttle,
+                                        int verbose)
+{
+    char str[MCT_DAEMON_TEXTBUFSIZE];
+    MctDaemonContext *noisiest[MCT_DAEMON_OVERLOAD_CONTEXTS_MAX];
+    uint64_t delta[MCT_DAEMON_OVERLOAD_CONTEXTS_MAX];
+    MctDaemonContext *context = NULL;
+    int8_t level = (int8_t)daemon_local->OverloadThrottleLevel;
+    int8_t current = 0;
+    uint64_t messages = 0;
+    uint64_t d = 0;
+    int max = (int)daemon_local->OverloadContexts;
+    int num = 0;
+    int i = 0;
+    int j = 0;
+
+    if (max > MCT_DAEMON_OVERLOAD_CONTEXTS_MAX) {
+        max = MCT_DAEMON_OVERLOAD_CONTEXTS_MAX;
+    }
+
+    for (i = 0; i < user_list->num_contexts; i++) {
+        context = &user_list->contexts[i];
+        messages = MCT_DAEMON_METRICS_GET(context->metrics.messages);
+        d = messages - context->throttle_messages;
+        context->throttle_messages = messages;
+
+        current = (context->log_level == MCT_LOG_DEFAULT) ?
+            (int8_t)daemon->default_log_level : context->log_level;
+
+        /* a log level kept up by offline logstorage cannot be lowered */
+        if (!throttle || (d == 0) || context->throttled || (current <= level) ||
+            (context->user_handle < MCT_FD_MINIMUM) ||
+            ((context->storage_log_level > level) &&
+             (daemon->maintain_logstorage_loglevel != MCT_MAINTAIN_LOGSTORAGE_LOGLEVEL_OFF))) {
+            continue;
+        }
+
+        /* keep the noisiest contexts sorted by descending message count */
+        for (j = num; (j > 0) && (delta[j - 1] < d); j--) {
+            if (j < max) {
+                noisiest[j] = noisiest[j - 1];
+                delta[j] = delta[j - 1];
+            }
+        }
+
+        if (j < max) {
+            noisiest[j] = context;
+            delta[j] = d;
+
+            if (num < max) {
+                num++;
+            }
+        }
+    }
+
+    for (i = 0; i < num; i++) {
+        context = noisiest[i];
+        context->saved_log_level = context->log_level;
+        context->throttle_log_level = level;
+        context->log_level = level;
+
+        if (mct_daemon_user_send_log_level(daemon, context, verbose) != 0) {
+            context->log_level = context->saved_log_level;
+            continue;
+        }
+
+        context->throttled = true;
+
+        snprintf(str, MCT_DAEMON_TEXTBUFSIZE,
+                 "Overload: log level of %.4s:%.4s lowered from %d to %d (%" PRIu64 " messages/s)",
+                 context->apid, context->ctid, context->saved_log_level, level, delta[i]);
+        mct_vlog(LOG_WARNING, "%s\n", str);
+        mct_daemon_log_internal(daemon, daemon_local, str, verbose);
+    }
+
+    return num;
+}
+
+/**
+ * @brief Restore the log level of contexts lowered by the overload control
+ *
+ * At most OverloadContexts contexts are restored per call. A context whose
+ * log level was changed since it was lowered keeps the new log level.
+ *
+ * @param daemon pointer to MctDaemon structure
+ * @param daemon_local pointer to MctDaemonLocal structure
+ * @param user_list contexts of this ECU
+ * @param verbose if set to true verbose information is printed out
+ * @return number of contexts still lowered
+ */
+static int mct_daemon_overload_restore(MctDaemon *daemon,
+                                       MctDaemonLocal *daemon_local,
+                                       MctDaemonRegisteredUsers *user_list,
+                                       int verbose)
+{
+    char str[MCT_DAEMON_TEXTBUFSIZE];
+    MctDaemonContext *context = NULL;
+    int restored = 0;
+    int remaining = 0;
+    int i = 0;
+
+    for (i = 0; i < user_list->num_contexts; i++) {
+        context = &user_list->contexts[i];
+
+        if (!context->throttled) {
+            continue;
+        }
+
+        if (context->log_level != context->throttle_log_level) {
+            context->throttled = false;
+            continue;
+        }
+
+        if ((unsigned long)restored >= daemon_local->OverloadContexts) {
+            remaining++;
+            continue;
+        }
+
+        context->throttled = false;
+        context->log_level = context->saved_log_level;
+        restored++;
+
+        if (context->user_handle < MCT_FD_MINIMUM) {
+            mct_daemon_context_changed(daemon, context, verbose);
+        } else if (mct_daemon_user_send_log_level(daemon, context, verbose) != 0) {
+            mct_vlog(LOG_WARNING, "Overload: cannot restore log level of %.4s:%.4s\n",
+                     context->apid, context->ctid);
+        }
+
+        snprintf(str, MCT_DAEMON_TEXTBUFSIZE,
+                 "Overload: log level of %.4s:%.4s restored to %d",
+                 context->apid, context->ctid, context->log_level);
+        mct_vlog(LOG_NOTICE, "%s\n", str);
+        mct_daemon_log_internal(daemon, daemon_local, str, verbose);
+    }
+
+    return remaining;
+}
+
+void mct_daemon_overload_check(MctDaemon *daemon,
+                               MctDaemonLocal *daemon_local,
+                               int verbose)
+{
+    char str[MCT_DAEMON_TEXTBUFSIZE];
+    MctDaemonOverload *overload = NULL;
+    MctDaemonRegisteredUsers *user_list = NULL;
+    int load = 0;
+    int high = 0;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL) || !daemon_local->OverloadControl) {
+        return;
+    }
+
+    user_list = mct_daemon_find_users_list(daemon, daemon->ecuid, verbose);
+
+    if (user_list == NULL) {
+        return;
+    }
+
+    overload = &daemon_local->overload;
+    load = mct_daemon_overload_load(daemon, daemon_local);
+    high = (load >= (int)daemon_local->OverloadHighWatermark);
+
+    if (high && (overload->load < (int)daemon_local->OverloadHighWatermark)) {
+        snprintf(str, MCT_DAEMON_TEXTBUFSIZE, "Overload: load %d%% above high watermark %lu%%",
+                 load, daemon_local->OverloadHighWatermark);
+        mct_vlog(LOG_WARNING, "%s\n", str);
+        mct_daemon_log_internal(daemon, daemon_local, str, verbose);
+    }
+
+    overload->load = load;
+
+    if (load > (int)daemon_local->OverloadLowWatermark) {
+        overload->calm = 0;
+    } else if (overload->calm < UINT_MAX) {
+        overload->calm++;
+    }
+
+    if (mct_daemon_overload_throttle(daemon, daemon_local, user_list, high, verbose) > 0) {
+        overload->throttled = 1;
+        return;
+    }
+
+    /* nothing left to lower: let the applications wait instead of dropping */
+    if (high && !overload->blocking && daemon_local->OverloadBlockMode &&
+        (daemon_local->flags.blockModeAllowed == MCT_DAEMON_BLOCK_MODE_ENABLED) &&
+        (daemon->blockMode == MCT_MODE_NON_BLOCKING)) {
+        if (mct_daemon_user_update_blockmode(daemon, MCT_ALL_APPLICATIONS,
+                                             MCT_MODE_BLOCKING, verbose) == MCT_RETURN_OK) {
+            overload->blocking = 1;
+            snprintf(str, MCT_DAEMON_TEXTBUFSIZE, "Overload: applications switched to blocking mode");
+            mct_vlog(LOG_WARNING, "%s\n", str);
+            mct_daemon_log_internal(daemon, daemon_local, str, verbose);
+        }
+
+        return;
+    }
+
+    if (overload->calm < daemon_local->OverloadRestoreTime) {
+        return;
+    }
+
+    if (overload->blocking) {
+        overload->blocking = 0;
+
+        /* the mode may have been changed by a client in the meantime */
+        if ((daemon->blockMode == MCT_MODE_BLOCKING) &&
+            (mct_daemon_user_update_blockmode(daemon, MCT_ALL_APPLICATIONS,
+                                              MCT_MODE_NON_BLOCKING, verbose) == MCT_RETURN_OK)) {
+            snprintf(str, MCT_DAEMON_TEXTBUFSIZE, "Overload: applications switched to non-blocking mode");
+            mct_vlog(LOG_NOTICE, "%s\n", str);
+            mct_daemon_log_internal(daemon, daemon_local, str, verbose);
+        }
+
+        return;
+    }
+
+    if (overload->throttled) {
+        overload->throttled = mct_daemon_overload_restore(daemon, daemon_local, user_list, verbose);
+    }
+}
+
 int mct_daemon_client_update(MctDaemon *daemon,
                              MctDaemonLocal *daemon_local,
                              int verbose)
@@ -1786,6 +2392,7 @@ int mct_daemon_client_update(MctDaemon *daemon,
             mct_vlog(LOG_INFO,
                      "Overflow occurred: %u messages discarded!\n",
                      daemon->overflow_counter);
+            daemon->overflow_total += daemon->overflow_counter;
             daemon->overflow_counter = 0;
         } else {
             mct_log(LOG_ERR, "Can't send overflow message to clients\n");
@@ -1793,6 +2400,9 @@ int mct_daemon_client_update(MctDaemon *daemon,
         }
     }
 
+    /* Report messages evicted in favour of higher log levels */
+    mct_daemon_report_evicted(daemon, daemon_local, verbose);
+
     return MCT_RETURN_OK;
 }
 
@@ -2117,6 +2727,12 @@ int mct_daemon_process_user_messages(MctDaemon *daemon,
     int run_loop = 1;
     int32_t min_size = (int32_t)sizeof(MctUserHeader);
     MctUserHeader *userheader;
+    MctConnection *con = NULL;
+    MctDaemonMetrics unused = { 0 };
+    MctDaemonMetrics *metrics = &unused;
+    int32_t before = 0;
+    unsigned long messages = 0;
+    unsigned long bytes = 0;
     int recv;
 
     PRINT_FUNCTION_VERBOSE(verbose);
@@ -2128,58 +2744,108 @@ int mct_daemon_process_user_messages(MctDaemon *daemon,
         return -1;
     }
 
-    recv = mct_receiver_receive(receiver);
+    con = mct_event_handler_find_connection(&daemon_local->pEvent, receiver->fd);
 
-    if ((recv <= 0) && (receiver->type == MCT_RECEIVE_SOCKET)) {
-        mct_daemon_close_socket(receiver->fd,
-                                daemon,
-                                daemon_local,
-                                verbose);
-        return 0;
-    } else if (recv < 0) {
-        mct_log(LOG_WARNING,
-                "mct_receiver_receive_fd() for user messages failed!\n");
-        return -1;
+    if (con != NULL) {
+        metrics = &con->metrics;
+    }
+
+    if ((con != NULL) && con->backlog) {
+        /* messages left over from the last round are processed first,
+         * new data is read once they are done */
+        con->backlog = 0;
+    } else {
+        recv = mct_receiver_receive(receiver);
+
+        if ((recv <= 0) && (receiver->type == MCT_RECEIVE_SOCKET)) {
+            mct_daemon_close_socket(receiver->fd,
+                                    daemon,
+                                    daemon_local,
+                                    verbose);
+            return 0;
+        } else if (recv < 0) {
+            mct_log(LOG_WARNING,
+                    "mct_receiver_receive_fd() for user messages failed!\n");
+            return -1;
+        }
     }
 
     /* look through buffer as long as data is in there */
     while ((receiver->bytesRcvd >= min_size) && run_loop) {
         mct_daemon_process_user_message_func func = NULL;
 
-        offset = 0;
-        userheader = (MctUserHeader *)(receiver->buf + offset);
+        /* give the other connections their turn once the budget is used up */
+        if (((daemon_local->AppReadBudgetMessages > 0) &&
+             (messages >= daemon_local->AppReadBudgetMessages)) ||
+            ((daemon_local->AppReadBudgetBytes > 0) &&
+             (bytes >= daemon_local->AppReadBudgetBytes))) {
+            if (con != NULL) {
+                con->backlog = 1;
+            }
 
-        while (!mct_user_check_userheader(userheader) &&
-               (offset + min_size <= receiver->bytesRcvd)) {
-            /* resync if necessary */
-            offset++;
-            userheader = (MctUserHeader *)(receiver->buf + offset);
+            break;
         }
 
-        /* Check for user header pattern */
-        if (!mct_user_check_userheader(userheader)) {
+        /* resync if necessary */
+        offset = mct_pattern_find(receiver->buf, (size_t)receiver->bytesRcvd,
+                                  mctUserHeader, sizeof(mctUserHeader));
+
+        if (offset < 0) {
+            /* drop everything which cannot be the start of a user header */
+            MCT_DAEMON_METRICS_ADD(metrics->errors, 1);
+            mct_receiver_remove(receiver,
+                                receiver->bytesRcvd - (int)(sizeof(mctUserHeader) - 1));
             break;
         }
 
         /* Set new start offset */
         if (offset > 0) {
+            MCT_DAEMON_METRICS_ADD(metrics->errors, 1);
             mct_receiver_remove(receiver, offset);
         }
 
+        if (receiver->bytesRcvd < min_size) {
+            break;
+        }
+
+        userheader = (MctUserHeader *)(receiver->buf);
+
         if (userheader->message >= MCT_USER_MESSAGE_NOT_SUPPORTED) {
+            MCT_DAEMON_METRICS_ADD(metrics->errors, 1);
             func = mct_daemon_process_user_message_not_sup;
         } else {
             func = process_user_func[userheader->message];
         }
 
+        /* keep order of batched log messages and other user messages */
+        if (userheader->message != MCT_USER_MESSAGE_LOG) {
+            mct_daemon_client_batch_flush(daemon, daemon_local,
+                                          daemon_local->flags.vflag);
+        }
+
+        before = receiver->bytesRcvd;
+        messages++;
+
         if (func(daemon,
                  daemon_local,
                  receiver,
                  daemon_local->flags.vflag) == -1) {
             run_loop = 0;
+
+            /* a message which could not be parsed was dropped */
+            if (receiver->bytesRcvd < before) {
+                MCT_DAEMON_METRICS_ADD(metrics->errors, 1);
+            }
+        } else if (receiver->bytesRcvd < before) {
+            bytes += (unsigned long)(before - receiver->bytesRcvd);
+            MCT_DAEMON_METRICS_ADD(metrics->messages, 1);
+            MCT_DAEMON_METRICS_ADD(metrics->bytes, before - receiver->bytesRcvd);
         }
     }
 
+    /* forward all log messages collected in this iteration */
+    mct_daemon_client_batch_flush(daemon, daemon_local, daemon_local->flags.vflag);
+
     /* keep not read data in buffer */
     if (mct_receiver_move_to_begin(receiver) == -1) {
         mct_log(LOG_WARNING,
@@ -2618,6 +3284,9 @@ int mct_daemon_process_user_message_unregister_application(MctDaemon *daemon,
         return -1;
     }
 
+    /* contexts of the application are located by their sort order */
+    mct_daemon_user_list_sort(user_list);
+
     if (user_list->num_applications > 0) {
         /* Delete this application and all corresponding contexts
          * for this application from internal table.
@@ -2778,11 +3447,12 @@ int mct_daemon_process_user_message_log(MctDaemon *daemon,
         mct_vlog(LOG_ERR, "%s: invalid function parameters.\n", __func__);
         return MCT_DAEMON_ERROR_UNKNOWN;
     }
-    ret = mct_message_read(&(daemon_local->msg),
-                           (unsigned char *)rec->buf + sizeof(MctUserHeader),
-                           rec->bytesRcvd - sizeof(MctUserHeader),
-                           0,
-                           verbose);
+    /* the message is forwarded straight from the receiver buffer */
+    ret = mct_message_read_view(&(daemon_local->msg),
+                                (unsigned char *)rec->buf + sizeof(MctUserHeader),
+                                rec->bytesRcvd - sizeof(MctUserHeader),
+                                0,
+                                verbose);
 
     if (ret != MCT_MESSAGE_ERROR_OK) {
         if (ret != MCT_MESSAGE_ERROR_SIZE) {
@@ -2810,7 +3480,23 @@ int mct_daemon_process_user_message_log(MctDaemon *daemon,
         return MCT_DAEMON_ERROR_UNKNOWN;
     }
 
-    mct_daemon_client_send_message_to_all_client(daemon, daemon_local, verbose);
+    if (MCT_IS_HTYP_UEH(daemon_local->msg.standardheader->htyp)) {
+        MctDaemonContext *context =
+            mct_daemon_context_find(daemon,
+                                    daemon_local->msg.extendedheader->apid,
+                                    daemon_local->msg.extendedheader->ctid,
+                                    daemon->ecuid,
+                                    verbose);
+
+        if (context != NULL) {
+            MCT_DAEMON_METRICS_ADD(context->metrics.messages, 1);
+            MCT_DAEMON_METRICS_ADD(context->metrics.bytes,
+                                   daemon_local->msg.headersize - sizeof(MctStorageHeader) +
+                                   daemon_local->msg.datasize);
+        }
+    }
+
+    mct_daemon_client_batch_add(daemon, daemon_local, verbose);
 
     /* keep not read data in buffer */
     size = daemon_local->msg.headersize +
@@ -2867,6 +3553,9 @@ int mct_daemon_process_user_message_set_app_ll_ts(MctDaemon *daemon,
         return MCT_RETURN_ERROR;
     }
 
+    /* contexts of the application are located by their sort order */
+    mct_daemon_user_list_sort(user_list);
+
     if (user_list->num_applications > 0) {
         /* Get all contexts with application id matching the received application id */
         application = mct_daemon_application_find(daemon,
@@ -2893,10 +3582,11 @@ int mct_daemon_process_user_message_set_app_ll_ts(MctDaemon *daemon,
                     context->trace_status = userctxt.trace_status;   /* No endianess conversion necessary */
 
                     /* The following function sends also the trace status */
-                    if ((context->user_handle >= MCT_FD_MINIMUM) &&
-                        (mct_daemon_user_send_log_level(daemon,
-                                                        context,
-                                                        verbose) != 0)) {
+                    if (context->user_handle < MCT_FD_MINIMUM) {
+                        mct_daemon_context_changed(daemon, context, verbose);
+                    } else if (mct_daemon_user_send_log_level(daemon,
+                                                              context,
+                                                              verbose) != 0) {
                         context->log_level = old_log_level;
                         context->trace_status = old_trace_status;
                     }
@@ -2939,13 +3629,246 @@ int mct_daemon_process_user_message_marker(MctDaemon *daemon,
     return 0;
 }
 
+/**
+ * Get the connection types the replay is sent to, TCP and serial client
+ * connections allowed by the current filter.
+ *
+ * @param daemon_local pointer to MCT Daemon local structure
+ * @return connection type mask
+ */
+static int mct_daemon_replay_type_mask(MctDaemonLocal *daemon_local)
+{
+    int client_mask = MCT_FILTER_CLIENT_CONNECTION_DEFAULT_MASK;
+    int type_mask = MCT_CONNECTION_NONE;
+
+    client_mask |= daemon_local->pFilter.current->client_mask;
+
+    if (client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_TCP)) {
+        type_mask |= MCT_CON_MASK_CLIENT_MSG_TCP;
+    }
+
+    if (client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_SERIAL)) {
+        type_mask |= MCT_CON_MASK_CLIENT_MSG_SERIAL;
+    }
+
+    return type_mask;
+}
+
+/**
+ * Start sending the current replay chunk to all client connections. Each
+ * connection is watched for writability until it got the whole chunk,
+ * see mct_daemon_handle_event().
+ *
+ * @param daemon_local pointer to MCT Daemon local structure
+ * @return number of connections the chunk is sent to
+ */
+static int mct_daemon_replay_start(MctDaemonLocal *daemon_local)
+{
+    MctConnection *con = daemon_local->pEvent.connections;
+    int type_mask = mct_daemon_replay_type_mask(daemon_local);
+    int started = 0;
+
+    while ((con = mct_connection_get_next(con, type_mask)) != NULL) {
+        con->replay = 1;
+        con->replay_offset = 0;
+        mct_event_handler_update_mask(&daemon_local->pEvent, con, POLLIN | POLLOUT);
+        started++;
+        con = con->next;
+    }
+
+    return started;
+}
+
+/**
+ * Count the client connections which did not get the whole replay chunk yet.
+ *
+ * @param daemon_local pointer to MCT Daemon local structure
+ * @return number of connections
+ */
+static int mct_daemon_replay_get_pending(MctDaemonLocal *daemon_local)
+{
+    MctConnection *con = daemon_local->pEvent.connections;
+    int pending = 0;
+
+    while ((con = mct_connection_get_next(con,
+                                          MCT_CON_MASK_CLIENT_MSG_TCP |
+                                          MCT_CON_MASK_CLIENT_MSG_SERIAL)) != NULL) {
+        if (con->replay) {
+            pending++;
+        }
+
+        con = con->next;
+    }
+
+    return pending;
+}
+
+/**
+ * Count the messages of the replay chunk which end within a range of bytes.
+ *
+ * @param replay pointer to replay chunk
+ * @param from start of range, excluded
+ * @param to end of range, included
+ * @return number of messages
+ */
+static int mct_daemon_replay_count_messages(MctDaemonReplay *replay, uint32_t from, uint32_t to)
+{
+    int count = 0;
+    int i = 0;
+
+    for (i = 0; i < replay->count; i++) {
+        if ((replay->ends[i] > from) && (replay->ends[i] <= to)) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Append a message to the replay chunk, preceded by the serial header if
+ * configured.
+ *
+ * @param daemon pointer to MCT Daemon structure
+ * @param replay pointer to replay chunk
+ * @param data1 first part of message
+ * @param size1 size of first part
+ * @param data2 second part of message
+ * @param size2 size of second part
+ * @return 0 on success, -1 if the message does not fit into the chunk
+ */
+static int mct_daemon_replay_append(MctDaemon *daemon,
+                                    MctDaemonReplay *replay,
+                                    const void *data1,
+                                    size_t size1,
+                                    const void *data2,
+                                    size_t size2)
+{
+    size_t serial = daemon->sendserialheader ? sizeof(mctSerialHeader) : 0;
+
+    if ((replay->count >= MCT_DAEMON_REPLAY_MAX_MESSAGES) ||
+        (replay->size + serial + size1 + size2 > MCT_DAEMON_REPLAY_CHUNK_SIZE)) {
+        return -1;
+    }
+
+    if (serial > 0) {
+        memcpy(replay->data + replay->size, mctSerialHeader, serial);
+        replay->size += (uint32_t)serial;
+    }
+
+    memcpy(replay->data + replay->size, data1, size1);
+    replay->size += (uint32_t)size1;
+
+    if (size2 > 0) {
+        memcpy(replay->data + replay->size, data2, size2);
+        replay->size += (uint32_t)size2;
+    }
+
+    replay->ends[replay->count++] = replay->size;
+
+    return 0;
+}
+
+/**
+ * Move the oldest messages of the client ringbuffer into the replay chunk.
+ *
+ * @param daemon pointer to MCT Daemon structure
+ * @param replay pointer to replay chunk
+ * @return number of messages, negative value on error
+ */
+static int mct_daemon_replay_collect_ringbuffer(MctDaemon *daemon,
+                                                MctDaemonReplay *replay)
+{
+    struct iovec parts[2 * MCT_DAEMON_REPLAY_MAX_MESSAGES];
+    int count = 0;
+    int i = 0;
+
+    count = mct_buffer_get_vector(&(daemon->client_ringbuffer), parts,
+                                  MCT_DAEMON_REPLAY_MAX_MESSAGES,
+                                  MCT_DAEMON_REPLAY_CHUNK_SIZE);
+
+    if (count < 0) {
+        return count;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (mct_daemon_replay_append(daemon, replay,
+                                     parts[2 * i].iov_base, parts[2 * i].iov_len,
+                                     parts[2 * i + 1].iov_base, parts[2 * i + 1].iov_len) != 0) {
+            break;
+        }
+    }
+
+    if ((count > 0) && (replay->count == 0)) {
+        mct_vlog(LOG_WARNING, "%s: Buffered message too large (%zu), discarded\n",
+                 __func__, parts[0].iov_len + parts[1].iov_len);
+        mct_buffer_remove(&(daemon->client_ringbuffer));
+    }
+
+    for (i = 0; i < replay->count; i++) {
+        mct_buffer_remove(&(daemon->client_ringbuffer));
+    }
+
+    return replay->count;
+}
+
+/**
+ * Move the oldest spooled messages into the replay chunk.
+ *
+ * @param daemon pointer to MCT Daemon structure
+ * @param daemon_local pointer to MCT Daemon local structure
+ * @return number of messages, negative value on error
+ */
+static int mct_daemon_replay_collect_spool(MctDaemon *daemon,
+                                           MctDaemonLocal *daemon_local)
+{
+    static uint8_t data[MCT_DAEMON_REPLAY_CHUNK_SIZE];
+    MctDaemonReplay *replay = &(daemon_local->replay);
+    MctDaemonSpool *spool = &(daemon_local->spool);
+    uint32_t size = 0;
+    int length = 0;
+    int used = 0;
+
+    length = mct_daemon_spool_read(spool, data, sizeof(data));
+
+    while ((length < 0) && ((size = (uint32_t)mct_daemon_spool_get_next_size(spool)) > 0) &&
+           (size + sizeof(size) > sizeof(data))) {
+        mct_vlog(LOG_WARNING, "%s: Spooled message too large (%u), discarded\n",
+                 __func__, size);
+        mct_daemon_spool_remove(spool);
+        length = mct_daemon_spool_read(spool, data, sizeof(data));
+    }
+
+    if (length < 0) {
+        return -1;
+    }
+
+    /* each message is preceded by its size */
+    while (used < length) {
+        memcpy(&size, data + used, sizeof(size));
+
+        if (mct_daemon_replay_append(daemon, replay, data + used + sizeof(size), size,
+                                     NULL, 0) != 0) {
+            break;
+        }
+
+        used += (int)(sizeof(size) + size);
+    }
+
+    if (used > 0) {
+        mct_daemon_spool_consume(spool, used);
+        mct_daemon_spool_sync(spool);
+    }
+
+    return replay->count;
+}
+
 int mct_daemon_send_ringbuffer_to_client(MctDaemon *daemon,
                                          MctDaemonLocal *daemon_local,
                                          int verbose)
 {
-    int ret;
-    static uint8_t data[MCT_DAEMON_RCVBUFSIZE];
-    int length;
+    MctDaemonReplay *replay = NULL;
+    int count = 0;
 
     PRINT_FUNCTION_VERBOSE(verbose);
 
@@ -2956,39 +3879,176 @@ int mct_daemon_send_ringbuffer_to_client(MctDaemon *daemon,
         return MCT_DAEMON_ERROR_UNKNOWN;
     }
 
-    if (mct_buffer_get_message_count(&(daemon->client_ringbuffer)) <= 0) {
-        mct_daemon_change_state(daemon, MCT_DAEMON_STATE_SEND_DIRECT);
-        return MCT_DAEMON_ERROR_OK;
+    replay = &(daemon_local->replay);
+
+    if (replay->data == NULL) {
+        return MCT_DAEMON_ERROR_UNKNOWN;
     }
 
-    while ((length = mct_buffer_copy(&(daemon->client_ringbuffer), data, sizeof(data))) > 0) {
+    if (replay->size > 0) {
+        /* clients still getting the chunk continue when they are writable */
+        if (mct_daemon_replay_get_pending(daemon_local) > 0) {
+            return MCT_DAEMON_ERROR_OK;
+        }
 
-        if ((ret =
-                 mct_daemon_client_send(MCT_DAEMON_SEND_FORCE, daemon, daemon_local, 0, 0, data,
-                                        length, 0, 0,
-                                        verbose))) {
-            return ret;
+        /* all clients got lost before the chunk was sent, start it again */
+        if (!replay->delivered) {
+            mct_daemon_replay_start(daemon_local);
+            return MCT_DAEMON_ERROR_OK;
         }
 
-        mct_buffer_remove(&(daemon->client_ringbuffer));
+        replay->size = 0;
+        replay->count = 0;
+        replay->delivered = 0;
+    }
 
-        if (daemon->state != MCT_DAEMON_STATE_SEND_BUFFER) {
-            mct_daemon_change_state(daemon, MCT_DAEMON_STATE_SEND_BUFFER);
-        }
+    /* spooled messages are newer than all messages in the ring buffer */
+    if (mct_buffer_get_message_count(&(daemon->client_ringbuffer)) > 0) {
+        count = mct_daemon_replay_collect_ringbuffer(daemon, replay);
+    } else if (!mct_daemon_spool_is_empty(&(daemon_local->spool))) {
+        count = mct_daemon_replay_collect_spool(daemon, daemon_local);
+    }
+
+    if (count < 0) {
+        mct_log(LOG_ERR, "Can't read contents of ring buffer\n");
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
 
-        if (mct_buffer_get_message_count(&(daemon->client_ringbuffer)) <= 0) {
+    if (replay->count == 0) {
+        if ((mct_buffer_get_message_count(&(daemon->client_ringbuffer)) <= 0) &&
+            mct_daemon_spool_is_empty(&(daemon_local->spool)) &&
+            (mct_connection_get_next(daemon_local->pEvent.connections,
+                                     MCT_CON_MASK_CLIENT_MSG_TCP |
+                                     MCT_CON_MASK_CLIENT_MSG_SERIAL) != NULL)) {
             mct_daemon_change_state(daemon, MCT_DAEMON_STATE_SEND_DIRECT);
-            return MCT_DAEMON_ERROR_OK;
         }
+
+        return MCT_DAEMON_ERROR_OK;
+    }
+
+    if ((mct_daemon_replay_start(daemon_local) > 0) &&
+        (daemon->state != MCT_DAEMON_STATE_SEND_BUFFER)) {
+        mct_daemon_change_state(daemon, MCT_DAEMON_STATE_SEND_BUFFER);
     }
 
     return MCT_DAEMON_ERROR_OK;
 }
 
+int mct_daemon_send_ringbuffer_to_connection(MctDaemon *daemon,
+                                             MctDaemonLocal *daemon_local,
+                                             MctConnection *con,
+                                             int verbose)
+{
+    MctDaemonReplay *replay = NULL;
+    int ret = 0;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL) || (con == NULL) || (con->receiver == NULL)) {
+        mct_vlog(LOG_ERR, "%s: Invalid parameters\n", __func__);
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+
+    replay = &(daemon_local->replay);
+
+    /* e.g. connected while the chunk was sent, it gets the next one */
+    if (!con->replay || (replay->size == 0)) {
+        con->replay = 0;
+        mct_event_handler_update_mask(&daemon_local->pEvent, con, POLLIN);
+        return MCT_DAEMON_ERROR_OK;
+    }
+
+    if (con->replay_offset < replay->size) {
+        ret = mct_connection_send_nonblocking(con,
+                                              replay->data + con->replay_offset,
+                                              replay->size - con->replay_offset);
+
+        if (ret < 0) {
+            mct_vlog(LOG_WARNING, "%s: send mct messages failed\n", __func__);
+            MCT_DAEMON_METRICS_ADD(con->metrics.dropped,
+                                   mct_daemon_replay_count_messages(replay, con->replay_offset,
+                                                                    replay->size));
+            con->replay = 0;
+
+            if (con->type == MCT_CONNECTION_CLIENT_MSG_TCP) {
+                mct_daemon_close_socket(con->receiver->fd, daemon, daemon_local, verbose);
+            } else {
+                mct_event_handler_update_mask(&daemon_local->pEvent, con, POLLIN);
+            }
+
+            mct_daemon_send_ringbuffer_to_client(daemon, daemon_local, verbose);
+
+            return MCT_DAEMON_ERROR_SEND_FAILED;
+        }
+
+        MCT_DAEMON_METRICS_ADD(con->metrics.messages,
+                               mct_daemon_replay_count_messages(replay, con->replay_offset,
+                                                                con->replay_offset + (uint32_t)ret));
+        MCT_DAEMON_METRICS_ADD(con->metrics.bytes, ret);
+        con->replay_offset += (uint32_t)ret;
+
+        if (con->replay_offset < replay->size) {
+            return MCT_DAEMON_ERROR_OK;
+        }
+    }
+
+    con->replay = 0;
+    replay->delivered = 1;
+    mct_event_handler_update_mask(&daemon_local->pEvent, con, POLLIN);
+
+    /* the next chunk is started once all clients got this one */
+    return mct_daemon_send_ringbuffer_to_client(daemon, daemon_local, verbose);
+}
+
+void mct_daemon_replay_complete_message(MctDaemonLocal *daemon_local, int sock)
+{
+    MctDaemonReplay *replay = NULL;
+    MctConnection *con = NULL;
+    struct iovec iov;
+    int i = 0;
+
+    if (daemon_local == NULL) {
+        return;
+    }
+
+    replay = &(daemon_local->replay);
+    con = mct_event_handler_find_connection(&(daemon_local->pEvent), sock);
+
+    if ((con == NULL) || !con->replay || (replay->size == 0)) {
+        return;
+    }
+
+    /* a direct message must not be sent in the middle of a replayed one */
+    while ((i < replay->count) && (replay->ends[i] < con->replay_offset)) {
+        i++;
+    }
+
+    if ((i == replay->count) || (replay->ends[i] == con->replay_offset)) {
+        return;
+    }
+
+    iov.iov_base = replay->data + con->replay_offset;
+    iov.iov_len = replay->ends[i] - con->replay_offset;
+
+    if (mct_connection_send_vector(con, &iov, 1) == MCT_DAEMON_ERROR_OK) {
+        MCT_DAEMON_METRICS_ADD(con->metrics.messages, 1);
+        MCT_DAEMON_METRICS_ADD(con->metrics.bytes, iov.iov_len);
+        con->replay_offset = replay->ends[i];
+    }
+}
+
 int create_timer_fd(MctDaemonLocal *daemon_local,
                     int period_sec,
                     int starts_in,
                     MctTimers timer_id)
+{
+    return create_timer_fd_ms(daemon_local, period_sec * 1000, starts_in * 1000, timer_id);
+}
+
+int create_timer_fd_ms(MctDaemonLocal *daemon_local,
+                       int period_ms,
+                       int starts_in_ms,
+                       MctTimers timer_id)
 {
     int local_fd = MCT_FD_INIT;
     char *timer_name = NULL;
@@ -3005,7 +4065,7 @@ int create_timer_fd(MctDaemonLocal *daemon_local,
         return -1;
     }
 
-    if ((period_sec <= 0) || (starts_in <= 0)) {
+    if ((period_ms <= 0) || (starts_in_ms <= 0)) {
         /* timer not activated via the service file */
         mct_vlog(LOG_INFO, "<%s> not set: period=0\n", timer_name);
         local_fd = MCT_FD_INIT;
@@ -3019,10 +4079,10 @@ int create_timer_fd(MctDaemonLocal *daemon_local,
                      timer_name, strerror(errno));
         }
 
-        l_timer_spec.it_interval.tv_sec = period_sec;
-        l_timer_spec.it_interval.tv_nsec = 0;
-        l_timer_spec.it_value.tv_sec = starts_in;
-        l_timer_spec.it_value.tv_nsec = 0;
+        l_timer_spec.it_interval.tv_sec = period_ms / 1000;
+        l_timer_spec.it_interval.tv_nsec = (long)(period_ms % 1000) * 1000000L;
+        l_timer_spec.it_value.tv_sec = starts_in_ms / 1000;
+        l_timer_spec.it_value.tv_nsec = (long)(starts_in_ms % 1000) * 1000000L;
 
         if (timerfd_settime(local_fd, 0, &l_timer_spec, NULL) < 0) {
             mct_vlog(LOG_WARNING, "<%s> timerfd_settime failed: %s\n",
@@ -3036,8 +4096,13 @@ int create_timer_fd(MctDaemonLocal *daemon_local,
      * Event handling registration is done later on with other connections.
      */
     if (local_fd > 0) {
-        mct_vlog(LOG_INFO, "<%s> initialized with %d timer\n", timer_name,
-                 period_sec);
+        if (period_ms % 1000 == 0) {
+            mct_vlog(LOG_INFO, "<%s> initialized with %d timer\n", timer_name,
+                     period_ms / 1000);
+        } else {
+            mct_vlog(LOG_INFO, "<%s> initialized with %d ms timer\n", timer_name,
+                     period_ms);
+        }
     }
 
     return mct_connection_create(daemon_local,
@@ -10,6 +10,9 @@
 #include "mct_daemon_event_handler_types.h"
 #include "mct_daemon_filter_types.h"
 #include "mct_offline_trace.h"
+#include "mct_daemon_udp_socket.h"
+#include "mct_daemon_spool.h"
+#include "mct-daemon_cfg.h"
 
 #define MCT_DAEMON_FLAG_MAX 256
 
@@ -34,6 +37,7 @@ typedef struct
     char bvalue[NAME_MAX + 1];                          /**< (String: Baudrate) Serial device baudrate (Default: 115200) */
     char yvalue[NAME_MAX + 1];                          /**< (String: Devicename) Additional support for serial device */
     char ivalue[NAME_MAX + 1];                          /**< (String: Directory) Directory where to store the persistant configuration (Default: /tmp) */
+    int persistanceStorageFormat;                       /**< (int) Format of the persistant configuration: 0 = text, 1 = binary (Default: 1) */
     char cvalue[NAME_MAX + 1];                          /**< (String: Directory) Filename of MCT configuration file (Default: /etc/mct.conf) */
     int sharedMemorySize;                               /**< (int) Size of shared memory (Default: 100000) */
     int sendMessageTime;                                /**< (Boolean) Send periodic Message Time if client is connected (Default: 0) */
@@ -41,6 +45,7 @@ typedef struct
     int offlineTraceFileSize;                           /**< (int) Maximum size in bytes of one trace file (Default: 1000000) */
     int offlineTraceMaxSize;                            /**< (int) Maximum size of all trace files (Default: 4000000) */
     int offlineTraceFilenameTimestampBased;             /**< (int) timestamp based or index based (Default: 1 Timestamp based) */
+    int offlineTraceCompression;                        /**< (Boolean) write compressed blocks of messages (Default: 0) */
     int loggingMode;                                    /**< (int) The logging console for internal logging of mct-daemon (Default: 0) */
     int loggingLevel;                                   /**< (int) The logging level for internal logging of mct-daemon (Default: 6) */
     char loggingFilename[MCT_DAEMON_FLAG_MAX];          /**< (String: Filename) The logging filename if internal logging mode is log to file (Default: /tmp/log) */
@@ -54,7 +59,11 @@ typedef struct
     unsigned int offlineLogstorageMaxCounter;           /**< (int) Maximum offline logstorage file counter index until wraparound  */
     unsigned int offlineLogstorageMaxCounterIdx;        /**< (int) String len of  offlineLogstorageMaxCounter*/
     unsigned int offlineLogstorageCacheSize;            /**< (int) Max cache size offline logstorage cache */
+    char offlineLogstorageCacheDir[MCT_MOUNT_PATH_MAX]; /**< (String: Directory) DIR path of files keeping the logstorage caches, relative to the device if not absolute */
     int offlineLogstorageOptionalCounter;               /**< (Boolean) Do not append index to filename if NOFiles=1 */
+    unsigned long offlineLogstorageQueueSize;           /**< (int) Queue size of logstorage writer threads, 0 to write in event loop */
+    int offlineLogstorageQueuePolicy;                   /**< (Boolean) Wait for writer thread if queue is full instead of discarding */
+    unsigned long offlineLogstorageSyncInterval;        /**< (int) Period in ms of syncing ON_TIMER log files, 0 to disable */
 #ifdef MCT_DAEMON_USE_UNIX_SOCKET_IPC
     char appSockPath[MCT_DAEMON_FLAG_MAX]; /**< Path to User socket */
 #else /* MCT_DAEMON_USE_FIFO_IPC */
@@ -74,6 +83,58 @@ typedef struct
     char msgFilterConfFile[MCT_DAEMON_FLAG_MAX]; /**< Filter config file path */
     int blockModeAllowed;                        /** (int) The BlockMode Allowance flag (Default: 0 - Not allowed) */
 } MctDaemonFlags;
+/**
+ * One message collected in a batch of the mct daemon.
+ */
+typedef struct
+{
+    MctStorageHeader storageheader; /**< storage header of the message */
+    uint8_t *header;                /**< standard header, header extras and extended header */
+    int headersize;                 /**< size of header */
+    uint8_t *data;                  /**< payload of the message */
+    int datasize;                   /**< size of payload */
+    int skip_network;               /**< (Boolean) network routing disabled by logstorage */
+} MctDaemonBatchEntry;
+
+/**
+ * Chunk of buffered messages replayed to the clients. The messages are taken
+ * out of the ring buffer or spool, every client connection keeps its own
+ * position in the chunk, see MctConnection.
+ */
+typedef struct
+{
+    uint8_t *data;                                 /**< replayed messages, serial headers included */
+    uint32_t size;                                 /**< size of chunk, 0 if no chunk is replayed */
+    int count;                                     /**< number of messages in chunk */
+    uint32_t ends[MCT_DAEMON_REPLAY_MAX_MESSAGES]; /**< end offset of each message in chunk */
+    int delivered;                                 /**< (Boolean) chunk was sent completely to a client */
+} MctDaemonReplay;
+
+/**
+ * Messages parsed within one event loop iteration, forwarded to all sinks at once.
+ */
+typedef struct
+{
+    MctDaemonBatchEntry *entries; /**< collected messages */
+    int count;                    /**< number of collected messages */
+    int max_count;                /**< maximum number of messages in one batch */
+    uint8_t *buffer;              /**< storage for headers and payloads of collected messages */
+    uint32_t used;                /**< used bytes in buffer */
+    uint32_t size;                /**< size of buffer */
+} MctDaemonMessageBatch;
+
+/**
+ * State of the overload control.
+ */
+typedef struct
+{
+    int load;               /**< load in percent at the last check */
+    unsigned int calm;      /**< seconds the load stayed below the low watermark */
+    int throttled;          /**< contexts with lowered log level remain */
+    int blocking;           /**< applications were switched to blocking mode */
+    uint64_t lost;          /**< overflowed, evicted and dropped messages at the last check */
+} MctDaemonOverload;
+
 /**
  * The global parameters of a mct daemon.
  */
@@ -83,6 +144,7 @@ typedef struct
     MctFile file;                    /**< struct for file access */
     MctEventHandler pEvent;          /**< struct for message producer event handling */
     MctMessage msg;                  /**< one mct message */
+    MctDaemonMessageBatch batch;     /**< messages to be forwarded to all sinks at once */
     int client_connections;          /**< counter for nr. of client connections */
     int internal_client_connections; /**< counter for nr. of internal client connections */
     size_t baudrate;                 /**< Baudrate of serial connection */
@@ -92,7 +154,30 @@ typedef struct
     unsigned long RingbufferMinSize;
     unsigned long RingbufferMaxSize;
     unsigned long RingbufferStepSize;
+    char RingbufferSpoolDirectory[MCT_PATH_MAX]; /**< spool directory, spool is off if empty */
+    unsigned long RingbufferSpoolSegmentSize;    /**< maximum size of one spool segment */
+    unsigned long RingbufferSpoolMaxSize;        /**< maximum size of all spool segments */
+    MctDaemonSpool spool;            /**< disk spool taking over when the ring buffer is full */
+    MctDaemonReplay replay;          /**< buffered messages being replayed to the clients */
     unsigned long daemonFifoSize;
+    unsigned long RecvBufSizeApp;    /**< receive buffer size of application connections */
+    unsigned long RecvBufSizeSocket; /**< receive buffer size of client socket connections */
+    unsigned long RecvBufSizeSerial; /**< receive buffer size of serial connections */
+    unsigned long AppReadBudgetMessages; /**< messages processed per application connection and poll round, 0 for no limit */
+    unsigned long AppReadBudgetBytes;    /**< bytes processed per application connection and poll round, 0 for no limit */
+    int OverloadControl;                 /**< (Boolean) lower log levels of the noisiest contexts on overload */
+    unsigned long OverloadHighWatermark; /**< load in percent above which log levels are lowered */
+    unsigned long OverloadLowWatermark;  /**< load in percent below which log levels are restored */
+    unsigned long OverloadThrottleLevel; /**< log level the noisiest contexts are lowered to */
+    unsigned long OverloadContexts;      /**< contexts lowered or restored per second */
+    unsigned long OverloadRestoreTime;   /**< seconds below the low watermark before restoring */
+    int OverloadBlockMode;               /**< (Boolean) switch applications to blocking mode if lowering is not enough */
+    MctDaemonOverload overload;          /**< state of the overload control */
+    int UDPConnectionSetup;          /**< (Boolean) UDP multicast output enabled */
+    char UDPMulticastIPAddress[INET_ADDRSTRLEN]; /**< multicast group address */
+    int UDPMulticastIPPort;          /**< multicast port */
+    int UDPMulticastTTL;             /**< time to live of multicast datagrams */
+    MctDaemonUdpMulticast udp;       /**< UDP multicast output channel */
 
     MctMessageFilter pFilter; /**< struct for message filter handling */
 } MctDaemonLocal;
@@ -145,6 +230,13 @@ int mct_daemon_process_user_messages(MctDaemon *daemon,
                                      MctDaemonLocal *daemon_local,
                                      MctReceiver *recv,
                                      int verbose);
+int mct_daemon_log_internal(MctDaemon *daemon,
+                            MctDaemonLocal *daemon_local,
+                            char *str,
+                            int verbose);
+void mct_daemon_overload_check(MctDaemon *daemon,
+                               MctDaemonLocal *daemon_local,
+                               int verbose);
 int mct_daemon_process_one_s_timer(MctDaemon *daemon,
                                    MctDaemonLocal *daemon_local,
                                    MctReceiver *recv,
@@ -153,6 +245,10 @@ int mct_daemon_process_sixty_s_timer(MctDaemon *daemon,
                                      MctDaemonLocal *daemon_local,
                                      MctReceiver *recv,
                                      int verbose);
+int mct_daemon_process_logstorage_timer(MctDaemon *daemon,
+                                        MctDaemonLocal *daemon_local,
+                                        MctReceiver *recv,
+                                        int verbose);
 int mct_daemon_process_systemd_timer(MctDaemon *daemon,
                                      MctDaemonLocal *daemon_local,
                                      MctReceiver *recv,
@@ -214,10 +310,16 @@ int mct_daemon_process_user_message_marker(MctDaemon *daemon,
 int mct_daemon_send_ringbuffer_to_client(MctDaemon *daemon,
                                          MctDaemonLocal *daemon_local,
                                          int verbose);
+int mct_daemon_send_ringbuffer_to_connection(MctDaemon *daemon,
+                                             MctDaemonLocal *daemon_local,
+                                             MctConnection *con,
+                                             int verbose);
+void mct_daemon_replay_complete_message(MctDaemonLocal *daemon_local, int sock);
 void mct_daemon_timingpacket_thread(void *ptr);
 void mct_daemon_ecu_version_thread(void *ptr);
 
 int create_timer_fd(MctDaemonLocal *daemon_local, int period_sec, int starts_in, MctTimers timer);
+int create_timer_fd_ms(MctDaemonLocal *daemon_local, int period_ms, int starts_in_ms, MctTimers timer);
 
 int mct_daemon_close_socket(int sock, MctDaemon *daemon, MctDaemonLocal *daemon_local, int verbose);
 int mct_daemon_client_update(MctDaemon *daemon, MctDaemonLocal *daemon_local, int verbose);
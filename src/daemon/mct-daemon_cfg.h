@@ -15,11 +15,71 @@
 #define MCT_SHM_RCV_BUFFER_SIZE     10000
 /* Size of receive buffer for fifo connection  (from user application) */
 #define MCT_DAEMON_RCVBUFSIZE       10024
+/* Size of receive buffer for application connections */
+#define MCT_DAEMON_RCVBUFSIZEAPP    MCT_RECEIVE_BUFSIZE
 /* Size of receive buffer for socket connection (from mct client) */
 #define MCT_DAEMON_RCVBUFSIZESOCK   10024
 /* Size of receive buffer for serial connection (from mct client) */
 #define MCT_DAEMON_RCVBUFSIZESERIAL 10024
 
+/* Number of messages and bytes processed per application connection in one
+ * poll round, 0 for no limit. A connection over budget is continued in the
+ * next round, which serves it once like every other ready connection */
+#define MCT_DAEMON_APP_READ_BUDGET_MESSAGES 256
+#define MCT_DAEMON_APP_READ_BUDGET_BYTES    0
+
+/* Overload control: fill level in percent above which the log levels of the
+ * noisiest contexts are lowered and below which they are restored again */
+#define MCT_DAEMON_OVERLOAD_HIGH_WATERMARK 80
+#define MCT_DAEMON_OVERLOAD_LOW_WATERMARK  50
+/* Log level the noisiest contexts are lowered to */
+#define MCT_DAEMON_OVERLOAD_THROTTLE_LEVEL MCT_LOG_WARN
+/* Number of contexts lowered or restored per second */
+#define MCT_DAEMON_OVERLOAD_CONTEXTS       4
+#define MCT_DAEMON_OVERLOAD_CONTEXTS_MAX   64
+/* Seconds the load must stay below the low watermark before restoring */
+#define MCT_DAEMON_OVERLOAD_RESTORE_TIME   10
+
+/* Size in bytes of the queue between event loop and writer thread of each
+ * offline logstorage device, 0 to write from the event loop */
+#define MCT_DAEMON_LOGSTORAGE_QUEUE_SIZE   (1024 * 1024)
+
+/* Time in ms the event loop waits for room in the queue of a logstorage
+ * device before the device is considered stalled */
+#define MCT_DAEMON_LOGSTORAGE_QUEUE_TIMEOUT 1000
+
+/* Time in ms the event loop waits for the logstorage devices to write their
+ * caches on a sync request before it answers without them */
+#define MCT_DAEMON_LOGSTORAGE_SYNC_TIMEOUT 5000
+
+/* Period in ms of writing the log files of ON_TIMER logstorage filters to
+ * the device, 0 to disable the timer */
+#define MCT_DAEMON_LOGSTORAGE_SYNC_INTERVAL 1000
+
+/* Maximum number of messages collected in one batch before it is forwarded.
+ * Each message takes up to three iovec entries when sent to a client,
+ * so this must stay below IOV_MAX / 3 */
+#define MCT_DAEMON_BATCH_MAX_MESSAGES 256
+/* Size of the buffer holding headers and payloads of one batch */
+#define MCT_DAEMON_BATCH_BUFSIZE    MCT_RECEIVE_BUFSIZE
+
+/* Maximum number of buffered messages replayed to clients in one chunk */
+#define MCT_DAEMON_REPLAY_MAX_MESSAGES 256
+/* Size of the staging buffer of a replay chunk, must hold the largest message.
+ * Each client is sent as much of the chunk as it takes whenever it is writable,
+ * so live messages are handled in between */
+#define MCT_DAEMON_REPLAY_CHUNK_SIZE   (256 * 1024)
+
+/* Default UDP multicast group address */
+#define MCT_DAEMON_UDP_MULTICAST_IP   "225.0.0.37"
+/* Default UDP multicast port */
+#define MCT_DAEMON_UDP_MULTICAST_PORT 3491
+/* Default time to live of UDP multicast datagrams */
+#define MCT_DAEMON_UDP_MULTICAST_TTL  1
+/* Maximum size of one UDP multicast datagram including its header.
+ * Batches are split into several datagrams to stay below this size */
+#define MCT_DAEMON_UDP_MAX_DATAGRAM_SIZE 1472
+
 /* Size of buffer for text output */
 #define MCT_DAEMON_TEXTSIZE         10024
 
@@ -11,6 +11,8 @@
 #include <syslog.h>
 #include <errno.h>
 #include <pthread.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
 
 #ifdef linux
 #include <sys/timerfd.h>
@@ -118,6 +120,13 @@ static int mct_daemon_client_send_all_multiple(MctDaemon *daemon,
                                            size2,
                                            daemon->sendserialheader);
 
+        if (ret != MCT_DAEMON_ERROR_OK) {
+            MCT_DAEMON_METRICS_ADD(temp->metrics.dropped, 1);
+        } else {
+            MCT_DAEMON_METRICS_ADD(temp->metrics.messages, 1);
+            MCT_DAEMON_METRICS_ADD(temp->metrics.bytes, size1 + size2);
+        }
+
         if ((ret != MCT_DAEMON_ERROR_OK) &&
             (MCT_CONNECTION_CLIENT_MSG_TCP == temp->type)) {
             mct_daemon_close_socket(temp->receiver->fd,
@@ -139,6 +148,196 @@ static int mct_daemon_client_send_all_multiple(MctDaemon *daemon,
     return sent;
 }
 
+/** mct_daemon_client_get_priority
+ *
+ * Get the priority of a message in the client ringbuffer. Log messages are
+ * ranked by their log level, control messages are never evicted and all
+ * other messages are ranked like info messages.
+ *
+ * @param header message header, starting with the standard header
+ * @param size size of message header
+ * @return priority, 0 is the most important one
+ */
+static unsigned char mct_daemon_client_get_priority(const uint8_t *header, int size)
+{
+    const MctStandardHeader *standardheader = (const MctStandardHeader *)header;
+    const MctExtendedHeader *extendedheader = NULL;
+    int offset = 0;
+    int mtin = 0;
+
+    if ((header == NULL) || (size < (int)sizeof(MctStandardHeader)) ||
+        !MCT_IS_HTYP_UEH(standardheader->htyp)) {
+        return MCT_LOG_INFO;
+    }
+
+    offset = (int)sizeof(MctStandardHeader) + MCT_STANDARD_HEADER_EXTRA_SIZE(standardheader->htyp);
+
+    if (size < offset + (int)sizeof(MctExtendedHeader)) {
+        return MCT_LOG_INFO;
+    }
+
+    extendedheader = (const MctExtendedHeader *)(header + offset);
+
+    switch (MCT_GET_MSIN_MSTP(extendedheader->msin)) {
+    case MCT_TYPE_LOG:
+        mtin = MCT_GET_MSIN_MTIN(extendedheader->msin);
+
+        if ((mtin >= MCT_LOG_FATAL) && (mtin <= MCT_LOG_VERBOSE)) {
+            return (unsigned char)mtin;
+        }
+
+        return MCT_LOG_INFO;
+    case MCT_TYPE_CONTROL:
+        return MCT_LOG_OFF;
+    default:
+        return MCT_LOG_INFO;
+    }
+}
+
+/** mct_daemon_client_store
+ *
+ * Store one message in the client ringbuffer. If the ringbuffer is full,
+ * the message is appended to the spool. Once the spool holds messages,
+ * all newer messages are appended to it as well to keep the order.
+ * Without spool, messages of a lower log level are evicted from the
+ * ringbuffer to make room for the message.
+ *
+ * @param daemon Pointer to MCT Daemon structure
+ * @param daemon_local Pointer to MCT Daemon local structure
+ * @param data1 message header
+ * @param size1 size of message header
+ * @param data2 message payload
+ * @param size2 size of message payload
+ * @return MCT_RETURN_OK if stored, negative value if message must be discarded
+ */
+static int mct_daemon_client_store(MctDaemon *daemon,
+                                   MctDaemonLocal *daemon_local,
+                                   void *data1,
+                                   int size1,
+                                   void *data2,
+                                   int size2)
+{
+    unsigned char priority = 0;
+
+    if (mct_daemon_spool_is_empty(&(daemon_local->spool))) {
+        priority = mct_daemon_client_get_priority(data1, size1);
+
+        if (mct_buffer_push3_priority(&(daemon->client_ringbuffer), priority,
+                                      data1, (unsigned int)size1,
+                                      data2, (unsigned int)size2, 0, 0) == MCT_RETURN_OK) {
+            return MCT_RETURN_OK;
+        }
+
+        if (!mct_daemon_spool_is_enabled(&(daemon_local->spool))) {
+            if ((mct_buffer_evict(&(daemon->client_ringbuffer), priority, size1 + size2,
+                                  daemon->evicted_counter) == MCT_RETURN_OK) &&
+                (mct_buffer_push3_priority(&(daemon->client_ringbuffer), priority,
+                                           data1, (unsigned int)size1,
+                                           data2, (unsigned int)size2, 0, 0) == MCT_RETURN_OK)) {
+                return MCT_RETURN_OK;
+            }
+
+            return MCT_RETURN_BUFFER_FULL;
+        }
+    }
+
+    return mct_daemon_spool_push(&(daemon_local->spool), data1, (uint32_t)size1,
+                                 data2, (uint32_t)size2);
+}
+
+/** mct_daemon_client_is_buffering
+ *
+ * Check if messages are stored in the client ringbuffer instead of being
+ * sent to the clients.
+ *
+ * @param daemon Pointer to MCT Daemon structure
+ * @return 1 if messages are buffered, 0 otherwise
+ */
+static int mct_daemon_client_is_buffering(MctDaemon *daemon)
+{
+    return (daemon->state == MCT_DAEMON_STATE_BUFFER) ||
+           (daemon->state == MCT_DAEMON_STATE_SEND_BUFFER) ||
+           (daemon->state == MCT_DAEMON_STATE_BUFFER_FULL);
+}
+
+/** mct_daemon_client_buffer
+ *
+ * Store a message which was not sent to the clients in the client
+ * ringbuffer, also when it is full as less important messages might be
+ * evicted. A message which cannot be stored is counted as overflow.
+ *
+ * @param daemon Pointer to MCT Daemon structure
+ * @param daemon_local Pointer to MCT Daemon local structure
+ * @param data1 message header
+ * @param size1 size of message header
+ * @param data2 message payload
+ * @param size2 size of message payload
+ * @return MCT_DAEMON_ERROR_OK if stored, MCT_DAEMON_ERROR_BUFFER_FULL if discarded
+ */
+static int mct_daemon_client_buffer(MctDaemon *daemon,
+                                    MctDaemonLocal *daemon_local,
+                                    void *data1,
+                                    int size1,
+                                    void *data2,
+                                    int size2)
+{
+    if (mct_daemon_client_store(daemon, daemon_local, data1, size1, data2, size2) >= MCT_RETURN_OK) {
+        return MCT_DAEMON_ERROR_OK;
+    }
+
+    if (daemon->state != MCT_DAEMON_STATE_BUFFER_FULL) {
+        mct_daemon_change_state(daemon, MCT_DAEMON_STATE_BUFFER_FULL);
+    }
+
+    daemon->overflow_counter += 1;
+
+    if (daemon->overflow_counter == 1) {
+        mct_vlog(LOG_INFO, "%s: Buffer is full! Messages will be discarded.\n", __func__);
+    }
+
+    return MCT_DAEMON_ERROR_BUFFER_FULL;
+}
+
+/** mct_daemon_client_notify_overflow
+ *
+ * Tell the clients how many messages were discarded while the client
+ * ringbuffer was full, once messages are sent to them again.
+ *
+ * @param daemon Pointer to MCT Daemon structure
+ * @param daemon_local Pointer to MCT Daemon local structure
+ * @param verbose if set to true verbose information is printed out
+ */
+static void mct_daemon_client_notify_overflow(MctDaemon *daemon,
+                                              MctDaemonLocal *daemon_local,
+                                              int verbose)
+{
+    /* the notification is sent through mct_daemon_client_send() itself */
+    static int sent_message_overflow_cnt = 0;
+
+    if ((daemon->overflow_counter == 0) ||
+        (daemon_local->client_connections == 0)) {
+        return;
+    }
+
+    sent_message_overflow_cnt++;
+
+    if (sent_message_overflow_cnt >= 2) {
+        sent_message_overflow_cnt--;
+        return;
+    }
+
+    if (mct_daemon_send_message_overflow(daemon, daemon_local,
+                                         verbose) == MCT_DAEMON_ERROR_OK) {
+        mct_vlog(LOG_WARNING,
+                 "%s: %u messages discarded! Now able to send messages to the client.\n",
+                 __func__,
+                 daemon->overflow_counter);
+        daemon->overflow_total += daemon->overflow_counter;
+        daemon->overflow_counter = 0;
+        sent_message_overflow_cnt--;
+    }
+}
+
 int mct_daemon_client_send(int sock,
                            MctDaemon *daemon,
                            MctDaemonLocal *daemon_local,
@@ -153,7 +352,6 @@ int mct_daemon_client_send(int sock,
     int sent, ret;
     int ret_logstorage = 0;
     int client_mask = MCT_FILTER_CLIENT_CONNECTION_DEFAULT_MASK;
-    static int sent_message_overflow_cnt = 0;
 
     if ((daemon == NULL) || (daemon_local == NULL)) {
         mct_vlog(LOG_ERR, "%s: Invalid arguments\n", __func__);
@@ -169,7 +367,10 @@ int mct_daemon_client_send(int sock,
          * connection or not. Currently, the MCT Viewer receives some daemon
          * status messages also in states where no log messages are received */
 
-        /* Send message to specific socket */
+        /* Send message to specific socket, after the replayed message
+         * which is partly sent to it */
+        mct_daemon_replay_complete_message(daemon_local, sock);
+
         if (isatty(sock)) {
             if ((ret =
                      mct_daemon_serial_send(sock, data1, size1, data2, size2,
@@ -190,10 +391,10 @@ int mct_daemon_client_send(int sock,
     }
 
     /* write message to offline trace */
-    /* In the SEND_BUFFER state we must skip offline tracing because the offline traces */
-    /* are going without buffering directly to the offline trace. Thus we have to filter out */
-    /* the traces that are coming from the buffer. */
-    if ((sock != MCT_DAEMON_SEND_FORCE) && (daemon->state != MCT_DAEMON_STATE_SEND_BUFFER)) {
+    /* Messages replayed from the buffer are sent with MCT_DAEMON_SEND_FORCE and must skip */
+    /* offline tracing because the offline traces are going without buffering directly to */
+    /* the offline trace. Live messages arriving during the replay are still traced. */
+    if (sock != MCT_DAEMON_SEND_FORCE) {
         if ((client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_OFFLINE_TRACE)) &&
             daemon_local->flags.offlineTraceDirectory[0]) {
             if (mct_offline_trace_write(&(daemon_local->offlineTrace), storage_header,
@@ -224,6 +425,12 @@ int mct_daemon_client_send(int sock,
                                                          data2,
                                                          size2);
         }
+
+        /* send message to multicast group if network routing is not disabled */
+        if ((client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_UDP)) &&
+            (daemon_local->udp.sock >= 0) && (ret_logstorage != 1)) {
+            mct_daemon_udp_send(&daemon_local->udp, data1, size1, data2, size2);
+        }
     }
 
     /* send messages to daemon socket */
@@ -249,65 +456,33 @@ int mct_daemon_client_send(int sock,
     }
 
     /* Message was not sent to client, so store it in client ringbuffer */
-    if ((sock != MCT_DAEMON_SEND_FORCE) &&
-        ((daemon->state == MCT_DAEMON_STATE_BUFFER) ||
-         (daemon->state == MCT_DAEMON_STATE_SEND_BUFFER) ||
-         (daemon->state == MCT_DAEMON_STATE_BUFFER_FULL))) {
-        if (daemon->state != MCT_DAEMON_STATE_BUFFER_FULL) {
-            /* Store message in history buffer */
-            ret = mct_buffer_push3(&(daemon->client_ringbuffer), data1, size1, data2, size2, 0, 0);
-            if (ret < MCT_RETURN_OK) {
-                mct_daemon_change_state(daemon, MCT_DAEMON_STATE_BUFFER_FULL);
-            }
-        }
-
-        if (daemon->state == MCT_DAEMON_STATE_BUFFER_FULL) {
-            daemon->overflow_counter += 1;
-
-            if (daemon->overflow_counter == 1) {
-                mct_vlog(LOG_INFO, "%s: Buffer is full! Messages will be discarded.\n", __func__);
-            }
-
-            return MCT_DAEMON_ERROR_BUFFER_FULL;
-        }
-    } else {
-        if ((daemon->overflow_counter > 0) &&
-            (daemon_local->client_connections > 0)) {
-            sent_message_overflow_cnt++;
-            if (sent_message_overflow_cnt >= 2) {
-                sent_message_overflow_cnt--;
-            }
-            else {
-                if (mct_daemon_send_message_overflow(daemon, daemon_local,
-                                          verbose) == MCT_DAEMON_ERROR_OK) {
-                    mct_vlog(LOG_WARNING,
-                             "%s: %u messages discarded! Now able to send messages to the client.\n",
-                             __func__,
-                             daemon->overflow_counter);
-                    daemon->overflow_counter = 0;
-                    sent_message_overflow_cnt--;
-                }
-            }
-        }
+    if ((sock != MCT_DAEMON_SEND_FORCE) && mct_daemon_client_is_buffering(daemon)) {
+        return mct_daemon_client_buffer(daemon, daemon_local, data1, size1, data2, size2);
     }
 
+    mct_daemon_client_notify_overflow(daemon, daemon_local, verbose);
+
     return MCT_DAEMON_ERROR_OK;
 }
 
-int mct_daemon_client_send_message_to_all_client(MctDaemon *daemon,
-                                                 MctDaemonLocal *daemon_local,
-                                                 int verbose)
+/** @brief Prepare the currently parsed message for forwarding.
+ *
+ * Overwrites the ECU id if configured, sets the storage header and prints
+ * the message if requested by the daemon flags.
+ *
+ * @param daemon Daemon structure
+ * @param daemon_local Daemon local structure holding the parsed message
+ * @param verbose If set to true verbose information is printed out.
+ *
+ * @return MCT_DAEMON_ERROR_OK on success, MCT_DAEMON_ERROR_UNKNOWN otherwise.
+ */
+static int mct_daemon_client_prepare_message(MctDaemon *daemon,
+                                             MctDaemonLocal *daemon_local,
+                                             int verbose)
 {
     static char text[MCT_DAEMON_TEXTSIZE];
     char *ecu_ptr = NULL;
 
-    PRINT_FUNCTION_VERBOSE(verbose);
-
-    if ((daemon == NULL) || (daemon_local == NULL)) {
-        mct_vlog(LOG_ERR, "%s: invalid arguments\n", __func__);
-        return MCT_DAEMON_ERROR_UNKNOWN;
-    }
-
     /* set overwrite ecu id */
     if ((daemon_local->flags.evalue[0]) &&
         (strncmp(daemon_local->msg.headerextra.ecu,
@@ -362,14 +537,438 @@ int mct_daemon_client_send_message_to_all_client(MctDaemon *daemon,
         }
     }
 
+    return MCT_DAEMON_ERROR_OK;
+}
+
+int mct_daemon_client_send_message_to_all_client(MctDaemon *daemon,
+                                                 MctDaemonLocal *daemon_local,
+                                                 int verbose)
+{
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL)) {
+        mct_vlog(LOG_ERR, "%s: invalid arguments\n", __func__);
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+
+    if (mct_daemon_client_prepare_message(daemon, daemon_local, verbose) !=
+        MCT_DAEMON_ERROR_OK) {
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+
     /* send message to client or write to log file */
     return mct_daemon_client_send(MCT_DAEMON_SEND_TO_ALL, daemon, daemon_local,
                                   daemon_local->msg.headerbuffer, sizeof(MctStorageHeader),
-                                  daemon_local->msg.headerbuffer + sizeof(MctStorageHeader),
+                                  (uint8_t *)daemon_local->msg.standardheader,
                                   daemon_local->msg.headersize - sizeof(MctStorageHeader),
                                   daemon_local->msg.databuffer, daemon_local->msg.datasize, verbose);
 }
 
+int mct_daemon_client_batch_init(MctDaemonMessageBatch *batch,
+                                 int max_count,
+                                 uint32_t size)
+{
+    if ((batch == NULL) || (max_count <= 0) || (size == 0)) {
+        return MCT_RETURN_WRONG_PARAMETER;
+    }
+
+    batch->entries = calloc((size_t)max_count, sizeof(MctDaemonBatchEntry));
+    batch->buffer = malloc(size);
+
+    if ((batch->entries == NULL) || (batch->buffer == NULL)) {
+        mct_log(LOG_ERR, "Cannot allocate memory for message batch\n");
+        mct_daemon_client_batch_free(batch);
+        return MCT_RETURN_ERROR;
+    }
+
+    batch->max_count = max_count;
+    batch->size = size;
+    batch->count = 0;
+    batch->used = 0;
+
+    return MCT_RETURN_OK;
+}
+
+void mct_daemon_client_batch_free(MctDaemonMessageBatch *batch)
+{
+    if (batch == NULL) {
+        return;
+    }
+
+    free(batch->entries);
+    free(batch->buffer);
+    batch->entries = NULL;
+    batch->buffer = NULL;
+    batch->max_count = 0;
+    batch->size = 0;
+    batch->count = 0;
+    batch->used = 0;
+}
+
+int mct_daemon_client_batch_add(MctDaemon *daemon,
+                                MctDaemonLocal *daemon_local,
+                                int verbose)
+{
+    MctDaemonMessageBatch *batch = NULL;
+    MctDaemonBatchEntry *entry = NULL;
+    MctMessage *msg = NULL;
+    uint32_t needed = 0;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL)) {
+        mct_vlog(LOG_ERR, "%s: invalid arguments\n", __func__);
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+
+    batch = &daemon_local->batch;
+    msg = &daemon_local->msg;
+
+    /* batching not available, forward message directly */
+    if ((batch->entries == NULL) || (batch->buffer == NULL)) {
+        return mct_daemon_client_send_message_to_all_client(daemon,
+                                                            daemon_local,
+                                                            verbose);
+    }
+
+    if (mct_daemon_client_prepare_message(daemon, daemon_local, verbose) !=
+        MCT_DAEMON_ERROR_OK) {
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+
+    /* a view refers to the receiver buffer, which stays valid until the batch is flushed */
+    needed = msg->is_view ? 0 :
+        (uint32_t)(msg->headersize - sizeof(MctStorageHeader) + msg->datasize);
+
+    if (needed > batch->size) {
+        mct_vlog(LOG_WARNING, "%s: message of %u bytes exceeds batch size\n",
+                 __func__, needed);
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+
+    if ((batch->count >= batch->max_count) ||
+        ((batch->used + needed) > batch->size)) {
+        mct_daemon_client_batch_flush(daemon, daemon_local, verbose);
+    }
+
+    entry = &batch->entries[batch->count];
+    memcpy(&entry->storageheader, msg->storageheader, sizeof(MctStorageHeader));
+
+    entry->headersize = msg->headersize - (int)sizeof(MctStorageHeader);
+    entry->datasize = msg->datasize;
+
+    if (msg->is_view) {
+        entry->header = (uint8_t *)msg->standardheader;
+        entry->data = msg->databuffer;
+    } else {
+        entry->header = batch->buffer + batch->used;
+        memcpy(entry->header, msg->standardheader, (size_t)entry->headersize);
+        batch->used += (uint32_t)entry->headersize;
+
+        entry->data = batch->buffer + batch->used;
+
+        if (msg->datasize > 0) {
+            memcpy(entry->data, msg->databuffer, (size_t)msg->datasize);
+        }
+
+        batch->used += (uint32_t)entry->datasize;
+    }
+
+    entry->skip_network = 0;
+    batch->count++;
+
+    return MCT_DAEMON_ERROR_OK;
+}
+
+/** @brief Sends a batch of messages to the multicast group.
+ *
+ * Messages are packed into as few datagrams as possible, each datagram
+ * staying below MCT_DAEMON_UDP_MAX_DATAGRAM_SIZE. A message which is larger
+ * on its own is sent in a datagram of its own. Messages for which
+ * logstorage disabled network routing are skipped.
+ *
+ * @param daemon_local Daemon local structure
+ * @param batch The batch of messages to be sent.
+ */
+static void mct_daemon_client_send_batch_udp(MctDaemonLocal *daemon_local,
+                                             MctDaemonMessageBatch *batch)
+{
+    struct iovec iov[2 * MCT_DAEMON_BATCH_MAX_MESSAGES];
+    int iovcnt = 0;
+    size_t size = 0;
+    size_t msg_size = 0;
+    const size_t max_size = MCT_DAEMON_UDP_MAX_DATAGRAM_SIZE - sizeof(MctMulticastHeader);
+    int i = 0;
+
+    for (i = 0; (i < batch->count) && (i < MCT_DAEMON_BATCH_MAX_MESSAGES); i++) {
+        if (batch->entries[i].skip_network) {
+            continue;
+        }
+
+        msg_size = (size_t)(batch->entries[i].headersize + batch->entries[i].datasize);
+
+        if ((iovcnt > 0) && ((size + msg_size) > max_size)) {
+            mct_daemon_udp_sendv(&daemon_local->udp, iov, iovcnt);
+            iovcnt = 0;
+            size = 0;
+        }
+
+        iov[iovcnt].iov_base = batch->entries[i].header;
+        iov[iovcnt].iov_len = (size_t)batch->entries[i].headersize;
+        iovcnt++;
+
+        if (batch->entries[i].datasize > 0) {
+            iov[iovcnt].iov_base = batch->entries[i].data;
+            iov[iovcnt].iov_len = (size_t)batch->entries[i].datasize;
+            iovcnt++;
+        }
+
+        size += msg_size;
+    }
+
+    if (iovcnt > 0) {
+        mct_daemon_udp_sendv(&daemon_local->udp, iov, iovcnt);
+    }
+}
+
+/** @brief Sends a batch of messages to all the clients.
+ *
+ * Same as mct_daemon_client_send_all_multiple(), but all messages of the
+ * batch are written with one vectored send per client connection.
+ * Messages for which logstorage disabled network routing are skipped.
+ *
+ * @param daemon Daemon structure needed for socket closure.
+ * @param daemon_local Daemon local structure
+ * @param batch The batch of messages to be sent.
+ * @param verbose Needed for socket closure.
+ *
+ * @return 1 if sent to at least one client, 0 otherwise.
+ */
+static int mct_daemon_client_send_all_batch(MctDaemon *daemon,
+                                            MctDaemonLocal *daemon_local,
+                                            MctDaemonMessageBatch *batch,
+                                            int verbose)
+{
+    struct iovec iov[3 * MCT_DAEMON_BATCH_MAX_MESSAGES];
+    int iovcnt = 0;
+    int messages = 0;
+    int i = 0;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    for (i = 0; (i < batch->count) && (i < MCT_DAEMON_BATCH_MAX_MESSAGES); i++) {
+        if (batch->entries[i].skip_network) {
+            continue;
+        }
+
+        messages++;
+
+        if (daemon->sendserialheader) {
+            iov[iovcnt].iov_base = (void *)mctSerialHeader;
+            iov[iovcnt].iov_len = sizeof(mctSerialHeader);
+            iovcnt++;
+        }
+
+        iov[iovcnt].iov_base = batch->entries[i].header;
+        iov[iovcnt].iov_len = (size_t)batch->entries[i].headersize;
+        iovcnt++;
+
+        if (batch->entries[i].datasize > 0) {
+            iov[iovcnt].iov_base = batch->entries[i].data;
+            iov[iovcnt].iov_len = (size_t)batch->entries[i].datasize;
+            iovcnt++;
+        }
+    }
+
+    if (iovcnt == 0) {
+        return 0;
+    }
+
+    return mct_daemon_client_send_all_vector(daemon, daemon_local, iov, iovcnt,
+                                             messages, verbose);
+}
+
+int mct_daemon_client_send_all_vector(MctDaemon *daemon,
+                                      MctDaemonLocal *daemon_local,
+                                      const struct iovec *iov,
+                                      int iovcnt,
+                                      int messages,
+                                      int verbose)
+{
+    int sent = 0;
+    int ret = 0;
+    size_t size = 0;
+    int i = 0;
+    unsigned int j = 0;
+    MctConnection *temp = NULL;
+    int type_mask = MCT_CONNECTION_NONE;
+    int client_mask = MCT_FILTER_CLIENT_CONNECTION_DEFAULT_MASK;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL) || (iov == NULL)) {
+        mct_vlog(LOG_ERR, "%s: Invalid parameters\n", __func__);
+        return 0;
+    }
+
+    /* get current client mask to avoid multiple function calls */
+    client_mask |= daemon_local->pFilter.current->client_mask;
+
+    /* check for TCP and Serial if allowed in current filter configuration*/
+    if (client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_TCP)) {
+        type_mask |= MCT_CON_MASK_CLIENT_MSG_TCP;
+    }
+
+    if (client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_SERIAL)) {
+        type_mask |= MCT_CON_MASK_CLIENT_MSG_SERIAL;
+    }
+
+    for (i = 0; i < iovcnt; i++) {
+        size += iov[i].iov_len;
+    }
+
+    for (j = 0; j < daemon_local->pEvent.nfds; j++) {
+        temp = mct_event_handler_find_connection(&(daemon_local->pEvent),
+                                                 daemon_local->pEvent.pfd[j].fd);
+
+        if ((temp == NULL) || (temp->receiver == NULL) ||
+            !((1 << temp->type) & type_mask)) {
+            continue;
+        }
+
+        ret = mct_connection_send_vector(temp, iov, iovcnt);
+
+        if (ret != MCT_DAEMON_ERROR_OK) {
+            MCT_DAEMON_METRICS_ADD(temp->metrics.dropped, messages);
+        } else {
+            MCT_DAEMON_METRICS_ADD(temp->metrics.messages, messages);
+            MCT_DAEMON_METRICS_ADD(temp->metrics.bytes, size);
+        }
+
+        if ((ret != MCT_DAEMON_ERROR_OK) &&
+            (MCT_CONNECTION_CLIENT_MSG_TCP == temp->type)) {
+            mct_daemon_close_socket(temp->receiver->fd,
+                                    daemon,
+                                    daemon_local,
+                                    verbose);
+        }
+
+        if (ret != MCT_DAEMON_ERROR_OK) {
+            mct_vlog(LOG_WARNING, "%s: send mct messages failed\n", __func__);
+        } else {
+            sent = 1;
+        }
+    }
+
+    return sent;
+}
+
+/**
+ * @brief Write all messages of a batch to the offline trace
+ *
+ * @param daemon_local Structure containing needed information.
+ * @param batch Messages to be written.
+ */
+static void mct_daemon_client_batch_offline_trace(MctDaemonLocal *daemon_local,
+                                                  MctDaemonMessageBatch *batch)
+{
+    struct iovec iov[3 * MCT_DAEMON_BATCH_MAX_MESSAGES];
+    int count = 0;
+    int i = 0;
+
+    for (i = 0; (i < batch->count) && (i < MCT_DAEMON_BATCH_MAX_MESSAGES); i++) {
+        iov[3 * i].iov_base = &batch->entries[i].storageheader;
+        iov[3 * i].iov_len = sizeof(MctStorageHeader);
+        iov[3 * i + 1].iov_base = batch->entries[i].header;
+        iov[3 * i + 1].iov_len = (size_t)batch->entries[i].headersize;
+        iov[3 * i + 2].iov_base = batch->entries[i].data;
+        iov[3 * i + 2].iov_len = (size_t)batch->entries[i].datasize;
+        count++;
+    }
+
+    if (mct_offline_trace_write_vector(&(daemon_local->offlineTrace), iov, count)) {
+        static int error_mct_offline_trace_write_failed = 0;
+
+        if (!error_mct_offline_trace_write_failed) {
+            mct_vlog(LOG_ERR, "%s: mct_offline_trace_write_vector failed!\n", __func__);
+            error_mct_offline_trace_write_failed = 1;
+        }
+    }
+}
+
+int mct_daemon_client_batch_flush(MctDaemon *daemon,
+                                  MctDaemonLocal *daemon_local,
+                                  int verbose)
+{
+    MctDaemonMessageBatch *batch = NULL;
+    MctDaemonBatchEntry *entry = NULL;
+    int client_mask = MCT_FILTER_CLIENT_CONNECTION_DEFAULT_MASK;
+    int ret = MCT_DAEMON_ERROR_OK;
+    int i = 0;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL)) {
+        mct_vlog(LOG_ERR, "%s: invalid arguments\n", __func__);
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+
+    batch = &daemon_local->batch;
+
+    if (batch->count == 0) {
+        return MCT_DAEMON_ERROR_OK;
+    }
+
+    /* get current client mask to avoid multiple function calls */
+    client_mask |= daemon_local->pFilter.current->client_mask;
+
+    /* Offline trace and logstorage get the whole batch at once */
+    if ((client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_OFFLINE_TRACE)) &&
+        daemon_local->flags.offlineTraceDirectory[0]) {
+        mct_daemon_client_batch_offline_trace(daemon_local, batch);
+    }
+
+    if ((client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_OFFLINE_LOGSTORAGE)) &&
+        (daemon_local->flags.offlineLogstorageMaxDevices > 0)) {
+        mct_daemon_logstorage_write_batch(daemon,
+                                          &daemon_local->flags,
+                                          batch->entries,
+                                          batch->count);
+    }
+
+    if ((client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_UDP)) &&
+        (daemon_local->udp.sock >= 0)) {
+        mct_daemon_client_send_batch_udp(daemon_local, batch);
+    }
+
+    /* send messages to daemon socket */
+    if (((client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_TCP)) ||
+         (client_mask & MCT_CONNECTION_TO_MASK(MCT_CONNECTION_CLIENT_MSG_SERIAL))) &&
+        (daemon->state == MCT_DAEMON_STATE_SEND_DIRECT)) {
+        mct_daemon_client_send_all_batch(daemon, daemon_local, batch, verbose);
+    }
+
+    /* Messages were not sent to client, so store them in client ringbuffer */
+    if (mct_daemon_client_is_buffering(daemon)) {
+        for (i = 0; i < batch->count; i++) {
+            entry = &batch->entries[i];
+
+            if (mct_daemon_client_buffer(daemon, daemon_local,
+                                         entry->header, entry->headersize,
+                                         entry->data, entry->datasize) != MCT_DAEMON_ERROR_OK) {
+                ret = MCT_DAEMON_ERROR_BUFFER_FULL;
+            }
+        }
+    } else {
+        mct_daemon_client_notify_overflow(daemon, daemon_local, verbose);
+    }
+
+    batch->count = 0;
+    batch->used = 0;
+
+    return ret;
+}
+
 int mct_daemon_client_send_control_message(int sock,
                                            MctDaemon *daemon,
                                            MctDaemonLocal *daemon_local,
@@ -508,7 +1107,8 @@ int mct_daemon_client_process_control(int sock,
             if ((con->type == MCT_CONNECTION_CONTROL_MSG) &&
                 (((daemon_local->pFilter.backend == NULL) &&
                   (id == MCT_SERVICE_ID_SET_FILTER_LEVEL)) ||
-                 (id == MCT_SERVICE_ID_GET_FILTER_STATUS))) {
+                 (id == MCT_SERVICE_ID_GET_FILTER_STATUS) ||
+                 (id == MCT_SERVICE_ID_GET_METRICS))) {
                 mct_vlog(LOG_INFO, "Set Filter Level request received\n");
             } else {
                 mct_vlog(LOG_WARNING,
@@ -546,37 +1146,26 @@ int mct_daemon_client_process_control(int sock,
             }
             case MCT_SERVICE_ID_STORE_CONFIG:
             {
-                if (mct_daemon_applications_save(daemon, daemon->runtime_application_cfg,
-                                                 verbose) == 0) {
-                    if (mct_daemon_contexts_save(daemon, daemon->runtime_context_cfg,
-                                                 verbose) == 0) {
-                        mct_daemon_control_service_response(sock,
-                                                            daemon,
-                                                            daemon_local,
-                                                            id,
-                                                            MCT_SERVICE_RESPONSE_OK,
-                                                            verbose);
-                    } else {
-                        /* Delete saved files */
-                        mct_daemon_control_reset_to_factory_default(
-                            daemon,
-                            daemon->runtime_application_cfg,
-                            daemon->runtime_context_cfg,
-                            daemon_local->flags.
-                            contextLogLevel,
-                            daemon_local->flags.
-                            contextTraceStatus,
-                            daemon_local->flags.
-                            enforceContextLLAndTS,
-                            verbose);
-                        mct_daemon_control_service_response(sock,
-                                                            daemon,
-                                                            daemon_local,
-                                                            id,
-                                                            MCT_SERVICE_RESPONSE_ERROR,
-                                                            verbose);
-                    }
+                if (mct_daemon_runtime_config_save(daemon, verbose) == 0) {
+                    mct_daemon_control_service_response(sock,
+                                                        daemon,
+                                                        daemon_local,
+                                                        id,
+                                                        MCT_SERVICE_RESPONSE_OK,
+                                                        verbose);
                 } else {
+                    /* Delete saved files */
+                    mct_daemon_control_reset_to_factory_default(
+                        daemon,
+                        daemon->runtime_application_cfg,
+                        daemon->runtime_context_cfg,
+                        daemon_local->flags.
+                        contextLogLevel,
+                        daemon_local->flags.
+                        contextTraceStatus,
+                        daemon_local->flags.
+                        enforceContextLLAndTS,
+                        verbose);
                     mct_daemon_control_service_response(sock,
                                                         daemon,
                                                         daemon_local,
@@ -748,6 +1337,12 @@ int mct_daemon_client_process_control(int sock,
                                                      verbose);
                 break;
             }
+            case MCT_SERVICE_ID_GET_METRICS:
+            {
+                mct_daemon_control_get_metrics(sock, daemon, daemon_local,
+                                               msg, verbose);
+                break;
+            }
             case MCT_SERVICE_ID_SET_ALL_LOG_LEVEL:
             {
                 mct_daemon_control_set_all_log_level(sock, daemon, daemon_local, msg, verbose);
@@ -934,6 +1529,7 @@ void mct_daemon_control_get_log_info(int sock,
     uint32_t sid;
 
     MctDaemonRegisteredUsers *user_list = NULL;
+    MctDaemonLogInfoCacheEntry *cache = NULL;
 
     PRINT_FUNCTION_VERBOSE(verbose);
 
@@ -951,6 +1547,9 @@ void mct_daemon_control_get_log_info(int sock,
         return;
     }
 
+    /* the response lists applications and their contexts in sort order */
+    mct_daemon_user_list_sort(user_list);
+
     /* prepare pointer to message request */
     req = (MctServiceGetLogInfoRequest *)(msg->databuffer);
 
@@ -976,6 +1575,32 @@ void mct_daemon_control_get_log_info(int sock,
         return;
     }
 
+    /* serve a repeated request from the response cache */
+    cache = mct_daemon_log_info_cache_get(user_list, req->options, req->apid, req->ctid);
+
+    if (cache != NULL) {
+        resp.databuffer = (uint8_t *)malloc(cache->size);
+
+        if (resp.databuffer == NULL) {
+            mct_daemon_control_service_response(sock,
+                                                daemon,
+                                                daemon_local,
+                                                MCT_SERVICE_ID_GET_LOG_INFO,
+                                                MCT_SERVICE_RESPONSE_ERROR,
+                                                verbose);
+            return;
+        }
+
+        memcpy(resp.databuffer, cache->data, cache->size);
+        resp.datasize = cache->size;
+        resp.databuffersize = cache->size;
+
+        mct_daemon_client_send_control_message(sock, daemon, daemon_local, &resp, "", "", verbose);
+
+        mct_message_free(&resp, 0);
+        return;
+    }
+
     if (req->apid[0] != '\0') {
         application = mct_daemon_application_find(daemon,
                                                   req->apid,
@@ -1273,6 +1898,9 @@ void mct_daemon_control_get_log_info(int sock,
 
     mct_set_id((char *)(resp.databuffer + offset), MCT_DAEMON_REMO_STRING);
 
+    mct_daemon_log_info_cache_put(user_list, req->options, req->apid, req->ctid,
+                                  resp.databuffer, resp.datasize);
+
     /* send message */
     mct_daemon_client_send_control_message(sock, daemon, daemon_local, &resp, "", "", verbose);
 
@@ -2666,11 +3294,40 @@ int mct_daemon_process_one_s_timer(MctDaemon *daemon,
                                         daemon_local->flags.vflag);
     }
 
+    mct_daemon_overload_check(daemon, daemon_local, daemon_local->flags.vflag);
+
     mct_log(LOG_DEBUG, "Timer timingpacket\n");
 
     return 0;
 }
 
+int mct_daemon_process_logstorage_timer(MctDaemon *daemon,
+                                        MctDaemonLocal *daemon_local,
+                                        MctReceiver *receiver,
+                                        int verbose)
+{
+    uint64_t expir = 0;
+    ssize_t res = 0;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon_local == NULL) || (daemon == NULL) || (receiver == NULL)) {
+        mct_vlog(LOG_ERR, "%s: invalid parameters", __func__);
+        return -1;
+    }
+
+    res = read(receiver->fd, &expir, sizeof(expir));
+
+    if (res < 0) {
+        mct_vlog(LOG_WARNING, "%s: Fail to read timer (%s)\n", __func__,
+                 strerror(errno));
+    }
+
+    mct_daemon_logstorage_sync_files(daemon, daemon_local);
+
+    return 0;
+}
+
 int mct_daemon_process_sixty_s_timer(MctDaemon *daemon,
                                      MctDaemonLocal *daemon_local,
                                      MctReceiver *receiver,
@@ -2898,6 +3555,7 @@ void mct_daemon_control_service_logstorage(int sock,
     device = &daemon->storage_handle[device_index];
 
     if (req->connection_type == MCT_OFFLINE_LOGSTORAGE_DEVICE_CONNECTED) {
+        mct_daemon_logstorage_drain(daemon, device);
         ret = mct_logstorage_device_connected(device, req->mount_point);
 
         if (ret == 1) {
@@ -2967,6 +3625,7 @@ void mct_daemon_control_service_logstorage(int sock,
             daemon_local->flags.offlineLogstorageMaxDevices,
             verbose);
 
+        mct_daemon_logstorage_drain(daemon, &(daemon->storage_handle[device_index]));
         mct_logstorage_device_disconnected(&(daemon->storage_handle[device_index]),
                                            MCT_LOGSTORAGE_SYNC_ON_DEVICE_DISCONNECT);
 
@@ -3039,4 +3698,246 @@ void mct_daemon_control_service_logstorage(int sock,
                                             MCT_SERVICE_RESPONSE_ERROR,
                                             verbose);
     }
-}
\ No newline at end of file
+}
+
+/** @brief Fill the counters of one connection of a metrics response.
+ *
+ * The queue depth is the number of bytes the kernel holds for the
+ * connection: not yet read for applications, not yet sent for clients.
+ *
+ * @param daemon Daemon structure
+ * @param con Connection
+ * @param entry Entry of the metrics response
+ *
+ * @return 1 if the connection is reported, 0 otherwise.
+ */
+static int mct_daemon_control_get_metrics_connection(MctDaemon *daemon,
+                                                     MctConnection *con,
+                                                     MctServiceMetricsConnection *entry)
+{
+    MctDaemonRegisteredUsers *user_list = NULL;
+    int queue = 0;
+    int fd = con->receiver->fd;
+    int i = 0;
+
+    switch (con->type) {
+        case MCT_CONNECTION_APP_MSG:
+            entry->kind = MCT_SERVICE_METRICS_APPLICATION;
+
+            if (ioctl(fd, FIONREAD, &queue) < 0) {
+                queue = 0;
+            }
+
+            user_list = mct_daemon_find_users_list(daemon, daemon->ecuid, 0);
+
+            for (i = 0; (user_list != NULL) && (i < user_list->num_applications); i++) {
+                if (user_list->applications[i].user_handle == fd) {
+                    memcpy(entry->apid, user_list->applications[i].apid, MCT_ID_SIZE);
+                    break;
+                }
+            }
+
+            break;
+        case MCT_CONNECTION_CLIENT_MSG_TCP:
+        case MCT_CONNECTION_CLIENT_MSG_SERIAL:
+            entry->kind = (con->type == MCT_CONNECTION_CLIENT_MSG_TCP) ?
+                MCT_SERVICE_METRICS_TCP : MCT_SERVICE_METRICS_SERIAL;
+
+            if (ioctl(fd, TIOCOUTQ, &queue) < 0) {
+                queue = 0;
+            }
+
+            break;
+        default:
+            return 0;
+    }
+
+    entry->handle = fd;
+    entry->messages = MCT_DAEMON_METRICS_GET(con->metrics.messages);
+    entry->bytes = MCT_DAEMON_METRICS_GET(con->metrics.bytes);
+    entry->errors = MCT_DAEMON_METRICS_GET(con->metrics.errors);
+    entry->dropped = MCT_DAEMON_METRICS_GET(con->metrics.dropped);
+    entry->queue_depth = (uint32_t)queue;
+
+    return 1;
+}
+
+/** @brief Fill the counters of one logstorage device of a metrics response.
+ *
+ * Messages are counted when they are written to the device or queued for
+ * its writer thread. Dropped messages were discarded because the queue of
+ * the writer thread was full, the queue depth is the number of queued bytes.
+ *
+ * @param daemon Daemon structure
+ * @param index Index of the logstorage device
+ * @param entry Entry of the metrics response
+ *
+ * @return 1 if the device is reported, 0 otherwise.
+ */
+static int mct_daemon_control_get_metrics_logstorage(MctDaemon *daemon,
+                                                     int index,
+                                                     MctServiceMetricsConnection *entry)
+{
+    MctDaemonLogStorageWriter *writer = NULL;
+
+    if ((daemon->storage_metrics == NULL) ||
+        (daemon->storage_handle[index].config_status != MCT_OFFLINE_LOGSTORAGE_CONFIG_DONE)) {
+        return 0;
+    }
+
+    if (daemon->storage_writer != NULL) {
+        writer = &daemon->storage_writer[index];
+    }
+
+    entry->kind = MCT_SERVICE_METRICS_LOGSTORAGE;
+    entry->handle = index;
+    entry->messages = MCT_DAEMON_METRICS_GET(daemon->storage_metrics[index].messages);
+    entry->bytes = MCT_DAEMON_METRICS_GET(daemon->storage_metrics[index].bytes);
+    entry->errors = MCT_DAEMON_METRICS_GET(daemon->storage_metrics[index].errors);
+    entry->dropped = (writer != NULL) ? writer->dropped : 0;
+    entry->queue_depth = mct_daemon_logstorage_writer_get_queue_depth(writer);
+
+    return 1;
+}
+
+void mct_daemon_control_get_metrics(int sock, MctDaemon *daemon,
+                                    MctDaemonLocal *daemon_local,
+                                    MctMessage *msg, int verbose)
+{
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    MctMessage resp_msg = {0};
+    MctServiceGetMetrics *req = NULL;
+    MctServiceGetMetricsResponse *resp = NULL;
+    MctServiceMetricsConnection connections[MCT_SERVICE_METRICS_CONNECTIONS_MAX];
+    MctServiceMetricsContext *context_entry = NULL;
+    MctDaemonRegisteredUsers *user_list = NULL;
+    MctDaemonContext *context = NULL;
+    MctConnection *con = NULL;
+    uint32_t offset = 0;
+    int num_connections = 0;
+    int num_contexts = 0;
+    int total_contexts = 0;
+    int i = 0;
+
+    if ((daemon == NULL) || (daemon_local == NULL) || (msg == NULL) ||
+        (msg->databuffer == NULL)) {
+        return;
+    }
+
+    if (msg->datasize < (int32_t)sizeof(MctServiceGetMetrics)) {
+        mct_daemon_control_service_response(sock, daemon, daemon_local,
+                                            MCT_SERVICE_ID_GET_METRICS,
+                                            MCT_SERVICE_RESPONSE_ERROR,
+                                            verbose);
+        return;
+    }
+
+    req = (MctServiceGetMetrics *)msg->databuffer;
+    offset = req->context_offset;
+
+    memset(connections, 0, sizeof(connections));
+
+    for (con = daemon_local->pEvent.connections;
+         (con != NULL) && (num_connections < MCT_SERVICE_METRICS_CONNECTIONS_MAX);
+         con = con->next) {
+        if (con->receiver == NULL) {
+            continue;
+        }
+
+        num_connections += mct_daemon_control_get_metrics_connection(daemon, con,
+                                                                     &connections[num_connections]);
+    }
+
+    if ((daemon_local->udp.sock >= 0) &&
+        (num_connections < MCT_SERVICE_METRICS_CONNECTIONS_MAX)) {
+        connections[num_connections].kind = MCT_SERVICE_METRICS_UDP;
+        connections[num_connections].handle = daemon_local->udp.sock;
+        connections[num_connections].messages =
+            MCT_DAEMON_METRICS_GET(daemon_local->udp.metrics.messages);
+        connections[num_connections].bytes =
+            MCT_DAEMON_METRICS_GET(daemon_local->udp.metrics.bytes);
+        connections[num_connections].dropped =
+            MCT_DAEMON_METRICS_GET(daemon_local->udp.metrics.dropped);
+        num_connections++;
+    }
+
+    for (i = 0; (i < daemon_local->flags.offlineLogstorageMaxDevices) &&
+         (num_connections < MCT_SERVICE_METRICS_CONNECTIONS_MAX); i++) {
+        num_connections += mct_daemon_control_get_metrics_logstorage(daemon, i,
+                                                                     &connections[num_connections]);
+    }
+
+    user_list = mct_daemon_find_users_list(daemon, daemon->ecuid, verbose);
+
+    if (user_list != NULL) {
+        /* report contexts in id order, so the offset is stable between requests */
+        mct_daemon_user_list_sort(user_list);
+        total_contexts = user_list->num_contexts;
+
+        if (offset < (uint32_t)total_contexts) {
+            num_contexts = total_contexts - (int)offset;
+
+            if (num_contexts > MCT_SERVICE_METRICS_CONTEXTS_MAX) {
+                num_contexts = MCT_SERVICE_METRICS_CONTEXTS_MAX;
+            }
+        }
+    }
+
+    if (mct_message_init(&resp_msg, verbose) == -1) {
+        return;
+    }
+
+    resp_msg.datasize = (int32_t)(sizeof(MctServiceGetMetricsResponse) +
+                                  sizeof(MctServiceMetricsConnection) * (size_t)num_connections +
+                                  sizeof(MctServiceMetricsContext) * (size_t)num_contexts);
+    resp_msg.databuffer = (uint8_t *)calloc((size_t)resp_msg.datasize, sizeof(uint8_t));
+
+    if (resp_msg.databuffer == NULL) {
+        mct_log(LOG_CRIT, "Cannot allocate memory for message response\n");
+        return;
+    }
+
+    resp_msg.databuffersize = resp_msg.datasize;
+
+    resp = (MctServiceGetMetricsResponse *)resp_msg.databuffer;
+    resp->service_id = MCT_SERVICE_ID_GET_METRICS;
+    resp->status = MCT_SERVICE_RESPONSE_OK;
+    resp->buffer_used = (uint32_t)mct_buffer_get_used_size(&daemon->client_ringbuffer);
+    resp->buffer_size = mct_buffer_get_total_size(&daemon->client_ringbuffer);
+    resp->buffer_max_size = daemon->client_ringbuffer.max_size;
+    resp->buffer_messages = (uint32_t)mct_buffer_get_message_count(&daemon->client_ringbuffer);
+    resp->overflow_counter = daemon->overflow_total + daemon->overflow_counter;
+
+    for (i = 0; i < MCT_BUFFER_PRIORITY_MAX; i++) {
+        resp->evicted_counter[i] = daemon->evicted_total[i] + daemon->evicted_counter[i];
+    }
+
+    resp->spool_size = daemon_local->spool.total;
+    resp->num_connections = (uint16_t)num_connections;
+    resp->total_contexts = (uint32_t)total_contexts;
+    resp->context_offset = offset;
+    resp->num_contexts = (uint16_t)num_contexts;
+
+    memcpy(resp_msg.databuffer + sizeof(MctServiceGetMetricsResponse),
+           connections,
+           sizeof(MctServiceMetricsConnection) * (size_t)num_connections);
+
+    context_entry = (MctServiceMetricsContext *)(resp_msg.databuffer +
+                                                 sizeof(MctServiceGetMetricsResponse) +
+                                                 sizeof(MctServiceMetricsConnection) *
+                                                 (size_t)num_connections);
+
+    for (i = 0; i < num_contexts; i++) {
+        context = &user_list->contexts[offset + (uint32_t)i];
+        memcpy(context_entry[i].apid, context->apid, MCT_ID_SIZE);
+        memcpy(context_entry[i].ctid, context->ctid, MCT_ID_SIZE);
+        context_entry[i].messages = MCT_DAEMON_METRICS_GET(context->metrics.messages);
+        context_entry[i].bytes = MCT_DAEMON_METRICS_GET(context->metrics.bytes);
+    }
+
+    mct_daemon_client_send_control_message(sock, daemon, daemon_local, &resp_msg,
+                                           "", "", verbose);
+    /* free message */
+    mct_message_free(&resp_msg, verbose);
+}
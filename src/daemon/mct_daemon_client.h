@@ -44,6 +44,63 @@ int mct_daemon_client_send(int sock,
 int mct_daemon_client_send_message_to_all_client(MctDaemon *daemon,
                                                  MctDaemonLocal *daemon_local,
                                                  int verbose);
+/**
+ * Allocate entries and data buffer of a message batch.
+ * @param batch pointer to message batch
+ * @param max_count maximum number of messages in the batch
+ * @param size size of the buffer holding headers and payloads
+ * @return MCT_RETURN_OK on success, MCT_RETURN_ERROR otherwise
+ */
+int mct_daemon_client_batch_init(MctDaemonMessageBatch *batch,
+                                 int max_count,
+                                 uint32_t size);
+/**
+ * Free all memory of a message batch.
+ * @param batch pointer to message batch
+ */
+void mct_daemon_client_batch_free(MctDaemonMessageBatch *batch);
+/**
+ * Prepare the current message and append it to the daemon message batch.
+ * The batch is flushed first if it cannot hold the message.
+ * If no batch is allocated, the message is sent out immediately.
+ * @param daemon pointer to mct daemon structure
+ * @param daemon_local pointer to mct daemon local structure
+ * @param verbose if set to true verbose information is printed out.
+ * @return 0 if success, less than 0 if there is an error
+ */
+int mct_daemon_client_batch_add(MctDaemon *daemon,
+                                MctDaemonLocal *daemon_local,
+                                int verbose);
+/**
+ * Forward all messages of the daemon message batch to offline trace,
+ * offline logstorage, clients and client ringbuffer. Each client
+ * connection gets the whole batch in one vectored send.
+ * @param daemon pointer to mct daemon structure
+ * @param daemon_local pointer to mct daemon local structure
+ * @param verbose if set to true verbose information is printed out.
+ * @return 0 if success, less than 0 if there is an error or buffer is full
+ */
+int mct_daemon_client_batch_flush(MctDaemon *daemon,
+                                  MctDaemonLocal *daemon_local,
+                                  int verbose);
+/**
+ * Send a vector of buffers to all TCP and serial client connections
+ * allowed by the current filter. Each connection is written once.
+ * Connections failing to send are closed.
+ * @param daemon pointer to mct daemon structure
+ * @param daemon_local pointer to mct daemon local structure
+ * @param iov buffers to be sent, in order
+ * @param iovcnt number of buffers
+ * @param messages number of messages in the buffers, for the metrics
+ * @param verbose if set to true verbose information is printed out.
+ * @return 1 if sent to at least one client, 0 otherwise
+ */
+int mct_daemon_client_send_all_vector(MctDaemon *daemon,
+                                      MctDaemonLocal *daemon_local,
+                                      const struct iovec *iov,
+                                      int iovcnt,
+                                      int messages,
+                                      int verbose);
 /**
  * Send out response message to mct client
  * @param sock connection handle used for sending response
@@ -375,6 +432,21 @@ void mct_daemon_control_get_filter_status(int sock,
                                           MctDaemon *daemon,
                                           MctDaemonLocal *daemon_local,
                                           int verbose);
+/**
+ * Process and generate response to received get metrics control message.
+ * The response holds the counters of all connections and of at most
+ * MCT_SERVICE_METRICS_CONTEXTS_MAX contexts starting at the requested offset.
+ * @param sock connection handle used for sending response
+ * @param daemon pointer to mct daemon structure
+ * @param daemon_local pointer to mct daemon local structure
+ * @param msg pointer to received control message
+ * @param verbose if set to true verbose information is printed out.
+ */
+void mct_daemon_control_get_metrics(int sock,
+                                    MctDaemon *daemon,
+                                    MctDaemonLocal *daemon_local,
+                                    MctMessage *msg,
+                                    int verbose);
 /**
  * Process and generate response to received set BlockMode message
  * @param sock connection handle used for sending response
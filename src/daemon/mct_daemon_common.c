@@ -19,8 +19,6 @@
 #include "mct_daemon_socket.h"
 #include "mct_daemon_serial.h"
 
-char *app_recv_buffer = NULL; /* pointer to receiver buffer for application msges */
-
 static int mct_daemon_cmp_apid(const void *m1, const void *m2)
 {
     if ((m1 == NULL) || (m2 == NULL)) {
@@ -56,6 +54,361 @@ static int mct_daemon_cmp_apid_ctid(const void *m1, const void *m2)
     return ret;
 }
 
+/* pack up to four characters of an id the way mct_set_id() stores them */
+static uint32_t mct_daemon_pack_id(const char *id)
+{
+    char tmp[MCT_ID_SIZE];
+    uint32_t packed = 0;
+
+    mct_set_id(tmp, id);
+    memcpy(&packed, tmp, MCT_ID_SIZE);
+
+    return packed;
+}
+
+static uint64_t mct_daemon_index_key(const char *apid, const char *ctid)
+{
+    uint64_t key = (uint64_t)mct_daemon_pack_id(apid) << 32;
+
+    if (ctid != NULL) {
+        key |= mct_daemon_pack_id(ctid);
+    }
+
+    return key;
+}
+
+static int mct_daemon_index_slot(MctDaemonIndex *index, uint64_t key)
+{
+    /* Fibonacci hashing, the upper bits are the best mixed ones */
+    return (int)(((key * 0x9E3779B97F4A7C15ULL) >> 32) & (uint64_t)(index->size - 1));
+}
+
+static void mct_daemon_index_free(MctDaemonIndex *index)
+{
+    free(index->slots);
+    index->slots = NULL;
+    index->size = 0;
+    index->count = 0;
+}
+
+static int mct_daemon_index_find(MctDaemonIndex *index, uint64_t key)
+{
+    int slot = 0;
+
+    if (index->count == 0) {
+        return -1;
+    }
+
+    for (slot = mct_daemon_index_slot(index, key);
+         index->slots[slot].pos >= 0;
+         slot = (slot + 1) & (index->size - 1)) {
+        if (index->slots[slot].key == key) {
+            return index->slots[slot].pos;
+        }
+    }
+
+    return -1;
+}
+
+static int mct_daemon_index_resize(MctDaemonIndex *index, int size)
+{
+    MctDaemonIndexSlot *old = index->slots;
+    int old_size = index->size;
+    int i = 0;
+    int slot = 0;
+
+    index->slots = malloc(sizeof(MctDaemonIndexSlot) * (size_t)size);
+
+    if (index->slots == NULL) {
+        index->slots = old;
+        return MCT_RETURN_ERROR;
+    }
+
+    for (i = 0; i < size; i++) {
+        index->slots[i].pos = -1;
+    }
+
+    index->size = size;
+
+    for (i = 0; i < old_size; i++) {
+        if (old[i].pos < 0) {
+            continue;
+        }
+
+        slot = mct_daemon_index_slot(index, old[i].key);
+
+        while (index->slots[slot].pos >= 0) {
+            slot = (slot + 1) & (size - 1);
+        }
+
+        index->slots[slot] = old[i];
+    }
+
+    free(old);
+
+    return MCT_RETURN_OK;
+}
+
+/* add key or update its position, the table is kept at most half full */
+static int mct_daemon_index_set(MctDaemonIndex *index, uint64_t key, int pos)
+{
+    int slot = 0;
+
+    if (((index->count + 1) * 2 > index->size) &&
+        (mct_daemon_index_resize(index,
+                                 (index->size > 0) ? index->size * 2 :
+                                 MCT_DAEMON_INDEX_MIN_SIZE) != MCT_RETURN_OK)) {
+        return MCT_RETURN_ERROR;
+    }
+
+    for (slot = mct_daemon_index_slot(index, key);
+         index->slots[slot].pos >= 0;
+         slot = (slot + 1) & (index->size - 1)) {
+        if (index->slots[slot].key == key) {
+            index->slots[slot].pos = pos;
+            return MCT_RETURN_OK;
+        }
+    }
+
+    index->slots[slot].key = key;
+    index->slots[slot].pos = pos;
+    index->count++;
+
+    return MCT_RETURN_OK;
+}
+
+/* remove key and shift following entries of its probe sequence back */
+static void mct_daemon_index_remove(MctDaemonIndex *index, uint64_t key)
+{
+    int slot = 0;
+    int next = 0;
+    int home = 0;
+
+    if (index->count == 0) {
+        return;
+    }
+
+    for (slot = mct_daemon_index_slot(index, key);
+         index->slots[slot].key != key;
+         slot = (slot + 1) & (index->size - 1)) {
+        if (index->slots[slot].pos < 0) {
+            /* not indexed */
+            return;
+        }
+    }
+
+    if (index->slots[slot].pos < 0) {
+        /* stale key of an empty slot */
+        return;
+    }
+
+    for (next = (slot + 1) & (index->size - 1);
+         index->slots[next].pos >= 0;
+         next = (next + 1) & (index->size - 1)) {
+        home = mct_daemon_index_slot(index, index->slots[next].key);
+
+        /* move entry if its home slot is not between the hole and itself */
+        if (((next - home) & (index->size - 1)) >= ((next - slot) & (index->size - 1))) {
+            index->slots[slot] = index->slots[next];
+            slot = next;
+        }
+    }
+
+    index->slots[slot].pos = -1;
+    index->count--;
+}
+
+int mct_daemon_init_user_information(MctDaemon *daemon, int verbose)
+{
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if (daemon == NULL) {
+        return MCT_RETURN_WRONG_PARAMETER;
+    }
+
+    daemon->user_list = calloc(1, sizeof(MctDaemonRegisteredUsers));
+
+    if (daemon->user_list == NULL) {
+        mct_log(LOG_ERR, "Allocating memory for user information failed\n");
+        return MCT_RETURN_ERROR;
+    }
+
+    mct_set_id(daemon->user_list[0].ecu, daemon->ecuid);
+    daemon->user_list[0].sorted = true;
+    daemon->num_user_lists = 1;
+
+    return MCT_RETURN_OK;
+}
+
+void mct_daemon_user_list_sort(MctDaemonRegisteredUsers *user_list)
+{
+    int i = 0;
+
+    if ((user_list == NULL) || user_list->sorted) {
+        return;
+    }
+
+    if (user_list->num_applications > 1) {
+        qsort(user_list->applications,
+              user_list->num_applications,
+              sizeof(MctDaemonApplication),
+              mct_daemon_cmp_apid);
+    }
+
+    if (user_list->num_contexts > 1) {
+        qsort(user_list->contexts,
+              user_list->num_contexts,
+              sizeof(MctDaemonContext),
+              mct_daemon_cmp_apid_ctid);
+    }
+
+    /* positions changed, keys stay the same */
+    for (i = 0; i < user_list->num_applications; i++) {
+        mct_daemon_index_set(&user_list->application_index,
+                             mct_daemon_index_key(user_list->applications[i].apid, NULL),
+                             i);
+    }
+
+    for (i = 0; i < user_list->num_contexts; i++) {
+        mct_daemon_index_set(&user_list->context_index,
+                             mct_daemon_index_key(user_list->contexts[i].apid,
+                                                  user_list->contexts[i].ctid),
+                             i);
+    }
+
+    user_list->sorted = true;
+}
+
+/* remember changes of the daemon's own applications and contexts for the next store */
+static void mct_daemon_runtime_config_mark(MctDaemon *daemon,
+                                           const char *ecu,
+                                           const char *apid,
+                                           const char *ctid)
+{
+    if (mct_daemon_pack_id(ecu) == mct_daemon_pack_id(daemon->ecuid)) {
+        mct_daemon_runtime_store_mark(&daemon->runtime_store, apid, ctid);
+    }
+}
+
+MctDaemonLogInfoCacheEntry *mct_daemon_log_info_cache_get(MctDaemonRegisteredUsers *user_list,
+                                                          int8_t options,
+                                                          const char *apid,
+                                                          const char *ctid)
+{
+    MctDaemonLogInfoCacheEntry *entry = NULL;
+    char app[MCT_ID_SIZE];
+    char ctx[MCT_ID_SIZE];
+    int i = 0;
+
+    if ((user_list == NULL) || (apid == NULL) || (ctid == NULL)) {
+        return NULL;
+    }
+
+    mct_set_id(app, apid);
+    mct_set_id(ctx, ctid);
+
+    for (i = 0; i < MCT_DAEMON_LOG_INFO_CACHE_SIZE; i++) {
+        entry = &user_list->log_info_cache[i];
+
+        if ((entry->options == options) &&
+            (memcmp(entry->apid, app, MCT_ID_SIZE) == 0) &&
+            (memcmp(entry->ctid, ctx, MCT_ID_SIZE) == 0)) {
+            entry->used = ++user_list->log_info_used;
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+void mct_daemon_log_info_cache_put(MctDaemonRegisteredUsers *user_list,
+                                   int8_t options,
+                                   const char *apid,
+                                   const char *ctid,
+                                   const uint8_t *data,
+                                   uint32_t size)
+{
+    MctDaemonLogInfoCacheEntry *entry = NULL;
+    uint8_t *copy = NULL;
+    int i = 0;
+
+    if ((user_list == NULL) || (apid == NULL) || (ctid == NULL) ||
+        (data == NULL) || (options == 0)) {
+        return;
+    }
+
+    copy = malloc(size);
+
+    if (copy == NULL) {
+        return;
+    }
+
+    memcpy(copy, data, size);
+
+    /* unused entries have the lowest time stamp */
+    entry = &user_list->log_info_cache[0];
+
+    for (i = 1; i < MCT_DAEMON_LOG_INFO_CACHE_SIZE; i++) {
+        if (user_list->log_info_cache[i].used < entry->used) {
+            entry = &user_list->log_info_cache[i];
+        }
+    }
+
+    free(entry->data);
+    entry->options = options;
+    mct_set_id(entry->apid, apid);
+    mct_set_id(entry->ctid, ctid);
+    entry->data = copy;
+    entry->size = size;
+    entry->used = ++user_list->log_info_used;
+}
+
+void mct_daemon_log_info_cache_invalidate(MctDaemonRegisteredUsers *user_list,
+                                          const char *apid,
+                                          const char *ctid,
+                                          int changed)
+{
+    MctDaemonLogInfoCacheEntry *entry = NULL;
+    char app[MCT_ID_SIZE] = { 0 };
+    char ctx[MCT_ID_SIZE] = { 0 };
+    int affected = 0;
+    int i = 0;
+
+    if (user_list == NULL) {
+        return;
+    }
+
+    mct_set_id(app, apid);
+    mct_set_id(ctx, ctid);
+
+    for (i = 0; i < MCT_DAEMON_LOG_INFO_CACHE_SIZE; i++) {
+        entry = &user_list->log_info_cache[i];
+
+        if (entry->options == 0) {
+            continue;
+        }
+
+        /* options 3: ids, 4: log level, 5: trace status, 6 and 7: both */
+        affected = (changed & MCT_DAEMON_LOG_INFO_CHANGED_IDS) ||
+            ((changed & MCT_DAEMON_LOG_INFO_CHANGED_LOG_LEVEL) &&
+             ((entry->options == 4) || (entry->options >= 6))) ||
+            ((changed & MCT_DAEMON_LOG_INFO_CHANGED_TRACE_STATUS) &&
+             (entry->options >= 5));
+
+        /* response of all applications, of the application or of the context */
+        if (affected && (apid != NULL) && (entry->apid[0] != '\0')) {
+            affected = (memcmp(entry->apid, app, MCT_ID_SIZE) == 0) &&
+                ((ctid == NULL) || (entry->ctid[0] == '\0') ||
+                 (memcmp(entry->ctid, ctx, MCT_ID_SIZE) == 0));
+        }
+
+        if (affected) {
+            free(entry->data);
+            memset(entry, 0, sizeof(MctDaemonLogInfoCacheEntry));
+        }
+    }
+}
+
 MctDaemonRegisteredUsers *mct_daemon_find_users_list(MctDaemon *daemon,
                                                      char *ecu,
                                                      int verbose)
@@ -63,14 +416,17 @@ MctDaemonRegisteredUsers *mct_daemon_find_users_list(MctDaemon *daemon,
     PRINT_FUNCTION_VERBOSE(verbose);
 
     int i = 0;
+    uint32_t id = 0;
 
     if ((daemon == NULL) || (ecu == NULL)) {
         mct_vlog(LOG_ERR, "%s: Wrong parameters", __func__);
         return (MctDaemonRegisteredUsers *)NULL;
     }
 
+    id = mct_daemon_pack_id(ecu);
+
     for (i = 0; i < daemon->num_user_lists; i++) {
-        if (strncmp(ecu, daemon->user_list[i].ecu, MCT_ID_SIZE) == 0) {
+        if (id == mct_daemon_pack_id(daemon->user_list[i].ecu)) {
             return &daemon->user_list[i];
         }
     }
@@ -133,6 +489,9 @@ int mct_daemon_init_runtime_configuration(MctDaemon *daemon,
 
     strcat(daemon->runtime_configuration, MCT_RUNTIME_CONFIGURATION); /* strcat uncritical here, because max length already checked */
 
+    mct_daemon_runtime_store_init(&daemon->runtime_store,
+                                  runtime_directory[0] ? runtime_directory : MCT_RUNTIME_DEFAULT_DIRECTORY);
+
     return MCT_RETURN_OK;
 }
 
@@ -160,6 +519,9 @@ int mct_daemon_init(MctDaemon *daemon,
     daemon->force_ll_ts = ForceLLTS;
 
     daemon->overflow_counter = 0;
+    memset(daemon->evicted_counter, 0, sizeof(daemon->evicted_counter));
+    daemon->overflow_total = 0;
+    memset(daemon->evicted_total, 0, sizeof(daemon->evicted_total));
 
     daemon->runtime_context_cfg_loaded = 0;
 
@@ -185,6 +547,8 @@ int mct_daemon_init(MctDaemon *daemon,
     }
 
     daemon->storage_handle = NULL;
+    daemon->storage_writer = NULL;
+    daemon->storage_metrics = NULL;
     return 0;
 }
 
@@ -211,14 +575,14 @@ int mct_daemon_free(MctDaemon *daemon, int verbose)
     }
 
     free(daemon->user_list);
-
-    if (app_recv_buffer) {
-        free(app_recv_buffer);
-    }
+    daemon->user_list = NULL;
+    daemon->num_user_lists = 0;
 
     /* free ringbuffer */
     mct_buffer_free_dynamic(&(daemon->client_ringbuffer));
 
+    mct_daemon_runtime_store_free(&daemon->runtime_store);
+
     return 0;
 }
 
@@ -281,6 +645,9 @@ int mct_daemon_applications_clear(MctDaemon *daemon, char *ecu, int verbose)
 
     user_list->applications = NULL;
     user_list->num_applications = 0;
+    user_list->max_applications = 0;
+    mct_daemon_index_free(&user_list->application_index);
+    mct_daemon_log_info_cache_invalidate(user_list, NULL, NULL, MCT_DAEMON_LOG_INFO_CHANGED_ALL);
 
     return 0;
 }
@@ -327,7 +694,7 @@ MctDaemonApplication *mct_daemon_application_add(MctDaemon *daemon,
 {
     MctDaemonApplication *application;
     MctDaemonApplication *old;
-    int new_application;
+    int max;
     int mct_user_handle;
     bool owns_user_handle;
     MctDaemonRegisteredUsers *user_list = NULL;
@@ -346,46 +713,38 @@ MctDaemonApplication *mct_daemon_application_add(MctDaemon *daemon,
         return (MctDaemonApplication *)NULL;
     }
 
-    if (user_list->applications == NULL) {
-        user_list->applications = (MctDaemonApplication *)
-            malloc(sizeof(MctDaemonApplication) * MCT_DAEMON_APPL_ALLOC_SIZE);
-
-        if (user_list->applications == NULL) {
-            return (MctDaemonApplication *)NULL;
-        }
-    }
-
-    new_application = 0;
+    /* new application or new description */
+    mct_daemon_log_info_cache_invalidate(user_list, apid, NULL, MCT_DAEMON_LOG_INFO_CHANGED_IDS);
+    mct_daemon_runtime_config_mark(daemon, ecu, apid, NULL);
 
     /* Check if application [apid] is already available */
     application = mct_daemon_application_find(daemon, apid, ecu, verbose);
 
     if (application == NULL) {
-        user_list->num_applications += 1;
+        if (user_list->num_applications == user_list->max_applications) {
+            /* grow geometrically, at least by MCT_DAEMON_APPL_ALLOC_SIZE entries */
+            max = user_list->max_applications +
+                ((user_list->max_applications > MCT_DAEMON_APPL_ALLOC_SIZE) ?
+                 user_list->max_applications : MCT_DAEMON_APPL_ALLOC_SIZE);
+            old = realloc(user_list->applications, sizeof(MctDaemonApplication) * (size_t)max);
+
+            if (old == NULL) {
+                return (MctDaemonApplication *)NULL;
+            }
 
-        if (user_list->num_applications != 0) {
-            if ((user_list->num_applications % MCT_DAEMON_APPL_ALLOC_SIZE) == 0) {
-                /* allocate memory in steps of MCT_DAEMON_APPL_ALLOC_SIZE, e.g. 100 */
-                old = user_list->applications;
-                user_list->applications = (MctDaemonApplication *)
-                    malloc(sizeof(MctDaemonApplication) *
-                           ((user_list->num_applications / MCT_DAEMON_APPL_ALLOC_SIZE) + 1) *
-                           MCT_DAEMON_APPL_ALLOC_SIZE);
-
-                if (user_list->applications == NULL) {
-                    user_list->applications = old;
-                    user_list->num_applications -= 1;
-                    return (MctDaemonApplication *)NULL;
-                }
+            user_list->applications = old;
+            user_list->max_applications = max;
+        }
 
-                memcpy(user_list->applications,
-                       old,
-                       sizeof(MctDaemonApplication) * user_list->num_applications);
-                free(old);
-            }
+        if (mct_daemon_index_set(&user_list->application_index,
+                                 mct_daemon_index_key(apid, NULL),
+                                 user_list->num_applications) != MCT_RETURN_OK) {
+            return (MctDaemonApplication *)NULL;
         }
 
-        application = &(user_list->applications[user_list->num_applications - 1]);
+        /* appended in registration order, sorted on demand */
+        application = &(user_list->applications[user_list->num_applications]);
+        user_list->num_applications += 1;
 
         mct_set_id(application->apid, apid);
         application->pid = 0;
@@ -395,7 +754,10 @@ MctDaemonApplication *mct_daemon_application_add(MctDaemon *daemon,
         application->blockmode_status = MCT_MODE_NON_BLOCKING;
         application->owns_user_handle = false;
 
-        new_application = 1;
+        if ((user_list->num_applications > 1) &&
+            (mct_daemon_cmp_apid(application - 1, application) > 0)) {
+            user_list->sorted = false;
+        }
     } else if ((pid != application->pid) && (application->pid != 0)) {
 
         mct_vlog(
@@ -472,17 +834,6 @@ MctDaemonApplication *mct_daemon_application_add(MctDaemon *daemon,
         application->pid = pid;
     }
 
-    /* Sort */
-    if (new_application) {
-        qsort(user_list->applications,
-              user_list->num_applications,
-              sizeof(MctDaemonApplication),
-              mct_daemon_cmp_apid);
-
-        /* Find new position of application with apid*/
-        application = mct_daemon_application_find(daemon, apid, ecu, verbose);
-    }
-
     return application;
 }
 
@@ -492,6 +843,7 @@ int mct_daemon_application_del(MctDaemon *daemon,
                                int verbose)
 {
     int pos;
+    int last;
     MctDaemonRegisteredUsers *user_list = NULL;
 
     PRINT_FUNCTION_VERBOSE(verbose);
@@ -507,6 +859,10 @@ int mct_daemon_application_del(MctDaemon *daemon,
     }
 
     if (user_list->num_applications > 0) {
+        mct_daemon_log_info_cache_invalidate(user_list, application->apid, NULL,
+                                             MCT_DAEMON_LOG_INFO_CHANGED_IDS);
+        mct_daemon_runtime_config_mark(daemon, ecu, application->apid, NULL);
+
         mct_daemon_application_reset_user_handle(daemon, application, verbose);
 
         /* Free description of application to be deleted */
@@ -516,16 +872,22 @@ int mct_daemon_application_del(MctDaemon *daemon,
         }
 
         pos = application - (user_list->applications);
-
-        /* move all applications above pos to pos */
-        memmove(&(user_list->applications[pos]),
-                &(user_list->applications[pos + 1]),
-                sizeof(MctDaemonApplication) * ((user_list->num_applications - 1) - pos));
+        last = user_list->num_applications - 1;
+
+        mct_daemon_index_remove(&user_list->application_index,
+                                mct_daemon_index_key(application->apid, NULL));
+
+        /* move last application to pos */
+        if (pos != last) {
+            user_list->applications[pos] = user_list->applications[last];
+            mct_daemon_index_set(&user_list->application_index,
+                                 mct_daemon_index_key(user_list->applications[pos].apid, NULL),
+                                 pos);
+            user_list->sorted = false;
+        }
 
         /* Clear last application */
-        memset(&(user_list->applications[user_list->num_applications - 1]),
-               0,
-               sizeof(MctDaemonApplication));
+        memset(&(user_list->applications[last]), 0, sizeof(MctDaemonApplication));
 
         user_list->num_applications--;
     }
@@ -538,8 +900,8 @@ MctDaemonApplication *mct_daemon_application_find(MctDaemon *daemon,
                                                   char *ecu,
                                                   int verbose)
 {
-    MctDaemonApplication application;
     MctDaemonRegisteredUsers *user_list = NULL;
+    int pos;
 
     PRINT_FUNCTION_VERBOSE(verbose);
 
@@ -554,20 +916,14 @@ MctDaemonApplication *mct_daemon_application_find(MctDaemon *daemon,
         return (MctDaemonApplication *)NULL;
     }
 
-    /* Check, if apid is smaller than smallest apid or greater than greatest apid */
-    if ((memcmp(apid, user_list->applications[0].apid, MCT_ID_SIZE) < 0) ||
-        (memcmp(apid,
-                user_list->applications[user_list->num_applications - 1].apid,
-                MCT_ID_SIZE) > 0)) {
+    pos = mct_daemon_index_find(&user_list->application_index,
+                                mct_daemon_index_key(apid, NULL));
+
+    if (pos < 0) {
         return (MctDaemonApplication *)NULL;
     }
 
-    mct_set_id(application.apid, apid);
-    return (MctDaemonApplication *)bsearch(&application,
-                                           user_list->applications,
-                                           user_list->num_applications,
-                                           sizeof(MctDaemonApplication),
-                                           mct_daemon_cmp_apid);
+    return &(user_list->applications[pos]);
 }
 
 int mct_daemon_applications_load(MctDaemon *daemon, const char *filename, int verbose)
@@ -682,6 +1038,9 @@ int mct_daemon_applications_save(MctDaemon *daemon, const char *filename, int ve
         return -1;
     }
 
+    /* store in sort order */
+    mct_daemon_user_list_sort(user_list);
+
     if ((user_list->applications != NULL) && (user_list->num_applications > 0)) {
         fd = fopen(filename, "w");
 
@@ -726,6 +1085,7 @@ MctDaemonContext *mct_daemon_context_add(MctDaemon *daemon,
     MctDaemonContext *context;
     MctDaemonContext *old;
     int new_context = 0;
+    int max;
     MctDaemonRegisteredUsers *user_list = NULL;
 
     PRINT_FUNCTION_VERBOSE(verbose);
@@ -749,15 +1109,6 @@ MctDaemonContext *mct_daemon_context_add(MctDaemon *daemon,
         return (MctDaemonContext *)NULL;
     }
 
-    if (user_list->contexts == NULL) {
-        user_list->contexts = (MctDaemonContext *)malloc(
-                sizeof(MctDaemonContext) * MCT_DAEMON_CONTEXT_ALLOC_SIZE);
-
-        if (user_list->contexts == NULL) {
-            return (MctDaemonContext *)NULL;
-        }
-    }
-
     /* Check if application [apid] is available */
     application = mct_daemon_application_find(daemon, apid, ecu, verbose);
 
@@ -765,41 +1116,48 @@ MctDaemonContext *mct_daemon_context_add(MctDaemon *daemon,
         return (MctDaemonContext *)NULL;
     }
 
+    /* new context, new description or log level */
+    mct_daemon_log_info_cache_invalidate(user_list, apid, ctid, MCT_DAEMON_LOG_INFO_CHANGED_IDS);
+    mct_daemon_runtime_config_mark(daemon, ecu, apid, ctid);
+
     /* Check if context [apid, ctid] is already available */
     context = mct_daemon_context_find(daemon, apid, ctid, ecu, verbose);
 
     if (context == NULL) {
-        user_list->num_contexts += 1;
+        if (user_list->num_contexts == user_list->max_contexts) {
+            /* grow geometrically, at least by MCT_DAEMON_CONTEXT_ALLOC_SIZE entries */
+            max = user_list->max_contexts +
+                ((user_list->max_contexts > MCT_DAEMON_CONTEXT_ALLOC_SIZE) ?
+                 user_list->max_contexts : MCT_DAEMON_CONTEXT_ALLOC_SIZE);
+            old = realloc(user_list->contexts, sizeof(MctDaemonContext) * (size_t)max);
+
+            if (old == NULL) {
+                return (MctDaemonContext *)NULL;
+            }
 
-        if (user_list->num_contexts != 0) {
-            if ((user_list->num_contexts % MCT_DAEMON_CONTEXT_ALLOC_SIZE) == 0) {
-                /* allocate memory for context in steps of MCT_DAEMON_CONTEXT_ALLOC_SIZE, e.g 100 */
-                old = user_list->contexts;
-                user_list->contexts = (MctDaemonContext *)malloc(sizeof(MctDaemonContext) *
-                                                                 ((user_list->num_contexts /
-                                                                   MCT_DAEMON_CONTEXT_ALLOC_SIZE) +
-                                                                  1) *
-                                                                 MCT_DAEMON_CONTEXT_ALLOC_SIZE);
-
-                if (user_list->contexts == NULL) {
-                    user_list->contexts = old;
-                    user_list->num_contexts -= 1;
-                    return (MctDaemonContext *)NULL;
-                }
+            user_list->contexts = old;
+            user_list->max_contexts = max;
+        }
 
-                memcpy(user_list->contexts,
-                       old,
-                       sizeof(MctDaemonContext) * user_list->num_contexts);
-                free(old);
-            }
+        if (mct_daemon_index_set(&user_list->context_index,
+                                 mct_daemon_index_key(apid, ctid),
+                                 user_list->num_contexts) != MCT_RETURN_OK) {
+            return (MctDaemonContext *)NULL;
         }
 
-        context = &(user_list->contexts[user_list->num_contexts - 1]);
+        /* appended in registration order, sorted on demand */
+        context = &(user_list->contexts[user_list->num_contexts]);
+        user_list->num_contexts += 1;
         memset(context, 0, sizeof(MctDaemonContext));
 
         mct_set_id(context->apid, apid);
         mct_set_id(context->ctid, ctid);
 
+        if ((user_list->num_contexts > 1) &&
+            (mct_daemon_cmp_apid_ctid(context - 1, context) > 0)) {
+            user_list->sorted = false;
+        }
+
         application->num_contexts++;
         new_context = 1;
     }
@@ -856,17 +1214,6 @@ MctDaemonContext *mct_daemon_context_add(MctDaemon *daemon,
         context->predefined = false;
     }
 
-    /* Sort */
-    if (new_context) {
-        qsort(user_list->contexts,
-              user_list->num_contexts,
-              sizeof(MctDaemonContext),
-              mct_daemon_cmp_apid_ctid);
-
-        /* Find new position of context with apid, ctid */
-        context = mct_daemon_context_find(daemon, apid, ctid, ecu, verbose);
-    }
-
     return context;
 }
 
@@ -876,6 +1223,7 @@ int mct_daemon_context_del(MctDaemon *daemon,
                            int verbose)
 {
     int pos;
+    int last;
     MctDaemonApplication *application;
     MctDaemonRegisteredUsers *user_list = NULL;
 
@@ -892,6 +1240,10 @@ int mct_daemon_context_del(MctDaemon *daemon,
     }
 
     if (user_list->num_contexts > 0) {
+        mct_daemon_log_info_cache_invalidate(user_list, context->apid, context->ctid,
+                                             MCT_DAEMON_LOG_INFO_CHANGED_IDS);
+        mct_daemon_runtime_config_mark(daemon, ecu, context->apid, context->ctid);
+
         application = mct_daemon_application_find(daemon, context->apid, ecu, verbose);
 
         /* Free description of context to be deleted */
@@ -901,16 +1253,23 @@ int mct_daemon_context_del(MctDaemon *daemon,
         }
 
         pos = context - (user_list->contexts);
-
-        /* move all contexts above pos to pos */
-        memmove(&(user_list->contexts[pos]),
-                &(user_list->contexts[pos + 1]),
-                sizeof(MctDaemonContext) * ((user_list->num_contexts - 1) - pos));
+        last = user_list->num_contexts - 1;
+
+        mct_daemon_index_remove(&user_list->context_index,
+                                mct_daemon_index_key(context->apid, context->ctid));
+
+        /* move last context to pos */
+        if (pos != last) {
+            user_list->contexts[pos] = user_list->contexts[last];
+            mct_daemon_index_set(&user_list->context_index,
+                                 mct_daemon_index_key(user_list->contexts[pos].apid,
+                                                      user_list->contexts[pos].ctid),
+                                 pos);
+            user_list->sorted = false;
+        }
 
         /* Clear last context */
-        memset(&(user_list->contexts[user_list->num_contexts - 1]),
-               0,
-               sizeof(MctDaemonContext));
+        memset(&(user_list->contexts[last]), 0, sizeof(MctDaemonContext));
 
         user_list->num_contexts--;
 
@@ -929,8 +1288,8 @@ MctDaemonContext *mct_daemon_context_find(MctDaemon *daemon,
                                           char *ecu,
                                           int verbose)
 {
-    MctDaemonContext context;
     MctDaemonRegisteredUsers *user_list = NULL;
+    int pos;
 
     PRINT_FUNCTION_VERBOSE(verbose);
 
@@ -945,22 +1304,14 @@ MctDaemonContext *mct_daemon_context_find(MctDaemon *daemon,
         return (MctDaemonContext *)NULL;
     }
 
-    /* Check, if apid is smaller than smallest apid or greater than greatest apid */
-    if ((memcmp(apid, user_list->contexts[0].apid, MCT_ID_SIZE) < 0) ||
-        (memcmp(apid,
-                user_list->contexts[user_list->num_contexts - 1].apid,
-                MCT_ID_SIZE) > 0)) {
+    pos = mct_daemon_index_find(&user_list->context_index,
+                                mct_daemon_index_key(apid, ctid));
+
+    if (pos < 0) {
         return (MctDaemonContext *)NULL;
     }
 
-    mct_set_id(context.apid, apid);
-    mct_set_id(context.ctid, ctid);
-
-    return (MctDaemonContext *)bsearch(&context,
-                                       user_list->contexts,
-                                       user_list->num_contexts,
-                                       sizeof(MctDaemonContext),
-                                       mct_daemon_cmp_apid_ctid);
+    return &(user_list->contexts[pos]);
 }
 
 int mct_daemon_contexts_invalidate_fd(MctDaemon *daemon,
@@ -1021,6 +1372,10 @@ int mct_daemon_contexts_clear(MctDaemon *daemon, char *ecu, int verbose)
         users->contexts = NULL;
     }
 
+    users->max_contexts = 0;
+    mct_daemon_index_free(&users->context_index);
+    mct_daemon_log_info_cache_invalidate(users, NULL, NULL, MCT_DAEMON_LOG_INFO_CHANGED_ALL);
+
     for (i = 0; i < users->num_applications; i++) {
         users->applications[i].num_contexts = 0;
     }
@@ -1158,6 +1513,9 @@ int mct_daemon_contexts_save(MctDaemon *daemon, const char *filename, int verbos
         return -1;
     }
 
+    /* store in sort order */
+    mct_daemon_user_list_sort(user_list);
+
     memset(apid, 0, sizeof(apid));
     memset(ctid, 0, sizeof(ctid));
 
@@ -1172,12 +1530,12 @@ int mct_daemon_contexts_save(MctDaemon *daemon, const char *filename, int verbos
                 if ((user_list->contexts[i].context_description) &&
                     (user_list->contexts[i].context_description[0] != '\0')) {
                     fprintf(fd, "%s:%s:%d:%d:%s:\n", apid, ctid,
-                            (int)(user_list->contexts[i].log_level),
+                            (int)mct_daemon_context_stored_log_level(&user_list->contexts[i]),
                             (int)(user_list->contexts[i].trace_status),
                             user_list->contexts[i].context_description);
                 } else {
                     fprintf(fd, "%s:%s:%d:%d::\n", apid, ctid,
-                            (int)(user_list->contexts[i].log_level),
+                            (int)mct_daemon_context_stored_log_level(&user_list->contexts[i]),
                             (int)(user_list->contexts[i].trace_status));
                 }
             }
@@ -1281,6 +1639,214 @@ int mct_daemon_configuration_load(MctDaemon *daemon, const char *filename, int v
     return 0;
 }
 
+/* apply one record of the binary runtime configuration */
+static int mct_daemon_runtime_config_apply(void *data, const MctDaemonRuntimeEntry *entry)
+{
+    MctDaemon *daemon = (MctDaemon *)data;
+    MctDaemonApplication *application = NULL;
+    MctDaemonContext *context = NULL;
+    char apid[MCT_ID_SIZE];
+    char ctid[MCT_ID_SIZE];
+    char description[MCT_DAEMON_DESCSIZE + 1];
+    uint16_t len = 0;
+
+    memcpy(apid, entry->apid, MCT_ID_SIZE);
+    memcpy(ctid, entry->ctid, MCT_ID_SIZE);
+
+    len = (entry->description_length > MCT_DAEMON_DESCSIZE) ?
+        MCT_DAEMON_DESCSIZE : entry->description_length;
+    memcpy(description, entry->description, len);
+    description[len] = '\0';
+
+    switch (entry->type) {
+    case MCT_DAEMON_RUNTIME_RECORD_APPLICATION:
+        /* pid is unknown at loading time */
+        application = mct_daemon_application_add(daemon, apid, 0, description, -1,
+                                                 daemon->ecuid, 0);
+        break;
+    case MCT_DAEMON_RUNTIME_RECORD_CONTEXT:
+        /* log_level_pos, and user_handle are unknown at loading time */
+        context = mct_daemon_context_add(daemon, apid, ctid, entry->log_level,
+                                         entry->trace_status, 0, 0, description,
+                                         daemon->ecuid, 0);
+        break;
+    case MCT_DAEMON_RUNTIME_RECORD_APPLICATION_DEL:
+        application = mct_daemon_application_find(daemon, apid, daemon->ecuid, 0);
+
+        if (application != NULL) {
+            mct_daemon_application_del(daemon, application, daemon->ecuid, 0);
+        }
+
+        return 0;
+    case MCT_DAEMON_RUNTIME_RECORD_CONTEXT_DEL:
+        context = mct_daemon_context_find(daemon, apid, ctid, daemon->ecuid, 0);
+
+        if (context != NULL) {
+            mct_daemon_context_del(daemon, context, daemon->ecuid, 0);
+        }
+
+        return 0;
+    default:
+        return -1;
+    }
+
+    if ((application == NULL) && (context == NULL)) {
+        mct_vlog(LOG_WARNING, "%s: Cannot restore %.4s:%.4s\n", __func__, apid, ctid);
+        return -1;
+    }
+
+    return 0;
+}
+
+int mct_daemon_runtime_config_load(MctDaemon *daemon, int verbose)
+{
+    MctDaemonRuntimeStore *store = NULL;
+    int ret = 0;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if (daemon == NULL) {
+        return -1;
+    }
+
+    store = &daemon->runtime_store;
+
+    if (store->enabled &&
+        (mct_daemon_runtime_store_load(store, mct_daemon_runtime_config_apply,
+                                       daemon) == MCT_RETURN_OK)) {
+        return 0;
+    }
+
+    /* text format, or import of the text files into the first snapshot */
+    if ((mct_daemon_applications_load(daemon, daemon->runtime_application_cfg, verbose) != 0) ||
+        (mct_daemon_contexts_load(daemon, daemon->runtime_context_cfg, verbose) != 0)) {
+        ret = -1;
+    }
+
+    mct_daemon_runtime_store_clear(store);
+
+    return ret;
+}
+
+int mct_daemon_runtime_config_save(MctDaemon *daemon, int verbose)
+{
+    MctDaemonRuntimeStore *store = NULL;
+    MctDaemonRegisteredUsers *user_list = NULL;
+    MctDaemonApplication *application = NULL;
+    MctDaemonContext *context = NULL;
+    const MctDaemonRuntimeKey *keys = NULL;
+    MctDaemonRuntimeEntry entry;
+    bool snapshot = false;
+    int num = 0;
+    int i = 0;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if (daemon == NULL) {
+        return -1;
+    }
+
+    store = &daemon->runtime_store;
+
+    if (!store->enabled) {
+        if ((mct_daemon_applications_save(daemon, daemon->runtime_application_cfg, verbose) != 0) ||
+            (mct_daemon_contexts_save(daemon, daemon->runtime_context_cfg, verbose) != 0)) {
+            return -1;
+        }
+
+        return 0;
+    }
+
+    user_list = mct_daemon_find_users_list(daemon, daemon->ecuid, verbose);
+
+    if (user_list == NULL) {
+        return -1;
+    }
+
+    snapshot = mct_daemon_runtime_store_need_snapshot(store);
+
+    if (snapshot) {
+        /* all applications, then all contexts */
+        num = user_list->num_applications + user_list->num_contexts;
+    } else {
+        num = mct_daemon_runtime_store_pending(store, &keys);
+    }
+
+    for (i = 0; i < num; i++) {
+        memset(&entry, 0, sizeof(entry));
+
+        if (snapshot) {
+            application = (i < user_list->num_applications) ?
+                &user_list->applications[i] : NULL;
+            context = (i < user_list->num_applications) ?
+                NULL : &user_list->contexts[i - user_list->num_applications];
+        } else if (keys[i].ctid[0] == '\0') {
+            application = mct_daemon_application_find(daemon, (char *)keys[i].apid,
+                                                      daemon->ecuid, verbose);
+            context = NULL;
+            entry.type = MCT_DAEMON_RUNTIME_RECORD_APPLICATION_DEL;
+            memcpy(entry.apid, keys[i].apid, MCT_ID_SIZE);
+        } else {
+            application = NULL;
+            context = mct_daemon_context_find(daemon, (char *)keys[i].apid,
+                                              (char *)keys[i].ctid, daemon->ecuid, verbose);
+            entry.type = MCT_DAEMON_RUNTIME_RECORD_CONTEXT_DEL;
+            memcpy(entry.apid, keys[i].apid, MCT_ID_SIZE);
+            memcpy(entry.ctid, keys[i].ctid, MCT_ID_SIZE);
+        }
+
+        if (application != NULL) {
+            entry.type = MCT_DAEMON_RUNTIME_RECORD_APPLICATION;
+            memcpy(entry.apid, application->apid, MCT_ID_SIZE);
+            entry.description = application->application_description;
+        } else if (context != NULL) {
+            entry.type = MCT_DAEMON_RUNTIME_RECORD_CONTEXT;
+            memcpy(entry.apid, context->apid, MCT_ID_SIZE);
+            memcpy(entry.ctid, context->ctid, MCT_ID_SIZE);
+            entry.log_level = mct_daemon_context_stored_log_level(context);
+            entry.trace_status = context->trace_status;
+            entry.description = context->context_description;
+        }
+
+        if (entry.description != NULL) {
+            entry.description_length = (uint16_t)strnlen(entry.description, MCT_DAEMON_DESCSIZE);
+        }
+
+        if (mct_daemon_runtime_store_add(store, &entry) != MCT_RETURN_OK) {
+            mct_vlog(LOG_ERR, "%s: Cannot store %.4s:%.4s\n", __func__, entry.apid, entry.ctid);
+            return -1;
+        }
+    }
+
+    if (mct_daemon_runtime_store_commit(store, snapshot) != MCT_RETURN_OK) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int8_t mct_daemon_context_stored_log_level(MctDaemonContext *context)
+{
+    if (context->throttled && (context->log_level == context->throttle_log_level)) {
+        return context->saved_log_level;
+    }
+
+    return context->log_level;
+}
+
+void mct_daemon_context_changed(MctDaemon *daemon, MctDaemonContext *context, int verbose)
+{
+    if ((daemon == NULL) || (context == NULL)) {
+        return;
+    }
+
+    mct_daemon_log_info_cache_invalidate(mct_daemon_find_users_list(daemon, daemon->ecuid, verbose),
+                                         context->apid, context->ctid,
+                                         MCT_DAEMON_LOG_INFO_CHANGED_LOG_LEVEL |
+                                         MCT_DAEMON_LOG_INFO_CHANGED_TRACE_STATUS);
+    mct_daemon_runtime_config_mark(daemon, daemon->ecuid, context->apid, context->ctid);
+}
+
 int mct_daemon_user_send_log_level(MctDaemon *daemon, MctDaemonContext *context, int verbose)
 {
     MctUserHeader userheader;
@@ -1295,6 +1861,10 @@ int mct_daemon_user_send_log_level(MctDaemon *daemon, MctDaemonContext *context,
         return -1;
     }
 
+    /* changes of contexts without connection to the application call
+     * mct_daemon_context_changed directly */
+    mct_daemon_context_changed(daemon, context, verbose);
+
     if (mct_user_set_userheader(&userheader, MCT_USER_MESSAGE_LOG_LEVEL) < MCT_RETURN_OK) {
         mct_vlog(LOG_ERR, "Failed to set userheader in %s", __func__);
         return -1;
@@ -1418,6 +1988,8 @@ void mct_daemon_control_reset_to_factory_default(MctDaemon *daemon,
         unlink(filename1);
     }
 
+    mct_daemon_runtime_store_remove(&daemon->runtime_store);
+
     daemon->default_log_level = InitialContextLogLevel;
     daemon->default_trace_status = InitialContextTraceStatus;
     daemon->force_ll_ts = InitialEnforceLlTsStatus;
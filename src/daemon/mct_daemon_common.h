@@ -13,6 +13,9 @@
 #include "mct_common.h"
 #include "mct_user.h"
 #include "mct_offline_logstorage.h"
+#include "mct_daemon_runtime_store.h"
+#include "mct_daemon_metrics.h"
+#include "mct_daemon_logstorage_writer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,6 +24,15 @@ extern "C" {
 #define MCT_DAEMON_RINGBUFFER_MIN_SIZE    500000   /**< Ring buffer size for storing log messages while no client is connected */
 #define MCT_DAEMON_RINGBUFFER_MAX_SIZE  10000000   /**< Ring buffer size for storing log messages while no client is connected */
 #define MCT_DAEMON_RINGBUFFER_STEP_SIZE   500000   /**< Ring buffer size for storing log messages while no client is connected */
+#define MCT_DAEMON_SPOOL_SEGMENT_SIZE    1000000   /**< Size of one spool segment file, used when the ring buffer is full */
+#define MCT_DAEMON_SPOOL_MAX_SIZE      100000000   /**< Size of all spool segment files, used when the ring buffer is full */
+
+#define MCT_DAEMON_LOG_INFO_CACHE_SIZE     8   /**< Number of cached GET_LOG_INFO responses per user list */
+
+#define MCT_DAEMON_LOG_INFO_CHANGED_IDS          0x01 /**< applications, contexts or descriptions changed */
+#define MCT_DAEMON_LOG_INFO_CHANGED_LOG_LEVEL    0x02 /**< log level of contexts changed */
+#define MCT_DAEMON_LOG_INFO_CHANGED_TRACE_STATUS 0x04 /**< trace status of contexts changed */
+#define MCT_DAEMON_LOG_INFO_CHANGED_ALL          0x07
 
 #define MCT_DAEMON_SEND_TO_ALL     -3   /**< Constant value to identify the command "send to all" */
 #define MCT_DAEMON_SEND_FORCE      -4   /**< Constant value to identify the command "send force to all" */
@@ -66,8 +78,46 @@ typedef struct
     char *context_description; /**< context description */
     int8_t storage_log_level;  /**< log level set for offline logstorage */
     bool predefined;           /**< set to true if this context is predefined by runtime configuration file */
+    MctDaemonMetrics metrics;  /**< Counters of log messages of this context */
+    bool throttled;            /**< log level was lowered by the overload control */
+    int8_t throttle_log_level; /**< log level set by the overload control */
+    int8_t saved_log_level;    /**< log level before it was lowered by the overload control */
+    uint64_t throttle_messages; /**< messages counted at the last overload check */
 } MctDaemonContext;
 
+/**
+ * One slot of a registry index.
+ */
+typedef struct
+{
+    uint64_t key; /**< packed application id and context id */
+    int pos;      /**< position in indexed table, -1 if slot is empty */
+} MctDaemonIndexSlot;
+
+/**
+ * Open addressing hash table mapping ids to positions in the application
+ * or context table of a registered users list.
+ */
+typedef struct
+{
+    MctDaemonIndexSlot *slots; /**< slots, NULL if nothing is indexed yet */
+    int size;                  /**< number of slots, a power of two */
+    int count;                 /**< number of used slots */
+} MctDaemonIndex;
+
+/**
+ * Serialized GET_LOG_INFO response for one request option and id filter.
+ */
+typedef struct
+{
+    int8_t options;         /**< option of the request, 0 if the entry is unused */
+    char apid[MCT_ID_SIZE]; /**< application id of the request, empty for all applications */
+    char ctid[MCT_ID_SIZE]; /**< context id of the request, empty for all contexts */
+    uint8_t *data;          /**< response payload */
+    uint32_t size;          /**< size of response payload */
+    uint32_t used;          /**< time stamp of last use, the least recently used entry is replaced */
+} MctDaemonLogInfoCacheEntry;
+
 /*
  * The parameter of registered users list
  */
@@ -78,6 +128,13 @@ typedef struct
     MctDaemonContext *contexts;         /**< Pointer to contexts */
     int num_contexts;                   /**< Total number of all contexts in all applications in this list */
     char ecu[MCT_ID_SIZE];              /**< ECU ID of where contexts are registered */
+    int max_applications;               /**< Number of allocated applications */
+    int max_contexts;                   /**< Number of allocated contexts */
+    MctDaemonIndex application_index;   /**< Index of applications by application id */
+    MctDaemonIndex context_index;       /**< Index of contexts by application id and context id */
+    bool sorted;                        /**< applications and contexts are sorted by id */
+    MctDaemonLogInfoCacheEntry log_info_cache[MCT_DAEMON_LOG_INFO_CACHE_SIZE]; /**< cached GET_LOG_INFO responses */
+    uint32_t log_info_used;             /**< use counter of the GET_LOG_INFO cache */
 } MctDaemonRegisteredUsers;
 
 /**
@@ -91,6 +148,9 @@ typedef struct
     int8_t default_trace_status;                /**< Default trace status (of daemon) */
     int8_t force_ll_ts;                         /**< Enforce ll and ts to not exceed default_log_level, default_trace_status */
     unsigned int overflow_counter;              /**< counts the number of lost messages. */
+    unsigned int evicted_counter[MCT_BUFFER_PRIORITY_MAX]; /**< counts the messages evicted from the client ringbuffer per log level */
+    uint64_t overflow_total;                    /**< lost messages already reported by overflow messages */
+    uint64_t evicted_total[MCT_BUFFER_PRIORITY_MAX]; /**< evicted messages per log level already reported */
     int runtime_context_cfg_loaded;             /**< Set to one, if runtime context configuration has been loaded, zero otherwise */
     char ecuid[MCT_ID_SIZE];                    /**< ECU ID of daemon */
     int sendserialheader;                       /**< 1: send serial header; 0 don't send serial header */
@@ -99,11 +159,14 @@ typedef struct
     char runtime_application_cfg[PATH_MAX + 1]; /**< Path and filename of persistent application configuration. Set to path max, as it specifies a full path*/
     char runtime_context_cfg[PATH_MAX + 1];     /**< Path and filename of persistent context configuration */
     char runtime_configuration[PATH_MAX + 1];   /**< Path and filename of persistent configuration */
+    MctDaemonRuntimeStore runtime_store;        /**< Binary persistent application and context configuration */
     MctUserLogMode mode;                        /**< Mode used for tracing: off, external, internal, both */
     char connectionState;                       /**< state for tracing: 0 = no client connected, 1 = client connected */
     char *ECUVersionString;                     /**< Version string to send to client. Loaded from a file at startup. May be null. */
     MctDaemonState state;                       /**< the current logging state of mct daemon. */
     MctLogStorage *storage_handle;
+    MctDaemonLogStorageWriter *storage_writer;  /**< Writer thread per storage_handle, NULL if written by the event loop */
+    MctDaemonMetrics *storage_metrics;          /**< Counters per storage_handle */
     int blockMode;                    /**< current active BlockMode setting. */
     int maintain_logstorage_loglevel; /* Permission to maintain the logstorage loglevel*/
 } MctDaemon;
@@ -139,6 +202,67 @@ int mct_daemon_init(MctDaemon *daemon,
  */
 int mct_daemon_free(MctDaemon *daemon, int verbose);
 
+/**
+ * Allocate the list of registered applications and contexts of the daemon ECU.
+ * Must be called after the ECU id of the daemon is set.
+ * @param daemon pointer to mct daemon structure
+ * @param verbose if set to true verbose information is printed out.
+ * @return MCT_RETURN_OK on success, MCT_RETURN_ERROR otherwise
+ */
+int mct_daemon_init_user_information(MctDaemon *daemon, int verbose);
+
+/**
+ * Sort applications and contexts of a user list by their ids.
+ * Applications and contexts are stored in registration order and only sorted
+ * on demand, e.g. for control responses which walk the contexts of one
+ * application. Pointers to applications and contexts become invalid.
+ * @param user_list pointer to user list
+ */
+void mct_daemon_user_list_sort(MctDaemonRegisteredUsers *user_list);
+
+/**
+ * Get a cached GET_LOG_INFO response.
+ * @param user_list pointer to user list
+ * @param options option of the request
+ * @param apid application id of the request, empty for all applications
+ * @param ctid context id of the request, empty for all contexts
+ * @return pointer to cache entry, NULL if the response is not cached
+ */
+MctDaemonLogInfoCacheEntry *mct_daemon_log_info_cache_get(MctDaemonRegisteredUsers *user_list,
+                                                          int8_t options,
+                                                          const char *apid,
+                                                          const char *ctid);
+
+/**
+ * Store a GET_LOG_INFO response, replacing the least recently used one.
+ * @param user_list pointer to user list
+ * @param options option of the request
+ * @param apid application id of the request, empty for all applications
+ * @param ctid context id of the request, empty for all contexts
+ * @param data response payload, copied
+ * @param size size of response payload
+ */
+void mct_daemon_log_info_cache_put(MctDaemonRegisteredUsers *user_list,
+                                   int8_t options,
+                                   const char *apid,
+                                   const char *ctid,
+                                   const uint8_t *data,
+                                   uint32_t size);
+
+/**
+ * Drop cached GET_LOG_INFO responses affected by a change.
+ * Only responses which contain the changed application or context and the
+ * changed information are dropped.
+ * @param user_list pointer to user list
+ * @param apid changed application, NULL for all applications
+ * @param ctid changed context, NULL for all contexts of the application
+ * @param changed MCT_DAEMON_LOG_INFO_CHANGED_* flags
+ */
+void mct_daemon_log_info_cache_invalidate(MctDaemonRegisteredUsers *user_list,
+                                          const char *apid,
+                                          const char *ctid,
+                                          int changed);
+
 /**
  * Find information about application/contexts for a specific ECU
  * @param daemon pointer to mct daemon structure
@@ -344,7 +468,43 @@ int mct_daemon_configuration_load(MctDaemon *daemon, const char *filename, int v
  * @return negative value if there was an error
  */
 int mct_daemon_configuration_save(MctDaemon *daemon, const char *filename, int verbose);
+/**
+ * Load persistent applications and contexts
+ * In binary format, the text files are imported if no snapshot exists.
+ * @param daemon pointer to mct daemon structure
+ * @param verbose if set to true verbose information is printed out.
+ * @return negative value if there was an error
+ */
+int mct_daemon_runtime_config_load(MctDaemon *daemon, int verbose);
+/**
+ * Save applications and contexts persistently
+ * In binary format, only changes since the last save are appended to the
+ * journal unless a new snapshot is due.
+ * @param daemon pointer to mct daemon structure
+ * @param verbose if set to true verbose information is printed out.
+ * @return negative value if there was an error
+ */
+int mct_daemon_runtime_config_save(MctDaemon *daemon, int verbose);
+
+
+/**
+ * Get the log level of a context to be stored in the runtime configuration.
+ * A log level lowered by the overload control is not stored, the log level
+ * before is returned instead.
+ * @param context pointer to context
+ * @return log level to be stored
+ */
+int8_t mct_daemon_context_stored_log_level(MctDaemonContext *context);
 
+/**
+ * Forget cached GET_LOG_INFO responses of a context and mark it for the
+ * next runtime configuration store after its log level or trace status
+ * was changed
+ * @param daemon pointer to mct daemon structure
+ * @param context pointer to changed context
+ * @param verbose if set to true verbose information is printed out.
+ */
+void mct_daemon_context_changed(MctDaemon *daemon, MctDaemonContext *context, int verbose);
 
 /**
  * Send user message MCT_USER_MESSAGE_LOG_LEVEL to user application
@@ -14,6 +14,16 @@
 #define MCT_RUNTIME_CONTEXT_CFG     "/mct-runtime-context.cfg"
 /* Path and filename for runtime configuration */
 #define MCT_RUNTIME_CONFIGURATION     "/mct-runtime.cfg"
+/* Path and filename for binary runtime configuration (applications and contexts) */
+#define MCT_RUNTIME_SNAPSHOT        "/mct-runtime.snapshot"
+/* Path and filename for changes since the last binary runtime configuration */
+#define MCT_RUNTIME_JOURNAL         "/mct-runtime.journal"
+
+/* Size of the journal at which it is folded into a new snapshot */
+#define MCT_DAEMON_RUNTIME_JOURNAL_MAX_SIZE 65536
+/* Number of changed ids recorded between two stores, a snapshot is written
+ * if more ids change */
+#define MCT_DAEMON_RUNTIME_PENDING_MAX      4096
 
 /* Default Path for control socket */
 #define MCT_DAEMON_DEFAULT_CTRL_SOCK_PATH MCT_RUNTIME_DEFAULT_DIRECTORY \
@@ -38,6 +48,9 @@
 /* Number of entries to be allocated at one in context table,
  * when no more entries are available */
 #define MCT_DAEMON_CONTEXT_ALLOC_SIZE  1000
+/* Initial number of slots of the application and context indices,
+ * must be a power of two */
+#define MCT_DAEMON_INDEX_MIN_SIZE        64
 
 /* Debug get log info function,
  * set to 1 to enable, 0 to disable debugging */
@@ -8,6 +8,7 @@
 #include <syslog.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include "mct_daemon_connection_types.h"
 #include "mct_daemon_connection.h"
@@ -19,9 +20,9 @@
 #include "mct_daemon_common.h"
 #include "mct_common.h"
 #include "mct_daemon_socket.h"
+#include "mct_daemon_serial.h"
 
 static MctConnectionId connectionId;
-extern char *app_recv_buffer;
 
 /** @brief Generic sending function.
  *
@@ -112,6 +113,92 @@ int mct_connection_send_multiple(MctConnection *con,
     return ret;
 }
 
+/** @brief Send a vector of buffers through a connection.
+ *
+ * Used to forward a whole batch of messages at once, so that a connection
+ * is written once per batch instead of once per message part.
+ *
+ * @param con The connection to send the buffers through.
+ * @param iov The buffers to be sent, in order.
+ * @param iovcnt Number of buffers.
+ *
+ * @return MCT_DAEMON_ERROR_OK on success, MCT_DAEMON_ERROR_SEND_FAILED
+ *         on send failure, MCT_DAEMON_ERROR_UNKNOWN otherwise.
+ */
+int mct_connection_send_vector(MctConnection *con,
+                               const struct iovec *iov,
+                               int iovcnt)
+{
+    MctConnectionType type = MCT_CONNECTION_TYPE_MAX;
+
+    if ((con != NULL) && (con->receiver != NULL)) {
+        type = con->type;
+    }
+
+    if (iovcnt <= 0) {
+        return MCT_DAEMON_ERROR_OK;
+    }
+
+    switch (type) {
+        case MCT_CONNECTION_CLIENT_MSG_SERIAL:
+            return mct_daemon_serial_sendv(con->receiver->fd,
+                                           iov,
+                                           iovcnt);
+        case MCT_CONNECTION_CLIENT_MSG_TCP:
+            return mct_daemon_socket_sendvreliable(con->receiver->fd,
+                                                   iov,
+                                                   iovcnt);
+        default:
+            return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+}
+
+/** @brief Send as much of a buffer through a connection as it takes now.
+ *
+ * TCP connections are written without waiting for room in the socket
+ * buffer. Used to replay buffered messages to each client at its own pace,
+ * the caller keeps track of the position in the buffer.
+ *
+ * @param con The connection to send the buffer through.
+ * @param data The buffer to be sent.
+ * @param size Size of the buffer.
+ *
+ * @return Number of bytes sent, 0 if the connection cannot take data now,
+ *         -1 on send failure.
+ */
+int mct_connection_send_nonblocking(MctConnection *con,
+                                    const void *data,
+                                    size_t size)
+{
+    MctConnectionType type = MCT_CONNECTION_TYPE_MAX;
+    ssize_t ret = -1;
+
+    if ((con != NULL) && (con->receiver != NULL)) {
+        type = con->type;
+    }
+
+    switch (type) {
+        case MCT_CONNECTION_CLIENT_MSG_SERIAL:
+            ret = write(con->receiver->fd, data, size);
+            break;
+        case MCT_CONNECTION_CLIENT_MSG_TCP:
+            ret = send(con->receiver->fd, data, size, MSG_DONTWAIT);
+            break;
+        default:
+            return -1;
+    }
+
+    if (ret < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+            return 0;
+        }
+
+        return -1;
+    }
+
+    return (int)ret;
+}
+
 /** @brief Get the next connection filtered with a type mask.
  *
  * In some cases we need the next connection available of a specific type or
@@ -146,11 +233,6 @@ static void mct_connection_destroy_receiver(MctConnection *con)
         case MCT_CONNECTION_GATEWAY:
             /* We rely on the gateway for clean-up */
             break;
-        case MCT_CONNECTION_APP_MSG:
-            mct_receiver_free_global_buffer(con->receiver);
-            free(con->receiver);
-            con->receiver = NULL;
-            break;
         default:
             (void)mct_receiver_free(con->receiver);
             free(con->receiver);
@@ -167,14 +249,15 @@ static void mct_connection_destroy_receiver(MctConnection *con)
  * Based on the connection type provided, this function returns the pointer
  * to the MctReceiver structure corresponding.
  *
- * @param daemon_local Structure where to take the MctReceiver pointer from.
+ * @param daemon_local Structure where to take the receive buffer sizes from.
  * @param type Type of the connection.
  * @param fd File descriptor
  *
  * @return MctReceiver structure or NULL if none corresponds to the type.
  */
-static MctReceiver *mct_connection_get_receiver(MctConnectionType type,
-                                                    int fd)
+static MctReceiver *mct_connection_get_receiver(MctDaemonLocal *daemon_local,
+                                                MctConnectionType type,
+                                                int fd)
 {
     MctReceiver *ret = NULL;
     MctReceiverType receiver_type = MCT_RECEIVE_FD;
@@ -193,7 +276,8 @@ static MctReceiver *mct_connection_get_receiver(MctConnectionType type,
             ret = calloc(1, sizeof(MctReceiver));
 
             if (ret) {
-                mct_receiver_init(ret, fd, MCT_RECEIVE_SOCKET, MCT_DAEMON_RCVBUFSIZESOCK);
+                mct_receiver_init(ret, fd, MCT_RECEIVE_SOCKET,
+                                  (int)daemon_local->RecvBufSizeSocket);
             }
 
             break;
@@ -201,7 +285,8 @@ static MctReceiver *mct_connection_get_receiver(MctConnectionType type,
             ret = calloc(1, sizeof(MctReceiver));
 
             if (ret) {
-                mct_receiver_init(ret, fd, MCT_RECEIVE_FD, MCT_DAEMON_RCVBUFSIZESERIAL);
+                mct_receiver_init(ret, fd, MCT_RECEIVE_FD,
+                                  (int)daemon_local->RecvBufSizeSerial);
             }
 
             break;
@@ -221,7 +306,25 @@ static MctReceiver *mct_connection_get_receiver(MctConnectionType type,
             }
 
             if (ret) {
-                mct_receiver_init_global_buffer(ret, fd, receiver_type, &app_recv_buffer);
+                mct_receiver_init(ret, fd, receiver_type,
+                                  (int)daemon_local->RecvBufSizeApp);
+            }
+
+            break;
+        case MCT_CONNECTION_ONE_S_TIMER:
+        /* FALL THROUGH */
+        case MCT_CONNECTION_SIXTY_S_TIMER:
+        /* FALL THROUGH */
+        case MCT_CONNECTION_LOGSTORAGE_TIMER:
+#ifdef MCT_SYSTEMD_WATCHDOG_ENABLE
+        /* FALL THROUGH */
+        case MCT_CONNECTION_SYSTEMD_TIMER:
+#endif
+            /* the timer handlers read the expiration count from the fd */
+            ret = calloc(1, sizeof(MctReceiver));
+
+            if (ret) {
+                mct_receiver_init(ret, fd, MCT_RECEIVE_FD, (int)sizeof(uint64_t));
             }
 
             break;
@@ -229,9 +332,6 @@ static MctReceiver *mct_connection_get_receiver(MctConnectionType type,
         case MCT_CONNECTION_APP_CONNECT:
             /* FALL THROUGH */
 #endif
-        case MCT_CONNECTION_ONE_S_TIMER:
-        /* FALL THROUGH */
-        case MCT_CONNECTION_SIXTY_S_TIMER:
         default:
             ret = NULL;
     }
@@ -283,6 +383,9 @@ void *mct_connection_get_callback(MctConnection *con)
         case MCT_CONNECTION_SIXTY_S_TIMER:
             ret = mct_daemon_process_sixty_s_timer;
             break;
+        case MCT_CONNECTION_LOGSTORAGE_TIMER:
+            ret = mct_daemon_process_logstorage_timer;
+            break;
 #ifdef MCT_SYSTEMD_WATCHDOG_ENABLE
         case MCT_CONNECTION_SYSTEMD_TIMER:
             ret = mct_daemon_process_systemd_timer;
@@ -367,7 +470,7 @@ int mct_connection_create(MctDaemonLocal *daemon_local,
 
     memset(temp, 0, sizeof(MctConnection));
 
-    temp->receiver = mct_connection_get_receiver(type, fd);
+    temp->receiver = mct_connection_get_receiver(daemon_local, type, fd);
 
     if (!temp->receiver) {
         mct_vlog(LOG_CRIT, "Unable to get receiver from %u connection.\n",
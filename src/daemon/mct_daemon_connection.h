@@ -1,11 +1,15 @@
 #ifndef MCT_DAEMON_CONNECTION_H
 #define MCT_DAEMON_CONNECTION_H
 
+#include <sys/uio.h>
+
 #include "mct_daemon_connection_types.h"
 #include "mct_daemon_event_handler_types.h"
 #include "mct-daemon.h"
 
 int mct_connection_send_multiple(MctConnection *, void *, int, void *, int, int);
+int mct_connection_send_vector(MctConnection *, const struct iovec *, int);
+int mct_connection_send_nonblocking(MctConnection *, const void *, size_t);
 
 MctConnection *mct_connection_get_next(MctConnection *, int);
 int mct_connection_create_remaining(MctDaemonLocal *);
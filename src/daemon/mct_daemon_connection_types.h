@@ -1,6 +1,7 @@
 #ifndef MCT_DAEMON_CONNECTION_TYPES_H
 #define MCT_DAEMON_CONNECTION_TYPES_H
 #include "mct_common.h"
+#include "mct_daemon_metrics.h"
 
 typedef enum {
     UNDEFINED,  /* Undefined status */
@@ -27,6 +28,8 @@ typedef enum {
     MCT_CONNECTION_FILTER,
     MCT_CONNECTION_GATEWAY,
     MCT_CONNECTION_GATEWAY_TIMER,
+    MCT_CONNECTION_CLIENT_MSG_UDP,
+    MCT_CONNECTION_LOGSTORAGE_TIMER,
     MCT_CONNECTION_TYPE_MAX
 } MctConnectionType;
 
@@ -47,7 +50,9 @@ typedef enum {
 #define MCT_CON_MASK_FILTER             (1 << MCT_CONNECTION_FILTER)
 #define MCT_CON_MASK_GATEWAY            (1 << MCT_CONNECTION_GATEWAY)
 #define MCT_CON_MASK_GATEWAY_TIMER      (1 << MCT_CONNECTION_GATEWAY_TIMER)
-#define MCT_CON_MASK_ALL                (0xffff)
+#define MCT_CON_MASK_CLIENT_MSG_UDP     (1 << MCT_CONNECTION_CLIENT_MSG_UDP)
+#define MCT_CON_MASK_LOGSTORAGE_TIMER   (1 << MCT_CONNECTION_LOGSTORAGE_TIMER)
+#define MCT_CON_MASK_ALL                ((1 << MCT_CONNECTION_TYPE_MAX) - 1)
 
 #define MCT_CONNECTION_TO_MASK(C)        (1 << (C))
 
@@ -63,6 +68,10 @@ typedef struct MctConnection {
     MctConnectionStatus status; /**< Status of connection */
     struct MctConnection *next; /**< For multiple client connection using linked list */
     int ev_mask;                /**< Mask to set when registering the connection for events */
+    MctDaemonMetrics metrics;   /**< Counters of received or sent messages */
+    int backlog;                /**< Received messages are left over because the read budget was used up */
+    int replay;                 /**< Connection still has to get the current replay chunk */
+    uint32_t replay_offset;     /**< Bytes of the current replay chunk sent to this connection */
 } MctConnection;
 
 #endif /* MCT_DAEMON_CONNECTION_TYPES_H */
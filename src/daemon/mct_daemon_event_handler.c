@@ -144,11 +144,32 @@ static void mct_event_handler_disable_fd(MctEventHandler *ev, int fd)
     }
 }
 
+/** @brief Check for connections with left over messages
+ *
+ * @param ev The event handler structure where the list of connection is.
+ *
+ * @return 1 if a connection used up its read budget in the last round, 0 otherwise.
+ */
+static int mct_event_handler_has_backlog(MctEventHandler *ev)
+{
+    MctConnection *temp = NULL;
+
+    for (temp = ev->connections; temp != NULL; temp = temp->next) {
+        if (temp->backlog) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 /** @brief Catch and process incoming events.
  *
  * This function waits for events on all connections. Once an event raise,
  * the callback for the specific connection is called, or the connection is
  * destroyed if a hangup occurs.
+ * Connections which used up their read budget in the last round are
+ * continued without waiting, each ready connection is served once per round.
  *
  * @param daemon Structure to be passed to the callback.
  * @param daemon_local Structure containing needed information.
@@ -162,15 +183,18 @@ int mct_daemon_handle_event(MctEventHandler *pEvent,
 {
     int ret = 0;
     unsigned int i = 0;
+    int backlog = 0;
     int (*callback)(MctDaemon *, MctDaemonLocal *, MctReceiver *, int) = NULL;
 
     if ((pEvent == NULL) || (daemon == NULL) || (daemon_local == NULL)) {
         return MCT_RETURN_ERROR;
     }
 
-    ret = poll(pEvent->pfd, pEvent->nfds, MCT_EV_TIMEOUT_MSEC);
+    backlog = mct_event_handler_has_backlog(pEvent);
+
+    ret = poll(pEvent->pfd, pEvent->nfds, backlog ? 0 : MCT_EV_TIMEOUT_MSEC);
 
-    if (ret <= 0) {
+    if ((ret < 0) || ((ret == 0) && !backlog)) {
         /* We are not interested in EINTR has it comes
          * either from timeout or signal.
          */
@@ -191,10 +215,16 @@ int mct_daemon_handle_event(MctEventHandler *pEvent,
         MctConnectionType type = MCT_CONNECTION_TYPE_MAX;
 
         if (pEvent->pfd[i].revents == 0) {
-            continue;
-        }
+            if (backlog) {
+                con = mct_event_handler_find_connection(pEvent, pEvent->pfd[i].fd);
+            }
 
-        con = mct_event_handler_find_connection(pEvent, pEvent->pfd[i].fd);
+            if ((con == NULL) || !con->backlog) {
+                continue;
+            }
+        } else {
+            con = mct_event_handler_find_connection(pEvent, pEvent->pfd[i].fd);
+        }
 
         if (con && con->receiver) {
             type = con->type;
@@ -223,6 +253,28 @@ int mct_daemon_handle_event(MctEventHandler *pEvent,
             continue;
         }
 
+        /* A client is able to take more data: continue replaying the
+         * buffered messages to it, each client at its own pace.
+         */
+        if (pEvent->pfd[i].revents & POLLOUT) {
+            short revents = pEvent->pfd[i].revents;
+
+            if (mct_daemon_send_ringbuffer_to_connection(daemon,
+                                                         daemon_local,
+                                                         con,
+                                                         daemon_local->flags.vflag)) {
+                mct_log(LOG_DEBUG,
+                        "Can't send contents of ring buffer to client\n");
+            }
+
+            /* the connection is closed if sending failed */
+            con = mct_event_handler_find_connection(pEvent, fd);
+
+            if ((con == NULL) || !(revents & POLLIN)) {
+                continue;
+            }
+        }
+
         /* Get the function to be used to handle the event */
         callback = mct_connection_get_callback(con);
 
@@ -417,6 +469,38 @@ int mct_connection_check_activate(MctEventHandler *evhdl,
     return 0;
 }
 
+/** @brief Change the events watched for a connection
+ *
+ * Used to watch client connections for writability while the buffered
+ * messages are replayed.
+ *
+ * @param evhdl The event handler structure.
+ * @param con The connection to act on
+ * @param mask The new mask of events to be watched
+ */
+void mct_event_handler_update_mask(MctEventHandler *evhdl,
+                                   MctConnection *con,
+                                   int mask)
+{
+    nfds_t i = 0;
+
+    if (!evhdl || !con || !con->receiver || (con->ev_mask == mask)) {
+        return;
+    }
+
+    con->ev_mask = mask;
+
+    if (con->status != ACTIVE) {
+        return;
+    }
+
+    for (i = 0; i < evhdl->nfds; i++) {
+        if (evhdl->pfd[i].fd == con->receiver->fd) {
+            evhdl->pfd[i].events = mask;
+        }
+    }
+}
+
 /** @brief Registers a connection for event handling and takes its ownership.
  *
  * As we add the connection to the list of connection, we take its ownership.
@@ -30,4 +30,8 @@ int mct_connection_check_activate(MctEventHandler *,
                                   MctConnection *,
                                   MctMessageFilter *,
                                   int);
+
+void mct_event_handler_update_mask(MctEventHandler *,
+                                   MctConnection *,
+                                   int);
 #endif /* MCT_DAEMON_EVENT_HANDLER_H */
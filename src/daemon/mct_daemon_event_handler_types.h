@@ -15,6 +15,7 @@ typedef enum {
     MCT_TIMER_PACKET = 0,
     MCT_TIMER_ECU,
     MCT_TIMER_GATEWAY,
+    MCT_TIMER_LOGSTORAGE,
     MCT_TIMER_UNKNOWN
 } MctTimers;
 
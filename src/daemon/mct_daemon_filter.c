@@ -363,6 +363,8 @@ static MctReturnValue mct_daemon_filter_client_mask(MctMessageFilter *mf,
             config->client_mask |= MCT_CON_MASK_CLIENT_MSG_OFFLINE_LOGSTORAGE;
         } else if (strncasecmp(token, "Trace", strlen(token)) == 0) {
             config->client_mask |= MCT_CON_MASK_CLIENT_MSG_OFFLINE_TRACE;
+        } else if (strncasecmp(token, "UDP", strlen(token)) == 0) {
+            config->client_mask |= MCT_CON_MASK_CLIENT_MSG_UDP;
         } else {
             mct_vlog(LOG_INFO, "Ignoring unknown client type: %s\n", token);
         }
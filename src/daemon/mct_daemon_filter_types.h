@@ -17,6 +17,7 @@
         MCT_CON_MASK_ONE_S_TIMER | \
         MCT_CON_MASK_SIXTY_S_TIMER | \
         MCT_CON_MASK_SYSTEMD_TIMER | \
+        MCT_CON_MASK_LOGSTORAGE_TIMER | \
         MCT_CON_MASK_CONTROL_CONNECT | \
         MCT_CON_MASK_CONTROL_MSG)
 
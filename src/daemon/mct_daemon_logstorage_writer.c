@@ -0,0 +1,430 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+
+#include "mct_types.h"
+#include "mct_common.h"
+#include "mct-daemon_cfg.h"
+
+#include "mct_daemon_logstorage_writer.h"
+
+/* header of each record in the queue, followed by the filter pointers,
+ * the storage header, the message header and the payload */
+typedef struct
+{
+    uint32_t length; /**< length of record including header and padding */
+    int32_t num;     /**< number of filters or MCT_DAEMON_LOGSTORAGE_RECORD_* */
+    int32_t size1;   /**< size of storage header */
+    int32_t size2;   /**< size of message header */
+    int32_t size3;   /**< size of payload */
+    int32_t reserved;
+} MctDaemonLogStorageRecord;
+
+/* records start at multiples of this, so padding always has room for a header */
+#define MCT_DAEMON_LOGSTORAGE_RECORD_ALIGN 32
+
+/* values of num for records without message */
+#define MCT_DAEMON_LOGSTORAGE_RECORD_PADDING -1 /* skip up to the end of the queue */
+#define MCT_DAEMON_LOGSTORAGE_RECORD_SYNC    -2 /* sync with strategy size1 */
+
+/* wake up the other thread if it sleeps */
+static void mct_daemon_logstorage_writer_wake(MctDaemonLogStorageWriter *writer)
+{
+    if (__atomic_load_n(&writer->waiting, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&writer->lock);
+        pthread_cond_broadcast(&writer->cond);
+        pthread_mutex_unlock(&writer->lock);
+    }
+}
+
+/* absolute CLOCK_MONOTONIC time timeout ms from now */
+static void mct_daemon_logstorage_writer_deadline(struct timespec *deadline, int timeout)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += timeout / 1000;
+    deadline->tv_nsec += (timeout % 1000) * 1000000L;
+
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+/* hand the reserved records over to the writer thread */
+static void mct_daemon_logstorage_writer_publish(MctDaemonLogStorageWriter *writer)
+{
+    if (writer->next == writer->head) {
+        return;
+    }
+
+    __atomic_store_n(&writer->head, writer->next, __ATOMIC_SEQ_CST);
+    mct_daemon_logstorage_writer_wake(writer);
+}
+
+static void *mct_daemon_logstorage_writer_run(void *arg)
+{
+    MctDaemonLogStorageWriter *writer = (MctDaemonLogStorageWriter *)arg;
+    MctDaemonLogStorageRecord *record = NULL;
+    MctLogStorageFilterConfig **config = NULL;
+    unsigned char *data = NULL;
+    uint64_t tail = writer->tail;
+
+    for (;;) {
+        if (tail == __atomic_load_n(&writer->head, __ATOMIC_ACQUIRE)) {
+            pthread_mutex_lock(&writer->lock);
+            __atomic_add_fetch(&writer->waiting, 1, __ATOMIC_SEQ_CST);
+
+            /* a drain may wait for the queue to become empty */
+            pthread_cond_broadcast(&writer->cond);
+
+            while ((tail == __atomic_load_n(&writer->head, __ATOMIC_SEQ_CST)) &&
+                   !writer->stop) {
+                pthread_cond_wait(&writer->cond, &writer->lock);
+            }
+
+            __atomic_sub_fetch(&writer->waiting, 1, __ATOMIC_SEQ_CST);
+
+            if ((tail == __atomic_load_n(&writer->head, __ATOMIC_ACQUIRE)) && writer->stop) {
+                pthread_mutex_unlock(&writer->lock);
+                break;
+            }
+
+            pthread_mutex_unlock(&writer->lock);
+            continue;
+        }
+
+        record = (MctDaemonLogStorageRecord *)(writer->queue + (tail & (writer->size - 1)));
+
+        if (record->num == MCT_DAEMON_LOGSTORAGE_RECORD_SYNC) {
+            if (record->size1 == MCT_LOGSTORAGE_SYNC_ON_TIMER) {
+                mct_logstorage_sync_files(writer->handle);
+            } else {
+                mct_logstorage_sync_caches(writer->handle);
+            }
+        }
+        else if ((record->num >= 0) && !__atomic_load_n(&writer->failed, __ATOMIC_RELAXED)) {
+            config = (MctLogStorageFilterConfig **)(record + 1);
+            data = (unsigned char *)(config + record->num);
+
+            if (mct_logstorage_write_routed(writer->handle,
+                                            &writer->uconfig,
+                                            config,
+                                            record->num,
+                                            data,
+                                            record->size1,
+                                            data + record->size1,
+                                            record->size2,
+                                            data + record->size1 + record->size2,
+                                            record->size3) < 0) {
+                __atomic_store_n(&writer->failed, 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        tail += record->length;
+        __atomic_store_n(&writer->tail, tail, __ATOMIC_SEQ_CST);
+        mct_daemon_logstorage_writer_wake(writer);
+    }
+
+    return NULL;
+}
+
+int mct_daemon_logstorage_writer_init(MctDaemonLogStorageWriter *writer,
+                                      MctLogStorage *handle,
+                                      MctLogStorageUserConfig *uconfig,
+                                      uint32_t size,
+                                      int policy)
+{
+    uint32_t queue_size = MCT_DAEMON_LOGSTORAGE_RECORD_ALIGN;
+    pthread_condattr_t attr;
+
+    if ((writer == NULL) || (handle == NULL) || (uconfig == NULL) || (size == 0)) {
+        return MCT_RETURN_WRONG_PARAMETER;
+    }
+
+    memset(writer, 0, sizeof(MctDaemonLogStorageWriter));
+
+    while ((queue_size < size) && (queue_size < (1U << 31))) {
+        queue_size <<= 1;
+    }
+
+    writer->queue = malloc(queue_size);
+
+    if (writer->queue == NULL) {
+        mct_vlog(LOG_ERR, "%s: Cannot allocate %u bytes\n", __func__, queue_size);
+        return MCT_RETURN_ERROR;
+    }
+
+    writer->handle = handle;
+    writer->uconfig = *uconfig;
+    writer->size = queue_size;
+    writer->policy = policy;
+    pthread_mutex_init(&writer->lock, NULL);
+
+    /* waiting for room in the queue is bounded by a monotonic timeout */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&writer->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&writer->thread, NULL, mct_daemon_logstorage_writer_run, writer) != 0) {
+        mct_vlog(LOG_ERR, "%s: Cannot start writer thread\n", __func__);
+        pthread_cond_destroy(&writer->cond);
+        pthread_mutex_destroy(&writer->lock);
+        free(writer->queue);
+        writer->queue = NULL;
+        return MCT_RETURN_ERROR;
+    }
+
+    writer->started = 1;
+
+    return MCT_RETURN_OK;
+}
+
+void mct_daemon_logstorage_writer_free(MctDaemonLogStorageWriter *writer)
+{
+    if ((writer == NULL) || !writer->started) {
+        return;
+    }
+
+    mct_daemon_logstorage_writer_publish(writer);
+
+    pthread_mutex_lock(&writer->lock);
+    writer->stop = 1;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+
+    pthread_join(writer->thread, NULL);
+    writer->started = 0;
+
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->lock);
+    free(writer->queue);
+    writer->queue = NULL;
+}
+
+/* reserve room for a record of the given length, returns the record and the
+ * write position after it or NULL if the record is discarded */
+static MctDaemonLogStorageRecord *mct_daemon_logstorage_writer_reserve(MctDaemonLogStorageWriter *writer,
+                                                                       uint32_t length,
+                                                                       int policy,
+                                                                       uint64_t *next)
+{
+    MctDaemonLogStorageRecord *record = NULL;
+    uint64_t head = writer->next;
+    uint32_t offset = (uint32_t)(head & (writer->size - 1));
+    uint32_t padding = 0;
+
+    /* a record is never split, the rest of the queue is skipped instead */
+    if (writer->size - offset < length) {
+        padding = writer->size - offset;
+    }
+
+    if ((uint64_t)length + padding > writer->size) {
+        return NULL;
+    }
+
+    /* a stalled device takes messages again once half of its queue is
+     * free, a device which stays slow would otherwise hold up the event
+     * loop each time its queue is full again */
+    if (writer->stalled) {
+        if (head - __atomic_load_n(&writer->tail, __ATOMIC_ACQUIRE) >= writer->size / 2) {
+            return NULL;
+        }
+
+        mct_vlog(LOG_INFO, "%s: Device %s caught up\n",
+                 __func__, writer->handle->device_mount_point);
+        writer->stalled = 0;
+    }
+
+    if (writer->size - (head - __atomic_load_n(&writer->tail, __ATOMIC_ACQUIRE)) <
+        length + padding) {
+        struct timespec timeout;
+        int ret = 0;
+
+        if (policy != MCT_DAEMON_LOGSTORAGE_QUEUE_WAIT) {
+            return NULL;
+        }
+
+        /* the writer thread can only make room by writing what it has got */
+        mct_daemon_logstorage_writer_publish(writer);
+        mct_daemon_logstorage_writer_deadline(&timeout, MCT_DAEMON_LOGSTORAGE_QUEUE_TIMEOUT);
+
+        pthread_mutex_lock(&writer->lock);
+        __atomic_add_fetch(&writer->waiting, 1, __ATOMIC_SEQ_CST);
+
+        while ((ret == 0) &&
+               (writer->size - (head - __atomic_load_n(&writer->tail, __ATOMIC_SEQ_CST)) <
+                length + padding)) {
+            ret = pthread_cond_timedwait(&writer->cond, &writer->lock, &timeout);
+        }
+
+        __atomic_sub_fetch(&writer->waiting, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&writer->lock);
+
+        if (writer->size - (head - __atomic_load_n(&writer->tail, __ATOMIC_ACQUIRE)) <
+            length + padding) {
+            mct_vlog(LOG_WARNING,
+                     "%s: Device %s does not take messages, discard them until it catches up\n",
+                     __func__, writer->handle->device_mount_point);
+            writer->stalled = 1;
+            return NULL;
+        }
+    }
+
+    if (padding > 0) {
+        record = (MctDaemonLogStorageRecord *)(writer->queue + offset);
+        record->length = padding;
+        record->num = MCT_DAEMON_LOGSTORAGE_RECORD_PADDING;
+        head += padding;
+        offset = 0;
+    }
+
+    record = (MctDaemonLogStorageRecord *)(writer->queue + offset);
+    record->length = length;
+    *next = head + length;
+
+    return record;
+}
+
+int mct_daemon_logstorage_writer_push(MctDaemonLogStorageWriter *writer,
+                                      MctLogStorageFilterConfig **config,
+                                      int num,
+                                      unsigned char *data1,
+                                      int size1,
+                                      unsigned char *data2,
+                                      int size2,
+                                      unsigned char *data3,
+                                      int size3)
+{
+    MctDaemonLogStorageRecord *record = NULL;
+    uint8_t *dst = NULL;
+    uint64_t next = 0;
+    uint32_t length = 0;
+
+    length = (uint32_t)(sizeof(MctDaemonLogStorageRecord) +
+                        sizeof(MctLogStorageFilterConfig *) * (size_t)num +
+                        (size_t)size1 + (size_t)size2 + (size_t)size3);
+    length = (length + MCT_DAEMON_LOGSTORAGE_RECORD_ALIGN - 1) &
+        ~(uint32_t)(MCT_DAEMON_LOGSTORAGE_RECORD_ALIGN - 1);
+
+    record = mct_daemon_logstorage_writer_reserve(writer, length, writer->policy, &next);
+
+    if (record == NULL) {
+        writer->dropped++;
+        return MCT_RETURN_BUFFER_FULL;
+    }
+
+    record->num = num;
+    record->size1 = size1;
+    record->size2 = size2;
+    record->size3 = size3;
+
+    dst = (uint8_t *)(record + 1);
+    memcpy(dst, config, sizeof(MctLogStorageFilterConfig *) * (size_t)num);
+    dst += sizeof(MctLogStorageFilterConfig *) * (size_t)num;
+    memcpy(dst, data1, (size_t)size1);
+    memcpy(dst + size1, data2, (size_t)size2);
+    memcpy(dst + size1 + size2, data3, (size_t)size3);
+
+    writer->next = next;
+
+    return MCT_RETURN_OK;
+}
+
+void mct_daemon_logstorage_writer_flush(MctDaemonLogStorageWriter *writer)
+{
+    if ((writer == NULL) || !writer->started) {
+        return;
+    }
+
+    mct_daemon_logstorage_writer_publish(writer);
+}
+
+int mct_daemon_logstorage_writer_sync(MctDaemonLogStorageWriter *writer, int status)
+{
+    MctDaemonLogStorageRecord *record = NULL;
+    uint64_t next = 0;
+
+    if ((writer == NULL) || !writer->started) {
+        return MCT_RETURN_WRONG_PARAMETER;
+    }
+
+    /* a periodic sync never waits, the thread is busy writing anyway if
+     * the queue is full */
+    record = mct_daemon_logstorage_writer_reserve(writer,
+                                                  MCT_DAEMON_LOGSTORAGE_RECORD_ALIGN,
+                                                  (status == MCT_LOGSTORAGE_SYNC_ON_TIMER) ?
+                                                  MCT_DAEMON_LOGSTORAGE_QUEUE_DROP :
+                                                  MCT_DAEMON_LOGSTORAGE_QUEUE_WAIT,
+                                                  &next);
+
+    if (record == NULL) {
+        return MCT_RETURN_BUFFER_FULL;
+    }
+
+    record->num = MCT_DAEMON_LOGSTORAGE_RECORD_SYNC;
+    record->size1 = status;
+    writer->next = next;
+    mct_daemon_logstorage_writer_publish(writer);
+
+    return MCT_RETURN_OK;
+}
+
+void mct_daemon_logstorage_writer_drain(MctDaemonLogStorageWriter *writer)
+{
+    if ((writer == NULL) || !writer->started) {
+        return;
+    }
+
+    mct_daemon_logstorage_writer_publish(writer);
+
+    pthread_mutex_lock(&writer->lock);
+    __atomic_add_fetch(&writer->waiting, 1, __ATOMIC_SEQ_CST);
+
+    while (__atomic_load_n(&writer->tail, __ATOMIC_SEQ_CST) != writer->head) {
+        pthread_cond_wait(&writer->cond, &writer->lock);
+    }
+
+    __atomic_sub_fetch(&writer->waiting, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+int mct_daemon_logstorage_writer_wait(MctDaemonLogStorageWriter *writer, int timeout)
+{
+    struct timespec deadline;
+    int ret = 0;
+
+    if ((writer == NULL) || !writer->started) {
+        return MCT_RETURN_OK;
+    }
+
+    mct_daemon_logstorage_writer_publish(writer);
+    mct_daemon_logstorage_writer_deadline(&deadline, timeout);
+
+    pthread_mutex_lock(&writer->lock);
+    __atomic_add_fetch(&writer->waiting, 1, __ATOMIC_SEQ_CST);
+
+    while ((ret == 0) && (__atomic_load_n(&writer->tail, __ATOMIC_SEQ_CST) != writer->head)) {
+        ret = pthread_cond_timedwait(&writer->cond, &writer->lock, &deadline);
+    }
+
+    __atomic_sub_fetch(&writer->waiting, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&writer->lock);
+
+    if (__atomic_load_n(&writer->tail, __ATOMIC_SEQ_CST) != writer->head) {
+        return MCT_RETURN_ERROR;
+    }
+
+    return MCT_RETURN_OK;
+}
+
+uint32_t mct_daemon_logstorage_writer_get_queue_depth(MctDaemonLogStorageWriter *writer)
+{
+    if ((writer == NULL) || !writer->started) {
+        return 0;
+    }
+
+    return (uint32_t)(writer->next - __atomic_load_n(&writer->tail, __ATOMIC_ACQUIRE));
+}
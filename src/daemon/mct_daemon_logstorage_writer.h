@@ -0,0 +1,150 @@
+#ifndef MCT_DAEMON_LOGSTORAGE_WRITER_H
+#define MCT_DAEMON_LOGSTORAGE_WRITER_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "mct_common.h"
+#include "mct_offline_logstorage.h"
+
+#define MCT_DAEMON_LOGSTORAGE_QUEUE_DROP 0 /**< discard messages which do not fit into the queue */
+#define MCT_DAEMON_LOGSTORAGE_QUEUE_WAIT 1 /**< wait for the writer thread if the queue is full,
+                                            *   at most MCT_DAEMON_LOGSTORAGE_QUEUE_TIMEOUT */
+
+/**
+ * Writer thread of one offline logstorage device.
+ *
+ * The event loop resolves the filters of a message and appends the message
+ * together with its filters to a single producer, single consumer queue.
+ * The writer thread takes the messages from the queue and writes them to
+ * the log files, so slow devices do not stall the event loop.
+ *
+ * While the writer thread runs, only it touches the log files and caches
+ * of the device. The event loop drains the queue before it syncs, connects
+ * or disconnects the device, or lets the writer thread sync the device.
+ *
+ * Every device has its own queue, so devices are written in parallel. A
+ * device which does not take messages within MCT_DAEMON_LOGSTORAGE_QUEUE_TIMEOUT
+ * is marked stalled and its messages are discarded until half of its queue
+ * is free again, so it does not slow down the other devices.
+ */
+typedef struct
+{
+    MctLogStorage *handle;          /**< device written by this thread */
+    MctLogStorageUserConfig uconfig; /**< user configuration of log file names */
+    pthread_t thread;               /**< writer thread */
+    int started;                    /**< writer thread is running */
+    int stop;                       /**< writer thread shall exit once the queue is empty */
+    int policy;                     /**< MCT_DAEMON_LOGSTORAGE_QUEUE_* */
+    uint8_t *queue;                 /**< queued records */
+    uint32_t size;                  /**< size of queue, a power of two */
+    uint64_t head;                  /**< write position handed over to the writer thread */
+    uint64_t next;                  /**< write position of the event loop */
+    uint64_t tail;                  /**< read position of the writer thread */
+    int waiting;                    /**< a thread waits for the other one */
+    int failed;                     /**< writing failed too often, device must be disconnected */
+    int stalled;                    /**< device did not take messages in time, messages are discarded */
+    uint64_t dropped;               /**< messages discarded because the queue was full */
+    uint64_t reported;              /**< discarded messages already reported */
+    pthread_mutex_t lock;           /**< protects sleeping and wake up */
+    pthread_cond_t cond;            /**< signals new records, free space or an empty queue */
+} MctDaemonLogStorageWriter;
+
+/**
+ * @brief mct_daemon_logstorage_writer_init - allocate queue and start writer thread
+ * @param writer writer
+ * @param handle logstorage device
+ * @param uconfig user configuration of log file names
+ * @param size size of queue in bytes, rounded up to a power of two
+ * @param policy MCT_DAEMON_LOGSTORAGE_QUEUE_DROP or MCT_DAEMON_LOGSTORAGE_QUEUE_WAIT
+ * @return MCT_RETURN_OK on success, MCT_RETURN_ERROR otherwise
+ */
+int mct_daemon_logstorage_writer_init(MctDaemonLogStorageWriter *writer,
+                                      MctLogStorage *handle,
+                                      MctLogStorageUserConfig *uconfig,
+                                      uint32_t size,
+                                      int policy);
+
+/**
+ * @brief mct_daemon_logstorage_writer_free - write all queued messages and stop writer thread
+ * @param writer writer
+ */
+void mct_daemon_logstorage_writer_free(MctDaemonLogStorageWriter *writer);
+
+/**
+ * @brief mct_daemon_logstorage_writer_push - queue a message for the writer thread
+ *
+ * The writer thread takes the message once mct_daemon_logstorage_writer_flush
+ * is called, so a batch of messages wakes it up only once.
+ *
+ * @param writer writer
+ * @param config filters obtained by mct_logstorage_route
+ * @param num number of filters
+ * @param data1 storage header
+ * @param size1 size of storage header
+ * @param data2 message header
+ * @param size2 size of message header
+ * @param data3 message payload
+ * @param size3 size of message payload
+ * @return MCT_RETURN_OK if the message was queued, MCT_RETURN_BUFFER_FULL
+ *         if it was discarded
+ */
+int mct_daemon_logstorage_writer_push(MctDaemonLogStorageWriter *writer,
+                                      MctLogStorageFilterConfig **config,
+                                      int num,
+                                      unsigned char *data1,
+                                      int size1,
+                                      unsigned char *data2,
+                                      int size2,
+                                      unsigned char *data3,
+                                      int size3);
+
+/**
+ * @brief mct_daemon_logstorage_writer_flush - hand the queued messages over to the writer thread
+ * @param writer writer
+ */
+void mct_daemon_logstorage_writer_flush(MctDaemonLogStorageWriter *writer);
+
+/**
+ * @brief mct_daemon_logstorage_writer_sync - let the writer thread sync the device
+ *
+ * The request is queued behind the messages already queued. A periodic
+ * sync is discarded if the queue is full.
+ *
+ * @param writer writer
+ * @param status MCT_LOGSTORAGE_SYNC_ON_TIMER to sync files of ON_TIMER filters,
+ *               MCT_LOGSTORAGE_SYNC_ON_DEMAND to sync all caches
+ * @return MCT_RETURN_OK if the request was queued, MCT_RETURN_BUFFER_FULL
+ *         if it was discarded
+ */
+int mct_daemon_logstorage_writer_sync(MctDaemonLogStorageWriter *writer, int status);
+
+/**
+ * @brief mct_daemon_logstorage_writer_drain - wait until all queued messages are written
+ *
+ * Afterwards the writer thread does not touch the device until the next
+ * message is queued.
+ *
+ * @param writer writer
+ */
+void mct_daemon_logstorage_writer_drain(MctDaemonLogStorageWriter *writer);
+
+/**
+ * @brief mct_daemon_logstorage_writer_wait - wait a limited time until all queued messages are written
+ *
+ * Unlike mct_daemon_logstorage_writer_drain, the writer thread may still
+ * touch the device afterwards if the time is up.
+ *
+ * @param writer writer
+ * @param timeout maximum time to wait in ms
+ * @return MCT_RETURN_OK if the queue is empty, MCT_RETURN_ERROR if the time is up
+ */
+int mct_daemon_logstorage_writer_wait(MctDaemonLogStorageWriter *writer, int timeout);
+
+/**
+ * @brief mct_daemon_logstorage_writer_get_queue_depth - get bytes queued for the writer thread
+ * @param writer writer
+ * @return number of queued bytes, including messages not yet handed over
+ */
+uint32_t mct_daemon_logstorage_writer_get_queue_depth(MctDaemonLogStorageWriter *writer);
+
+#endif /* MCT_DAEMON_LOGSTORAGE_WRITER_H */
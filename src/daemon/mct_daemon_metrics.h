@@ -0,0 +1,31 @@
+#ifndef MCT_DAEMON_METRICS_H
+#define MCT_DAEMON_METRICS_H
+
+#include <stdint.h>
+
+/**
+ * Counters of the daemon metrics.
+ *
+ * Counters are updated on the message path with relaxed atomic operations,
+ * so they may be read at any time without taking a lock. They only count,
+ * they never order other memory accesses.
+ */
+
+#define MCT_DAEMON_METRICS_ADD(counter, value) \
+    ((void)__atomic_fetch_add(&(counter), (uint64_t)(value), __ATOMIC_RELAXED))
+
+#define MCT_DAEMON_METRICS_GET(counter) \
+    __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+
+/**
+ * Counters of an application connection, a client connection or a context.
+ */
+typedef struct
+{
+    uint64_t messages; /**< messages received from an application or sent to a client */
+    uint64_t bytes;    /**< bytes received from an application or sent to a client */
+    uint64_t errors;   /**< bytes skipped to resync or unsupported messages received */
+    uint64_t dropped;  /**< messages which could not be sent to a client */
+} MctDaemonMetrics;
+
+#endif /* MCT_DAEMON_METRICS_H */
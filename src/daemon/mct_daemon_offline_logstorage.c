@@ -6,6 +6,7 @@
 #include "mct-daemon.h"
 #include "mct_daemon_offline_logstorage.h"
 #include "mct_daemon_offline_logstorage_internal.h"
+#include "mct_config_file_parser.h"
 
 /**
  * mct_logstorage_split_ecuid
@@ -37,6 +38,7 @@ static MctReturnValue mct_logstorage_split_ecuid(char *key,
 }
 
 unsigned int g_logstorage_cache_max;
+char g_logstorage_cache_dir[MCT_MOUNT_PATH_MAX + 1];
 /**
  * mct_logstorage_split_ctid
  *
@@ -977,6 +979,208 @@ int mct_daemon_logstorage_get_loglevel(MctDaemon *daemon,
     return storage_loglevel;
 }
 
+/**
+ * mct_daemon_logstorage_queue
+ *
+ * Obtain the filter configurations of a log message and pass the message to
+ * the writer thread of the storage device.
+ *
+ * @param writer        Writer thread of storage device
+ * @param data1         message header buffer
+ * @param size1         message header buffer size
+ * @param data2         message extended header buffer
+ * @param size2         message extended header size
+ * @param data3         message data buffer
+ * @param size3         message data size
+ * @param disable_nw    Flag to disable network routing
+ * @return              1 if queued, 0 if not stored on the device or discarded,
+ *                      -1 if the writer thread failed to write
+ */
+static int mct_daemon_logstorage_queue(MctDaemonLogStorageWriter *writer,
+                                       unsigned char *data1,
+                                       int size1,
+                                       unsigned char *data2,
+                                       int size2,
+                                       unsigned char *data3,
+                                       int size3,
+                                       int *disable_nw)
+{
+    MctLogStorageFilterConfig *config[MCT_CONFIG_FILE_SECTIONS_MAX] = { 0 };
+    int num = 0;
+
+    /* the writer thread gave up on the device, it is disconnected by caller
+     * and the flag is cleared afterwards */
+    if (__atomic_load_n(&writer->failed, __ATOMIC_RELAXED)) {
+        return -1;
+    }
+
+    num = mct_logstorage_route(writer->handle, config, data2, size2, disable_nw);
+
+    if (num <= 0) {
+        return 0;
+    }
+
+    if (mct_daemon_logstorage_writer_push(writer, config, num,
+                                          data1, size1,
+                                          data2, size2,
+                                          data3, size3) != MCT_RETURN_OK) {
+        return 0;
+    }
+
+    if (writer->dropped > writer->reported) {
+        mct_vlog(LOG_WARNING,
+                 "%s: %llu messages discarded for %s, queue was full\n",
+                 __func__,
+                 (unsigned long long)(writer->dropped - writer->reported),
+                 writer->handle->device_mount_point);
+        writer->reported = writer->dropped;
+    }
+
+    return 1;
+}
+
+void mct_daemon_logstorage_drain(MctDaemon *daemon, MctLogStorage *handle)
+{
+    if ((daemon == NULL) || (daemon->storage_writer == NULL) ||
+        (daemon->storage_handle == NULL) || (handle == NULL)) {
+        return;
+    }
+
+    mct_daemon_logstorage_writer_drain(&daemon->storage_writer[handle - daemon->storage_handle]);
+}
+
+void mct_daemon_logstorage_sync_files(MctDaemon *daemon, MctDaemonLocal *daemon_local)
+{
+    int i = 0;
+
+    if ((daemon == NULL) || (daemon_local == NULL) || (daemon->storage_handle == NULL)) {
+        return;
+    }
+
+    for (i = 0; i < daemon_local->flags.offlineLogstorageMaxDevices; i++) {
+        if (daemon->storage_handle[i].config_status !=
+            MCT_OFFLINE_LOGSTORAGE_CONFIG_DONE) {
+            continue;
+        }
+
+        /* the writer thread owns the files, sync in order with the messages */
+        if (daemon->storage_writer != NULL) {
+            mct_daemon_logstorage_writer_sync(&daemon->storage_writer[i],
+                                              MCT_LOGSTORAGE_SYNC_ON_TIMER);
+        }
+        else {
+            mct_logstorage_sync_files(&daemon->storage_handle[i]);
+        }
+    }
+}
+
+/**
+ * mct_daemon_logstorage_write_device
+ *
+ * Write log message to one storage device, or queue it for the writer
+ * thread of the device. If the device cannot be written, it is disconnected.
+ *
+ * @param daemon        Pointer to Mct Daemon structure
+ * @param index         Index of storage device
+ * @param file_config   User configuration of log file names
+ * @param data1         message header buffer
+ * @param size1         message header buffer size
+ * @param data2         message extended header buffer
+ * @param size2         message extended header size
+ * @param data3         message data buffer
+ * @param size3         message data size
+ * @param disable_nw    Flag to disable network routing
+ * @return              0 on success, -1 on error
+ */
+static int mct_daemon_logstorage_write_device(MctDaemon *daemon,
+                                              int index,
+                                              MctLogStorageUserConfig *file_config,
+                                              unsigned char *data1,
+                                              int size1,
+                                              unsigned char *data2,
+                                              int size2,
+                                              unsigned char *data3,
+                                              int size3,
+                                              int *disable_nw)
+{
+    MctLogStorageFilterConfig *config[MCT_CONFIG_FILE_SECTIONS_MAX] = { 0 };
+    int num = 0;
+    int ret = 0;
+
+    if (daemon->storage_writer != NULL) {
+        ret = mct_daemon_logstorage_queue(&(daemon->storage_writer[index]),
+                                          data1,
+                                          size1,
+                                          data2,
+                                          size2,
+                                          data3,
+                                          size3,
+                                          disable_nw);
+    } else {
+        num = mct_logstorage_route(&(daemon->storage_handle[index]), config,
+                                   data2, size2, disable_nw);
+
+        if (num > 0) {
+            ret = mct_logstorage_write_routed(&(daemon->storage_handle[index]),
+                                              file_config,
+                                              config,
+                                              num,
+                                              data1,
+                                              size1,
+                                              data2,
+                                              size2,
+                                              data3,
+                                              size3);
+            ret = (ret < 0) ? ret : 1;
+        }
+    }
+
+    if (ret == 1) {
+        MCT_DAEMON_METRICS_ADD(daemon->storage_metrics[index].messages, 1);
+        MCT_DAEMON_METRICS_ADD(daemon->storage_metrics[index].bytes, size1 + size2 + size3);
+        ret = 0;
+    }
+
+    if (ret < 0) {
+        MCT_DAEMON_METRICS_ADD(daemon->storage_metrics[index].errors, 1);
+        mct_log(LOG_ERR,
+                "mct_daemon_logstorage_write: failed. "
+                "Disable storage device\n");
+        /* MCT_OFFLINE_LOGSTORAGE_MAX_ERRORS happened,
+         * therefore remove logstorage device */
+        mct_daemon_logstorage_drain(daemon, &(daemon->storage_handle[index]));
+        mct_logstorage_device_disconnected(
+            &(daemon->storage_handle[index]),
+            MCT_LOGSTORAGE_SYNC_ON_DEVICE_DISCONNECT);
+
+        /* queued records of the device were discarded while draining */
+        if (daemon->storage_writer != NULL) {
+            __atomic_store_n(&daemon->storage_writer[index].failed, 0, __ATOMIC_RELAXED);
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * mct_daemon_logstorage_get_user_config
+ *
+ * Copy the user configuration of log file names from the daemon flags.
+ *
+ * @param user_config   MctDaemon configuration
+ * @param file_config   User configuration of log file names
+ */
+static void mct_daemon_logstorage_get_user_config(MctDaemonFlags *user_config,
+                                                  MctLogStorageUserConfig *file_config)
+{
+    file_config->logfile_timestamp = user_config->offlineLogstorageTimestamp;
+    file_config->logfile_delimiter = user_config->offlineLogstorageDelimiter;
+    file_config->logfile_maxcounter = user_config->offlineLogstorageMaxCounter;
+    file_config->logfile_optional_counter = user_config->offlineLogstorageOptionalCounter;
+    file_config->logfile_counteridxlen =
+        user_config->offlineLogstorageMaxCounterIdx;
+}
+
 /**
  * mct_daemon_logstorage_write
  *
@@ -995,13 +1199,13 @@ int mct_daemon_logstorage_get_loglevel(MctDaemon *daemon,
  * @return              0 on success, -1 on error, 1 on disable network routing
  */
 int mct_daemon_logstorage_write(MctDaemon *daemon,
-                                 MctDaemonFlags *user_config,
-                                 unsigned char *data1,
-                                 int size1,
-                                 unsigned char *data2,
-                                 int size2,
-                                 unsigned char *data3,
-                                 int size3)
+                                MctDaemonFlags *user_config,
+                                unsigned char *data1,
+                                int size1,
+                                unsigned char *data2,
+                                int size2,
+                                unsigned char *data3,
+                                int size3)
 {
     int i = 0;
     int ret = 0;
@@ -1018,40 +1222,28 @@ int mct_daemon_logstorage_write(MctDaemon *daemon,
     }
 
     /* Copy user configuration */
-    file_config.logfile_timestamp = user_config->offlineLogstorageTimestamp;
-    file_config.logfile_delimiter = user_config->offlineLogstorageDelimiter;
-    file_config.logfile_maxcounter = user_config->offlineLogstorageMaxCounter;
-    file_config.logfile_optional_counter = user_config->offlineLogstorageOptionalCounter;
-    file_config.logfile_counteridxlen =
-        user_config->offlineLogstorageMaxCounterIdx;
+    mct_daemon_logstorage_get_user_config(user_config, &file_config);
 
     for (i = 0; i < user_config->offlineLogstorageMaxDevices; i++) {
         if (daemon->storage_handle[i].config_status ==
             MCT_OFFLINE_LOGSTORAGE_CONFIG_DONE) {
             int disable_nw = 0;
-            if ((ret = mct_logstorage_write(&(daemon->storage_handle[i]),
-                                     &file_config,
-                                     data1,
-                                     size1,
-                                     data2,
-                                     size2,
-                                     data3,
-                                     size3,
-                                     &disable_nw)) < 0) {
-                mct_log(LOG_ERR,
-                        "mct_daemon_logstorage_write: failed. "
-                        "Disable storage device\n");
-                /* MCT_OFFLINE_LOGSTORAGE_MAX_ERRORS happened,
-                 * therefore remove logstorage device */
-                mct_logstorage_device_disconnected(
-                    &(daemon->storage_handle[i]),
-                    MCT_LOGSTORAGE_SYNC_ON_DEVICE_DISCONNECT);
+
+            ret = mct_daemon_logstorage_write_device(daemon, i, &file_config,
+                                                     data1, size1,
+                                                     data2, size2,
+                                                     data3, size3,
+                                                     &disable_nw);
+
+            if (daemon->storage_writer != NULL) {
+                mct_daemon_logstorage_writer_flush(&daemon->storage_writer[i]);
             }
+
             if (i == 0) {
                 if (disable_nw == 1) {
                     ret = 1;
                 }
-            } else {
+            } else if (disable_nw == 1) {
                 mct_vlog(LOG_WARNING,
                          "%s: DisableNetwork is not supported for more than one device yet\n",
                          __func__);
@@ -1062,6 +1254,62 @@ int mct_daemon_logstorage_write(MctDaemon *daemon,
     return ret;
 }
 
+int mct_daemon_logstorage_write_batch(MctDaemon *daemon,
+                                      MctDaemonFlags *user_config,
+                                      MctDaemonBatchEntry *entries,
+                                      int count)
+{
+    int i = 0;
+    int j = 0;
+    int ret = 0;
+    MctLogStorageUserConfig file_config;
+
+    if ((daemon == NULL) || (user_config == NULL) || (entries == NULL) ||
+        (user_config->offlineLogstorageMaxDevices <= 0)) {
+        return -1;
+    }
+
+    mct_daemon_logstorage_get_user_config(user_config, &file_config);
+
+    for (i = 0; i < user_config->offlineLogstorageMaxDevices; i++) {
+        int warned = 0;
+
+        /* the device is disconnected if it cannot be written */
+        for (j = 0; (j < count) &&
+             (daemon->storage_handle[i].config_status == MCT_OFFLINE_LOGSTORAGE_CONFIG_DONE);
+             j++) {
+            int disable_nw = 0;
+
+            if (mct_daemon_logstorage_write_device(daemon, i, &file_config,
+                                                   (unsigned char *)&entries[j].storageheader,
+                                                   sizeof(MctStorageHeader),
+                                                   entries[j].header,
+                                                   entries[j].headersize,
+                                                   entries[j].data,
+                                                   entries[j].datasize,
+                                                   &disable_nw) < 0) {
+                ret = -1;
+            }
+
+            if (i == 0) {
+                entries[j].skip_network = (disable_nw == 1);
+            } else if ((disable_nw == 1) && !warned) {
+                mct_vlog(LOG_WARNING,
+                         "%s: DisableNetwork is not supported for more than one device yet\n",
+                         __func__);
+                warned = 1;
+            }
+        }
+
+        /* the writer thread is woken up once per batch */
+        if (daemon->storage_writer != NULL) {
+            mct_daemon_logstorage_writer_flush(&daemon->storage_writer[i]);
+        }
+    }
+
+    return ret;
+}
+
 /**
  * mct_daemon_logstorage_setup_internal_storage
  *
@@ -1090,6 +1338,7 @@ int mct_daemon_logstorage_setup_internal_storage(MctDaemon *daemon,
 
     /* connect internal storage device */
     /* Device index always used as 0 as it is setup on MCT daemon startup */
+    mct_daemon_logstorage_drain(daemon, &(daemon->storage_handle[0]));
     ret = mct_logstorage_device_connected(&(daemon->storage_handle[0]), path);
 
     if (ret != 0) {
@@ -1135,6 +1384,12 @@ void mct_daemon_logstorage_set_logstorage_cache_size(unsigned int size)
     g_logstorage_cache_max = size * 1024;
 }
 
+void mct_daemon_logstorage_set_logstorage_cache_dir(const char *path)
+{
+    strncpy(g_logstorage_cache_dir, path, MCT_MOUNT_PATH_MAX);
+    g_logstorage_cache_dir[MCT_MOUNT_PATH_MAX] = 0;
+}
+
 int mct_daemon_logstorage_cleanup(MctDaemon *daemon,
                                   MctDaemonLocal *daemon_local,
                                   int verbose)
@@ -1162,6 +1417,7 @@ int mct_daemon_logstorage_cleanup(MctDaemon *daemon,
             (&daemon->storage_handle[i])->uconfig.logfile_optional_counter =
                 daemon_local->flags.offlineLogstorageOptionalCounter;
 
+            mct_daemon_logstorage_drain(daemon, &daemon->storage_handle[i]);
             mct_logstorage_device_disconnected(
                 &daemon->storage_handle[i],
                 MCT_LOGSTORAGE_SYNC_ON_DAEMON_EXIT);
@@ -1171,6 +1427,33 @@ int mct_daemon_logstorage_cleanup(MctDaemon *daemon,
     return 0;
 }
 
+/**
+ * mct_daemon_logstorage_sync_writer
+ *
+ * Let the writer thread of a device sync its caches and wait a limited time
+ * for it, so a stalled device does not hold up the daemon.
+ *
+ * @param writer        Writer thread of storage device
+ * @return              0 on success, -1 if the device did not sync in time
+ */
+static int mct_daemon_logstorage_sync_writer(MctDaemonLogStorageWriter *writer)
+{
+    if (mct_daemon_logstorage_writer_sync(writer, MCT_LOGSTORAGE_SYNC_ON_DEMAND) != MCT_RETURN_OK) {
+        mct_vlog(LOG_WARNING, "%s: Device %s is stalled, caches not synced\n",
+                 __func__, writer->handle->device_mount_point);
+        return MCT_RETURN_ERROR;
+    }
+
+    if (mct_daemon_logstorage_writer_wait(writer, MCT_DAEMON_LOGSTORAGE_SYNC_TIMEOUT) !=
+        MCT_RETURN_OK) {
+        mct_vlog(LOG_WARNING, "%s: Device %s is still syncing its caches\n",
+                 __func__, writer->handle->device_mount_point);
+        return MCT_RETURN_ERROR;
+    }
+
+    return MCT_RETURN_OK;
+}
+
 int mct_daemon_logstorage_sync_cache(MctDaemon *daemon,
                                      MctDaemonLocal *daemon_local,
                                      char *mnt_point,
@@ -1205,6 +1488,11 @@ int mct_daemon_logstorage_sync_cache(MctDaemon *daemon,
             handle->uconfig.logfile_optional_counter =
                 daemon_local->flags.offlineLogstorageOptionalCounter;
 
+            if (daemon->storage_writer != NULL) {
+                return mct_daemon_logstorage_sync_writer(
+                    &daemon->storage_writer[handle - daemon->storage_handle]);
+            }
+
             if (mct_logstorage_sync_caches(handle) != 0) {
                 return MCT_RETURN_ERROR;
             }
@@ -1225,11 +1513,38 @@ int mct_daemon_logstorage_sync_cache(MctDaemon *daemon,
                 daemon->storage_handle[i].uconfig.logfile_optional_counter =
                     daemon_local->flags.offlineLogstorageOptionalCounter;
 
+                /* writer threads sync their devices in parallel */
+                if (daemon->storage_writer != NULL) {
+                    if (mct_daemon_logstorage_writer_sync(&daemon->storage_writer[i],
+                                                          MCT_LOGSTORAGE_SYNC_ON_DEMAND) !=
+                        MCT_RETURN_OK) {
+                        mct_vlog(LOG_WARNING, "%s: Device %s is stalled, caches not synced\n",
+                                 __func__, daemon->storage_handle[i].device_mount_point);
+                    }
+
+                    continue;
+                }
+
                 if (mct_logstorage_sync_caches(&daemon->storage_handle[i]) != 0) {
                     return MCT_RETURN_ERROR;
                 }
             }
         }
+
+        /* wait a limited time until all devices are synced, stalled devices
+         * must not hold up the daemon */
+        for (i = 0; (daemon->storage_writer != NULL) &&
+             (i < daemon_local->flags.offlineLogstorageMaxDevices); i++) {
+            if ((daemon->storage_handle[i].connection_type ==
+                 MCT_OFFLINE_LOGSTORAGE_DEVICE_CONNECTED) &&
+                !daemon->storage_writer[i].stalled &&
+                (mct_daemon_logstorage_writer_wait(&daemon->storage_writer[i],
+                                                   MCT_DAEMON_LOGSTORAGE_SYNC_TIMEOUT) !=
+                 MCT_RETURN_OK)) {
+                mct_vlog(LOG_WARNING, "%s: Device %s is still syncing its caches\n",
+                         __func__, daemon->storage_handle[i].device_mount_point);
+            }
+        }
     }
 
     return 0;
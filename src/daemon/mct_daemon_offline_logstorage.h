@@ -92,6 +92,49 @@ int mct_daemon_logstorage_write(MctDaemon *daemon,
                                  unsigned char *data3,
                                  int size3);
 
+/**
+ * mct_daemon_logstorage_write_batch
+ *
+ * Write a batch of log messages to all attached storage devices. Each
+ * device gets the whole batch at once, its writer thread is woken up
+ * only once per batch. Devices which cannot be written are disconnected.
+ *
+ * @param daemon        Pointer to Mct Daemon structure
+ * @param user_config   MctDaemon configuration
+ * @param entries       messages of the batch, skip_network is set for
+ *                      messages whose network routing is disabled
+ * @param count         number of messages
+ * @return              0 on success, -1 on error
+ */
+int mct_daemon_logstorage_write_batch(MctDaemon *daemon,
+                                      MctDaemonFlags *user_config,
+                                      MctDaemonBatchEntry *entries,
+                                      int count);
+
+/**
+ * mct_daemon_logstorage_drain
+ *
+ * Wait until the writer thread of a storage device wrote all queued log
+ * messages. Must be called before the device is synced, connected or
+ * disconnected by the event loop.
+ *
+ * @param daemon        Pointer to Mct Daemon structure
+ * @param handle        Storage device
+ */
+void mct_daemon_logstorage_drain(MctDaemon *daemon, MctLogStorage *handle);
+
+/**
+ * mct_daemon_logstorage_sync_files
+ *
+ * Write log files of ON_TIMER filters of all configured storage devices to
+ * the device. If writer threads are used, the sync is queued behind the
+ * pending log messages.
+ *
+ * @param daemon        Pointer to Mct Daemon structure
+ * @param daemon_local  Pointer to Mct Daemon Local structure
+ */
+void mct_daemon_logstorage_sync_files(MctDaemon *daemon, MctDaemonLocal *daemon_local);
+
 /**
  * mct_daemon_logstorage_setup_internal_storage
  *
@@ -116,6 +159,14 @@ int mct_daemon_logstorage_setup_internal_storage(MctDaemon *daemon,
  */
 void mct_daemon_logstorage_set_logstorage_cache_size(unsigned int size);
 
+/**
+ * Set directory of the files keeping the logstorage caches. An empty path
+ * keeps the caches in memory only.
+ *
+ * @param path  Directory, relative to the device mount point if not absolute
+ */
+void mct_daemon_logstorage_set_logstorage_cache_dir(const char *path);
+
 /**
  * Cleanup mct logstorage
  *
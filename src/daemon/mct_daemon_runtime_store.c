@@ -0,0 +1,616 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "mct_types.h"
+#include "mct_common.h"
+#include "mct_daemon_common_cfg.h"
+
+#include "mct_daemon_runtime_store.h"
+
+/* header at the beginning of snapshot and journal */
+typedef struct
+{
+    char pattern[MCT_ID_SIZE]; /**< mctRuntimeSnapshotPattern or mctRuntimeJournalPattern */
+    uint32_t records;          /**< number of records of a snapshot, 0 in a journal */
+} MctDaemonRuntimeHeader;
+
+/* record as stored in the files, followed by the description */
+typedef struct
+{
+    uint32_t checksum;           /**< checksum of the rest of the record and the description */
+    uint8_t type;                /**< MCT_DAEMON_RUNTIME_RECORD_* */
+    int8_t log_level;
+    int8_t trace_status;
+    uint8_t reserved;
+    char apid[MCT_ID_SIZE];
+    char ctid[MCT_ID_SIZE];
+    uint16_t description_length;
+    uint16_t reserved2;
+} MctDaemonRuntimeRecord;
+
+static const char mctRuntimeSnapshotPattern[MCT_ID_SIZE] = { 'M', 'R', 'S', 1 };
+static const char mctRuntimeJournalPattern[MCT_ID_SIZE] = { 'M', 'R', 'J', 1 };
+
+#define MCT_DAEMON_RUNTIME_CHECKSUM_OFFSET sizeof(uint32_t)
+#define MCT_DAEMON_RUNTIME_ALLOC_SIZE      4096
+#define MCT_DAEMON_RUNTIME_PENDING_MIN     64
+
+/* Adler-32 */
+static uint32_t mct_daemon_runtime_checksum(uint32_t sum, const uint8_t *data, uint32_t size)
+{
+    uint32_t a = sum & 0xffff;
+    uint32_t b = sum >> 16;
+    uint32_t i = 0;
+
+    for (i = 0; i < size; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+
+    return (b << 16) | a;
+}
+
+static uint32_t mct_daemon_runtime_record_checksum(const MctDaemonRuntimeRecord *record,
+                                                   const uint8_t *description)
+{
+    uint32_t sum = 1;
+
+    sum = mct_daemon_runtime_checksum(sum,
+                                      (const uint8_t *)record + MCT_DAEMON_RUNTIME_CHECKSUM_OFFSET,
+                                      sizeof(MctDaemonRuntimeRecord) -
+                                      MCT_DAEMON_RUNTIME_CHECKSUM_OFFSET);
+
+    return mct_daemon_runtime_checksum(sum, description, record->description_length);
+}
+
+/*
+ * Pass the valid records to the callback, which may be NULL to only validate.
+ * Returns the size of the valid records, the first damaged record ends them.
+ */
+static uint32_t mct_daemon_runtime_replay(const uint8_t *data,
+                                          uint32_t size,
+                                          MctDaemonRuntimeCallback callback,
+                                          void *user,
+                                          uint32_t *records)
+{
+    MctDaemonRuntimeRecord record;
+    MctDaemonRuntimeEntry entry;
+    uint32_t offset = 0;
+    uint32_t length = 0;
+
+    *records = 0;
+
+    while (size - offset >= sizeof(MctDaemonRuntimeRecord)) {
+        /* records are not aligned */
+        memcpy(&record, data + offset, sizeof(record));
+        length = sizeof(record) + record.description_length;
+
+        if ((size - offset < length) ||
+            (record.type < MCT_DAEMON_RUNTIME_RECORD_APPLICATION) ||
+            (record.type > MCT_DAEMON_RUNTIME_RECORD_CONTEXT_DEL) ||
+            (record.checksum != mct_daemon_runtime_record_checksum(&record,
+                                                                   data + offset + sizeof(record)))) {
+            break;
+        }
+
+        if (callback != NULL) {
+            entry.type = record.type;
+            entry.log_level = record.log_level;
+            entry.trace_status = record.trace_status;
+            memcpy(entry.apid, record.apid, MCT_ID_SIZE);
+            memcpy(entry.ctid, record.ctid, MCT_ID_SIZE);
+            entry.description = (const char *)(data + offset + sizeof(record));
+            entry.description_length = record.description_length;
+
+            callback(user, &entry);
+        }
+
+        offset += length;
+        (*records)++;
+    }
+
+    return offset;
+}
+
+/* map a file, returns NULL if it does not exist or is too small */
+static uint8_t *mct_daemon_runtime_map(const char *path, int flags, int *fd, uint32_t *size)
+{
+    struct stat status;
+    void *data = NULL;
+
+    *fd = open(path, flags);
+
+    if (*fd < 0) {
+        if (errno != ENOENT) {
+            mct_vlog(LOG_WARNING, "%s: Cannot open %s: %s\n", __func__, path, strerror(errno));
+        }
+
+        return NULL;
+    }
+
+    if ((fstat(*fd, &status) != 0) ||
+        (status.st_size < (off_t)sizeof(MctDaemonRuntimeHeader)) ||
+        (status.st_size > (off_t)UINT32_MAX)) {
+        mct_vlog(LOG_WARNING, "%s: Invalid runtime configuration %s\n", __func__, path);
+        close(*fd);
+        *fd = -1;
+        return NULL;
+    }
+
+    data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, *fd, 0);
+
+    if (data == MAP_FAILED) {
+        mct_vlog(LOG_WARNING, "%s: Cannot map %s: %s\n", __func__, path, strerror(errno));
+        close(*fd);
+        *fd = -1;
+        return NULL;
+    }
+
+    *size = (uint32_t)status.st_size;
+
+    return (uint8_t *)data;
+}
+
+static int mct_daemon_runtime_write(int fd, const uint8_t *data, uint32_t size)
+{
+    ssize_t ret = 0;
+
+    while (size > 0) {
+        ret = write(fd, data, size);
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return MCT_RETURN_ERROR;
+        }
+
+        data += ret;
+        size -= (uint32_t)ret;
+    }
+
+    return MCT_RETURN_OK;
+}
+
+static int mct_daemon_runtime_cmp_key(const void *k1, const void *k2)
+{
+    return memcmp(k1, k2, sizeof(MctDaemonRuntimeKey));
+}
+
+/* sort pending ids, an id changed several times is stored once */
+static void mct_daemon_runtime_unique(MctDaemonRuntimeStore *store)
+{
+    int i = 0;
+    int num = 0;
+
+    if (store->num_pending == 0) {
+        return;
+    }
+
+    qsort(store->pending, (size_t)store->num_pending, sizeof(MctDaemonRuntimeKey),
+          mct_daemon_runtime_cmp_key);
+
+    for (i = 1, num = 1; i < store->num_pending; i++) {
+        if (memcmp(&store->pending[i], &store->pending[num - 1], sizeof(MctDaemonRuntimeKey)) != 0) {
+            store->pending[num++] = store->pending[i];
+        }
+    }
+
+    store->num_pending = num;
+}
+
+void mct_daemon_runtime_store_init(MctDaemonRuntimeStore *store, const char *directory)
+{
+    if ((store == NULL) || (directory == NULL)) {
+        return;
+    }
+
+    memset(store, 0, sizeof(MctDaemonRuntimeStore));
+
+    snprintf(store->snapshot, sizeof(store->snapshot), "%s" MCT_RUNTIME_SNAPSHOT, directory);
+    snprintf(store->journal, sizeof(store->journal), "%s" MCT_RUNTIME_JOURNAL, directory);
+}
+
+void mct_daemon_runtime_store_free(MctDaemonRuntimeStore *store)
+{
+    if (store == NULL) {
+        return;
+    }
+
+    free(store->pending);
+    store->pending = NULL;
+    store->num_pending = 0;
+    store->max_pending = 0;
+
+    free(store->data);
+    store->data = NULL;
+    store->records = 0;
+    store->size = 0;
+    store->max_size = 0;
+}
+
+void mct_daemon_runtime_store_mark(MctDaemonRuntimeStore *store,
+                                   const char *apid,
+                                   const char *ctid)
+{
+    MctDaemonRuntimeKey *pending = NULL;
+    int max = 0;
+
+    if ((store == NULL) || !store->enabled || store->full || (apid == NULL)) {
+        return;
+    }
+
+    if ((store->num_pending == store->max_pending) &&
+        (store->max_pending >= MCT_DAEMON_RUNTIME_PENDING_MAX)) {
+        mct_daemon_runtime_unique(store);
+    }
+
+    if (store->num_pending == store->max_pending) {
+        if (store->max_pending >= MCT_DAEMON_RUNTIME_PENDING_MAX) {
+            /* cheaper to write everything */
+            store->full = true;
+            store->num_pending = 0;
+            return;
+        }
+
+        max = (store->max_pending > 0) ? (store->max_pending * 2) : MCT_DAEMON_RUNTIME_PENDING_MIN;
+        pending = realloc(store->pending, sizeof(MctDaemonRuntimeKey) * (size_t)max);
+
+        if (pending == NULL) {
+            store->full = true;
+            store->num_pending = 0;
+            return;
+        }
+
+        store->pending = pending;
+        store->max_pending = max;
+    }
+
+    pending = &store->pending[store->num_pending++];
+    memset(pending, 0, sizeof(MctDaemonRuntimeKey));
+    mct_set_id(pending->apid, apid);
+    mct_set_id(pending->ctid, ctid);
+}
+
+void mct_daemon_runtime_store_clear(MctDaemonRuntimeStore *store)
+{
+    if (store == NULL) {
+        return;
+    }
+
+    store->num_pending = 0;
+    store->full = false;
+}
+
+int mct_daemon_runtime_store_load(MctDaemonRuntimeStore *store,
+                                  MctDaemonRuntimeCallback callback,
+                                  void *data)
+{
+    const MctDaemonRuntimeHeader *header = NULL;
+    uint8_t *map = NULL;
+    uint32_t size = 0;
+    uint32_t valid = 0;
+    uint32_t records = 0;
+    bool enabled = false;
+    int fd = -1;
+
+    if ((store == NULL) || (callback == NULL)) {
+        return MCT_RETURN_ERROR;
+    }
+
+    store->snapshot_exists = false;
+    store->journal_size = 0;
+
+    map = mct_daemon_runtime_map(store->snapshot, O_RDONLY, &fd, &size);
+
+    if (map == NULL) {
+        return MCT_RETURN_ERROR;
+    }
+
+    header = (const MctDaemonRuntimeHeader *)map;
+    valid = mct_daemon_runtime_replay(map + sizeof(*header), size - sizeof(*header),
+                                      NULL, NULL, &records);
+
+    /* a snapshot is replaced as a whole, so it must be complete */
+    if ((memcmp(header->pattern, mctRuntimeSnapshotPattern, MCT_ID_SIZE) != 0) ||
+        (valid != size - sizeof(*header)) || (records != header->records)) {
+        mct_vlog(LOG_WARNING, "%s: Invalid runtime configuration %s\n", __func__, store->snapshot);
+        munmap(map, size);
+        close(fd);
+        return MCT_RETURN_ERROR;
+    }
+
+    /* loaded records are stored already */
+    enabled = store->enabled;
+    store->enabled = false;
+
+    mct_daemon_runtime_replay(map + sizeof(*header), size - sizeof(*header),
+                              callback, data, &records);
+
+    munmap(map, size);
+    close(fd);
+
+    store->snapshot_exists = true;
+
+    mct_vlog(LOG_INFO, "%s: Loaded %u records from %s\n", __func__, records, store->snapshot);
+
+    /* changes stored after the snapshot */
+    map = mct_daemon_runtime_map(store->journal, O_RDWR, &fd, &size);
+
+    if (map == NULL) {
+        /* appending starts with a new journal */
+        store->enabled = enabled;
+        return MCT_RETURN_OK;
+    }
+
+    header = (const MctDaemonRuntimeHeader *)map;
+
+    if (memcmp(header->pattern, mctRuntimeJournalPattern, MCT_ID_SIZE) != 0) {
+        mct_vlog(LOG_WARNING, "%s: Invalid runtime configuration %s\n", __func__, store->journal);
+        munmap(map, size);
+        close(fd);
+        store->enabled = enabled;
+        return MCT_RETURN_OK;
+    }
+
+    valid = mct_daemon_runtime_replay(map + sizeof(*header), size - sizeof(*header),
+                                      callback, data, &records);
+
+    store->enabled = enabled;
+
+    munmap(map, size);
+
+    /* drop the last record if the daemon stopped while it was written */
+    if ((valid != size - sizeof(*header)) &&
+        (ftruncate(fd, (off_t)(valid + sizeof(*header))) != 0)) {
+        mct_vlog(LOG_WARNING, "%s: Cannot truncate %s: %s\n",
+                 __func__, store->journal, strerror(errno));
+        /* write a snapshot with the next store */
+        store->full = true;
+    }
+
+    close(fd);
+
+    store->journal_size = valid + sizeof(*header);
+
+    mct_vlog(LOG_INFO, "%s: Loaded %u records from %s\n", __func__, records, store->journal);
+
+    return MCT_RETURN_OK;
+}
+
+bool mct_daemon_runtime_store_need_snapshot(MctDaemonRuntimeStore *store)
+{
+    if (store == NULL) {
+        return true;
+    }
+
+    return store->full || !store->snapshot_exists ||
+           (store->journal_size >= MCT_DAEMON_RUNTIME_JOURNAL_MAX_SIZE);
+}
+
+int mct_daemon_runtime_store_pending(MctDaemonRuntimeStore *store,
+                                     const MctDaemonRuntimeKey **keys)
+{
+    if ((store == NULL) || (keys == NULL)) {
+        return 0;
+    }
+
+    *keys = store->pending;
+
+    if (store->num_pending == 0) {
+        return 0;
+    }
+
+    mct_daemon_runtime_unique(store);
+
+    return store->num_pending;
+}
+
+int mct_daemon_runtime_store_add(MctDaemonRuntimeStore *store,
+                                 const MctDaemonRuntimeEntry *entry)
+{
+    MctDaemonRuntimeRecord record;
+    uint32_t length = 0;
+    uint32_t max = 0;
+    uint8_t *data = NULL;
+
+    if ((store == NULL) || (entry == NULL)) {
+        return MCT_RETURN_ERROR;
+    }
+
+    length = sizeof(record) + entry->description_length;
+
+    if (store->max_size - store->size < length) {
+        max = store->max_size + MCT_DAEMON_RUNTIME_ALLOC_SIZE;
+
+        while (max - store->size < length) {
+            max *= 2;
+        }
+
+        data = realloc(store->data, max);
+
+        if (data == NULL) {
+            /* a record would be missing */
+            store->records = 0;
+            store->size = 0;
+            store->full = true;
+            store->num_pending = 0;
+            return MCT_RETURN_ERROR;
+        }
+
+        store->data = data;
+        store->max_size = max;
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.type = entry->type;
+    record.log_level = entry->log_level;
+    record.trace_status = entry->trace_status;
+    memcpy(record.apid, entry->apid, MCT_ID_SIZE);
+    memcpy(record.ctid, entry->ctid, MCT_ID_SIZE);
+    record.description_length = entry->description_length;
+    record.checksum = mct_daemon_runtime_record_checksum(&record,
+                                                         (const uint8_t *)entry->description);
+
+    memcpy(store->data + store->size, &record, sizeof(record));
+
+    if (entry->description_length > 0) {
+        memcpy(store->data + store->size + sizeof(record), entry->description,
+               entry->description_length);
+    }
+
+    store->size += length;
+    store->records++;
+
+    return MCT_RETURN_OK;
+}
+
+static int mct_daemon_runtime_write_snapshot(MctDaemonRuntimeStore *store)
+{
+    MctDaemonRuntimeHeader header;
+    char path[PATH_MAX + 8];
+    int fd = -1;
+
+    snprintf(path, sizeof(path), "%s.tmp", store->snapshot);
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0) {
+        mct_vlog(LOG_ERR, "%s: Cannot open %s: %s\n", __func__, path, strerror(errno));
+        return MCT_RETURN_ERROR;
+    }
+
+    memcpy(header.pattern, mctRuntimeSnapshotPattern, MCT_ID_SIZE);
+    header.records = store->records;
+
+    if ((mct_daemon_runtime_write(fd, (const uint8_t *)&header, sizeof(header)) != MCT_RETURN_OK) ||
+        (mct_daemon_runtime_write(fd, store->data, store->size) != MCT_RETURN_OK) ||
+        (fsync(fd) != 0)) {
+        mct_vlog(LOG_ERR, "%s: Cannot write %s: %s\n", __func__, path, strerror(errno));
+        close(fd);
+        unlink(path);
+        return MCT_RETURN_ERROR;
+    }
+
+    close(fd);
+
+    /* the previous snapshot stays valid until it is replaced */
+    if (rename(path, store->snapshot) != 0) {
+        mct_vlog(LOG_ERR, "%s: Cannot rename %s: %s\n", __func__, path, strerror(errno));
+        unlink(path);
+        return MCT_RETURN_ERROR;
+    }
+
+    store->snapshot_exists = true;
+
+    /* replaying the journal again would be harmless, its records are complete states */
+    if ((unlink(store->journal) != 0) && (errno != ENOENT)) {
+        mct_vlog(LOG_WARNING, "%s: Cannot delete %s: %s\n",
+                 __func__, store->journal, strerror(errno));
+    }
+
+    store->journal_size = 0;
+
+    return MCT_RETURN_OK;
+}
+
+static int mct_daemon_runtime_write_journal(MctDaemonRuntimeStore *store)
+{
+    MctDaemonRuntimeHeader header;
+    int fd = -1;
+
+    if (store->size == 0) {
+        return MCT_RETURN_OK;
+    }
+
+    fd = open(store->journal,
+              O_WRONLY | O_CREAT | O_APPEND | ((store->journal_size == 0) ? O_TRUNC : 0),
+              0644);
+
+    if (fd < 0) {
+        mct_vlog(LOG_ERR, "%s: Cannot open %s: %s\n", __func__, store->journal, strerror(errno));
+        return MCT_RETURN_ERROR;
+    }
+
+    if (store->journal_size == 0) {
+        memcpy(header.pattern, mctRuntimeJournalPattern, MCT_ID_SIZE);
+        header.records = 0;
+
+        if (mct_daemon_runtime_write(fd, (const uint8_t *)&header, sizeof(header)) != MCT_RETURN_OK) {
+            mct_vlog(LOG_ERR, "%s: Cannot write %s: %s\n",
+                     __func__, store->journal, strerror(errno));
+            close(fd);
+            return MCT_RETURN_ERROR;
+        }
+
+        store->journal_size = sizeof(header);
+    }
+
+    if ((mct_daemon_runtime_write(fd, store->data, store->size) != MCT_RETURN_OK) ||
+        (fdatasync(fd) != 0)) {
+        mct_vlog(LOG_ERR, "%s: Cannot write %s: %s\n", __func__, store->journal, strerror(errno));
+        close(fd);
+        return MCT_RETURN_ERROR;
+    }
+
+    close(fd);
+
+    store->journal_size += store->size;
+
+    return MCT_RETURN_OK;
+}
+
+int mct_daemon_runtime_store_commit(MctDaemonRuntimeStore *store, bool snapshot)
+{
+    int ret = MCT_RETURN_OK;
+
+    if (store == NULL) {
+        return MCT_RETURN_ERROR;
+    }
+
+    if (snapshot) {
+        ret = mct_daemon_runtime_write_snapshot(store);
+    } else {
+        ret = mct_daemon_runtime_write_journal(store);
+    }
+
+    store->records = 0;
+    store->size = 0;
+
+    if (ret != MCT_RETURN_OK) {
+        /* the journal may end with a partial record, start over with a snapshot */
+        store->full = true;
+        store->num_pending = 0;
+        return ret;
+    }
+
+    mct_daemon_runtime_store_clear(store);
+
+    return MCT_RETURN_OK;
+}
+
+void mct_daemon_runtime_store_remove(MctDaemonRuntimeStore *store)
+{
+    if (store == NULL) {
+        return;
+    }
+
+    unlink(store->snapshot);
+    unlink(store->journal);
+
+    store->snapshot_exists = false;
+    store->journal_size = 0;
+    store->records = 0;
+    store->size = 0;
+
+    mct_daemon_runtime_store_clear(store);
+}
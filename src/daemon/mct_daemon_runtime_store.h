@@ -0,0 +1,172 @@
+#ifndef MCT_DAEMON_RUNTIME_STORE_H
+#define MCT_DAEMON_RUNTIME_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "mct_common.h"
+
+/**
+ * Binary store of the persistent runtime configuration.
+ *
+ * A snapshot file holds the complete application and context configuration.
+ * Later stores only append records of the changed applications and contexts
+ * to a journal file. At startup the snapshot is mapped and the journal is
+ * replayed on top of it. Once the journal exceeds its maximum size it is
+ * folded into a new snapshot.
+ */
+
+#define MCT_DAEMON_RUNTIME_RECORD_APPLICATION     1 /**< application and its description */
+#define MCT_DAEMON_RUNTIME_RECORD_CONTEXT         2 /**< context, its log level, trace status and description */
+#define MCT_DAEMON_RUNTIME_RECORD_APPLICATION_DEL 3 /**< application was removed */
+#define MCT_DAEMON_RUNTIME_RECORD_CONTEXT_DEL     4 /**< context was removed */
+
+/**
+ * Id of a changed application (empty context id) or context.
+ */
+typedef struct
+{
+    char apid[MCT_ID_SIZE];
+    char ctid[MCT_ID_SIZE];
+} MctDaemonRuntimeKey;
+
+/**
+ * One application or context of the snapshot or journal.
+ */
+typedef struct
+{
+    uint8_t type;                /**< MCT_DAEMON_RUNTIME_RECORD_* */
+    int8_t log_level;            /**< log level of context */
+    int8_t trace_status;         /**< trace status of context */
+    char apid[MCT_ID_SIZE];      /**< application id */
+    char ctid[MCT_ID_SIZE];      /**< context id, empty for application records */
+    const char *description;     /**< description, not 0-terminated */
+    uint16_t description_length; /**< length of description */
+} MctDaemonRuntimeEntry;
+
+typedef struct
+{
+    bool enabled;                    /**< runtime configuration is stored in binary format */
+    char snapshot[PATH_MAX + 1];     /**< path of snapshot file */
+    char journal[PATH_MAX + 1];      /**< path of journal file */
+    bool snapshot_exists;            /**< a valid snapshot file is available */
+    uint32_t journal_size;           /**< size of journal file */
+    MctDaemonRuntimeKey *pending;    /**< ids changed since the last store */
+    int num_pending;                 /**< number of pending ids */
+    int max_pending;                 /**< number of allocated pending ids */
+    bool full;                       /**< pending ids are incomplete, a snapshot must be written */
+    uint8_t *data;                   /**< records of the store in progress */
+    uint32_t records;                /**< number of records of the store in progress */
+    uint32_t size;                   /**< size of records of the store in progress */
+    uint32_t max_size;               /**< allocated size of data */
+} MctDaemonRuntimeStore;
+
+/**
+ * Called for every record while loading.
+ * @param data user data passed to mct_daemon_runtime_store_load
+ * @param entry application or context
+ * @return 0 on success, -1 to skip the record
+ */
+typedef int (*MctDaemonRuntimeCallback)(void *data, const MctDaemonRuntimeEntry *entry);
+
+/**
+ * @brief mct_daemon_runtime_store_init - set file names, no file is accessed
+ * @param store runtime store
+ * @param directory directory of snapshot and journal
+ */
+void mct_daemon_runtime_store_init(MctDaemonRuntimeStore *store, const char *directory);
+
+/**
+ * @brief mct_daemon_runtime_store_free - free pending ids and record buffer
+ * @param store runtime store
+ */
+void mct_daemon_runtime_store_free(MctDaemonRuntimeStore *store);
+
+/**
+ * @brief mct_daemon_runtime_store_mark - remember a changed application or context
+ *
+ * If too many ids change between two stores, a complete snapshot is
+ * written instead of journal records.
+ *
+ * @param store runtime store
+ * @param apid application id
+ * @param ctid context id, NULL for an application
+ */
+void mct_daemon_runtime_store_mark(MctDaemonRuntimeStore *store,
+                                   const char *apid,
+                                   const char *ctid);
+
+/**
+ * @brief mct_daemon_runtime_store_clear - forget all changes
+ * @param store runtime store
+ */
+void mct_daemon_runtime_store_clear(MctDaemonRuntimeStore *store);
+
+/**
+ * @brief mct_daemon_runtime_store_load - replay snapshot and journal
+ *
+ * The snapshot is mapped and its records are passed to the callback,
+ * followed by the records of the journal. A journal with an incomplete
+ * last record is truncated to its last complete record.
+ *
+ * @param store runtime store
+ * @param callback called for every record
+ * @param data user data of callback
+ * @return MCT_RETURN_OK on success, MCT_RETURN_ERROR if no valid snapshot exists
+ */
+int mct_daemon_runtime_store_load(MctDaemonRuntimeStore *store,
+                                  MctDaemonRuntimeCallback callback,
+                                  void *data);
+
+/**
+ * @brief mct_daemon_runtime_store_need_snapshot
+ * @param store runtime store
+ * @return true if the next store must contain the complete configuration
+ */
+bool mct_daemon_runtime_store_need_snapshot(MctDaemonRuntimeStore *store);
+
+/**
+ * @brief mct_daemon_runtime_store_pending - get ids changed since the last store
+ *
+ * Ids are sorted, an application is returned before its contexts.
+ *
+ * @param store runtime store
+ * @param keys returns array of ids, valid until the next commit or mark
+ * @return number of ids
+ */
+int mct_daemon_runtime_store_pending(MctDaemonRuntimeStore *store,
+                                     const MctDaemonRuntimeKey **keys);
+
+/**
+ * @brief mct_daemon_runtime_store_add - add a record to the store in progress
+ *
+ * On error the store in progress is dropped and the next store writes a
+ * snapshot.
+ *
+ * @param store runtime store
+ * @param entry application or context
+ * @return MCT_RETURN_OK on success, MCT_RETURN_ERROR otherwise
+ */
+int mct_daemon_runtime_store_add(MctDaemonRuntimeStore *store,
+                                 const MctDaemonRuntimeEntry *entry);
+
+/**
+ * @brief mct_daemon_runtime_store_commit - write the records of the store in progress
+ *
+ * A snapshot is written to a temporary file which replaces the previous
+ * snapshot, the journal is removed afterwards. Otherwise the records are
+ * appended to the journal. Pending ids are cleared on success.
+ *
+ * @param store runtime store
+ * @param snapshot true if the records are the complete configuration
+ * @return MCT_RETURN_OK on success, MCT_RETURN_ERROR otherwise
+ */
+int mct_daemon_runtime_store_commit(MctDaemonRuntimeStore *store, bool snapshot);
+
+/**
+ * @brief mct_daemon_runtime_store_remove - delete snapshot and journal
+ * @param store runtime store
+ */
+void mct_daemon_runtime_store_remove(MctDaemonRuntimeStore *store);
+
+#endif /* MCT_DAEMON_RUNTIME_STORE_H */
@@ -43,3 +43,39 @@ int mct_daemon_serial_send(int sock,
 
     return MCT_DAEMON_ERROR_OK;
 }
+
+int mct_daemon_serial_sendv(int fd, const struct iovec *iov, int iovcnt)
+{
+    int idx = 0;
+    size_t offset = 0;
+
+    while (idx < iovcnt) {
+        ssize_t ret;
+
+        if (offset > 0) {
+            /* finish the partially written buffer first */
+            ret = write(fd,
+                        (uint8_t *)iov[idx].iov_base + offset,
+                        iov[idx].iov_len - offset);
+        } else {
+            ret = writev(fd,
+                         &iov[idx],
+                         (iovcnt - idx) < IOV_MAX ? (iovcnt - idx) : IOV_MAX);
+        }
+
+        if (ret < 0) {
+            mct_vlog(LOG_WARNING,
+                     "%s: serial write failed [errno: %d]!\n", __func__, errno);
+            return MCT_DAEMON_ERROR_SEND_FAILED;
+        }
+
+        offset += (size_t)ret;
+
+        while ((idx < iovcnt) && (offset >= iov[idx].iov_len)) {
+            offset -= iov[idx].iov_len;
+            idx++;
+        }
+    }
+
+    return MCT_DAEMON_ERROR_OK;
+}
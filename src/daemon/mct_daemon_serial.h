@@ -3,6 +3,7 @@
 
 #include <limits.h>
 #include <semaphore.h>
+#include <sys/uio.h>
 #include "mct_common.h"
 #include "mct_user.h"
 
@@ -13,4 +14,13 @@ int mct_daemon_serial_send(int sock,
                            int size2,
                            char serialheader);
 
+/**
+ * @brief mct_daemon_serial_sendv - writes a vector of buffers to a serial device, rewriting partially written data
+ * @param fd
+ * @param iov array of buffers to be written in order
+ * @param iovcnt number of buffers
+ * @return on sucess: MCT_DAEMON_ERROR_OK, on error: MCT_DAEMON_ERROR_SEND_FAILED
+ */
+int mct_daemon_serial_sendv(int fd, const struct iovec *iov, int iovcnt);
+
 #endif /* MCT_DAEMON_SERIAL_H */
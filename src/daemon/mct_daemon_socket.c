@@ -11,6 +11,7 @@
 #include <errno.h>
 #include <pthread.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 
 #ifdef linux
 #include <sys/timerfd.h>
@@ -201,3 +202,40 @@ int mct_daemon_socket_sendreliable(int sock, void *data_buffer, int message_size
     return MCT_DAEMON_ERROR_OK;
 }
 
+
+int mct_daemon_socket_sendvreliable(int sock, const struct iovec *iov, int iovcnt)
+{
+    int idx = 0;
+    size_t offset = 0;
+
+    while (idx < iovcnt) {
+        ssize_t ret;
+
+        if (offset > 0) {
+            /* finish the partially sent buffer first */
+            ret = send(sock,
+                       (uint8_t *)iov[idx].iov_base + offset,
+                       iov[idx].iov_len - offset,
+                       0);
+        } else {
+            ret = writev(sock,
+                         &iov[idx],
+                         (iovcnt - idx) < IOV_MAX ? (iovcnt - idx) : IOV_MAX);
+        }
+
+        if (ret < 0) {
+            mct_vlog(LOG_WARNING,
+                     "%s: socket send failed [errno: %d]!\n", __func__, errno);
+            return MCT_DAEMON_ERROR_SEND_FAILED;
+        }
+
+        offset += (size_t)ret;
+
+        while ((idx < iovcnt) && (offset >= iov[idx].iov_len)) {
+            offset -= iov[idx].iov_len;
+            idx++;
+        }
+    }
+
+    return MCT_DAEMON_ERROR_OK;
+}
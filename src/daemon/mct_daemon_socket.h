@@ -3,6 +3,7 @@
 
 #include <limits.h>
 #include <semaphore.h>
+#include <sys/uio.h>
 #include "mct_common.h"
 #include "mct_user.h"
 
@@ -27,4 +28,13 @@ int mct_daemon_socket_send(int sock,
  */
 int mct_daemon_socket_sendreliable(int sock, void *data_buffer, int message_size);
 
+/**
+ * @brief mct_daemon_socket_sendvreliable - sends a vector of buffers to socket, resending partially written data
+ * @param sock
+ * @param iov array of buffers to be sent in order
+ * @param iovcnt number of buffers
+ * @return on sucess: MCT_DAEMON_ERROR_OK, on error: MCT_DAEMON_ERROR_SEND_FAILED
+ */
+int mct_daemon_socket_sendvreliable(int sock, const struct iovec *iov, int iovcnt);
+
 #endif /* MCT_DAEMON_SOCKET_H */
@@ -0,0 +1,448 @@
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "mct_types.h"
+#include "mct_common.h"
+#include "mct-daemon_cfg.h"
+
+#include "mct_daemon_spool.h"
+
+/* header at the beginning of each segment file */
+typedef struct
+{
+    char pattern[MCT_ID_SIZE]; /**< mctSpoolPattern */
+    uint32_t roffset;          /**< read position, messages before were already sent */
+} MctDaemonSpoolHeader;
+
+static const char mctSpoolPattern[MCT_ID_SIZE] = { 'M', 'S', 'P', 1 };
+
+#define MCT_DAEMON_SPOOL_PREFIX  "mct_spool_"
+#define MCT_DAEMON_SPOOL_SUFFIX  ".spl"
+/* directory, prefix, 10 digits index and suffix */
+#define MCT_DAEMON_SPOOL_PATH_MAX (MCT_PATH_MAX + 32)
+
+static void mct_daemon_spool_path(MctDaemonSpool *spool,
+                                  uint32_t index,
+                                  char *path,
+                                  size_t size)
+{
+    snprintf(path, size, "%s/" MCT_DAEMON_SPOOL_PREFIX "%010u" MCT_DAEMON_SPOOL_SUFFIX,
+             spool->directory, index);
+}
+
+/* size of the oldest segment, the newest one may still grow */
+static uint32_t mct_daemon_spool_read_end(MctDaemonSpool *spool)
+{
+    if ((spool->first == spool->last) && (spool->wfd >= 0)) {
+        return spool->wsize;
+    }
+
+    return spool->rsize;
+}
+
+/* delete the oldest segment */
+static void mct_daemon_spool_drop_first(MctDaemonSpool *spool, int exists)
+{
+    char path[MCT_DAEMON_SPOOL_PATH_MAX];
+
+    if (exists) {
+        spool->total -= mct_daemon_spool_read_end(spool);
+        mct_daemon_spool_path(spool, spool->first, path, sizeof(path));
+
+        if (unlink(path) != 0) {
+            mct_vlog(LOG_WARNING, "%s: Cannot delete %s: %s\n", __func__, path, strerror(errno));
+        }
+    }
+
+    if (spool->rfd >= 0) {
+        close(spool->rfd);
+        spool->rfd = -1;
+    }
+
+    if ((spool->first == spool->last) && (spool->wfd >= 0)) {
+        close(spool->wfd);
+        spool->wfd = -1;
+    }
+
+    spool->segments--;
+
+    if (spool->segments > 0) {
+        spool->first++;
+    } else {
+        spool->total = 0;
+    }
+}
+
+/* open the oldest segment for reading, segments which cannot be used are skipped */
+static void mct_daemon_spool_open_read(MctDaemonSpool *spool)
+{
+    char path[MCT_DAEMON_SPOOL_PATH_MAX];
+    MctDaemonSpoolHeader header;
+    struct stat st;
+
+    memset(&st, 0, sizeof(st));
+
+    while ((spool->rfd < 0) && (spool->segments > 0)) {
+        mct_daemon_spool_path(spool, spool->first, path, sizeof(path));
+        spool->rfd = open(path, O_RDWR);
+
+        if (spool->rfd < 0) {
+            mct_daemon_spool_drop_first(spool, 0);
+            continue;
+        }
+
+        if ((fstat(spool->rfd, &st) != 0) ||
+            (pread(spool->rfd, &header, sizeof(header), 0) != sizeof(header)) ||
+            (memcmp(header.pattern, mctSpoolPattern, sizeof(header.pattern)) != 0)) {
+            mct_vlog(LOG_WARNING, "%s: Invalid spool segment %s\n", __func__, path);
+            spool->rsize = (uint32_t)st.st_size;
+            mct_daemon_spool_drop_first(spool, 1);
+            continue;
+        }
+
+        spool->rsize = (uint32_t)st.st_size;
+        spool->roffset = header.roffset;
+
+        if ((spool->roffset < sizeof(header)) || (spool->roffset > spool->rsize)) {
+            spool->roffset = sizeof(header);
+        }
+    }
+}
+
+int mct_daemon_spool_init(MctDaemonSpool *spool,
+                          const char *directory,
+                          unsigned long segment_size,
+                          unsigned long max_size)
+{
+    char path[MCT_DAEMON_SPOOL_PATH_MAX];
+    DIR *dir = NULL;
+    struct dirent *entry = NULL;
+    struct stat st;
+    uint32_t index = 0;
+    int found = 0;
+    int n = 0;
+
+    if ((spool == NULL) || (directory == NULL) || (directory[0] == '\0')) {
+        return MCT_RETURN_ERROR;
+    }
+
+    memset(spool, 0, sizeof(MctDaemonSpool));
+    spool->wfd = -1;
+    spool->rfd = -1;
+
+    if ((segment_size <= sizeof(MctDaemonSpoolHeader)) || (segment_size > UINT32_MAX) ||
+        (max_size < segment_size) || (max_size > UINT32_MAX)) {
+        mct_vlog(LOG_ERR, "%s: Invalid spool sizes %lu/%lu\n", __func__, segment_size, max_size);
+        return MCT_RETURN_ERROR;
+    }
+
+    if ((mkdir(directory, 0750) != 0) && (errno != EEXIST)) {
+        mct_vlog(LOG_ERR, "%s: Cannot create %s: %s\n", __func__, directory, strerror(errno));
+        return MCT_RETURN_ERROR;
+    }
+
+    dir = opendir(directory);
+
+    if (dir == NULL) {
+        mct_vlog(LOG_ERR, "%s: Cannot open %s: %s\n", __func__, directory, strerror(errno));
+        return MCT_RETURN_ERROR;
+    }
+
+    strncpy(spool->directory, directory, sizeof(spool->directory) - 1);
+    spool->segment_size = (uint32_t)segment_size;
+    spool->max_size = (uint32_t)max_size;
+
+    /* pick up segments left by a previous run, they are replayed first */
+    while ((entry = readdir(dir)) != NULL) {
+        if ((sscanf(entry->d_name, MCT_DAEMON_SPOOL_PREFIX "%u%n", &index, &n) != 1) ||
+            (strcmp(entry->d_name + n, MCT_DAEMON_SPOOL_SUFFIX) != 0)) {
+            continue;
+        }
+
+        mct_daemon_spool_path(spool, index, path, sizeof(path));
+
+        if (stat(path, &st) != 0) {
+            continue;
+        }
+
+        if (!found || (index < spool->first)) {
+            spool->first = index;
+        }
+
+        if (!found || (index > spool->last)) {
+            spool->last = index;
+        }
+
+        spool->total += (uint64_t)st.st_size;
+        found = 1;
+    }
+
+    closedir(dir);
+
+    if (found) {
+        spool->segments = (int)(spool->last - spool->first + 1);
+        mct_vlog(LOG_INFO, "%s: %d spool segments (%llu bytes) found in %s\n",
+                 __func__, spool->segments, (unsigned long long)spool->total, directory);
+    }
+
+    return MCT_RETURN_OK;
+}
+
+void mct_daemon_spool_free(MctDaemonSpool *spool)
+{
+    if ((spool == NULL) || (spool->directory[0] == '\0')) {
+        return;
+    }
+
+    mct_daemon_spool_sync(spool);
+
+    if (spool->rfd >= 0) {
+        close(spool->rfd);
+        spool->rfd = -1;
+    }
+
+    if (spool->wfd >= 0) {
+        close(spool->wfd);
+        spool->wfd = -1;
+    }
+
+    spool->directory[0] = '\0';
+}
+
+int mct_daemon_spool_is_enabled(MctDaemonSpool *spool)
+{
+    return (spool != NULL) && (spool->directory[0] != '\0');
+}
+
+int mct_daemon_spool_is_empty(MctDaemonSpool *spool)
+{
+    return (spool == NULL) || (spool->segments <= 0);
+}
+
+int mct_daemon_spool_push(MctDaemonSpool *spool,
+                          const void *data1,
+                          uint32_t size1,
+                          const void *data2,
+                          uint32_t size2)
+{
+    char path[MCT_DAEMON_SPOOL_PATH_MAX];
+    MctDaemonSpoolHeader header;
+    struct iovec iov[3];
+    uint32_t size = size1 + size2;
+    uint64_t record = sizeof(uint32_t) + (uint64_t)size;
+    int new_segment = 0;
+    ssize_t ret = 0;
+
+    if (!mct_daemon_spool_is_enabled(spool)) {
+        return MCT_RETURN_ERROR;
+    }
+
+    new_segment = (spool->wfd < 0) ||
+        ((spool->wsize + record > spool->segment_size) &&
+         (spool->wsize > sizeof(header)));
+
+    if (spool->total + record + (new_segment ? sizeof(header) : 0) > spool->max_size) {
+        return MCT_RETURN_BUFFER_FULL;
+    }
+
+    if (new_segment) {
+        if (spool->wfd >= 0) {
+            /* the read segment does not grow anymore */
+            if (spool->first == spool->last) {
+                spool->rsize = spool->wsize;
+            }
+
+            close(spool->wfd);
+            spool->wfd = -1;
+        }
+
+        spool->last++;
+
+        if (spool->segments == 0) {
+            spool->first = spool->last;
+        }
+
+        mct_daemon_spool_path(spool, spool->last, path, sizeof(path));
+        spool->wfd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0640);
+
+        memcpy(header.pattern, mctSpoolPattern, sizeof(header.pattern));
+        header.roffset = sizeof(header);
+
+        if ((spool->wfd < 0) || (write(spool->wfd, &header, sizeof(header)) != sizeof(header))) {
+            mct_vlog(LOG_ERR, "%s: Cannot create %s: %s\n", __func__, path, strerror(errno));
+
+            if (spool->wfd >= 0) {
+                close(spool->wfd);
+                spool->wfd = -1;
+                unlink(path);
+            }
+
+            spool->last--;
+            return MCT_RETURN_ERROR;
+        }
+
+        spool->wsize = sizeof(header);
+        spool->total += sizeof(header);
+        spool->segments++;
+    }
+
+    iov[0].iov_base = &size;
+    iov[0].iov_len = sizeof(size);
+    iov[1].iov_base = (void *)data1;
+    iov[1].iov_len = size1;
+    iov[2].iov_base = (void *)data2;
+    iov[2].iov_len = size2;
+
+    ret = writev(spool->wfd, iov, 3);
+
+    if (ret != (ssize_t)record) {
+        mct_vlog(LOG_ERR, "%s: Cannot write to spool: %s\n", __func__,
+                 (ret < 0) ? strerror(errno) : "short write");
+
+        /* do not leave a partial message behind */
+        if (ftruncate(spool->wfd, spool->wsize) != 0) {
+            mct_vlog(LOG_WARNING, "%s: Cannot truncate spool segment\n", __func__);
+        }
+
+        return MCT_RETURN_ERROR;
+    }
+
+    spool->wsize += (uint32_t)record;
+    spool->total += record;
+
+    return MCT_RETURN_OK;
+}
+
+/* find the oldest message, fully read segments are deleted on the way */
+static int mct_daemon_spool_next(MctDaemonSpool *spool, uint32_t *size)
+{
+    uint32_t end = 0;
+
+    while (spool->segments > 0) {
+        mct_daemon_spool_open_read(spool);
+
+        if (spool->rfd < 0) {
+            break;
+        }
+
+        end = mct_daemon_spool_read_end(spool);
+
+        /* an incomplete message at the end was left by an aborted write */
+        if ((spool->roffset + sizeof(*size) <= end) &&
+            (pread(spool->rfd, size, sizeof(*size), spool->roffset) == sizeof(*size)) &&
+            ((uint64_t)spool->roffset + sizeof(*size) + *size <= end)) {
+            return 1;
+        }
+
+        /* newest segment is still in use for appending */
+        if ((spool->first == spool->last) && (spool->wfd >= 0)) {
+            break;
+        }
+
+        mct_daemon_spool_drop_first(spool, 1);
+    }
+
+    return 0;
+}
+
+int mct_daemon_spool_get_next_size(MctDaemonSpool *spool)
+{
+    uint32_t size = 0;
+
+    if ((spool == NULL) || !mct_daemon_spool_next(spool, &size)) {
+        return 0;
+    }
+
+    return (int)size;
+}
+
+int mct_daemon_spool_read(MctDaemonSpool *spool, void *data, int max_size)
+{
+    uint8_t *records = (uint8_t *)data;
+    uint32_t size = 0;
+    uint32_t len = 0;
+    uint32_t used = 0;
+
+    if ((spool == NULL) || (data == NULL) || (max_size <= 0)) {
+        return -1;
+    }
+
+    if (!mct_daemon_spool_next(spool, &size)) {
+        return 0;
+    }
+
+    len = mct_daemon_spool_read_end(spool) - spool->roffset;
+
+    if (len > (uint32_t)max_size) {
+        len = (uint32_t)max_size;
+    }
+
+    if ((len < sizeof(size) + size) ||
+        (pread(spool->rfd, records, len, spool->roffset) != (ssize_t)len)) {
+        return -1;
+    }
+
+    /* only complete messages */
+    while (used + sizeof(size) <= len) {
+        memcpy(&size, records + used, sizeof(size));
+
+        if (used + sizeof(size) + size > len) {
+            break;
+        }
+
+        used += (uint32_t)sizeof(size) + size;
+    }
+
+    return (int)used;
+}
+
+int mct_daemon_spool_consume(MctDaemonSpool *spool, int size)
+{
+    if ((spool == NULL) || (spool->rfd < 0) || (size <= 0)) {
+        return MCT_RETURN_ERROR;
+    }
+
+    spool->roffset += (uint32_t)size;
+
+    if (spool->roffset >= mct_daemon_spool_read_end(spool)) {
+        mct_daemon_spool_drop_first(spool, 1);
+    }
+
+    return MCT_RETURN_OK;
+}
+
+int mct_daemon_spool_remove(MctDaemonSpool *spool)
+{
+    uint32_t size = 0;
+
+    if ((spool == NULL) || (spool->rfd < 0)) {
+        return MCT_RETURN_ERROR;
+    }
+
+    if (pread(spool->rfd, &size, sizeof(size), spool->roffset) != sizeof(size)) {
+        return MCT_RETURN_ERROR;
+    }
+
+    return mct_daemon_spool_consume(spool, (int)(sizeof(size) + size));
+}
+
+void mct_daemon_spool_sync(MctDaemonSpool *spool)
+{
+    if ((spool == NULL) || (spool->rfd < 0)) {
+        return;
+    }
+
+    if (pwrite(spool->rfd, &spool->roffset, sizeof(spool->roffset),
+               offsetof(MctDaemonSpoolHeader, roffset)) != sizeof(spool->roffset)) {
+        mct_vlog(LOG_WARNING, "%s: Cannot store spool read position\n", __func__);
+    }
+}
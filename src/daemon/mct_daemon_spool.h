@@ -0,0 +1,126 @@
+#ifndef MCT_DAEMON_SPOOL_H
+#define MCT_DAEMON_SPOOL_H
+
+#include <stdint.h>
+#include "mct_common.h"
+
+/**
+ * Disk spool of the daemon client ringbuffer.
+ *
+ * Messages which do not fit into the ringbuffer are appended to segment
+ * files in a directory. Segments are replayed in order when a client
+ * connects and deleted as soon as they have been sent completely.
+ * The read position of the oldest segment is stored in its header, so
+ * the spool survives a daemon restart.
+ */
+typedef struct
+{
+    char directory[MCT_PATH_MAX]; /**< spool directory, empty if spool is disabled */
+    uint32_t segment_size;        /**< maximum size of one segment file */
+    uint32_t max_size;            /**< maximum size of all segment files */
+    uint32_t first;               /**< index of oldest segment (read segment) */
+    uint32_t last;                /**< index of newest segment */
+    int segments;                 /**< number of segments, 0 if spool is empty */
+    int wfd;                      /**< fd of newest segment, -1 if not opened for appending */
+    uint32_t wsize;               /**< size of newest segment */
+    int rfd;                      /**< fd of oldest segment, -1 if not opened for reading */
+    uint32_t rsize;               /**< size of oldest segment */
+    uint32_t roffset;             /**< read position in oldest segment */
+    uint64_t total;               /**< size of all segment files */
+} MctDaemonSpool;
+
+/**
+ * @brief mct_daemon_spool_init - open spool and pick up segments of a previous run
+ * @param spool spool
+ * @param directory spool directory
+ * @param segment_size maximum size of one segment file
+ * @param max_size maximum size of all segment files
+ * @return MCT_RETURN_OK on success, MCT_RETURN_ERROR otherwise
+ */
+int mct_daemon_spool_init(MctDaemonSpool *spool,
+                          const char *directory,
+                          unsigned long segment_size,
+                          unsigned long max_size);
+
+/**
+ * @brief mct_daemon_spool_free - store read position and close all segments
+ * @param spool spool
+ */
+void mct_daemon_spool_free(MctDaemonSpool *spool);
+
+/**
+ * @brief mct_daemon_spool_is_enabled
+ * @param spool spool
+ * @return 1 if spool is configured, 0 otherwise
+ */
+int mct_daemon_spool_is_enabled(MctDaemonSpool *spool);
+
+/**
+ * @brief mct_daemon_spool_is_empty
+ * @param spool spool
+ * @return 1 if no message is pending in spool, 0 otherwise
+ */
+int mct_daemon_spool_is_empty(MctDaemonSpool *spool);
+
+/**
+ * @brief mct_daemon_spool_push - append one message to the newest segment
+ * @param spool spool
+ * @param data1 message header
+ * @param size1 size of message header
+ * @param data2 message payload
+ * @param size2 size of message payload
+ * @return MCT_RETURN_OK on success, MCT_RETURN_BUFFER_FULL if the spool
+ *         reached its maximum size, MCT_RETURN_ERROR otherwise
+ */
+int mct_daemon_spool_push(MctDaemonSpool *spool,
+                          const void *data1,
+                          uint32_t size1,
+                          const void *data2,
+                          uint32_t size2);
+
+/**
+ * @brief mct_daemon_spool_get_next_size - get size of oldest message
+ * @param spool spool
+ * @return size of message, 0 if spool is empty
+ */
+int mct_daemon_spool_get_next_size(MctDaemonSpool *spool);
+
+/**
+ * @brief mct_daemon_spool_read - read oldest messages without removing them
+ *
+ * As many complete messages of the oldest segment as fit are copied in one
+ * read. Each message is preceded by its size as uint32_t in host byte order.
+ *
+ * @param spool spool
+ * @param data buffer the messages are copied to
+ * @param max_size size of buffer
+ * @return number of bytes read, 0 if spool is empty, -1 on error or if the
+ *         oldest message does not fit into the buffer
+ */
+int mct_daemon_spool_read(MctDaemonSpool *spool, void *data, int max_size);
+
+/**
+ * @brief mct_daemon_spool_consume - remove messages returned by mct_daemon_spool_read
+ * @param spool spool
+ * @param size number of bytes to remove, must end at a message boundary
+ * @return MCT_RETURN_OK on success, MCT_RETURN_ERROR otherwise
+ */
+int mct_daemon_spool_consume(MctDaemonSpool *spool, int size);
+
+/**
+ * @brief mct_daemon_spool_remove - remove oldest message
+ *
+ * Segments are deleted when all of their messages are removed.
+ *
+ * @param spool spool
+ * @return MCT_RETURN_OK on success, MCT_RETURN_ERROR otherwise
+ */
+int mct_daemon_spool_remove(MctDaemonSpool *spool);
+
+/**
+ * @brief mct_daemon_spool_sync - store read position in the oldest segment
+ * @param spool spool
+ */
+void mct_daemon_spool_sync(MctDaemonSpool *spool);
+
+#endif /* MCT_DAEMON_SPOOL_H */
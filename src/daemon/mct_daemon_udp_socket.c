@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <sys/socket.h> /* for socket(), sendmsg() */
+#include <arpa/inet.h>  /* for sockaddr_in and inet_pton() */
+#include <string.h>     /* for memset() */
+#include <unistd.h>     /* for close() */
+#include <limits.h>     /* for IOV_MAX */
+#include <syslog.h>
+#include <errno.h>
+#include <sys/uio.h>
+
+#include "mct_types.h"
+#include "mct-daemon.h"
+#include "mct-daemon_cfg.h"
+#include "mct_daemon_common_cfg.h"
+
+#include "mct_daemon_udp_socket.h"
+
+int mct_daemon_udp_init(MctDaemonUdpMulticast *udp,
+                        const char *address,
+                        int port,
+                        int ttl)
+{
+    unsigned char mc_ttl = 0;
+    int lastErrno = 0;
+
+    if ((udp == NULL) || (address == NULL) || (port <= 0) || (port > 65535)) {
+        mct_vlog(LOG_ERR, "%s: invalid arguments\n", __func__);
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+
+    udp->sock = -1;
+    udp->seq = 0;
+
+    memset(&udp->addr, 0, sizeof(udp->addr));
+    udp->addr.sin_family = AF_INET;
+    udp->addr.sin_port = htons((uint16_t)port);
+
+    if (inet_pton(AF_INET, address, &udp->addr.sin_addr) != 1) {
+        mct_vlog(LOG_ERR, "%s: invalid multicast address %s\n", __func__, address);
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+
+    if ((udp->sock = socket(AF_INET, SOCK_DGRAM, 0)) == -1) {
+        lastErrno = errno;
+        mct_vlog(LOG_ERR, "%s: socket() error %d: %s\n", __func__, lastErrno,
+                 strerror(lastErrno));
+        return MCT_DAEMON_ERROR_UNKNOWN;
+    }
+
+    mc_ttl = (unsigned char)((ttl < 0) ? 0 : ((ttl > 255) ? 255 : ttl));
+
+    if (setsockopt(udp->sock, IPPROTO_IP, IP_MULTICAST_TTL, &mc_ttl, sizeof(mc_ttl)) < 0) {
+        lastErrno = errno;
+        mct_vlog(LOG_WARNING, "%s: setsockopt(IP_MULTICAST_TTL) error %d: %s\n",
+                 __func__, lastErrno, strerror(lastErrno));
+    }
+
+    mct_vlog(LOG_INFO, "%s: Multicast to %s:%d enabled\n", __func__, address, port);
+
+    return MCT_DAEMON_ERROR_OK;
+}
+
+void mct_daemon_udp_close(MctDaemonUdpMulticast *udp)
+{
+    if ((udp == NULL) || (udp->sock < 0)) {
+        return;
+    }
+
+    close(udp->sock);
+    udp->sock = -1;
+}
+
+int mct_daemon_udp_sendv(MctDaemonUdpMulticast *udp,
+                         const struct iovec *iov,
+                         int iovcnt)
+{
+    struct iovec vec[IOV_MAX];
+    struct msghdr msg;
+    MctMulticastHeader header;
+    ssize_t sent = 0;
+    int i = 0;
+
+    if ((udp == NULL) || (udp->sock < 0) || (iov == NULL) ||
+        (iovcnt <= 0) || (iovcnt >= IOV_MAX)) {
+        return MCT_DAEMON_ERROR_SEND_FAILED;
+    }
+
+    memcpy(header.pattern, mctMulticastHeader, sizeof(header.pattern));
+    header.seq = htonl(udp->seq);
+
+    vec[0].iov_base = &header;
+    vec[0].iov_len = sizeof(header);
+
+    for (i = 0; i < iovcnt; i++) {
+        vec[i + 1] = iov[i];
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &udp->addr;
+    msg.msg_namelen = sizeof(udp->addr);
+    msg.msg_iov = vec;
+    msg.msg_iovlen = (size_t)iovcnt + 1;
+
+    /* a lost datagram still consumes its sequence number */
+    udp->seq++;
+
+    sent = sendmsg(udp->sock, &msg, MSG_DONTWAIT);
+
+    if (sent < 0) {
+        static int error_udp_send_failed = 0;
+
+        MCT_DAEMON_METRICS_ADD(udp->metrics.dropped, 1);
+
+        if (!error_udp_send_failed) {
+            mct_vlog(LOG_WARNING, "%s: sendmsg() failed: %s\n", __func__, strerror(errno));
+            error_udp_send_failed = 1;
+        }
+
+        return MCT_DAEMON_ERROR_SEND_FAILED;
+    }
+
+    MCT_DAEMON_METRICS_ADD(udp->metrics.messages, 1);
+    MCT_DAEMON_METRICS_ADD(udp->metrics.bytes, sent);
+
+    return MCT_DAEMON_ERROR_OK;
+}
+
+int mct_daemon_udp_send(MctDaemonUdpMulticast *udp,
+                        void *data1,
+                        int size1,
+                        void *data2,
+                        int size2)
+{
+    struct iovec iov[2];
+    int iovcnt = 0;
+
+    if ((data1 != NULL) && (size1 > 0)) {
+        iov[iovcnt].iov_base = data1;
+        iov[iovcnt].iov_len = (size_t)size1;
+        iovcnt++;
+    }
+
+    if ((data2 != NULL) && (size2 > 0)) {
+        iov[iovcnt].iov_base = data2;
+        iov[iovcnt].iov_len = (size_t)size2;
+        iovcnt++;
+    }
+
+    return mct_daemon_udp_sendv(udp, iov, iovcnt);
+}
@@ -0,0 +1,70 @@
+#ifndef MCT_DAEMON_UDP_SOCKET_H
+#define MCT_DAEMON_UDP_SOCKET_H
+
+#include <stdint.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include "mct_common.h"
+#include "mct_daemon_metrics.h"
+
+/**
+ * UDP multicast output channel of the daemon.
+ */
+typedef struct
+{
+    int sock;                  /**< UDP socket, -1 if multicast is disabled */
+    struct sockaddr_in addr;   /**< multicast group address and port */
+    uint32_t seq;              /**< sequence number of the next datagram */
+    MctDaemonMetrics metrics;  /**< Counters of sent and dropped datagrams */
+} MctDaemonUdpMulticast;
+
+/**
+ * @brief mct_daemon_udp_init - open the multicast output channel
+ * @param udp multicast channel
+ * @param address multicast group address
+ * @param port multicast port
+ * @param ttl time to live of sent datagrams
+ * @return on success: MCT_DAEMON_ERROR_OK, on error: MCT_DAEMON_ERROR_UNKNOWN
+ */
+int mct_daemon_udp_init(MctDaemonUdpMulticast *udp,
+                        const char *address,
+                        int port,
+                        int ttl);
+
+/**
+ * @brief mct_daemon_udp_close - close the multicast output channel
+ * @param udp multicast channel
+ */
+void mct_daemon_udp_close(MctDaemonUdpMulticast *udp);
+
+/**
+ * @brief mct_daemon_udp_send - send one message in one datagram
+ * @param udp multicast channel
+ * @param data1 message header
+ * @param size1 size of message header
+ * @param data2 message payload
+ * @param size2 size of message payload
+ * @return on success: MCT_DAEMON_ERROR_OK, on error: MCT_DAEMON_ERROR_SEND_FAILED
+ */
+int mct_daemon_udp_send(MctDaemonUdpMulticast *udp,
+                        void *data1,
+                        int size1,
+                        void *data2,
+                        int size2);
+
+/**
+ * @brief mct_daemon_udp_sendv - send complete messages in one datagram
+ *
+ * The multicast header with the next sequence number is prepended.
+ * The total size must not exceed MCT_DAEMON_UDP_MAX_DATAGRAM_SIZE.
+ *
+ * @param udp multicast channel
+ * @param iov array of message buffers
+ * @param iovcnt number of buffers, at most IOV_MAX - 1
+ * @return on success: MCT_DAEMON_ERROR_OK, on error: MCT_DAEMON_ERROR_SEND_FAILED
+ */
+int mct_daemon_udp_sendv(MctDaemonUdpMulticast *udp,
+                         const struct iovec *iov,
+                         int iovcnt);
+
+#endif /* MCT_DAEMON_UDP_SOCKET_H */
@@ -66,8 +66,11 @@ MctReturnValue mct_client_init_port(MctClient *client, int port, int verbose)
     client->mode = MCT_CLIENT_MODE_TCP;
     client->receiver.buffer = NULL;
     client->receiver.buf = NULL;
-    client->receiver.backup_buf = NULL;
+    client->receiver.ring = 0;
     client->hostip = NULL;
+    client->multicast_seq = 0;
+    client->multicast_seq_valid = 0;
+    client->multicast_lost = 0;
 
     return MCT_RETURN_OK;
 }
@@ -445,6 +448,39 @@ MctReturnValue mct_client_cleanup(MctClient *client, int verbose)
     return ret;
 }
 
+/**
+ * Check and strip the multicast header of a received datagram.
+ * Lost datagrams are detected by gaps in the sequence numbers.
+ * Datagrams without multicast header are left untouched.
+ * @param client pointer to mct client structure
+ */
+static void mct_client_check_multicast_header(MctClient *client)
+{
+    MctMulticastHeader header;
+    uint32_t seq = 0;
+
+    if ((client->receiver.bytesRcvd < (int32_t)sizeof(MctMulticastHeader)) ||
+        (memcmp(client->receiver.buf, mctMulticastHeader, sizeof(mctMulticastHeader)) != 0)) {
+        return;
+    }
+
+    memcpy(&header, client->receiver.buf, sizeof(header));
+    seq = ntohl(header.seq);
+
+    if (client->multicast_seq_valid && (seq != client->multicast_seq)) {
+        client->multicast_lost += seq - client->multicast_seq;
+        mct_vlog(LOG_WARNING,
+                 "%s: %u multicast datagrams lost\n",
+                 __func__,
+                 seq - client->multicast_seq);
+    }
+
+    client->multicast_seq = seq + 1;
+    client->multicast_seq_valid = 1;
+
+    mct_receiver_remove(&(client->receiver), sizeof(MctMulticastHeader));
+}
+
 MctReturnValue mct_client_main_loop(MctClient *client, void *data, int verbose)
 {
     MctMessage msg;
@@ -472,6 +508,10 @@ MctReturnValue mct_client_main_loop(MctClient *client, void *data, int verbose)
             return MCT_RETURN_TRUE;
         }
 
+        if (client->mode == MCT_CLIENT_MODE_UDP_MULTICAST) {
+            mct_client_check_multicast_header(client);
+        }
+
         while (mct_message_read(&msg, (unsigned char *)(client->receiver.buf),
                                 client->receiver.bytesRcvd,
                                 client->resync_serial_header,
@@ -500,6 +540,12 @@ MctReturnValue mct_client_main_loop(MctClient *client, void *data, int verbose)
             }
         }
 
+        /* a datagram holds complete messages only, drop what is left over */
+        if ((client->mode == MCT_CLIENT_MODE_UDP_MULTICAST) &&
+            (client->receiver.bytesRcvd > 0)) {
+            mct_receiver_remove(&(client->receiver), client->receiver.bytesRcvd);
+        }
+
         if (mct_receiver_move_to_begin(&(client->receiver)) == MCT_RETURN_ERROR) {
             /* Return value ignored */
             mct_message_free(&msg, verbose);
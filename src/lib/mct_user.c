@@ -42,6 +42,7 @@
 #include "mct_user_shared.h"
 #include "mct_user_shared_cfg.h"
 #include "mct_user_cfg.h"
+#include "mct_pattern.h"
 
 #ifdef MCT_FATAL_LOG_RESET_ENABLE
 #define MCT_LOG_FATAL_RESET_TRAP(LOGLEVEL) \
@@ -3987,25 +3988,17 @@ MctReturnValue mct_user_log_check_user_message(void)
                 }
 
                 /* resync if necessary */
-                offset = 0;
-
-                do {
-                    userheader = (MctUserHeader *)(receiver->buf + offset);
-
-                    /* Check for user header pattern */
-                    if (mct_user_check_userheader(userheader)) {
-                        break;
-                    }
-
-                    offset++;
-                } while ((int32_t)(sizeof(MctUserHeader) + offset) <= receiver->bytesRcvd);
+                offset = mct_pattern_find(receiver->buf, (size_t)receiver->bytesRcvd,
+                                          mctUserHeader, sizeof(mctUserHeader));
 
                 /* Check for user header pattern */
-                if ((mct_user_check_userheader(userheader) < 0) ||
-                    (mct_user_check_userheader(userheader) == 0)) {
+                if ((offset < 0) ||
+                    ((int32_t)(sizeof(MctUserHeader) + offset) > receiver->bytesRcvd)) {
                     break;
                 }
 
+                userheader = (MctUserHeader *)(receiver->buf + offset);
+
                 /* Set new start offset */
                 if (offset > 0) {
                     receiver->buf += offset;
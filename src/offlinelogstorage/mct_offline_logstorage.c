@@ -14,6 +14,7 @@
 #include "mct_offline_logstorage_internal.h"
 #include "mct_offline_logstorage_behavior.h"
 #include "mct_config_file_parser.h"
+#include "mct_compress.h"
 
 #define MCT_OFFLINE_LOGSTORAGE_FILTER_ERROR 1
 #define MCT_OFFLINE_LOGSTORAGE_STORE_FILTER_ERROR 2
@@ -61,13 +62,12 @@ static void mct_logstorage_filter_config_free(MctLogStorageFilterConfig *data)
         data->ecuid = NULL;
     }
 
+    mct_logstorage_close_index(data);
+
     if (data->log != NULL)
         fclose(data->log);
 
-    if (data->cache != NULL) {
-        free(data->cache);
-        data->cache = NULL;
-    }
+    mct_logstorage_free_msg_cache(data);
 
     n = data->records;
 
@@ -261,6 +261,172 @@ static int mct_logstorage_list_find(char *key,
     return num;
 }
 
+/**
+ * mct_logstorage_filter_key_pack
+ *
+ * Pack a key of the form "ecu:apid:ctid" into ids the way mct_set_id()
+ * stores them. An empty id is packed as 0.
+ *
+ * @param key   Key to be packed
+ * @param ids   [out] Packed ECU, application and context id
+ * @return 0 on success, -1 if the key is not of the expected form
+ */
+static int mct_logstorage_filter_key_pack(const char *key, uint32_t *ids)
+{
+    char id[MCT_ID_SIZE + 1];
+    char tmp[MCT_ID_SIZE];
+    const char *end = NULL;
+    size_t len = 0;
+    int i = 0;
+
+    for (i = 0; i < 3; i++) {
+        end = (i < 2) ? strchr(key, ':') : key + strlen(key);
+
+        if (end == NULL)
+            return -1;
+
+        len = (size_t)(end - key);
+
+        /* keys with longer ids never matched a message */
+        if (len > MCT_ID_SIZE)
+            return -1;
+
+        memset(id, 0, sizeof(id));
+        memcpy(id, key, len);
+        mct_set_id(tmp, id);
+        memcpy(&ids[i], tmp, MCT_ID_SIZE);
+        key = end + 1;
+    }
+
+    return 0;
+}
+
+static int mct_logstorage_filter_index_slot(MctLogStorageFilterIndex *index,
+                                            uint32_t ecuid,
+                                            uint32_t apid,
+                                            uint32_t ctid)
+{
+    uint64_t key = (((uint64_t)apid << 32) | ctid) ^ ((uint64_t)ecuid * 0xC2B2AE3D27D4EB4FULL);
+
+    /* Fibonacci hashing, the upper bits are the best mixed ones */
+    return (int)(((key * 0x9E3779B97F4A7C15ULL) >> 32) & (uint64_t)(index->size - 1));
+}
+
+/**
+ * mct_logstorage_filter_index_free
+ *
+ * Free the filter index.
+ *
+ * @param index Filter index
+ */
+static void mct_logstorage_filter_index_free(MctLogStorageFilterIndex *index)
+{
+    free(index->slots);
+    index->slots = NULL;
+    index->size = 0;
+}
+
+/**
+ * mct_logstorage_filter_index_build
+ *
+ * Enter the keys of all filters into the filter index. Keys of one filter
+ * are entered in list order, so a lookup returns the filters of one key in
+ * the order of the configuration file. If the index cannot be built, the
+ * filter list is searched instead.
+ *
+ * @param index Filter index
+ * @param list  List of the filter configurations
+ * @return 0 on success, -1 on error
+ */
+static int mct_logstorage_filter_index_build(MctLogStorageFilterIndex *index,
+                                             MctLogStorageFilterList *list)
+{
+    MctLogStorageFilterList *tmp = NULL;
+    MctLogStorageFilterSlot *slot = NULL;
+    uint32_t ids[3];
+    int num_keys = 0;
+    int size = 16;
+    int pos = 0;
+    int i = 0;
+
+    mct_logstorage_filter_index_free(index);
+
+    for (tmp = list; tmp != NULL; tmp = tmp->next)
+        num_keys += tmp->num_keys;
+
+    /* keep the load factor at most one half */
+    while (size < 2 * num_keys)
+        size *= 2;
+
+    index->slots = calloc((size_t)size, sizeof(MctLogStorageFilterSlot));
+
+    if (index->slots == NULL)
+        return -1;
+
+    index->size = size;
+
+    for (tmp = list; tmp != NULL; tmp = tmp->next) {
+        for (i = 0; i < tmp->num_keys; i++) {
+            if (mct_logstorage_filter_key_pack(tmp->key_list +
+                                               (i * MCT_OFFLINE_LOGSTORAGE_MAX_KEY_LEN),
+                                               ids) != 0)
+                continue;
+
+            pos = mct_logstorage_filter_index_slot(index, ids[0], ids[1], ids[2]);
+
+            for (slot = &index->slots[pos]; slot->data != NULL;
+                 pos = (pos + 1) & (size - 1), slot = &index->slots[pos]) {
+                if ((slot->data == tmp->data) && (slot->ecuid == ids[0]) &&
+                    (slot->apid == ids[1]) && (slot->ctid == ids[2]))
+                    break;
+            }
+
+            slot->ecuid = ids[0];
+            slot->apid = ids[1];
+            slot->ctid = ids[2];
+            slot->data = tmp->data;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * mct_logstorage_filter_index_find
+ *
+ * Append all filter configurations with the given key to config, except
+ * the ones already contained in it.
+ *
+ * @param index  Filter index
+ * @param ids    Packed ECU, application and context id
+ * @param config Filter configurations found so far
+ * @param num    Number of filter configurations found so far
+ * @return Number of the filter configurations found including the new ones
+ */
+static int mct_logstorage_filter_index_find(MctLogStorageFilterIndex *index,
+                                            const uint32_t *ids,
+                                            MctLogStorageFilterConfig **config,
+                                            int num)
+{
+    MctLogStorageFilterSlot *slot = NULL;
+    int pos = mct_logstorage_filter_index_slot(index, ids[0], ids[1], ids[2]);
+    int i = 0;
+
+    for (slot = &index->slots[pos]; slot->data != NULL;
+         pos = (pos + 1) & (index->size - 1), slot = &index->slots[pos]) {
+        if ((slot->ecuid != ids[0]) || (slot->apid != ids[1]) || (slot->ctid != ids[2]))
+            continue;
+
+        for (i = 0; (i < num) && (config[i] != slot->data); i++)
+            ;
+
+        if (i == num)
+            config[num++] = slot->data;
+    }
+
+    return num;
+}
+
 /* Configuration file parsing helper functions */
 
 static int mct_logstorage_count_ids(const char *str)
@@ -300,6 +466,9 @@ void mct_logstorage_free(MctLogStorage *handle, int reason)
         return;
     }
 
+    mct_logstorage_filter_index_free(&handle->filter_index);
+    free(handle->route_cache);
+    handle->route_cache = NULL;
     mct_logstorage_list_destroy(&(handle->config_list), &handle->uconfig,
                                 handle->device_mount_point, reason);
 }
@@ -932,6 +1101,11 @@ static void mct_logstorage_filter_set_strategy(MctLogStorageFilterConfig *config
         config->mct_logstorage_write = &mct_logstorage_write_on_msg;
         config->mct_logstorage_sync = &mct_logstorage_sync_on_msg;
     }
+    else if (strategy == MCT_LOGSTORAGE_SYNC_ON_TIMER) {
+        config->mct_logstorage_prepare = &mct_logstorage_prepare_on_msg;
+        config->mct_logstorage_write = &mct_logstorage_write_on_msg;
+        config->mct_logstorage_sync = &mct_logstorage_sync_on_timer;
+    }
     else { /* cache based */
         config->mct_logstorage_prepare = &mct_logstorage_prepare_msg_cache;
         config->mct_logstorage_write = &mct_logstorage_write_msg_cache;
@@ -1151,6 +1325,15 @@ static int mct_logstorage_check_specificsize(MctLogStorageFilterConfig *config,
     return mct_logstorage_read_number(&config->specific_size, value);
 }
 
+static int mct_logstorage_check_sync_size(MctLogStorageFilterConfig *config,
+                                          char *value)
+{
+    if ((config == NULL) || (value == NULL))
+        return -1;
+
+    return mct_logstorage_read_number(&config->sync_size, value);
+}
+
 /**
  * mct_logstorage_check_sync_strategy
  *
@@ -1173,6 +1356,10 @@ static int mct_logstorage_check_sync_strategy(MctLogStorageFilterConfig *config,
         config->sync = MCT_LOGSTORAGE_SYNC_ON_MSG;
         mct_log(LOG_DEBUG, "ON_MSG found, ignore other if added\n");
     }
+    else if (strcasestr(value, "ON_TIMER") != NULL) {
+        config->sync = MCT_LOGSTORAGE_SYNC_ON_TIMER;
+        mct_log(LOG_DEBUG, "ON_TIMER found, ignore other if added\n");
+    }
     else { /* ON_MSG not set, combination of cache based strategies possible */
 
         if (strcasestr(value, "ON_DAEMON_EXIT") != NULL)
@@ -1265,6 +1452,70 @@ static int mct_logstorage_check_disable_network(MctLogStorageFilterConfig *confi
     return 0;
 }
 
+/**
+ * mct_logstorage_check_compression
+ *
+ * Evaluate compression. The compression is an optional filter
+ * configuration parameter.
+ * If the given value cannot be associated with a flag, the default
+ * flag will be assigned.
+ *
+ * @param[in] config    MctLogStorageFilterConfig
+ * @param[in] value     string given in config file
+ * @return              0 on success, 1 on unknown value, -1 on error
+ */
+static int mct_logstorage_check_compression(MctLogStorageFilterConfig *config,
+                                            char *value)
+{
+    if ((config == NULL) || (value == NULL))
+        return -1;
+
+    if (strcasestr(value, "ON") != NULL) {
+        config->compression = MCT_LOGSTORAGE_COMPRESSION_ON;
+    } else if (strcasestr(value, "OFF") != NULL) {
+        config->compression = MCT_LOGSTORAGE_COMPRESSION_OFF;
+    } else {
+        mct_log(LOG_WARNING,
+                "Unknown compression flag. Set default OFF\n");
+        config->compression = MCT_LOGSTORAGE_COMPRESSION_OFF;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * mct_logstorage_check_index
+ *
+ * Evaluate index flag. The index is an optional filter configuration
+ * parameter.
+ * If the given value cannot be associated with a flag, the default
+ * flag will be assigned.
+ *
+ * @param[in] config    MctLogStorageFilterConfig
+ * @param[in] value     string given in config file
+ * @return              0 on success, 1 on unknown value, -1 on error
+ */
+static int mct_logstorage_check_index(MctLogStorageFilterConfig *config,
+                                      char *value)
+{
+    if ((config == NULL) || (value == NULL))
+        return -1;
+
+    if (strcasestr(value, "ON") != NULL) {
+        config->index = MCT_LOGSTORAGE_INDEX_ON;
+    } else if (strcasestr(value, "OFF") != NULL) {
+        config->index = MCT_LOGSTORAGE_INDEX_OFF;
+    } else {
+        mct_log(LOG_WARNING,
+                "Unknown index flag. Set default OFF\n");
+        config->index = MCT_LOGSTORAGE_INDEX_OFF;
+        return 1;
+    }
+
+    return 0;
+}
+
 /**
  * mct_logstorage_check_ecuid
  *
@@ -1369,6 +1620,21 @@ static MctLogstorageFilterConf
         .key = "DisableNetwork",
         .func = mct_logstorage_check_disable_network,
         .is_opt = 1
+    },
+    [MCT_LOGSTORAGE_FILTER_CONF_COMPRESSION] = {
+        .key = "Compression",
+        .func = mct_logstorage_check_compression,
+        .is_opt = 1
+    },
+    [MCT_LOGSTORAGE_FILTER_CONF_SYNC_SIZE] = {
+        .key = "SyncSize",
+        .func = mct_logstorage_check_sync_size,
+        .is_opt = 1
+    },
+    [MCT_LOGSTORAGE_FILTER_CONF_INDEX] = {
+        .key = "Index",
+        .func = mct_logstorage_check_index,
+        .is_opt = 1
     }
 };
 
@@ -1444,6 +1710,21 @@ static MctLogstorageFilterConf
         .key = NULL,
         .func = mct_logstorage_check_disable_network,
         .is_opt = 1
+    },
+    [MCT_LOGSTORAGE_FILTER_CONF_COMPRESSION] = {
+        .key = NULL,
+        .func = mct_logstorage_check_compression,
+        .is_opt = 1
+    },
+    [MCT_LOGSTORAGE_FILTER_CONF_SYNC_SIZE] = {
+        .key = NULL,
+        .func = mct_logstorage_check_sync_size,
+        .is_opt = 1
+    },
+    [MCT_LOGSTORAGE_FILTER_CONF_INDEX] = {
+        .key = NULL,
+        .func = mct_logstorage_check_index,
+        .is_opt = 1
     }
 };
 
@@ -1518,6 +1799,21 @@ static MctLogstorageFilterConf
         .key = NULL,
         .func = mct_logstorage_check_disable_network,
         .is_opt = 1
+    },
+    [MCT_LOGSTORAGE_FILTER_CONF_COMPRESSION] = {
+        .key = NULL,
+        .func = mct_logstorage_check_compression,
+        .is_opt = 1
+    },
+    [MCT_LOGSTORAGE_FILTER_CONF_SYNC_SIZE] = {
+        .key = NULL,
+        .func = mct_logstorage_check_sync_size,
+        .is_opt = 1
+    },
+    [MCT_LOGSTORAGE_FILTER_CONF_INDEX] = {
+        .key = NULL,
+        .func = mct_logstorage_check_index,
+        .is_opt = 1
     }
 };
 
@@ -1659,6 +1955,7 @@ static int mct_daemon_offline_setup_filter_properties(MctLogStorage *handle,
     tmp_data.log_level = MCT_LOG_VERBOSE;
     tmp_data.reset_log_level = MCT_LOG_OFF;
     tmp_data.disable_network_routing = MCT_LOGSTORAGE_DISABLE_NW_OFF;
+    tmp_data.compression = MCT_LOGSTORAGE_COMPRESSION_OFF;
 
     for (i = 0; i < MCT_LOGSTORAGE_FILTER_CONF_COUNT; i++) {
         ret = mct_logstorage_get_filter_value(config_file, sec_name, i, value);
@@ -1717,6 +2014,18 @@ static int mct_daemon_offline_setup_filter_properties(MctLogStorage *handle,
         return MCT_OFFLINE_LOGSTORAGE_FILTER_ERROR;
     }
 
+    /* Compressed files are written in blocks, so messages of a filter
+     * without cache based strategy are collected in a cache of one block */
+    if ((tmp_data.compression == MCT_LOGSTORAGE_COMPRESSION_ON) &&
+        MCT_OFFLINE_LOGSTORAGE_IS_FILE_BASED(tmp_data.sync)) {
+        tmp_data.sync = MCT_LOGSTORAGE_SYNC_ON_SPECIFIC_SIZE |
+            MCT_LOGSTORAGE_SYNC_ON_DEMAND |
+            MCT_LOGSTORAGE_SYNC_ON_DEVICE_DISCONNECT |
+            MCT_LOGSTORAGE_SYNC_ON_DAEMON_EXIT;
+        tmp_data.specific_size = MCT_OFFLINE_LOGSTORAGE_MIN(MCT_BLOCK_SIZE,
+                                                            tmp_data.file_size);
+    }
+
     /* filter configuration is valid */
     ret = mct_logstorage_setup_table(handle, &tmp_data);
 
@@ -1980,6 +2289,72 @@ static int mct_logstorage_store_filters(MctLogStorage *handle,
     return valid;
 }
 
+/**
+ * mct_logstorage_check_index_files
+ *
+ * Disable the index of filters which share their log files with other
+ * filters, as the position of messages in such files is not known to the
+ * single filter.
+ *
+ * @param list          List of filter configurations
+ */
+static void mct_logstorage_check_index_files(MctLogStorageFilterList *list)
+{
+    MctLogStorageFilterList *tmp = NULL;
+    MctLogStorageFilterList *other = NULL;
+
+    for (tmp = list; tmp != NULL; tmp = tmp->next) {
+        if ((tmp->data->index != MCT_LOGSTORAGE_INDEX_ON) ||
+            (tmp->data->file_name == NULL))
+            continue;
+
+        for (other = list; other != NULL; other = other->next) {
+            if ((other != tmp) && (other->data->file_name != NULL) &&
+                (strcmp(other->data->file_name, tmp->data->file_name) == 0)) {
+                mct_vlog(LOG_WARNING,
+                         "%s: Log file [%s] is shared by several filters, no index is written\n",
+                         __func__, tmp->data->file_name);
+                tmp->data->index = MCT_LOGSTORAGE_INDEX_OFF;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * mct_logstorage_recover_caches
+ *
+ * Write the caches left by a crash of the daemon to the log files.
+ *
+ * @param handle        MCT Logstorage handle
+ */
+static void mct_logstorage_recover_caches(MctLogStorage *handle)
+{
+    MctLogStorageFilterList *tmp = NULL;
+    MctNewestFileName *newest = NULL;
+
+    if (g_logstorage_cache_dir[0] == '\0')
+        return;
+
+    for (tmp = handle->config_list; tmp != NULL; tmp = tmp->next) {
+        if ((mct_logstorage_recover_msg_cache(tmp->data,
+                                              &handle->uconfig,
+                                              handle->device_mount_point) != 0) ||
+            (tmp->data->working_file_name == NULL))
+            continue;
+
+        /* filters with the same file name continue with the recovered file */
+        for (newest = handle->newest_file_list; newest != NULL; newest = newest->next) {
+            if (strcmp(newest->file_name, tmp->data->file_name) == 0) {
+                free(newest->newest_file);
+                newest->newest_file = strdup(tmp->data->working_file_name);
+                newest->wrap_id = tmp->data->wrap_id;
+                break;
+            }
+        }
+    }
+}
+
 /**
  * mct_logstorage_load_config
  *
@@ -2024,6 +2399,21 @@ static int mct_logstorage_load_config(MctLogStorage *handle)
     config_file_name[PATH_MAX - 1] = 0;
     ret = mct_logstorage_store_filters(handle, config_file_name);
 
+    if ((ret == 0) || (ret == 1)) {
+        mct_logstorage_check_index_files(handle->config_list);
+        mct_logstorage_recover_caches(handle);
+    }
+
+    if (((ret == 0) || (ret == 1)) &&
+        (mct_logstorage_filter_index_build(&handle->filter_index,
+                                           handle->config_list) != 0))
+        mct_log(LOG_WARNING, "Cannot build filter index, filters are searched\n");
+
+    /* routing decisions of a previous configuration are stale */
+    free(handle->route_cache);
+    handle->route_cache = calloc(MCT_OFFLINE_LOGSTORAGE_ROUTE_CACHE_SIZE,
+                                 sizeof(MctLogStorageRoute));
+
     if (ret == 1) {
         handle->config_status = MCT_OFFLINE_LOGSTORAGE_CONFIG_DONE;
         return 1;
@@ -2069,6 +2459,7 @@ int mct_logstorage_device_connected(MctLogStorage *handle, const char *mount_poi
     handle->device_mount_point[MCT_MOUNT_PATH_MAX] = 0;
     handle->connection_type = MCT_OFFLINE_LOGSTORAGE_DEVICE_CONNECTED;
     handle->config_status = 0;
+    handle->prepare_errors = 0;
     handle->write_errors = 0;
     handle->num_configs = 0;
     handle->newest_file_list = NULL;
@@ -2106,6 +2497,7 @@ int mct_logstorage_device_disconnected(MctLogStorage *handle, int reason)
     memset(handle->device_mount_point, 0, sizeof(char) * (MCT_MOUNT_PATH_MAX + 1));
     handle->connection_type = MCT_OFFLINE_LOGSTORAGE_DEVICE_DISCONNECTED;
     handle->config_status = 0;
+    handle->prepare_errors = 0;
     handle->write_errors = 0;
     handle->num_configs = 0;
 
@@ -2141,6 +2533,7 @@ int mct_logstorage_device_disconnected(MctLogStorage *handle, int reason)
 int mct_logstorage_get_loglevel_by_key(MctLogStorage *handle, char *key)
 {
     MctLogStorageFilterConfig *config[MCT_CONFIG_FILE_SECTIONS_MAX];
+    uint32_t ids[3];
     int num_configs = 0;
     int i = 0;
     int log_level = 0;
@@ -2152,7 +2545,11 @@ int mct_logstorage_get_loglevel_by_key(MctLogStorage *handle, char *key)
         (handle->config_status != MCT_OFFLINE_LOGSTORAGE_CONFIG_DONE))
         return -1;
 
-    num_configs = mct_logstorage_list_find(key, &(handle->config_list), config);
+    if (handle->filter_index.slots == NULL)
+        num_configs = mct_logstorage_list_find(key, &(handle->config_list), config);
+    else if (mct_logstorage_filter_key_pack(key, ids) == 0)
+        num_configs = mct_logstorage_filter_index_find(&handle->filter_index, ids,
+                                                       config, 0);
 
     if (num_configs == 0)
     {
@@ -2187,6 +2584,65 @@ int mct_logstorage_get_loglevel_by_key(MctLogStorage *handle, char *key)
     return log_level;
 }
 
+/**
+ * mct_logstorage_get_config_indexed
+ *
+ * Obtain the configuration data of all filters for provided apid and ctid
+ * from the filter index, probing the same keys as mct_logstorage_get_config
+ * in the same order.
+ *
+ * @param handle    MctLogStorage handle
+ * @param config    [out] Pointer to array of filter configurations
+ * @param apid      application id
+ * @param ctid      context id
+ * @param ecuid     ecu id
+ * @return          number of configurations found
+ */
+static int mct_logstorage_get_config_indexed(MctLogStorage *handle,
+                                             MctLogStorageFilterConfig **config,
+                                             char *apid,
+                                             char *ctid,
+                                             char *ecuid)
+{
+    char tmp[MCT_ID_SIZE];
+    uint32_t ecu = 0;
+    uint32_t app = 0;
+    uint32_t ctx = 0;
+    int i = 0;
+    int num_configs = 0;
+
+    mct_set_id(tmp, ecuid);
+    memcpy(&ecu, tmp, MCT_ID_SIZE);
+
+    if ((apid == NULL) && (ctid == NULL)) {
+        uint32_t ids[3] = { ecu, 0, 0 };
+
+        return mct_logstorage_filter_index_find(&handle->filter_index, ids, config, 0);
+    }
+
+    mct_set_id(tmp, apid);
+    memcpy(&app, tmp, MCT_ID_SIZE);
+    mct_set_id(tmp, ctid);
+    memcpy(&ctx, tmp, MCT_ID_SIZE);
+
+    /* :apid:, ::ctid, :apid:ctid, ecu:apid:ctid, ecu:apid:, ecu::ctid, ecu:: */
+    uint32_t ids[MCT_OFFLINE_LOGSTORAGE_MAX_POSSIBLE_KEYS][3] = {
+        { 0, app, 0 }, { 0, 0, ctx }, { 0, app, ctx }, { ecu, app, ctx },
+        { ecu, app, 0 }, { ecu, 0, ctx }, { ecu, 0, 0 }
+    };
+
+    for (i = 0; i < MCT_OFFLINE_LOGSTORAGE_MAX_POSSIBLE_KEYS; i++) {
+        num_configs = mct_logstorage_filter_index_find(&handle->filter_index, ids[i],
+                                                       config, num_configs);
+
+        /* If all filter configurations matched, stop and return */
+        if (num_configs == handle->num_configs)
+            break;
+    }
+
+    return num_configs;
+}
+
 /**
  * mct_logstorage_get_config
  *
@@ -2222,6 +2678,9 @@ int mct_logstorage_get_config(MctLogStorage *handle,
         (ecuid == NULL))
         return 0;
 
+    if (handle->filter_index.slots != NULL)
+        return mct_logstorage_get_config_indexed(handle, config, apid, ctid, ecuid);
+
     /* Prepare possible keys with
      * Possible combinations are
      * ecu::
@@ -2316,72 +2775,46 @@ int mct_logstorage_get_config(MctLogStorage *handle,
 }
 
 /**
- * mct_logstorage_filter
+ * mct_logstorage_filter_route
  *
- * Check if log message need to be stored in a certain device based on filter
- * config
+ * Obtain the filter configurations a message of the given ids is stored by,
+ * regardless of its log level
  * - get all MctLogStorageFilterConfig from hash table possible by given
  *   apid/ctid (apid:, :ctid, apid:ctid
- * - for each found structure, compare message log level with configured one
+ * - drop the ones with a different EcuID or excluding apid or ctid
  *
  * @param handle    MctLogStorage handle
- * @param config    Pointer to array of filter configurations
+ * @param config    [out] Pointer to array of filter configurations
  * @param apid      application id
  * @param ctid      context id
- * @param log_level Log level of message
  * @param ecuid     EcuID given in the message
  * @return          number of found configurations
  */
-static int mct_logstorage_filter(MctLogStorage *handle,
-                                     MctLogStorageFilterConfig **config,
-                                     char *apid,
-                                     char *ctid,
-                                     char *ecuid,
-                                     int log_level)
+static int mct_logstorage_filter_route(MctLogStorage *handle,
+                                       MctLogStorageFilterConfig **config,
+                                       char *apid,
+                                       char *ctid,
+                                       char *ecuid)
 {
     int i = 0;
     int num = 0;
-
-    if ((handle == NULL) || (config == NULL) || (ecuid == NULL))
-        return -1;
+    int found = 0;
 
     /* filter on names: find MctLogStorageFilterConfig structures */
-    num = mct_logstorage_get_config(handle, config, apid, ctid, ecuid);
+    found = mct_logstorage_get_config(handle, config, apid, ctid, ecuid);
 
-    if (num == 0) {
-        mct_vlog(LOG_DEBUG,
-                 "%s: No valid filter configuration found for apid=[%.4s] ctid=[%.4s] ecuid=[%.4s]\n",
-                 __func__, apid, ctid, ecuid);
-        return 0;
-    }
-
-    for (i = 0 ; i < num ; i++)
+    for (i = 0 ; i < found ; i++)
     {
         if (config[i] == NULL)
-        {
-            mct_vlog(LOG_DEBUG,
-                     "%s: config[%d] is NULL, continue the filter loop\n",
-                     __func__, i);
-            continue;
-        }
-
-        /* filter on log level */
-        if (log_level > config[i]->log_level) {
-            mct_vlog(LOG_DEBUG,
-                     "%s: Requested log level (%d) is higher than config[%d]->log_level (%d). Set the config to NULL and continue the filter loop\n",
-                     __func__, log_level, i, config[i]->log_level);
-            config[i] = NULL;
             continue;
-        }
 
         /* filter on ECU id only if EcuID is set */
         if (config[i]->ecuid != NULL) {
             if (strncmp(ecuid, config[i]->ecuid, MCT_ID_SIZE) != 0)
             {
                 mct_vlog(LOG_DEBUG,
-                         "%s: ECUID does not match (Requested=%s, config[%d]=%s). Set the config to NULL and continue the filter loop\n",
+                         "%s: ECUID does not match (Requested=%.4s, config[%d]=%s). Skip the config\n",
                          __func__, ecuid, i, config[i]->ecuid);
-                config[i] = NULL;
                 continue;
             }
         }
@@ -2390,65 +2823,190 @@ static int mct_logstorage_filter(MctLogStorage *handle,
             /* Filter on excluded application and context */
             if(apid != NULL && ctid != NULL && mct_logstorage_check_excluded_ids(apid, ",", config[i]->excluded_apids)
               && mct_logstorage_check_excluded_ids(ctid, ",", config[i]->excluded_ctids)) {
-                mct_vlog(LOG_DEBUG, "%s: %s matches with [%s] and %s matches with [%s]. Set the config to NULL and continue the filter loop\n",
+                mct_vlog(LOG_DEBUG, "%s: %.4s matches with [%s] and %.4s matches with [%s]. Skip the config\n",
                 __func__, apid, config[i]->excluded_apids, ctid, config[i]->excluded_ctids);
-                config[i] = NULL;
+                continue;
             }
         }
         else if(config[i]->excluded_apids == NULL) {
             /* Only filter on excluded contexts */
             if(ctid != NULL && config[i]->excluded_ctids != NULL && mct_logstorage_check_excluded_ids(ctid, ",", config[i]->excluded_ctids)) {
-                mct_vlog(LOG_DEBUG, "%s: %s matches with [%s]. Set the config to NULL and continue the filter loop\n",
+                mct_vlog(LOG_DEBUG, "%s: %.4s matches with [%s]. Skip the config\n",
                 __func__, ctid, config[i]->excluded_ctids);
-                config[i] = NULL;
+                continue;
             }
         }
         else if(config[i]->excluded_ctids == NULL) {
             /* Only filter on excluded applications */
             if(apid != NULL && config[i]->excluded_apids != NULL && mct_logstorage_check_excluded_ids(apid, ",", config[i]->excluded_apids)) {
-                mct_vlog(LOG_DEBUG, "%s: %s matches with [%s]. Set the config to NULL and continue the filter loop\n",
+                mct_vlog(LOG_DEBUG, "%s: %.4s matches with [%s]. Skip the config\n",
                 __func__, apid, config[i]->excluded_apids);
-                config[i] = NULL;
+                continue;
             }
         }
+
+        config[num++] = config[i];
     }
 
     return num;
 }
 
 /**
- * mct_logstorage_write
+ * mct_logstorage_filter_route_cached
  *
- * Write a message to one or more configured log files, based on filter
- * configuration.
+ * Obtain the filter configurations a message of the given ids is stored by
+ * from the routing decision cache. On a miss the decision is computed by
+ * mct_logstorage_filter_route and cached, unless it has too many filters.
+ * The cache is dropped whenever the filter configuration is loaded or freed.
  *
  * @param handle    MctLogStorage handle
- * @param uconfig   User configurations for log file
- * @param data1     Data buffer of message header
- * @param size1     Size of message header buffer
+ * @param config    [out] Pointer to array of filter configurations
+ * @param apid      application id
+ * @param ctid      context id
+ * @param ecuid     EcuID given in the message
+ * @param max_log_level [out] Highest log level of the found configurations
+ * @return          number of found configurations
+ */
+static int mct_logstorage_filter_route_cached(MctLogStorage *handle,
+                                              MctLogStorageFilterConfig **config,
+                                              char *apid,
+                                              char *ctid,
+                                              char *ecuid,
+                                              int *max_log_level)
+{
+    MctLogStorageRoute *route = NULL;
+    char tmp[MCT_ID_SIZE];
+    uint32_t ids[3] = { 0, 0, 0 };
+    uint64_t key = 0;
+    int type = MCT_LOGSTORAGE_ROUTE_ECU;
+    int num = 0;
+    int i = 0;
+
+    mct_set_id(tmp, ecuid);
+    memcpy(&ids[0], tmp, MCT_ID_SIZE);
+
+    if ((apid != NULL) || (ctid != NULL)) {
+        type = MCT_LOGSTORAGE_ROUTE_IDS;
+        mct_set_id(tmp, apid);
+        memcpy(&ids[1], tmp, MCT_ID_SIZE);
+        mct_set_id(tmp, ctid);
+        memcpy(&ids[2], tmp, MCT_ID_SIZE);
+    }
+
+    key = (((uint64_t)ids[1] << 32) | ids[2]) ^ ((uint64_t)ids[0] * 0xC2B2AE3D27D4EB4FULL);
+    route = &handle->route_cache[((key * 0x9E3779B97F4A7C15ULL) >> 32) &
+                                 (MCT_OFFLINE_LOGSTORAGE_ROUTE_CACHE_SIZE - 1)];
+
+    if ((route->type == type) && (route->ecuid == ids[0]) &&
+        (route->apid == ids[1]) && (route->ctid == ids[2])) {
+        memcpy(config, route->config, sizeof(MctLogStorageFilterConfig *) * (size_t)route->num);
+        *max_log_level = route->max_log_level;
+        return route->num;
+    }
+
+    num = mct_logstorage_filter_route(handle, config, apid, ctid, ecuid);
+
+    *max_log_level = -1;
+
+    for (i = 0; i < num; i++) {
+        if (config[i]->log_level > *max_log_level)
+            *max_log_level = config[i]->log_level;
+    }
+
+    if (num <= MCT_OFFLINE_LOGSTORAGE_ROUTE_MAX_CONFIGS) {
+        route->type = type;
+        route->ecuid = ids[0];
+        route->apid = ids[1];
+        route->ctid = ids[2];
+        route->num = num;
+        route->max_log_level = *max_log_level;
+        memcpy(route->config, config, sizeof(MctLogStorageFilterConfig *) * (size_t)num);
+    }
+
+    return num;
+}
+
+/**
+ * mct_logstorage_filter
+ *
+ * Check if log message need to be stored in a certain device based on filter
+ * config
+ * - get the MctLogStorageFilterConfig structures matching the ids of the
+ *   message, the EcuID and the excluded ids
+ * - for each found structure, compare message log level with configured one
+ *
+ * @param handle    MctLogStorage handle
+ * @param config    Pointer to array of filter configurations
+ * @param apid      application id
+ * @param ctid      context id
+ * @param log_level Log level of message
+ * @param ecuid     EcuID given in the message
+ * @return          number of found configurations
+ */
+static int mct_logstorage_filter(MctLogStorage *handle,
+                                     MctLogStorageFilterConfig **config,
+                                     char *apid,
+                                     char *ctid,
+                                     char *ecuid,
+                                     int log_level)
+{
+    int i = 0;
+    int num = 0;
+    int max_log_level = MCT_LOG_VERBOSE;
+
+    if ((handle == NULL) || (config == NULL) || (ecuid == NULL))
+        return -1;
+
+    if (handle->route_cache != NULL)
+        num = mct_logstorage_filter_route_cached(handle, config, apid, ctid, ecuid,
+                                                 &max_log_level);
+    else
+        num = mct_logstorage_filter_route(handle, config, apid, ctid, ecuid);
+
+    if ((num == 0) || (log_level > max_log_level)) {
+        mct_vlog(LOG_DEBUG,
+                 "%s: No valid filter configuration found for apid=[%.4s] ctid=[%.4s] ecuid=[%.4s]\n",
+                 __func__, apid, ctid, ecuid);
+        return 0;
+    }
+
+    for (i = 0 ; i < num ; i++)
+    {
+        /* filter on log level */
+        if (log_level > config[i]->log_level) {
+            mct_vlog(LOG_DEBUG,
+                     "%s: Requested log level (%d) is higher than config[%d]->log_level (%d). Set the config to NULL and continue the filter loop\n",
+                     __func__, log_level, i, config[i]->log_level);
+            config[i] = NULL;
+        }
+    }
+
+    return num;
+}
+
+/**
+ * mct_logstorage_route
+ *
+ * Obtain the filter configurations a message is to be stored in, based on
+ * filter configuration. Only the filter configurations are read, so the
+ * message may be written later by mct_logstorage_write_routed.
+ *
+ * @param handle    MctLogStorage handle
+ * @param config    [out] Filter configurations with a log file
  * @param data2     Data buffer of extended message body
  * @param size2     Size of extended message body
- * @param data3     Data buffer of message body
- * @param size3     Size of message body
  * @param disable_nw Flag to disable network routing
- * @return          0 on success or write errors < max write errors, -1 on error
+ * @return          number of filter configurations
  */
-int mct_logstorage_write(MctLogStorage *handle,
-                         MctLogStorageUserConfig *uconfig,
-                         unsigned char *data1,
-                         int size1,
+int mct_logstorage_route(MctLogStorage *handle,
+                         MctLogStorageFilterConfig **config,
                          unsigned char *data2,
                          int size2,
-                         unsigned char *data3,
-                         int size3,
                          int *disable_nw)
 {
-    MctLogStorageFilterConfig *config[MCT_CONFIG_FILE_SECTIONS_MAX];
-
     int i = 0;
-    int ret = 0;
     int num = 0;
-    int err = 0;
+    int found = 0;
     /* data2 contains MctStandardHeader, MctStandardHeaderExtra and
      * MctExtendedHeader. We are interested in ecuid, apid, ctid and loglevel */
     MctExtendedHeader *extendedHeader = NULL;
@@ -2456,13 +3014,10 @@ int mct_logstorage_write(MctLogStorage *handle,
     MctStandardHeader *standardHeader = NULL;
     unsigned int standardHeaderExtraLen = sizeof(MctStandardHeaderExtra);
     unsigned int header_len = 0;
-    MctNewestFileName *tmp = NULL;
-    int found = 0;
 
     int log_level = -1;
 
-    if ((handle == NULL) || (uconfig == NULL) ||
-        (data1 == NULL) || (data2 == NULL) || (data3 == NULL) ||
+    if ((handle == NULL) || (config == NULL) || (data2 == NULL) ||
         (handle->connection_type != MCT_OFFLINE_LOGSTORAGE_DEVICE_CONNECTED) ||
         (handle->config_status != MCT_OFFLINE_LOGSTORAGE_CONFIG_DONE))
         return 0;
@@ -2530,7 +3085,7 @@ int mct_logstorage_write(MctLogStorage *handle,
         }
     }
 
-    /* store log message in every found filter */
+    /* keep the filters the message is stored in */
     for (i = 0; i < num; i++)
     {
         if (config[i] == NULL)
@@ -2561,7 +3116,56 @@ int mct_logstorage_write(MctLogStorage *handle,
                 mct_vlog(LOG_DEBUG, "%s: Disable routing to network for ApId-CtId-EcuId [%s]-[%s]-[%s]\n", __func__,
                          config[i]->apids, config[i]->ctids, config[i]->ecuid);
         }
+        config[found++] = config[i];
+    }
+
+    return found;
+}
 
+/**
+ * mct_logstorage_write_routed
+ *
+ * Write a message to the log files of the filter configurations obtained
+ * by mct_logstorage_route.
+ *
+ * @param handle    MctLogStorage handle
+ * @param uconfig   User configurations for log file
+ * @param config    Filter configurations obtained by mct_logstorage_route
+ * @param num       Number of filter configurations
+ * @param data1     Data buffer of message header
+ * @param size1     Size of message header buffer
+ * @param data2     Data buffer of extended message body
+ * @param size2     Size of extended message body
+ * @param data3     Data buffer of message body
+ * @param size3     Size of message body
+ * @return          0 on success or write errors < max write errors, -1 on error
+ */
+int mct_logstorage_write_routed(MctLogStorage *handle,
+                                MctLogStorageUserConfig *uconfig,
+                                MctLogStorageFilterConfig **config,
+                                int num,
+                                unsigned char *data1,
+                                int size1,
+                                unsigned char *data2,
+                                int size2,
+                                unsigned char *data3,
+                                int size3)
+{
+    int i = 0;
+    int ret = 0;
+    int err = 0;
+    MctNewestFileName *tmp = NULL;
+    int found = 0;
+
+    if ((handle == NULL) || (uconfig == NULL) || (config == NULL) ||
+        (data1 == NULL) || (data2 == NULL) || (data3 == NULL) ||
+        (handle->connection_type != MCT_OFFLINE_LOGSTORAGE_DEVICE_CONNECTED) ||
+        (handle->config_status != MCT_OFFLINE_LOGSTORAGE_CONFIG_DONE))
+        return 0;
+
+    /* store log message in every found filter */
+    for (i = 0; i < num; i++)
+    {
         if (config[i]->skip == 1)
         {
             mct_vlog(LOG_DEBUG,
@@ -2605,8 +3209,7 @@ int mct_logstorage_write(MctLogStorage *handle,
         }
 
         if ((ret == 0) &&
-            (config[i]->sync == MCT_LOGSTORAGE_SYNC_UNSET ||
-             config[i]->sync == MCT_LOGSTORAGE_SYNC_ON_MSG)) {
+            MCT_OFFLINE_LOGSTORAGE_IS_FILE_BASED(config[i]->sync)) {
             /* It is abnormal if working file is still NULL after preparation. */
             if (!config[i]->working_file_name) {
                 mct_vlog(LOG_ERR, "Failed to prepare working file for %s\n",
@@ -2645,8 +3248,7 @@ int mct_logstorage_write(MctLogStorage *handle,
                  * If both working file name and newest file name are unavailable,
                  * it means the sync to file is not performed yet, wait for next times.
                  */
-                if (config[i]->sync != MCT_LOGSTORAGE_SYNC_ON_MSG &&
-                        config[i]->sync != MCT_LOGSTORAGE_SYNC_UNSET) {
+                if (!MCT_OFFLINE_LOGSTORAGE_IS_FILE_BASED(config[i]->sync)) {
                     if (config[i]->working_file_name) {
                         if (tmp->newest_file) {
                             free(tmp->newest_file);
@@ -2697,6 +3299,49 @@ int mct_logstorage_write(MctLogStorage *handle,
     return err;
 }
 
+/**
+ * mct_logstorage_write
+ *
+ * Write a message to one or more configured log files, based on filter
+ * configuration.
+ *
+ * @param handle    MctLogStorage handle
+ * @param uconfig   User configurations for log file
+ * @param data1     Data buffer of message header
+ * @param size1     Size of message header buffer
+ * @param data2     Data buffer of extended message body
+ * @param size2     Size of extended message body
+ * @param data3     Data buffer of message body
+ * @param size3     Size of message body
+ * @param disable_nw Flag to disable network routing
+ * @return          0 on success or write errors < max write errors, -1 on error
+ */
+int mct_logstorage_write(MctLogStorage *handle,
+                         MctLogStorageUserConfig *uconfig,
+                         unsigned char *data1,
+                         int size1,
+                         unsigned char *data2,
+                         int size2,
+                         unsigned char *data3,
+                         int size3,
+                         int *disable_nw)
+{
+    MctLogStorageFilterConfig *config[MCT_CONFIG_FILE_SECTIONS_MAX];
+    int num = 0;
+
+    if ((handle == NULL) || (uconfig == NULL) ||
+        (data1 == NULL) || (data2 == NULL) || (data3 == NULL))
+        return 0;
+
+    num = mct_logstorage_route(handle, config, data2, size2, disable_nw);
+
+    if (num == 0)
+        return 0;
+
+    return mct_logstorage_write_routed(handle, uconfig, config, num,
+                                       data1, size1, data2, size2, data3, size3);
+}
+
 /**
  * mct_logstorage_sync_caches
  *
@@ -2731,3 +3376,37 @@ int mct_logstorage_sync_caches(MctLogStorage *handle)
 
     return 0;
 }
+
+/**
+ * mct_logstorage_sync_files
+ *
+ * Write data of all filters with ON_TIMER sync strategy to the device.
+ *
+ * @param handle     MctLogStorage handle
+ * @return           0 on success, -1 on error
+ */
+int mct_logstorage_sync_files(MctLogStorage *handle)
+{
+    MctLogStorageFilterList *tmp = NULL;
+
+    if ((handle == NULL) ||
+        (handle->connection_type != MCT_OFFLINE_LOGSTORAGE_DEVICE_CONNECTED) ||
+        (handle->config_status != MCT_OFFLINE_LOGSTORAGE_CONFIG_DONE))
+        return -1;
+
+    for (tmp = handle->config_list; tmp != NULL; tmp = tmp->next) {
+        if ((tmp->data == NULL) ||
+            (tmp->data->sync != MCT_LOGSTORAGE_SYNC_ON_TIMER))
+            continue;
+
+        if (tmp->data->mct_logstorage_sync(tmp->data,
+                                           &handle->uconfig,
+                                           handle->device_mount_point,
+                                           MCT_LOGSTORAGE_SYNC_ON_TIMER) != 0)
+            mct_vlog(LOG_ERR,
+                     "%s: Sync failed. Continue with next file.\n",
+                     __func__);
+    }
+
+    return 0;
+}
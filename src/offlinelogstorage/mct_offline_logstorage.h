@@ -4,6 +4,7 @@
 #include <search.h>
 #include <stdbool.h>
 #include "mct_common.h"
+#include "mct_index.h"
 #include "mct-daemon_cfg.h"
 #include "mct_config_file_parser.h"
 
@@ -19,6 +20,8 @@
 #define MCT_OFFLINE_LOGSTORAGE_SYNC_CACHES         2  /* sync logstorage caches */
 
 #define MCT_OFFLINE_LOGSTORAGE_MAX_KEY_LEN         15  /* Maximum size for key */
+#define MCT_OFFLINE_LOGSTORAGE_ROUTE_CACHE_SIZE    256 /* Entries of the routing decision cache, a power of two */
+#define MCT_OFFLINE_LOGSTORAGE_ROUTE_MAX_CONFIGS   8   /* Maximum filters of a cached routing decision */
 #define MCT_OFFLINE_LOGSTORAGE_MAX_FILE_NAME_LEN   100 /* Maximum file name length of the log file including path under mount point */
 
 #define MCT_OFFLINE_LOGSTORAGE_FILE_EXTENSION_LEN   4
@@ -59,8 +62,14 @@
 #define MCT_LOGSTORAGE_SYNC_ON_DEVICE_DISCONNECT      (1 << 3) /* sync on device disconnect*/
 #define MCT_LOGSTORAGE_SYNC_ON_SPECIFIC_SIZE          (1 << 4) /* sync on after specific size */
 #define MCT_LOGSTORAGE_SYNC_ON_FILE_SIZE              (1 << 5) /* sync on file size reached */
+#define MCT_LOGSTORAGE_SYNC_ON_TIMER                  (1 << 6) /* datasync on daemon timer or after sync size */
 
 #define MCT_OFFLINE_LOGSTORAGE_IS_STRATEGY_SET(S, s) ((S)&(s))
+/* strategies writing each message to the log file instead of a cache */
+#define MCT_OFFLINE_LOGSTORAGE_IS_FILE_BASED(S) \
+    (((S) == MCT_LOGSTORAGE_SYNC_UNSET) || \
+     ((S) == MCT_LOGSTORAGE_SYNC_ON_MSG) || \
+     ((S) == MCT_LOGSTORAGE_SYNC_ON_TIMER))
 
 /* Offline Logstorage overwrite strategies */
 #define MCT_LOGSTORAGE_OVERWRITE_ERROR         -1 /* error case */
@@ -74,10 +83,18 @@
 #define MCT_LOGSTORAGE_DISABLE_NW_OFF            1 /* default, enable network routing */
 #define MCT_LOGSTORAGE_DISABLE_NW_ON            (1 << 1) /* disable network routing */
 
+#define MCT_LOGSTORAGE_COMPRESSION_OFF           0 /* default, plain MCT messages */
+#define MCT_LOGSTORAGE_COMPRESSION_ON            1 /* compressed blocks of MCT messages */
+
+#define MCT_LOGSTORAGE_INDEX_OFF                 0 /* default, no index file */
+#define MCT_LOGSTORAGE_INDEX_ON                  1 /* index file next to each log file */
+
 /* logstorage max cache */
 extern unsigned int g_logstorage_cache_max;
 /* current logstorage cache size */
 extern unsigned int g_logstorage_cache_size;
+/* directory of files keeping the caches, empty to keep them in memory only */
+extern char g_logstorage_cache_dir[MCT_MOUNT_PATH_MAX + 1];
 
 typedef struct
 {
@@ -87,6 +104,19 @@ typedef struct
     unsigned int end_sync_offset; /* end position of previous round */
 } MctLogStorageCacheFooter;
 
+/* pattern of cache file */
+#define MCT_LOGSTORAGE_CACHE_PATTERN      { 'M', 'C', 'T', 'C' }
+#define MCT_LOGSTORAGE_CACHE_PATTERN_SIZE 4
+#define MCT_LOGSTORAGE_CACHE_FILE_SUFFIX  ".cache"
+
+/* A cache kept in a file is followed by its footer and this trailer, so a
+ * cache left by a crash can be found and written to the log files */
+typedef struct
+{
+    char pattern[MCT_LOGSTORAGE_CACHE_PATTERN_SIZE]; /* MCT_LOGSTORAGE_CACHE_PATTERN */
+    unsigned int cache_size;      /* size of cache without footer and trailer */
+} MctLogStorageCacheTrailer;
+
 typedef struct
 {
     /* File name user configurations */
@@ -158,10 +188,18 @@ struct MctLogStorageFilterConfig
                                int status);
     FILE *log;                      /* current open log file */
     void *cache;                    /* log data cache */
+    char *cache_file;               /* file mapped as cache, NULL if cache is in memory only */
     unsigned int specific_size;     /* cache size used for specific_size sync strategy */
     unsigned int current_write_file_offset;    /* file offset for specific_size sync strategy */
     MctLogStorageFileList *records; /* File name list */
     int disable_network_routing;    /* Flag to disable routing to network client */
+    int compression;                /* Flag to store compressed blocks */
+    unsigned int sync_size;         /* bytes after which ON_TIMER syncs, 0 for timer only */
+    unsigned int unsynced_size;     /* bytes written since last ON_TIMER sync */
+    int index;                      /* Flag to write an index file next to each log file */
+    FILE *index_file;               /* index file of current log file */
+    MctIndexEntry index_block;      /* messages of current log file not yet indexed */
+    MctIndexEntry index_summary;    /* summary of current log file */
 };
 
 typedef struct MctLogStorageFilterList MctLogStorageFilterList;
@@ -174,6 +212,40 @@ struct MctLogStorageFilterList
     MctLogStorageFilterList *next;    /* Pointer to next */
 };
 
+/* One key of a filter in the filter index: packed ecu, application and
+ * context id, an empty id is 0 and stands for the wildcard */
+typedef struct
+{
+    uint32_t ecuid;                   /* Packed ECU id */
+    uint32_t apid;                    /* Packed application id */
+    uint32_t ctid;                    /* Packed context id */
+    MctLogStorageFilterConfig *data;  /* Filter data, NULL if slot is empty */
+} MctLogStorageFilterSlot;
+
+/* Open addressing hash table of all keys of all filters */
+typedef struct
+{
+    MctLogStorageFilterSlot *slots;   /* Slots, NULL if not built */
+    int size;                         /* Number of slots, a power of two */
+} MctLogStorageFilterIndex;
+
+#define MCT_LOGSTORAGE_ROUTE_EMPTY      0 /* Cache entry not used */
+#define MCT_LOGSTORAGE_ROUTE_IDS        1 /* Decision for messages with application and context id */
+#define MCT_LOGSTORAGE_ROUTE_ECU        2 /* Decision for messages without extended header */
+
+/* Filters a message of one (ecu, apid, ctid) is stored by, before the log
+ * level of the message is checked */
+typedef struct
+{
+    uint32_t ecuid;                   /* Packed ECU id */
+    uint32_t apid;                    /* Packed application id */
+    uint32_t ctid;                    /* Packed context id */
+    int type;                         /* MCT_LOGSTORAGE_ROUTE_* */
+    int num;                          /* Number of filters */
+    int max_log_level;                /* Highest log level of the filters */
+    MctLogStorageFilterConfig *config[MCT_OFFLINE_LOGSTORAGE_ROUTE_MAX_CONFIGS];
+} MctLogStorageRoute;
+
 typedef enum {
     MCT_LOGSTORAGE_CONFIG_FILE = 0,   /* Use mct-logstorage.conf file from device */
 } MctLogStorageConfigMode;
@@ -181,6 +253,8 @@ typedef enum {
 typedef struct
 {
     MctLogStorageFilterList *config_list; /* List of all filters */
+    MctLogStorageFilterIndex filter_index; /* Keys of all filters by packed ids */
+    MctLogStorageRoute *route_cache;   /* Routing decisions by packed ids, NULL if not built */
     MctLogStorageUserConfig uconfig;   /* User configurations for file name*/
     int num_configs;                   /* Number of configs */
     char device_mount_point[MCT_MOUNT_PATH_MAX + 1]; /* Device mount path */
@@ -227,6 +301,9 @@ typedef enum {
     MCT_LOGSTORAGE_FILTER_CONF_ECUID,
     MCT_LOGSTORAGE_FILTER_CONF_SPECIFIC_SIZE,
     MCT_LOGSTORAGE_FILTER_CONF_DISABLE_NETWORK,
+    MCT_LOGSTORAGE_FILTER_CONF_COMPRESSION,
+    MCT_LOGSTORAGE_FILTER_CONF_SYNC_SIZE,
+    MCT_LOGSTORAGE_FILTER_CONF_INDEX,
     MCT_LOGSTORAGE_FILTER_CONF_COUNT
 } MctLogstorageFilterConfType;
 
@@ -314,6 +391,54 @@ int mct_logstorage_write(MctLogStorage *handle,
                          int size3,
                          int *disable_nw);
 
+/**
+ * mct_logstorage_route
+ *
+ * Obtain the filter configurations a message is to be stored in. Only the
+ * filter configurations are read, the log files are not touched.
+ *
+ * @param handle    MctLogStorage handle
+ * @param config    [out] Filter configurations with a log file
+ * @param data2     Data buffer of extended message body
+ * @param size2     Size of extended message body
+ * @param disable_nw Flag to disable network routing
+ * @return          number of filter configurations
+ */
+int mct_logstorage_route(MctLogStorage *handle,
+                         MctLogStorageFilterConfig **config,
+                         unsigned char *data2,
+                         int size2,
+                         int *disable_nw);
+
+/**
+ * mct_logstorage_write_routed
+ *
+ * Write a message to the log files of the filter configurations obtained
+ * by mct_logstorage_route.
+ *
+ * @param handle    MctLogStorage handle
+ * @param uconfig   User configurations for log file
+ * @param config    Filter configurations obtained by mct_logstorage_route
+ * @param num       Number of filter configurations
+ * @param data1     Data buffer of message header
+ * @param size1     Size of message header buffer
+ * @param data2     Data buffer of extended message body
+ * @param size2     Size of extended message body
+ * @param data3     Data buffer of message body
+ * @param size3     Size of message body
+ * @return          0 on success or write errors < max write errors, -1 on error
+ */
+int mct_logstorage_write_routed(MctLogStorage *handle,
+                                MctLogStorageUserConfig *uconfig,
+                                MctLogStorageFilterConfig **config,
+                                int num,
+                                unsigned char *data1,
+                                int size1,
+                                unsigned char *data2,
+                                int size2,
+                                unsigned char *data3,
+                                int size3);
+
 /**
  * mct_logstorage_sync_caches
  *
@@ -324,4 +449,15 @@ int mct_logstorage_write(MctLogStorage *handle,
  */
 int mct_logstorage_sync_caches(MctLogStorage *handle);
 
+/**
+ * mct_logstorage_sync_files
+ *
+ * Write data of all filters with ON_TIMER sync strategy to the device.
+ * Called periodically by the daemon.
+ *
+ * @param  handle    MctLogStorage handle
+ * @return 0 on success, -1 otherwise
+ */
+int mct_logstorage_sync_files(MctLogStorage *handle);
+
 #endif /* MCT_OFFLINE_LOGSTORAGE_H */
@@ -4,6 +4,8 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -12,8 +14,14 @@
 #include "mct_offline_logstorage.h"
 #include "mct_offline_logstorage_behavior.h"
 #include "mct_offline_logstorage_behavior_internal.h"
+#include "mct_pattern.h"
+#include "mct_compress.h"
 
 unsigned int g_logstorage_cache_size;
+
+static const char mct_logstorage_cache_pattern[MCT_LOGSTORAGE_CACHE_PATTERN_SIZE] =
+    MCT_LOGSTORAGE_CACHE_PATTERN;
+
 /**
  * mct_logstorage_log_file_name
  *
@@ -260,6 +268,23 @@ unsigned int mct_logstorage_get_idx_of_log_file(MctLogStorageUserConfig *file_co
     return idx;
 }
 
+/**
+ * mct_logstorage_is_index_file
+ *
+ * Check if a file name is the name of an index file.
+ *
+ * @param name          File name
+ * @return              1 if it is an index file, 0 otherwise
+ */
+static int mct_logstorage_is_index_file(const char *name)
+{
+    size_t len = strlen(name);
+    size_t suffix_len = strlen(MCT_INDEX_FILE_SUFFIX);
+
+    return (len > suffix_len) &&
+           (strcmp(name + len - suffix_len, MCT_INDEX_FILE_SUFFIX) == 0);
+}
+
 /**
  * mct_logstorage_storage_dir_info
  *
@@ -350,6 +375,11 @@ int mct_logstorage_storage_dir_info(MctLogStorageUserConfig *file_config,
         mct_vlog(LOG_DEBUG,
                  "%s: Scanned file name=[%s], filter file name=[%s]\n",
                   __func__, files[i]->d_name, file_name);
+
+        /* index files are kept next to their log files */
+        if (mct_logstorage_is_index_file(files[i]->d_name))
+            continue;
+
         if (strncmp(files[i]->d_name, file_name, len) == 0) {
             if (config->num_files == 1 && file_config->logfile_optional_counter) {
                 /* <filename>.mct or <filename>_<tmsp>.mct */
@@ -438,6 +468,214 @@ int mct_logstorage_storage_dir_info(MctLogStorageUserConfig *file_config,
     return ret;
 }
 
+/**
+ * mct_logstorage_remove_file_record
+ *
+ * Remove a file from the file list after it was deleted from the device.
+ *
+ * @param config        MctLogStorageFilterConfig
+ * @param name          Name of deleted file
+ */
+static void mct_logstorage_remove_file_record(MctLogStorageFilterConfig *config,
+                                              const char *name)
+{
+    MctLogStorageFileList **tmp = &config->records;
+    MctLogStorageFileList *n = NULL;
+
+    while (*tmp != NULL) {
+        if (strcmp((*tmp)->name, name) == 0) {
+            n = *tmp;
+            *tmp = n->next;
+            free(n->name);
+            free(n);
+            return;
+        }
+
+        tmp = &(*tmp)->next;
+    }
+}
+
+/**
+ * mct_logstorage_preallocate
+ *
+ * Reserve the configured file size on the device for a log file written
+ * with ON_TIMER sync strategy. The file size itself is kept, so readers
+ * never see unwritten space. Failures are ignored as not every file system
+ * supports this.
+ *
+ * @param config        MctLogStorageFilterConfig
+ */
+static void mct_logstorage_preallocate(MctLogStorageFilterConfig *config)
+{
+    if ((config->log == NULL) || (config->file_size == 0))
+        return;
+
+    if (fallocate(fileno(config->log), FALLOC_FL_KEEP_SIZE, 0,
+                  (off_t)config->file_size) != 0)
+        mct_vlog(LOG_DEBUG, "%s: fallocate failed for [%s]: %s\n",
+                 __func__, config->file_name, strerror(errno));
+}
+
+/**
+ * mct_logstorage_remove_log_file
+ *
+ * Remove a log file from the device together with its index file.
+ *
+ * @param path          Absolute path of log file
+ */
+static void mct_logstorage_remove_log_file(const char *path)
+{
+    char index_path[MCT_OFFLINE_LOGSTORAGE_MAX_PATH_LEN + sizeof(MCT_INDEX_FILE_SUFFIX)];
+
+    remove(path);
+
+    snprintf(index_path, sizeof(index_path), "%s%s", path, MCT_INDEX_FILE_SUFFIX);
+    remove(index_path);
+}
+
+/**
+ * mct_logstorage_flush_index
+ *
+ * Append the pending block to the index file and start the next one.
+ *
+ * @param config        MctLogStorageFilterConfig
+ */
+static void mct_logstorage_flush_index(MctLogStorageFilterConfig *config)
+{
+    MctIndexEntry *block = &config->index_block;
+
+    if ((config->index_file == NULL) || (block->size == 0))
+        return;
+
+    if (mct_index_entry_write(block, config->index_file) != 0)
+        mct_vlog(LOG_WARNING, "%s: failed to write index of [%s]\n",
+                 __func__, config->working_file_name);
+
+    mct_index_entry_merge(&config->index_summary, block);
+    mct_index_entry_init(block, block->offset + block->size, 0);
+}
+
+/**
+ * mct_logstorage_index_messages
+ *
+ * Add messages written to the log file to its index. Uncompressed messages
+ * are indexed in blocks of MCT_INDEX_BLOCK_SIZE, a compressed block is
+ * indexed as one block.
+ *
+ * @param config        MctLogStorageFilterConfig
+ * @param data          Messages with storage header
+ * @param count         Size of messages
+ * @param stored        Size of compressed block in log file, 0 if not compressed
+ */
+static void mct_logstorage_index_messages(MctLogStorageFilterConfig *config,
+                                          const uint8_t *data,
+                                          unsigned int count,
+                                          unsigned int stored)
+{
+    const MctStandardHeader *standardheader = NULL;
+    MctIndexEntry *block = &config->index_block;
+    unsigned int offset = 0;
+    unsigned int len = 0;
+
+    if (config->index_file == NULL)
+        return;
+
+    while (offset < count) {
+        len = count - offset;
+
+        if (len >= sizeof(MctStorageHeader) + sizeof(MctStandardHeader)) {
+            standardheader = (const MctStandardHeader *)(data + offset +
+                                                         sizeof(MctStorageHeader));
+
+            if ((sizeof(MctStorageHeader) + MCT_BETOH_16(standardheader->len) <= len) &&
+                (MCT_BETOH_16(standardheader->len) >= sizeof(MctStandardHeader)))
+                len = sizeof(MctStorageHeader) + MCT_BETOH_16(standardheader->len);
+
+            mct_index_entry_add(block,
+                                (const MctStorageHeader *)(data + offset),
+                                (const uint8_t *)standardheader,
+                                (int)(len - sizeof(MctStorageHeader)));
+        }
+
+        offset += len;
+
+        if (stored == 0) {
+            block->size += len;
+            block->raw_size += len;
+
+            if (block->size >= MCT_INDEX_BLOCK_SIZE)
+                mct_logstorage_flush_index(config);
+        }
+    }
+
+    if (stored != 0) {
+        block->size = stored;
+        block->raw_size = count;
+        mct_logstorage_flush_index(config);
+    }
+}
+
+/**
+ * mct_logstorage_open_index
+ *
+ * Open the index file of the log file just opened. A new log file starts a
+ * new index file, the index file of an existing log file is continued.
+ *
+ * @param config        MctLogStorageFilterConfig
+ * @param path          Absolute path of log file
+ */
+static void mct_logstorage_open_index(MctLogStorageFilterConfig *config,
+                                      const char *path)
+{
+    char index_path[MCT_OFFLINE_LOGSTORAGE_MAX_PATH_LEN + sizeof(MCT_INDEX_FILE_SUFFIX)];
+    MctIndexEntry summary;
+    struct stat s;
+
+    if ((config->index != MCT_LOGSTORAGE_INDEX_ON) || (config->log == NULL))
+        return;
+
+    mct_logstorage_close_index(config);
+
+    if (fstat(fileno(config->log), &s) != 0)
+        return;
+
+    mct_index_entry_init(&config->index_block, (uint32_t)s.st_size, 0);
+    mct_index_entry_init(&config->index_summary, 0, MCT_INDEX_FLAG_SUMMARY);
+
+    snprintf(index_path, sizeof(index_path), "%s%s", path, MCT_INDEX_FILE_SUFFIX);
+    config->index_file = fopen(index_path, (s.st_size == 0) ? "w" : "a+");
+
+    if (config->index_file == NULL) {
+        mct_vlog(LOG_WARNING, "%s: failed to open index file [%s]\n",
+                 __func__, index_path);
+        return;
+    }
+
+    /* the summary written when the log file was closed goes on, unless
+     * messages were written without being indexed */
+    if ((s.st_size != 0) &&
+        (fseek(config->index_file, -(long)sizeof(summary), SEEK_END) == 0) &&
+        (mct_index_entry_read(&summary, config->index_file) == 0) &&
+        (summary.flags & MCT_INDEX_FLAG_SUMMARY) &&
+        (summary.size == (uint32_t)s.st_size))
+        config->index_summary = summary;
+}
+
+void mct_logstorage_close_index(MctLogStorageFilterConfig *config)
+{
+    if ((config == NULL) || (config->index_file == NULL))
+        return;
+
+    mct_logstorage_flush_index(config);
+
+    if (mct_index_entry_write(&config->index_summary, config->index_file) != 0)
+        mct_vlog(LOG_WARNING, "%s: failed to write index of [%s]\n",
+                 __func__, config->working_file_name);
+
+    fclose(config->index_file);
+    config->index_file = NULL;
+}
+
 /**
  * mct_logstorage_open_log_file
  *
@@ -446,6 +684,12 @@ int mct_logstorage_storage_dir_info(MctLogStorageUserConfig *file_config,
  * Otherwise create a new file, but take configured max number of files into
  * account and remove the oldest file if needed.
  *
+ * The file list is read from the storage directory once and then kept up to
+ * date as files are created and removed. The directory is only scanned again
+ * if the list does not match the working file, e.g. because another filter
+ * with the same file name switched to a newer file, or if the newest file
+ * was removed from the device.
+ *
  * @param  config    MctLogStorageFilterConfig
  * @param  file_config   User configurations for log file
  * @param  dev_path      Storage device path
@@ -465,6 +709,7 @@ int mct_logstorage_open_log_file(MctLogStorageFilterConfig *config,
     char storage_path[MCT_MOUNT_PATH_MAX + 1] = { '\0' };
     char file_name[MCT_OFFLINE_LOGSTORAGE_MAX_LOG_FILE_LEN + 1] = { '\0' };
     unsigned int num_log_files = 0;
+    bool scanned = false;
     struct stat s;
     memset(&s, 0, sizeof(struct stat));
     MctLogStorageFileList **tmp = NULL;
@@ -484,20 +729,55 @@ int mct_logstorage_open_log_file(MctLogStorageFilterConfig *config,
     if (config->records == NULL || is_update_required) {
         if (mct_logstorage_storage_dir_info(file_config, storage_path, config) != 0)
             return -1;
+
+        scanned = true;
     }
 
-    /* obtain locations of newest, current file names, file count */
-    tmp = &config->records;
+    for (;;) {
+        /* obtain locations of newest, current file names, file count */
+        num_log_files = 0;
+        newest = NULL;
+        tmp = &config->records;
 
-    while (*(tmp) != NULL) {
-        num_log_files += 1;
+        while (*(tmp) != NULL) {
+            num_log_files += 1;
 
-        if ((*tmp)->next == NULL)
-            newest = tmp;
+            if ((*tmp)->next == NULL)
+                newest = tmp;
 
-        tmp = &(*tmp)->next;
+            tmp = &(*tmp)->next;
+        }
+
+        if (scanned)
+            break;
+
+        /* the list is stale if the working file is not the newest one or
+         * the newest file has gone */
+        if (newest != NULL) {
+            memset(absolute_file_path, 0, sizeof(absolute_file_path));
+            strcat(absolute_file_path, storage_path);
+            strcat(absolute_file_path, (*newest)->name);
+        }
+
+        if ((newest == NULL) ||
+            ((config->working_file_name != NULL) &&
+             (strcmp(config->working_file_name, (*newest)->name) != 0)) ||
+            (stat(absolute_file_path, &s) != 0)) {
+            mct_vlog(LOG_DEBUG, "%s: File list of [%s] is outdated\n",
+                     __func__, config->file_name);
+
+            if (mct_logstorage_storage_dir_info(file_config, storage_path, config) != 0)
+                return -1;
+
+            scanned = true;
+            continue;
+        }
+
+        break;
     }
 
+    memset(absolute_file_path, 0, sizeof(absolute_file_path));
+
     /* need new file*/
     if (num_log_files == 0) {
         mct_logstorage_log_file_name(file_name,
@@ -615,8 +895,17 @@ int mct_logstorage_open_log_file(MctLogStorageFilterConfig *config,
              * remove it and reopen it.
              * In this case number of log file won't be increased*/
             if (config->wrap_id && stat(absolute_file_path, &s) == 0) {
-                remove(absolute_file_path);
+                mct_logstorage_remove_log_file(absolute_file_path);
+                mct_logstorage_remove_file_record(config, file_name);
                 num_log_files -= 1;
+
+                /* the removed record may have been the newest one, find
+                 * the end of the list again */
+                tmp = &config->records;
+
+                while (*tmp != NULL)
+                    tmp = &(*tmp)->next;
+
                 mct_vlog(LOG_DEBUG,
                          "%s: Remove '%s' (num_log_files: %u, config->num_files:%u)\n",
                          __func__, absolute_file_path, num_log_files, config->num_files);
@@ -657,7 +946,7 @@ int mct_logstorage_open_log_file(MctLogStorageFilterConfig *config,
                              "%s: Remove '%s' (num_log_files: %d, config->num_files:%d, file_name:%s)\n",
                              __func__, absolute_file_path, num_log_files,
                              config->num_files, config->file_name);
-                    remove(absolute_file_path);
+                    mct_logstorage_remove_log_file(absolute_file_path);
 
                     free((*head)->name);
                     (*head)->name = NULL;
@@ -670,6 +959,11 @@ int mct_logstorage_open_log_file(MctLogStorageFilterConfig *config,
         }
     }
 
+    config->unsynced_size = 0;
+
+    if (config->sync == MCT_LOGSTORAGE_SYNC_ON_TIMER)
+        mct_logstorage_preallocate(config);
+
     if (config->log == NULL) {
         if (*tmp != NULL) {
             if ((*tmp)->name != NULL) {
@@ -689,6 +983,11 @@ int mct_logstorage_open_log_file(MctLogStorageFilterConfig *config,
         return -1;
     }
 
+    memset(absolute_file_path, 0, sizeof(absolute_file_path));
+    strcat(absolute_file_path, storage_path);
+    strcat(absolute_file_path, config->working_file_name);
+    mct_logstorage_open_index(config, absolute_file_path);
+
     return ret;
 }
 
@@ -709,13 +1008,7 @@ static int mct_logstorage_find_mct_header(void *ptr,
     const char magic[] = { 'D', 'L', 'T', 0x01 };
     const char *cache = (char*)ptr + offset;
 
-    unsigned int i;
-    for (i = 0; i < cnt; i++) {
-        if ((cache[i] == 'D') && (strncmp(&cache[i], magic, 4) == 0))
-           return i;
-    }
-
-    return -1;
+    return mct_pattern_find(cache, cnt, magic, sizeof(magic));
 }
 
 /**
@@ -734,52 +1027,180 @@ static int mct_logstorage_find_last_mct_header(void *ptr,
 {
     const char magic[] = {'D', 'L', 'T', 0x01};
     const char *cache = (char*)ptr + offset;
-
     int i;
-    for (i = cnt - (MCT_ID_SIZE - 1) ; i > 0; i--) {
-        if ((cache[i] == 'D') && (strncmp(&cache[i], magic, 4) == 0))
-            return i;
+
+    /* a header at the very beginning is not considered */
+    if (cnt < 1)
+        return -1;
+
+    i = mct_pattern_find_last(cache + 1, cnt - 1, magic, sizeof(magic));
+
+    return (i < 0) ? -1 : (i + 1);
+}
+
+/**
+ * mct_logstorage_write_fd
+ *
+ * Write a buffer completely to a file descriptor.
+ *
+ * @param fd          file descriptor
+ * @param data        buffer
+ * @param count       size of buffer
+ * @return 0 on success, -1 on error
+ */
+static int mct_logstorage_write_fd(int fd, const uint8_t *data, unsigned int count)
+{
+    ssize_t ret = 0;
+    unsigned int done = 0;
+
+    while (done < count) {
+        ret = write(fd, data + done, count - done);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            return -1;
+        }
+
+        done += (unsigned int)ret;
     }
 
-    return -1;
+    return 0;
 }
 
 /**
- * mct_logstorage_check_write_ret
+ * mct_logstorage_write_blocks
  *
- * check the return value of fwrite
+ * Write complete messages as compressed blocks to a file descriptor.
  *
  * @param config      MctLogStorageFilterConfig
- * @param ret         return value of fwrite call
+ * @param fd          file descriptor
+ * @param data        messages
+ * @param count       size of messages
+ * @return size written on success, -1 on error
  */
-static void mct_logstorage_check_write_ret(MctLogStorageFilterConfig *config,
-                                               int ret)
+static int mct_logstorage_write_blocks(MctLogStorageFilterConfig *config,
+                                       int fd,
+                                       const uint8_t *data,
+                                       unsigned int count)
 {
-    if (config == NULL)
+    uint8_t *block = NULL;
+    unsigned int done = 0;
+    int written = 0;
+    int size = 0;
+    int len = 0;
+
+    block = malloc(sizeof(MctBlockHeader) + (size_t)mct_compress_bound((int)MCT_BLOCK_SIZE_MAX));
+
+    if (block == NULL)
+        return -1;
+
+    while (done < count) {
+        size = mct_block_split(data + done, (int)(count - done));
+        len = mct_block_encode(data + done, size, block);
+
+        if (mct_logstorage_write_fd(fd, block, (unsigned int)len) != 0) {
+            free(block);
+            return -1;
+        }
+
+        mct_logstorage_index_messages(config, data + done, (unsigned int)size,
+                                      (unsigned int)len);
+
+        done += (unsigned int)size;
+        written += len;
+    }
+
+    free(block);
+
+    return written;
+}
+
+/**
+ * mct_logstorage_write_cache
+ *
+ * Write a span of the cache to the log file with as few system calls as
+ * possible, bypassing the stdio buffer of the log file, and sync it.
+ * The span is compressed if configured for the filter. A span that could
+ * be written counts as written even if syncing it fails.
+ *
+ * @param config      MctLogStorageFilterConfig
+ * @param data        start of span in cache
+ * @param count       size of span
+ * @return 0 on success, -1 if the span was not written
+ */
+static int mct_logstorage_write_cache(MctLogStorageFilterConfig *config,
+                                      uint8_t *data,
+                                      unsigned int count)
+{
+    int written = (int)count;
+    int fd = -1;
+    struct stat s;
+
+    if ((config == NULL) || (config->log == NULL)) {
         mct_vlog(LOG_ERR, "%s: cannot retrieve config information\n", __func__);
+        return -1;
+    }
+
+    fd = fileno(config->log);
 
-    if (ret <= 0) {
-        if (ferror(config->log) != 0)
-            mct_vlog(LOG_ERR, "%s: failed to write cache into log file\n", __func__);
+    if (fstat(fd, &s) != 0)
+        s.st_size = -1;
+
+    if (config->compression == MCT_LOGSTORAGE_COMPRESSION_ON)
+        written = mct_logstorage_write_blocks(config, fd, data, count);
+    else if (mct_logstorage_write_fd(fd, data, count) != 0)
+        written = -1;
+    else
+        mct_logstorage_index_messages(config, data, count, 0);
+
+    if (written < 0) {
+        mct_vlog(LOG_ERR, "%s: failed to write cache into log file\n", __func__);
+
+        /* drop a partly written span, it is written again on the next sync */
+        if ((s.st_size >= 0) && (ftruncate(fd, s.st_size) != 0))
+            mct_vlog(LOG_WARNING, "%s: cannot remove partly written data\n", __func__);
+
+        return -1;
     }
-    else {
-        /* force sync */
-        if (fflush(config->log) != 0)
-            mct_vlog(LOG_ERR, "%s: failed to flush log file\n", __func__);
 
-        if (fsync(fileno(config->log)) != 0)
-            /* some filesystem doesn't support fsync() */
-            if (errno != ENOSYS)
-            {
-                mct_vlog(LOG_ERR, "%s: failed to sync log file\n", __func__);
-            }
+    config->current_write_file_offset += (unsigned int)written;
+
+    /* the span is in the log file and indexed already, so a failed sync is
+     * only reported; failing here would write the span again on the next sync.
+     * some filesystem doesn't support fsync() */
+    if ((fsync(fd) != 0) && (errno != ENOSYS) && (errno != EINVAL))
+        mct_vlog(LOG_ERR, "%s: failed to sync log file\n", __func__);
+
+    return 0;
+}
+
+/**
+ * mct_logstorage_close_log_file
+ *
+ * Close the log file of a filter, e.g. on rotation.
+ *
+ * @param config      MctLogStorageFilterConfig
+ */
+static void mct_logstorage_close_log_file(MctLogStorageFilterConfig *config)
+{
+    mct_logstorage_close_index(config);
+
+    if (config->log != NULL) {
+        fclose(config->log);
+        config->log = NULL;
     }
+
+    config->current_write_file_offset = 0;
 }
 
 /**
  * mct_logstorage_sync_to_file
  *
- * Write the log message to log file
+ * Write the log message to log file. The log file stays open between
+ * syncs and is only reopened when it is full or another filter with the
+ * same file name switched to a newer file.
  *
  * @param config        MctLogStorageFilterConfig
  * @param file_config   MctLogStorageUserConfig
@@ -796,11 +1217,11 @@ static int mct_logstorage_sync_to_file(MctLogStorageFilterConfig *config,
                                            unsigned int start_offset,
                                            unsigned int end_offset)
 {
-    int ret = 0;
     int start_index = 0;
     int end_index = 0;
     int count = 0;
     int remain_file_size = 0;
+    struct stat s;
 
     if ((config == NULL) || (file_config == NULL) || (dev_path == NULL) ||
         (footer == NULL))
@@ -811,23 +1232,26 @@ static int mct_logstorage_sync_to_file(MctLogStorageFilterConfig *config,
 
     count = end_offset - start_offset;
 
-    /* In case of cached-based strategy, the newest file information
-     * must be updated everytime of synchronization.
-     */
-    if (config->log) {
-        fclose(config->log);
-        config->log = NULL;
-        config->current_write_file_offset = 0;
+    /* Other filters may append to the same file, so take the size from
+     * the file itself. A full file is closed and the next one opened. */
+    if (config->log != NULL) {
+        if ((fstat(fileno(config->log), &s) == 0) &&
+            (s.st_size < (off_t)config->file_size))
+            config->current_write_file_offset = (unsigned int)s.st_size;
+        else
+            mct_logstorage_close_log_file(config);
     }
 
-    if (mct_logstorage_open_log_file(config, file_config,
-            dev_path, count, true, true) != 0) {
-        mct_vlog(LOG_ERR, "%s: failed to open log file\n", __func__);
-        return -1;
-    }
+    if (config->log == NULL) {
+        if (mct_logstorage_open_log_file(config, file_config,
+                dev_path, count, false, true) != 0) {
+            mct_vlog(LOG_ERR, "%s: failed to open log file\n", __func__);
+            return -1;
+        }
 
-    if (config->skip == 1) {
-        return 0;
+        if (config->skip == 1) {
+            return 0;
+        }
     }
 
     remain_file_size = config->file_size - config->current_write_file_offset;
@@ -845,24 +1269,18 @@ static int mct_logstorage_sync_to_file(MctLogStorageFilterConfig *config,
         if ((start_index >= 0) && (end_index > start_index) &&
             (count > 0) && (count <= remain_file_size))
         {
-            ret = fwrite((uint8_t*)config->cache + start_offset + start_index,
-                        count, 1, config->log);
-            mct_logstorage_check_write_ret(config, ret);
-
-            /* Close log file */
-            fclose(config->log);
-            config->log = NULL;
-            config->current_write_file_offset = 0;
+            /* data not written stays in the cache */
+            if (mct_logstorage_write_cache(config,
+                                           (uint8_t*)config->cache + start_offset + start_index,
+                                           count) != 0)
+                return -1;
 
             footer->last_sync_offset = start_offset + count;
             start_offset = footer->last_sync_offset;
         }
-        else
-        {
-            fclose(config->log);
-            config->log = NULL;
-            config->current_write_file_offset = 0;
-        }
+
+        /* Rotate log file */
+        mct_logstorage_close_log_file(config);
     }
 
     start_index = mct_logstorage_find_mct_header(config->cache, start_offset, count);
@@ -874,7 +1292,7 @@ static int mct_logstorage_sync_to_file(MctLogStorageFilterConfig *config,
         if (config->log == NULL)
         {
             if (mct_logstorage_open_log_file(config, file_config, dev_path,
-                                             count, true, false) != 0)
+                                             count, false, false) != 0)
             {
                 mct_vlog(LOG_ERR, "%s: failed to open log file\n", __func__);
                 return -1;
@@ -886,11 +1304,11 @@ static int mct_logstorage_sync_to_file(MctLogStorageFilterConfig *config,
             }
         }
 
-        ret = fwrite((uint8_t*)config->cache + start_offset + start_index, count, 1,
-                     config->log);
-        mct_logstorage_check_write_ret(config, ret);
+        if (mct_logstorage_write_cache(config,
+                                       (uint8_t*)config->cache + start_offset + start_index,
+                                       count) != 0)
+            return -1;
 
-        config->current_write_file_offset += count;
         footer->last_sync_offset = end_offset;
     }
 
@@ -899,6 +1317,35 @@ static int mct_logstorage_sync_to_file(MctLogStorageFilterConfig *config,
     return 0;
 }
 
+/**
+ * mct_logstorage_datasync
+ *
+ * Flush buffered data of the log file and write it to the device.
+ *
+ * @param config        MctLogStorageFilterConfig
+ * @return 0 on success, -1 on error
+ */
+static int mct_logstorage_datasync(MctLogStorageFilterConfig *config)
+{
+    if (config->log == NULL)
+        return 0;
+
+    config->unsynced_size = 0;
+
+    if (fflush(config->log) != 0) {
+        mct_log(LOG_ERR, "fflush failed\n");
+        return -1;
+    }
+
+    if ((fdatasync(fileno(config->log)) != 0) && (errno != EINVAL) &&
+        (errno != ENOSYS)) {
+        mct_vlog(LOG_ERR, "%s: failed to sync log file\n", __func__);
+        return -1;
+    }
+
+    return 0;
+}
+
 /**
  * mct_logstorage_prepare_on_msg
  *
@@ -944,12 +1391,20 @@ int mct_logstorage_prepare_on_msg(MctLogStorageFilterConfig *config,
                                            file_config,
                                            dev_path,
                                            log_msg_size,
-                                           true,
+                                           false,
                                            false);
     }
     else { /* already open, check size and create a new file if needed */
         ret = fstat(fileno(config->log), &s);
 
+        /* ON_TIMER keeps messages buffered, the file position includes them */
+        if ((ret == 0) && (config->sync == MCT_LOGSTORAGE_SYNC_ON_TIMER)) {
+            s.st_size = ftell(config->log);
+
+            if (s.st_size < 0)
+                ret = -1;
+        }
+
         if (ret == 0) {
             /* check if adding new data do not exceed max file size */
             /* Check if wrap id needs to be updated*/
@@ -966,7 +1421,11 @@ int mct_logstorage_prepare_on_msg(MctLogStorageFilterConfig *config,
                         }
                     }
                 }
+                else if (config->sync == MCT_LOGSTORAGE_SYNC_ON_TIMER) {
+                    mct_logstorage_datasync(config);
+                }
 
+                mct_logstorage_close_index(config);
                 fclose(config->log);
                 config->log = NULL;
 
@@ -984,7 +1443,7 @@ int mct_logstorage_prepare_on_msg(MctLogStorageFilterConfig *config,
                                                    file_config,
                                                    dev_path,
                                                    log_msg_size,
-                                                   true,
+                                                   false,
                                                    false);
             }
             else { /*everything is prepared */
@@ -1049,6 +1508,18 @@ int mct_logstorage_write_on_msg(MctLogStorageFilterConfig *config,
     if (ret != size3)
         mct_log(LOG_WARNING, "Wrote less data than specified\n");
 
+    config->unsynced_size += (unsigned int)(size1 + size2 + size3);
+
+    if ((config->index_file != NULL) && (size1 == (int)sizeof(MctStorageHeader))) {
+        mct_index_entry_add(&config->index_block, (MctStorageHeader *)data1,
+                            data2, size2);
+        config->index_block.size += (unsigned int)(size1 + size2 + size3);
+        config->index_block.raw_size += (unsigned int)(size1 + size2 + size3);
+
+        if (config->index_block.size >= MCT_INDEX_BLOCK_SIZE)
+            mct_logstorage_flush_index(config);
+    }
+
     return ferror(config->log);
 }
 
@@ -1087,6 +1558,377 @@ int mct_logstorage_sync_on_msg(MctLogStorageFilterConfig *config,
     return 0;
 }
 
+/**
+ * mct_logstorage_sync_on_timer
+ *
+ * Sync data to disk if sync size is reached on message, on daemon timer
+ * and on demand, device disconnect or daemon exit. Messages are only
+ * buffered in between, so no system call is done per message.
+ *
+ * @param config        MctLogStorageFilterConfig
+ * @param file_config   User configurations for log file
+ * @param dev_path      Storage device path
+ * @param status        Strategy flag
+ * @return 0 on success, -1 on error
+ */
+int mct_logstorage_sync_on_timer(MctLogStorageFilterConfig *config,
+                                 MctLogStorageUserConfig *file_config,
+                                 char *dev_path,
+                                 int status)
+{
+    (void)file_config;  /* satisfy compiler */
+    (void)dev_path;
+
+    if (config == NULL)
+        return -1;
+
+    if ((config->log == NULL) || (config->unsynced_size == 0))
+        return 0;
+
+    if ((status == MCT_LOGSTORAGE_SYNC_ON_MSG) &&
+        ((config->sync_size == 0) || (config->unsynced_size < config->sync_size)))
+        return 0;
+
+    return mct_logstorage_datasync(config);
+}
+
+/**
+ * mct_logstorage_cache_size
+ *
+ * Get the size of the cache of a filter without footer.
+ *
+ * @param config        MctLogStorageFilterConfig
+ * @return size of cache
+ */
+static unsigned int mct_logstorage_cache_size(MctLogStorageFilterConfig *config)
+{
+    if (MCT_OFFLINE_LOGSTORAGE_IS_STRATEGY_SET(config->sync,
+                                               MCT_LOGSTORAGE_SYNC_ON_SPECIFIC_SIZE) > 0)
+        return config->specific_size;
+
+    return config->file_size;
+}
+
+/**
+ * mct_logstorage_sync_cache
+ *
+ * Write the data of a cache not yet synced to the log files.
+ *
+ * @param config        MctLogStorageFilterConfig
+ * @param file_config   User configurations for log file
+ * @param dev_path      Storage device path
+ * @param footer        Footer of the cache
+ * @return 0 on success, -1 on error
+ */
+static int mct_logstorage_sync_cache(MctLogStorageFilterConfig *config,
+                                     MctLogStorageUserConfig *file_config,
+                                     char *dev_path,
+                                     MctLogStorageCacheFooter *footer)
+{
+    /* the footer is left as is from the first failed write on, so the
+     * data not written is synced again next time */
+    if (footer->wrap_around_cnt < 1)
+    {
+        /* Sync whole cache */
+        return mct_logstorage_sync_to_file(config, file_config, dev_path, footer,
+                                           footer->last_sync_offset, footer->offset);
+    }
+
+    if ((footer->wrap_around_cnt == 1) &&
+        (footer->offset < footer->last_sync_offset))
+    {
+        /* sync (1) footer->last_sync_offset to footer->end_sync_offset,
+         * and (2) footer->last_sync_offset (= 0) to footer->offset */
+        if (mct_logstorage_sync_to_file(config, file_config, dev_path, footer,
+                                        footer->last_sync_offset, footer->end_sync_offset) != 0)
+            return -1;
+    }
+    else
+    {
+        /* sync (1) footer->offset + index to footer->end_sync_offset,
+         * and (2) footer->last_sync_offset (= 0) to footer->offset */
+        if (mct_logstorage_sync_to_file(config, file_config, dev_path, footer,
+                                        footer->offset, footer->end_sync_offset) != 0)
+            return -1;
+    }
+
+    footer->last_sync_offset = 0;
+
+    return mct_logstorage_sync_to_file(config, file_config, dev_path, footer,
+                                       footer->last_sync_offset, footer->offset);
+}
+
+/**
+ * mct_logstorage_cache_file_name
+ *
+ * Get the path of the file keeping the cache of a filter. It stays the same
+ * across restarts of the daemon, so a cache left by a crash is found again.
+ *
+ * @param config        MctLogStorageFilterConfig
+ * @param dev_path      Storage device path
+ * @param path          Buffer for path of cache file
+ * @param size          Size of buffer
+ * @return 0 on success, -1 if caches are not kept in files
+ */
+static int mct_logstorage_cache_file_name(MctLogStorageFilterConfig *config,
+                                          char *dev_path,
+                                          char *path,
+                                          size_t size)
+{
+    const char *ids[] = { dev_path, config->file_name, config->apids,
+                          config->ctids, config->ecuid };
+    char name[MCT_OFFLINE_LOGSTORAGE_MAX_FILE_NAME_LEN + 1] = { '\0' };
+    uint32_t hash = 2166136261U;
+    unsigned int i;
+    const char *c;
+    int len;
+    int absolute = (g_logstorage_cache_dir[0] == '/');
+
+    if ((g_logstorage_cache_dir[0] == '\0') || (config->file_name == NULL))
+        return -1;
+
+    /* the mount point of a device may change, it only tells the caches of
+     * different devices in a shared directory apart */
+    for (i = absolute ? 0 : 1; i < sizeof(ids) / sizeof(ids[0]); i++) {
+        c = (ids[i] != NULL) ? ids[i] : "";
+
+        do {
+            hash ^= (uint8_t)*c;
+            hash *= 16777619U;
+        } while (*c++ != '\0');
+    }
+
+    strncpy(name, config->file_name, sizeof(name) - 1);
+
+    for (i = 0; name[i] != '\0'; i++)
+        if (name[i] == '/')
+            name[i] = '_';
+
+    if (absolute)
+        len = snprintf(path, size, "%s/%s_%08x%s", g_logstorage_cache_dir,
+                       name, hash, MCT_LOGSTORAGE_CACHE_FILE_SUFFIX);
+    else
+        len = snprintf(path, size, "%s/%s/%s_%08x%s", dev_path, g_logstorage_cache_dir,
+                       name, hash, MCT_LOGSTORAGE_CACHE_FILE_SUFFIX);
+
+    if ((len < 0) || ((size_t)len >= size))
+        return -1;
+
+    return 0;
+}
+
+/**
+ * mct_logstorage_recover_msg_cache
+ *
+ * Write the data of a cache file left by a crash of the daemon to the log
+ * files, as if the cache was synced, and remove the cache file.
+ *
+ * @param config        MctLogStorageFilterConfig
+ * @param file_config   User configurations for log file
+ * @param dev_path      Storage device path
+ * @return 0 on success or if there is nothing to recover, -1 on error
+ */
+int mct_logstorage_recover_msg_cache(MctLogStorageFilterConfig *config,
+                                     MctLogStorageUserConfig *file_config,
+                                     char *dev_path)
+{
+    char path[PATH_MAX + 1] = { '\0' };
+    MctLogStorageCacheTrailer trailer;
+    MctLogStorageCacheFooter *footer = NULL;
+    struct stat s;
+    uint8_t *cache = NULL;
+    int valid = 0;
+    int fd = -1;
+    int ret = 0;
+
+    if ((config == NULL) || (file_config == NULL) || (dev_path == NULL))
+        return -1;
+
+    if (MCT_OFFLINE_LOGSTORAGE_IS_FILE_BASED(config->sync) || (config->cache != NULL) ||
+        (mct_logstorage_cache_file_name(config, dev_path, path, sizeof(path)) != 0))
+        return 0;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+        return 0;
+
+    if ((fstat(fd, &s) == 0) &&
+        (s.st_size >= (off_t)(sizeof(MctLogStorageCacheFooter) + sizeof(trailer))) &&
+        (pread(fd, &trailer, sizeof(trailer), s.st_size - (off_t)sizeof(trailer)) ==
+         (ssize_t)sizeof(trailer)) &&
+        (memcmp(trailer.pattern, mct_logstorage_cache_pattern,
+                MCT_LOGSTORAGE_CACHE_PATTERN_SIZE) == 0) &&
+        ((off_t)trailer.cache_size + (off_t)(sizeof(MctLogStorageCacheFooter) + sizeof(trailer)) ==
+         s.st_size)) {
+        /* modifications of the footer while syncing are not written back */
+        cache = mmap(NULL, (size_t)s.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+        if (cache == MAP_FAILED) {
+            mct_vlog(LOG_ERR, "%s: Cannot map cache file [%s]: %s\n",
+                     __func__, path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+
+        footer = (MctLogStorageCacheFooter *)(cache + trailer.cache_size);
+        valid = (footer->offset <= trailer.cache_size) &&
+                (footer->last_sync_offset <= trailer.cache_size) &&
+                (footer->end_sync_offset <= trailer.cache_size);
+    }
+
+    if (!valid) {
+        mct_vlog(LOG_WARNING, "%s: Discard invalid cache file [%s]\n", __func__, path);
+    }
+    else if ((footer->wrap_around_cnt > 0) ||
+             (footer->offset != footer->last_sync_offset)) {
+        /* sync_to_file reads the data from the cache of the filter */
+        config->cache = cache;
+        ret = mct_logstorage_sync_cache(config, file_config, dev_path, footer);
+        config->cache = NULL;
+        mct_logstorage_close_log_file(config);
+
+        if (ret == 0)
+            mct_vlog(LOG_NOTICE, "%s: Recovered cache of [%s] left by a crash\n",
+                     __func__, config->file_name);
+        else
+            mct_vlog(LOG_ERR, "%s: Cannot recover cache of [%s] from [%s]\n",
+                     __func__, config->file_name, path);
+    }
+
+    if (cache != NULL)
+        munmap(cache, (size_t)s.st_size);
+
+    close(fd);
+
+    /* a cache which could not be written is kept for the next attempt */
+    if (ret == 0)
+        unlink(path);
+
+    return ret;
+}
+
+/**
+ * mct_logstorage_map_cache
+ *
+ * Create the cache of a filter in a shared mapping of a file, so its data
+ * survives a crash of the daemon. The kernel writes the data back to the
+ * file, there is no sync while the daemon runs.
+ *
+ * @param config        MctLogStorageFilterConfig
+ * @param file_config   User configurations for log file
+ * @param dev_path      Storage device path
+ * @param cache_size    Size of cache without footer
+ * @return cache, NULL if the cache cannot be kept in a file
+ */
+static void *mct_logstorage_map_cache(MctLogStorageFilterConfig *config,
+                                      MctLogStorageUserConfig *file_config,
+                                      char *dev_path,
+                                      unsigned int cache_size)
+{
+    char path[PATH_MAX + 1] = { '\0' };
+    MctLogStorageCacheTrailer trailer;
+    size_t size = cache_size + sizeof(MctLogStorageCacheFooter) + sizeof(trailer);
+    char *dir = NULL;
+    void *cache = NULL;
+    int fd = -1;
+    int err = 0;
+
+    if (mct_logstorage_cache_file_name(config, dev_path, path, sizeof(path)) != 0)
+        return NULL;
+
+    /* never overwrite data left by a crash */
+    if (mct_logstorage_recover_msg_cache(config, file_config, dev_path) != 0) {
+        mct_vlog(LOG_WARNING, "%s: Keep cache of [%s] in memory, [%s] is not recovered yet\n",
+                 __func__, config->file_name, path);
+        return NULL;
+    }
+
+    dir = strrchr(path, '/');
+    *dir = '\0';
+
+    if ((mkdir(path, 0700) != 0) && (errno != EEXIST))
+        mct_vlog(LOG_WARNING, "%s: Cannot create directory [%s]: %s\n",
+                 __func__, path, strerror(errno));
+
+    *dir = '/';
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+
+    if (fd < 0) {
+        mct_vlog(LOG_WARNING, "%s: Cannot create cache file [%s]: %s\n",
+                 __func__, path, strerror(errno));
+        return NULL;
+    }
+
+    /* reserve the space, writing to a mapping beyond a full tmpfs would
+     * kill the daemon */
+    err = posix_fallocate(fd, 0, (off_t)size);
+
+    if (err == 0) {
+        cache = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (cache == MAP_FAILED) {
+            err = errno;
+            cache = NULL;
+        }
+    }
+
+    close(fd);
+
+    if (cache != NULL) {
+        config->cache_file = strdup(path);
+
+        if (config->cache_file == NULL) {
+            err = ENOMEM;
+            munmap(cache, size);
+            cache = NULL;
+        }
+    }
+
+    if (cache == NULL) {
+        mct_vlog(LOG_WARNING, "%s: Cannot map cache file [%s]: %s\n",
+                 __func__, path, strerror(err));
+        unlink(path);
+        return NULL;
+    }
+
+    /* the new file is zero filled, i.e. cache and footer are empty */
+    memcpy(trailer.pattern, mct_logstorage_cache_pattern, MCT_LOGSTORAGE_CACHE_PATTERN_SIZE);
+    trailer.cache_size = cache_size;
+    memcpy((uint8_t *)cache + cache_size + sizeof(MctLogStorageCacheFooter),
+           &trailer, sizeof(trailer));
+
+    return cache;
+}
+
+/**
+ * mct_logstorage_free_msg_cache
+ *
+ * Release the cache of a filter. Its data was synced as configured, so a
+ * cache file is removed.
+ *
+ * @param config        MctLogStorageFilterConfig
+ */
+void mct_logstorage_free_msg_cache(MctLogStorageFilterConfig *config)
+{
+    if ((config == NULL) || (config->cache == NULL))
+        return;
+
+    if (config->cache_file != NULL) {
+        munmap(config->cache, mct_logstorage_cache_size(config) +
+               sizeof(MctLogStorageCacheFooter) + sizeof(MctLogStorageCacheTrailer));
+        unlink(config->cache_file);
+        free(config->cache_file);
+        config->cache_file = NULL;
+    }
+    else {
+        free(config->cache);
+    }
+
+    config->cache = NULL;
+}
+
 /**
  * mct_logstorage_prepare_msg_cache
  *
@@ -1123,6 +1965,9 @@ int mct_logstorage_prepare_msg_cache(MctLogStorageFilterConfig *config,
                 (strcmp(newest_file_info->newest_file, config->working_file_name) != 0))) {
             free(config->working_file_name);
             config->working_file_name = NULL;
+
+            /* another filter switched to a newer file */
+            mct_logstorage_close_log_file(config);
         }
         if (config->working_file_name == NULL) {
             config->working_file_name = strdup(newest_file_info->newest_file);
@@ -1156,18 +2001,7 @@ int mct_logstorage_prepare_msg_cache(MctLogStorageFilterConfig *config,
 
     if (config->cache == NULL)
     {
-        unsigned int cache_size = 0;
-
-        /* check for sync_specific_size strategy */
-        if (MCT_OFFLINE_LOGSTORAGE_IS_STRATEGY_SET(config->sync,
-               MCT_LOGSTORAGE_SYNC_ON_SPECIFIC_SIZE) > 0)
-        {
-            cache_size = config->specific_size;
-        }
-        else  /* other cache strategies */
-        {
-            cache_size = config->file_size;
-        }
+        unsigned int cache_size = mct_logstorage_cache_size(config);
 
         /* check total logstorage cache size */
         if ((g_logstorage_cache_size + cache_size +
@@ -1185,8 +2019,16 @@ int mct_logstorage_prepare_msg_cache(MctLogStorageFilterConfig *config,
                      g_logstorage_cache_max, config->apids, config->ctids);
         }
 
-        /* create cache */
-        config->cache = calloc(1, cache_size + sizeof(MctLogStorageCacheFooter));
+        /* keep cache in a file if configured, so it survives a crash */
+        if (g_logstorage_cache_dir[0] != '\0')
+            config->cache = mct_logstorage_map_cache(config, file_config,
+                                                     dev_path, cache_size);
+
+        /* create cache, page aligned as it is written to file directly */
+        if ((config->cache == NULL) &&
+            (posix_memalign(&config->cache, (size_t)sysconf(_SC_PAGESIZE),
+                            cache_size + sizeof(MctLogStorageCacheFooter)) != 0))
+            config->cache = NULL;
 
         if (config->cache == NULL)
         {
@@ -1195,6 +2037,9 @@ int mct_logstorage_prepare_msg_cache(MctLogStorageFilterConfig *config,
         }
         else
         {
+            if (config->cache_file == NULL)
+                memset(config->cache, 0, cache_size + sizeof(MctLogStorageCacheFooter));
+
             /* update current used cache size */
             g_logstorage_cache_size += cache_size + sizeof(MctLogStorageCacheFooter);
         }
@@ -1365,6 +2210,7 @@ int mct_logstorage_sync_msg_cache(MctLogStorageFilterConfig *config,
                                   int status)
 {
     unsigned int cache_size;
+    int ret = 0;
 
     MctLogStorageCacheFooter *footer = NULL;
 
@@ -1383,15 +2229,7 @@ int mct_logstorage_sync_msg_cache(MctLogStorageFilterConfig *config,
             return -1;
         }
 
-        if (MCT_OFFLINE_LOGSTORAGE_IS_STRATEGY_SET(config->sync,
-                                                   MCT_LOGSTORAGE_SYNC_ON_SPECIFIC_SIZE) > 0)
-        {
-            cache_size = config->specific_size;
-        }
-        else
-        {
-            cache_size = config->file_size;
-        }
+        cache_size = mct_logstorage_cache_size(config);
 
         footer = (MctLogStorageCacheFooter *)((uint8_t*)config->cache + cache_size);
         if (footer == NULL)
@@ -1401,53 +2239,27 @@ int mct_logstorage_sync_msg_cache(MctLogStorageFilterConfig *config,
         }
 
         /* sync cache data to file */
-        if (footer->wrap_around_cnt < 1)
-        {
-            /* Sync whole cache */
-            mct_logstorage_sync_to_file(config, file_config, dev_path, footer,
-                                        footer->last_sync_offset, footer->offset);
+        ret = mct_logstorage_sync_cache(config, file_config, dev_path, footer);
 
-        }
-        else if ((footer->wrap_around_cnt == 1) &&
-                 (footer->offset < footer->last_sync_offset))
-        {
-            /* sync (1) footer->last_sync_offset to footer->end_sync_offset,
-             * and (2) footer->last_sync_offset (= 0) to footer->offset */
-            mct_logstorage_sync_to_file(config, file_config, dev_path, footer,
-                                        footer->last_sync_offset, footer->end_sync_offset);
-            footer->last_sync_offset = 0;
-            mct_logstorage_sync_to_file(config, file_config, dev_path, footer,
-                                        footer->last_sync_offset, footer->offset);
-        }
-        else
-        {
-            /* sync (1) footer->offset + index to footer->end_sync_offset,
-             * and (2) footer->last_sync_offset (= 0) to footer->offset */
-            mct_logstorage_sync_to_file(config, file_config, dev_path, footer,
-                                        footer->offset, footer->end_sync_offset);
-            footer->last_sync_offset = 0;
-            mct_logstorage_sync_to_file(config, file_config, dev_path, footer,
-                                        footer->last_sync_offset, footer->offset);
-        }
+        if (ret != 0)
+            mct_vlog(LOG_ERR, "%s: Cannot write cache of [%s] to log file\n",
+                     __func__, config->file_name);
 
         /* Initialize cache if needed */
         if ((status == MCT_LOGSTORAGE_SYNC_ON_SPECIFIC_SIZE) ||
             (status == MCT_LOGSTORAGE_SYNC_ON_FILE_SIZE))
         {
-            /* clean ring buffer and reset footer information */
-            memset(config->cache, 0,
-                   cache_size + sizeof(MctLogStorageCacheFooter));
+            /* reset footer information, only data up to the offset is
+             * synced so the stale data need not be cleared. The cache is
+             * needed for the next messages, even if it was not written. */
+            memset(footer, 0, sizeof(MctLogStorageCacheFooter));
         }
 
         if (status == MCT_LOGSTORAGE_SYNC_ON_FILE_SIZE)
         {
             /* Close log file */
-            if (config->log != NULL) {
-                fclose(config->log);
-                config->log = NULL;
-                config->current_write_file_offset = 0;
-            }
+            mct_logstorage_close_log_file(config);
         }
     }
-    return 0;
+    return ret;
 }
@@ -24,6 +24,17 @@ int mct_logstorage_sync_on_msg(MctLogStorageFilterConfig *config,
                                char *dev_path,
                                int status);
 
+/* ON_TIMER uses prepare and write of ON_MSG, data is synced every sync_size
+ * bytes, on MCT_LOGSTORAGE_SYNC_ON_TIMER and on every other status */
+int mct_logstorage_sync_on_timer(MctLogStorageFilterConfig *config,
+                                 MctLogStorageUserConfig *file_config,
+                                 char *dev_path,
+                                 int status);
+
+/* Append the pending block and the summary to the index file of the
+ * current log file and close it, called before the log file is closed */
+void mct_logstorage_close_index(MctLogStorageFilterConfig *config);
+
 /* Logstorage cache functionality */
 int mct_logstorage_prepare_msg_cache(MctLogStorageFilterConfig *config,
                                      MctLogStorageUserConfig *file_config,
@@ -46,4 +57,13 @@ int mct_logstorage_sync_msg_cache(MctLogStorageFilterConfig *config,
                                   char *dev_path,
                                   int status);
 
+/* Write the data of a cache file left by a crash to the log files and
+ * remove the cache file, called before the cache is prepared */
+int mct_logstorage_recover_msg_cache(MctLogStorageFilterConfig *config,
+                                     MctLogStorageUserConfig *file_config,
+                                     char *dev_path);
+
+/* Release the cache of a filter and remove its cache file */
+void mct_logstorage_free_msg_cache(MctLogStorageFilterConfig *config);
+
 #endif /* MCT_OFFLINELOGSTORAGE_MCT_OFFLINE_LOGSTORAGE_BEHAVIOR_H_ */
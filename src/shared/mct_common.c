@@ -11,10 +11,13 @@
 #include <errno.h>
 #include <sys/stat.h> /* for mkdir() */
 #include <sys/wait.h>
+#include <sys/mman.h> /* for mmap(), memfd_create() */
 
 #include "mct_user_shared.h"
 #include "mct_common.h"
 #include "mct_common_cfg.h"
+#include "mct_pattern.h"
+#include "mct_compress.h"
 
 #include "mct_version.h"
 
@@ -41,6 +44,7 @@
 
 const char mctSerialHeader[MCT_ID_SIZE] = { 'D', 'L', 'S', 1 };
 char mctSerialHeaderChar[MCT_ID_SIZE] = { 'D', 'L', 'S', 1 };
+const char mctMulticastHeader[MCT_ID_SIZE] = { 'D', 'L', 'M', 1 };
 
 #if defined MCT_DAEMON_USE_FIFO_IPC || defined MCT_LIB_USE_FIFO_IPC
 char mctFifoBaseDir[MCT_PATH_MAX] = "/tmp";
@@ -609,6 +613,7 @@ MctReturnValue mct_message_init(MctMessage *msg, int verbose)
     msg->extendedheader = NULL;
 
     msg->found_serialheader = 0;
+    msg->is_view = 0;
 
     return MCT_RETURN_OK;
 }
@@ -622,11 +627,16 @@ MctReturnValue mct_message_free(MctMessage *msg, int verbose)
 
     /* delete databuffer if exists */
     if (msg->databuffer) {
-        free(msg->databuffer);
+        /* a view does not own its payload */
+        if (!msg->is_view)
+            free(msg->databuffer);
+
         msg->databuffer = NULL;
         msg->databuffersize = 0;
     }
 
+    msg->is_view = 0;
+
     return MCT_RETURN_OK;
 }
 
@@ -936,7 +946,24 @@ MctReturnValue mct_message_filter_check(MctMessage *msg, MctFilter *filter, int
     return found;
 }
 
-int mct_message_read(MctMessage *msg, uint8_t *buffer, unsigned int length, int resync, int verbose)
+/**
+ * Parse a message from a memory buffer, see mct_message_read().
+ * In view mode the standard header, the extended header and the payload
+ * are not copied, the message pointers refer to the buffer instead.
+ * @param msg pointer to structure of organising access to MCT messages
+ * @param buffer pointer to memory buffer
+ * @param length length of message in buffer
+ * @param resync if set to true resync to serial header is enforced
+ * @param view if set to true the message is parsed in view mode
+ * @param verbose if set to true verbose information is printed out.
+ * @return negative value if there was an error
+ */
+static int mct_message_read_buffer(MctMessage *msg,
+                                   uint8_t *buffer,
+                                   unsigned int length,
+                                   int resync,
+                                   int view,
+                                   int verbose)
 {
     uint32_t extra_size = 0;
 
@@ -965,23 +992,18 @@ int mct_message_read(MctMessage *msg, uint8_t *buffer, unsigned int length, int
 
         if (resync) {
             /* resync if necessary */
-            msg->resync_offset = 0;
-
-            do {
-                if (memcmp(buffer + msg->resync_offset, mctSerialHeader, sizeof(mctSerialHeader)) == 0) {
-                    /* serial header found */
-                    msg->found_serialheader = 1;
-                    buffer += sizeof(mctSerialHeader);
-                    length -= (unsigned int)sizeof(mctSerialHeader);
-                    break;
-                }
-
-                msg->resync_offset++;
-            } while ((sizeof(mctSerialHeader) + (size_t)msg->resync_offset) <= length);
-
-            /* Set new start offset */
-            if (msg->resync_offset > 0) {
-                /* Resyncing connection */
+            int found = mct_pattern_find(buffer, length, mctSerialHeader, sizeof(mctSerialHeader));
+
+            if (found >= 0) {
+                /* serial header found */
+                msg->found_serialheader = 1;
+                msg->resync_offset = found;
+                buffer += (size_t)found + sizeof(mctSerialHeader);
+                length -= (unsigned int)found + (unsigned int)sizeof(mctSerialHeader);
+            }
+            else {
+                /* skip everything which cannot be the start of a serial header */
+                msg->resync_offset = (int32_t)(length - (sizeof(mctSerialHeader) - 1));
                 buffer += msg->resync_offset;
                 length -= (unsigned int)msg->resync_offset;
             }
@@ -993,11 +1015,16 @@ int mct_message_read(MctMessage *msg, uint8_t *buffer, unsigned int length, int
         /* mct_log(LOG_ERR, "Length smaller than standard header!\n"); */
         return MCT_MESSAGE_ERROR_SIZE;
 
-    memcpy(msg->headerbuffer + sizeof(MctStorageHeader), buffer, sizeof(MctStandardHeader));
-
     /* set ptrs to structures */
     msg->storageheader = (MctStorageHeader *)msg->headerbuffer;
-    msg->standardheader = (MctStandardHeader *)(msg->headerbuffer + sizeof(MctStorageHeader));
+
+    if (view) {
+        msg->standardheader = (MctStandardHeader *)buffer;
+    }
+    else {
+        memcpy(msg->headerbuffer + sizeof(MctStorageHeader), buffer, sizeof(MctStandardHeader));
+        msg->standardheader = (MctStandardHeader *)(msg->headerbuffer + sizeof(MctStorageHeader));
+    }
 
     /* calculate complete size of headers */
     extra_size = MCT_STANDARD_HEADER_EXTRA_SIZE(msg->standardheader->htyp) +
@@ -1023,13 +1050,14 @@ int mct_message_read(MctMessage *msg, uint8_t *buffer, unsigned int length, int
         if (length < (msg->headersize - sizeof(MctStorageHeader)))
             return MCT_MESSAGE_ERROR_SIZE;
 
-        memcpy(msg->headerbuffer + sizeof(MctStorageHeader) + sizeof(MctStandardHeader),
-               buffer + sizeof(MctStandardHeader), (size_t)extra_size);
+        if (!view)
+            memcpy(msg->headerbuffer + sizeof(MctStorageHeader) + sizeof(MctStandardHeader),
+                   buffer + sizeof(MctStandardHeader), (size_t)extra_size);
 
         /* set extended header ptr and get standard header extra parameters */
         if (MCT_IS_HTYP_UEH(msg->standardheader->htyp))
             msg->extendedheader =
-                (MctExtendedHeader *)(msg->headerbuffer + sizeof(MctStorageHeader) + sizeof(MctStandardHeader) +
+                (MctExtendedHeader *)((uint8_t *)msg->standardheader + sizeof(MctStandardHeader) +
                                       MCT_STANDARD_HEADER_EXTRA_SIZE(msg->standardheader->htyp));
         else
             msg->extendedheader = NULL;
@@ -1042,6 +1070,25 @@ int mct_message_read(MctMessage *msg, uint8_t *buffer, unsigned int length, int
         /* mct_log(LOG_ERR,"length does not fit!\n"); */
         return MCT_MESSAGE_ERROR_SIZE;
 
+    if (view) {
+        /* a payload buffer owned by the message is not needed anymore */
+        if (!msg->is_view)
+            free(msg->databuffer);
+
+        msg->databuffer = buffer + (msg->headersize - sizeof(MctStorageHeader));
+        msg->databuffersize = msg->datasize;
+        msg->is_view = 1;
+
+        return MCT_MESSAGE_ERROR_OK;
+    }
+
+    if (msg->is_view) {
+        /* payload buffer belongs to the last parsed buffer */
+        msg->databuffer = NULL;
+        msg->databuffersize = 0;
+        msg->is_view = 0;
+    }
+
     /* free last used memory for buffer */
     if (msg->databuffer) {
         if (msg->datasize > msg->databuffersize) {
@@ -1069,6 +1116,16 @@ int mct_message_read(MctMessage *msg, uint8_t *buffer, unsigned int length, int
     return MCT_MESSAGE_ERROR_OK;
 }
 
+int mct_message_read(MctMessage *msg, uint8_t *buffer, unsigned int length, int resync, int verbose)
+{
+    return mct_message_read_buffer(msg, buffer, length, resync, 0, verbose);
+}
+
+int mct_message_read_view(MctMessage *msg, uint8_t *buffer, unsigned int length, int resync, int verbose)
+{
+    return mct_message_read_buffer(msg, buffer, length, resync, 1, verbose);
+}
+
 MctReturnValue mct_message_get_extraparameters(MctMessage *msg, int verbose)
 {
     PRINT_FUNCTION_VERBOSE(verbose);
@@ -1078,17 +1135,17 @@ MctReturnValue mct_message_get_extraparameters(MctMessage *msg, int verbose)
 
     if (MCT_IS_HTYP_WEID(msg->standardheader->htyp))
         memcpy(msg->headerextra.ecu,
-               msg->headerbuffer + sizeof(MctStorageHeader) + sizeof(MctStandardHeader),
+               (uint8_t *)msg->standardheader + sizeof(MctStandardHeader),
                MCT_ID_SIZE);
 
     if (MCT_IS_HTYP_WSID(msg->standardheader->htyp)) {
-        memcpy(&(msg->headerextra.seid), msg->headerbuffer + sizeof(MctStorageHeader) + sizeof(MctStandardHeader)
+        memcpy(&(msg->headerextra.seid), (uint8_t *)msg->standardheader + sizeof(MctStandardHeader)
                + (MCT_IS_HTYP_WEID(msg->standardheader->htyp) ? MCT_SIZE_WEID : 0), MCT_SIZE_WSID);
         msg->headerextra.seid = MCT_BETOH_32(msg->headerextra.seid);
     }
 
     if (MCT_IS_HTYP_WTMS(msg->standardheader->htyp)) {
-        memcpy(&(msg->headerextra.tmsp), msg->headerbuffer + sizeof(MctStorageHeader) + sizeof(MctStandardHeader)
+        memcpy(&(msg->headerextra.tmsp), (uint8_t *)msg->standardheader + sizeof(MctStandardHeader)
                + (MCT_IS_HTYP_WEID(msg->standardheader->htyp) ? MCT_SIZE_WEID : 0)
                + (MCT_IS_HTYP_WSID(msg->standardheader->htyp) ? MCT_SIZE_WSID : 0), MCT_SIZE_WTMS);
         msg->headerextra.tmsp = MCT_BETOH_32(msg->headerextra.tmsp);
@@ -1105,13 +1162,13 @@ MctReturnValue mct_message_set_extraparameters(MctMessage *msg, int verbose)
         return MCT_RETURN_WRONG_PARAMETER;
 
     if (MCT_IS_HTYP_WEID(msg->standardheader->htyp))
-        memcpy(msg->headerbuffer + sizeof(MctStorageHeader) + sizeof(MctStandardHeader),
+        memcpy((uint8_t *)msg->standardheader + sizeof(MctStandardHeader),
                msg->headerextra.ecu,
                MCT_ID_SIZE);
 
     if (MCT_IS_HTYP_WSID(msg->standardheader->htyp)) {
         msg->headerextra.seid = MCT_HTOBE_32(msg->headerextra.seid);
-        memcpy(msg->headerbuffer + sizeof(MctStorageHeader) + sizeof(MctStandardHeader)
+        memcpy((uint8_t *)msg->standardheader + sizeof(MctStandardHeader)
                + (MCT_IS_HTYP_WEID(msg->standardheader->htyp) ? MCT_SIZE_WEID : 0),
                &(msg->headerextra.seid),
                MCT_SIZE_WSID);
@@ -1119,7 +1176,7 @@ MctReturnValue mct_message_set_extraparameters(MctMessage *msg, int verbose)
 
     if (MCT_IS_HTYP_WTMS(msg->standardheader->htyp)) {
         msg->headerextra.tmsp = MCT_HTOBE_32(msg->headerextra.tmsp);
-        memcpy(msg->headerbuffer + sizeof(MctStorageHeader) + sizeof(MctStandardHeader)
+        memcpy((uint8_t *)msg->standardheader + sizeof(MctStandardHeader)
                + (MCT_IS_HTYP_WEID(msg->standardheader->htyp) ? MCT_SIZE_WEID : 0)
                + (MCT_IS_HTYP_WSID(msg->standardheader->htyp) ? MCT_SIZE_WSID : 0),
                &(msg->headerextra.tmsp),
@@ -1404,6 +1461,83 @@ MctReturnValue mct_file_read_data(MctFile *file, int verbose)
     return MCT_RETURN_OK;
 }
 
+/**
+ * mct_file_decompress
+ *
+ * Replace the handle of a compressed MCT file by an anonymous temporary
+ * file with the decompressed messages, so it is read like a plain file.
+ * Decompression stops at the first truncated or corrupted block, the
+ * messages of the blocks before are still read.
+ *
+ * @param file pointer to structure of organising access to MCT file
+ * @return negative value if there was an error
+ */
+static MctReturnValue mct_file_decompress(MctFile *file)
+{
+    MctBlockHeader header;
+    FILE *output = NULL;
+    uint8_t *data = NULL;
+    uint8_t *raw = NULL;
+    uint32_t size = 0;
+    uint32_t raw_size = 0;
+    uint32_t blocks = 0;
+    size_t read = 0;
+    int len = 0;
+
+    output = tmpfile();
+    data = malloc(MCT_BLOCK_SIZE_MAX);
+    raw = malloc(MCT_BLOCK_SIZE_MAX);
+
+    if ((output == NULL) || (data == NULL) || (raw == NULL)) {
+        mct_log(LOG_WARNING, "Cannot allocate buffers for decompression!\n");
+
+        if (output != NULL)
+            fclose(output);
+
+        free(data);
+        free(raw);
+        return MCT_RETURN_ERROR;
+    }
+
+    while ((read = fread(&header, 1, sizeof(header), file->handle)) == sizeof(header)) {
+        size = MCT_LETOH_32(header.size);
+        raw_size = MCT_LETOH_32(header.raw_size);
+
+        if (!mct_block_is_header(header.pattern) ||
+            (size > MCT_BLOCK_SIZE_MAX) || (raw_size > MCT_BLOCK_SIZE_MAX) ||
+            (fread(data, size, 1, file->handle) != 1))
+            break;
+
+        if (size == raw_size) {
+            len = (int)size;
+            memcpy(raw, data, size);
+        }
+        else {
+            len = mct_decompress(data, (int)size, raw, (int)raw_size);
+        }
+
+        if ((len != (int)raw_size) || (fwrite(raw, (size_t)len, 1, output) != 1))
+            break;
+
+        blocks++;
+        read = 0;
+    }
+
+    /* anything left over is a truncated or corrupted block */
+    if (read > 0)
+        mct_vlog(LOG_WARNING,
+                 "Truncated or corrupted block after %u blocks in compressed file, ignoring the rest!\n",
+                 blocks);
+
+    free(data);
+    free(raw);
+
+    fclose(file->handle);
+    file->handle = output;
+
+    return MCT_RETURN_OK;
+}
+
 MctReturnValue mct_file_open(MctFile *file, const char *filename, int verbose)
 {
     PRINT_FUNCTION_VERBOSE(verbose);
@@ -1442,6 +1576,24 @@ MctReturnValue mct_file_open(MctFile *file, const char *filename, int verbose)
         return MCT_RETURN_ERROR;
     }
 
+    /* compressed files are read from a decompressed copy */
+    if (file->file_length >= MCT_BLOCK_PATTERN_SIZE) {
+        char pattern[MCT_BLOCK_PATTERN_SIZE];
+
+        if ((fread(pattern, sizeof(pattern), 1, file->handle) == 1) &&
+            mct_block_is_header(pattern)) {
+            rewind(file->handle);
+
+            if (mct_file_decompress(file) < MCT_RETURN_OK)
+                return MCT_RETURN_ERROR;
+
+            fseek(file->handle, 0, SEEK_END);
+            file->file_length = ftell(file->handle);
+        }
+
+        rewind(file->handle);
+    }
+
     if (verbose)
         /* print file length */
         mct_vlog(LOG_DEBUG, "File is %lu bytes long\n", file->file_length);
@@ -1921,9 +2073,105 @@ MctReturnValue mct_vnlog(int prio, size_t size, const char *format, ...)
     return MCT_RETURN_OK;
 }
 
+/**
+ * Allocate the data area of a receiver.
+ *
+ * On Linux the area is a memfd mapped twice back to back, so that data
+ * wrapping around the end of the buffer can still be accessed contiguously
+ * and left over bytes never have to be moved. The size is rounded up to a
+ * multiple of the page size in that case. If the double mapping is not
+ * available, a plain linear buffer is allocated.
+ *
+ * @param receiver pointer to mct receiver structure
+ * @param buffersize requested size of the data area
+ * @return MCT_RETURN_OK on success, MCT_RETURN_ERROR otherwise
+ */
+static MctReturnValue mct_receiver_alloc_buffer(MctReceiver *receiver, int buffersize)
+{
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t size = 0;
+    int mfd = -1;
+    char *base = MAP_FAILED;
+
+    if (page_size > 0) {
+        size = (((size_t)buffersize + (size_t)page_size - 1) / (size_t)page_size) * (size_t)page_size;
+        mfd = memfd_create("mct_receiver", MFD_CLOEXEC);
+    }
+
+    if ((mfd >= 0) && (ftruncate(mfd, (off_t)size) == 0))
+        base = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if ((base != MAP_FAILED) &&
+        (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, mfd, 0) != MAP_FAILED) &&
+        (mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, mfd, 0) != MAP_FAILED)) {
+        close(mfd);
+        receiver->buffer = base;
+        receiver->buffersize = (int32_t)size;
+        receiver->ring = 1;
+        return MCT_RETURN_OK;
+    }
+
+    if (base != MAP_FAILED)
+        munmap(base, 2 * size);
+
+    if (mfd >= 0)
+        close(mfd);
+#endif
+
+    receiver->buffer = (char *)calloc(1, (size_t)buffersize);
+    receiver->buffersize = buffersize;
+    receiver->ring = 0;
+
+    return (receiver->buffer == NULL) ? MCT_RETURN_ERROR : MCT_RETURN_OK;
+}
+
+/**
+ * Release the data area of a receiver allocated by mct_receiver_alloc_buffer().
+ * @param receiver pointer to mct receiver structure
+ */
+static void mct_receiver_free_buffer(MctReceiver *receiver)
+{
+    if (receiver->buffer == NULL)
+        return;
+
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    if (receiver->ring)
+        munmap(receiver->buffer, 2 * (size_t)receiver->buffersize);
+    else
+#endif
+    free(receiver->buffer);
+
+    receiver->buffer = NULL;
+    receiver->ring = 0;
+}
+
+/**
+ * Bring the read position back into the first mapping of a ring buffer,
+ * or move the remaining data to the front of a linear buffer.
+ * @param receiver pointer to mct receiver structure
+ */
+static void mct_receiver_normalize(MctReceiver *receiver)
+{
+    if (receiver->bytesRcvd <= 0) {
+        receiver->bytesRcvd = 0;
+        receiver->buf = receiver->buffer;
+        return;
+    }
+
+    if (receiver->ring) {
+        while (receiver->buf >= receiver->buffer + receiver->buffersize)
+            receiver->buf -= receiver->buffersize;
+    }
+    else if (receiver->buf != receiver->buffer) {
+        memmove(receiver->buffer, receiver->buf, (size_t)receiver->bytesRcvd);
+        receiver->buf = receiver->buffer;
+    }
+}
+
 MctReturnValue mct_receiver_init(MctReceiver *receiver, int fd, MctReceiverType type, int buffersize)
 {
-    if (NULL == receiver)
+    if ((NULL == receiver) || (buffersize <= 0))
         return MCT_RETURN_WRONG_PARAMETER;
 
     receiver->fd = fd;
@@ -1932,55 +2180,23 @@ MctReturnValue mct_receiver_init(MctReceiver *receiver, int fd, MctReceiverType
     /** Reuse the receiver buffer if it exists and the buffer size
       * is not changed. If not, free the old one and allocate a new buffer.
       */
-    if ((NULL != receiver->buffer) && (buffersize != receiver->buffersize)) {
-       free(receiver->buffer);
-       receiver->buffer = NULL;
-    }
+    if ((NULL != receiver->buffer) &&
+        ((buffersize > receiver->buffersize) ||
+         (!receiver->ring && (buffersize != receiver->buffersize))))
+        mct_receiver_free_buffer(receiver);
 
     if (NULL == receiver->buffer) {
         receiver->lastBytesRcvd = 0;
         receiver->bytesRcvd = 0;
         receiver->totalBytesRcvd = 0;
         receiver->buf = NULL;
-        receiver->backup_buf = NULL;
-        receiver->buffer = (char *)calloc(1, (size_t)buffersize);
-        receiver->buffersize = (uint32_t)buffersize;
-    }
 
-    if (NULL == receiver->buffer) {
-        mct_log(LOG_ERR, "allocate memory for receiver buffer failed.\n");
-        return MCT_RETURN_ERROR;
-    }
-    else {
-        receiver->buf = receiver->buffer;
-    }
-
-    return MCT_RETURN_OK;
-}
-
-MctReturnValue mct_receiver_init_global_buffer(MctReceiver *receiver, int fd, MctReceiverType type, char **buffer)
-{
-    if (receiver == NULL)
-        return MCT_RETURN_WRONG_PARAMETER;
-
-    if (*buffer == NULL) {
-        /* allocating the buffer once and using it for all application receivers
-         * by keeping allocated buffer in app_recv_buffer global handle
-         */
-        *buffer = (char *)malloc(MCT_RECEIVE_BUFSIZE);
-
-        if (*buffer == NULL)
+        if (mct_receiver_alloc_buffer(receiver, buffersize) != MCT_RETURN_OK) {
+            mct_log(LOG_ERR, "allocate memory for receiver buffer failed.\n");
             return MCT_RETURN_ERROR;
+        }
     }
 
-    receiver->lastBytesRcvd = 0;
-    receiver->bytesRcvd = 0;
-    receiver->totalBytesRcvd = 0;
-    receiver->buffersize = MCT_RECEIVE_BUFSIZE;
-    receiver->fd = fd;
-    receiver->type = type;
-    receiver->buffer = *buffer;
-    receiver->backup_buf = NULL;
     receiver->buf = receiver->buffer;
 
     return MCT_RETURN_OK;
@@ -1992,31 +2208,11 @@ MctReturnValue mct_receiver_free(MctReceiver *receiver)
     if (receiver == NULL)
         return MCT_RETURN_WRONG_PARAMETER;
 
-    if (receiver->buffer)
-        free(receiver->buffer);
+    mct_receiver_free_buffer(receiver);
 
-    if (receiver->backup_buf)
-        free(receiver->backup_buf);
-
-    receiver->buffer = NULL;
     receiver->buf = NULL;
-    receiver->backup_buf = NULL;
-
-    return MCT_RETURN_OK;
-}
-
-MctReturnValue mct_receiver_free_global_buffer(MctReceiver *receiver)
-{
-
-    if (receiver == NULL)
-        return MCT_RETURN_WRONG_PARAMETER;
-
-    if (receiver->backup_buf)
-        free(receiver->backup_buf);
-
-    receiver->buffer = NULL;
-    receiver->buf = NULL;
-    receiver->backup_buf = NULL;
+    receiver->bytesRcvd = 0;
+    receiver->lastBytesRcvd = 0;
 
     return MCT_RETURN_OK;
 }
@@ -2024,6 +2220,8 @@ MctReturnValue mct_receiver_free_global_buffer(MctReceiver *receiver)
 int mct_receiver_receive(MctReceiver *receiver)
 {
     socklen_t addrlen;
+    char *write_pos = NULL;
+    size_t space = 0;
 
     if (receiver == NULL)
         return -1;
@@ -2031,33 +2229,26 @@ int mct_receiver_receive(MctReceiver *receiver)
     if (receiver->buffer == NULL)
         return -1;
 
-    receiver->buf = (char *)receiver->buffer;
+    /* left over data stays where it is, new data is appended behind it */
+    mct_receiver_normalize(receiver);
     receiver->lastBytesRcvd = receiver->bytesRcvd;
 
-    if ((receiver->lastBytesRcvd) && (receiver->backup_buf != NULL)) {
-        memcpy(receiver->buf, receiver->backup_buf, (size_t)receiver->lastBytesRcvd);
-        free(receiver->backup_buf);
-        receiver->backup_buf = NULL;
-    }
+    write_pos = receiver->buf + receiver->lastBytesRcvd;
+    space = (size_t)(receiver->buffersize - receiver->lastBytesRcvd);
 
     if (receiver->type == MCT_RECEIVE_SOCKET)
         /* wait for data from socket */
-        receiver->bytesRcvd = (int32_t) recv(receiver->fd,
-                                   receiver->buf + receiver->lastBytesRcvd,
-                                   receiver->buffersize - (uint32_t) receiver->lastBytesRcvd,
-                                   0);
+        receiver->bytesRcvd = (int32_t) recv(receiver->fd, write_pos, space, 0);
     else if (receiver->type == MCT_RECEIVE_FD)
         /* wait for data from fd */
-        receiver->bytesRcvd = (int32_t)read(receiver->fd,
-                                            receiver->buf + receiver->lastBytesRcvd,
-                                            receiver->buffersize - (uint32_t)receiver->lastBytesRcvd);
+        receiver->bytesRcvd = (int32_t)read(receiver->fd, write_pos, space);
 
     else { /* receiver->type == MCT_RECEIVE_UDP_SOCKET */
         /* wait for data from UDP socket */
         addrlen = sizeof(receiver->addr);
         receiver->bytesRcvd = recvfrom(receiver->fd,
-                                       receiver->buf + receiver->lastBytesRcvd,
-                                       receiver->buffersize - receiver->lastBytesRcvd,
+                                       write_pos,
+                                       space,
                                        0,
                                        (struct sockaddr *)&(receiver->addr),
                                        &addrlen);
@@ -2103,16 +2294,7 @@ MctReturnValue mct_receiver_move_to_begin(MctReceiver *receiver)
     if ((receiver->buffer == NULL) || (receiver->buf == NULL))
         return MCT_RETURN_ERROR;
 
-    if ((receiver->buffer != receiver->buf) && (receiver->bytesRcvd != 0)) {
-        receiver->backup_buf = calloc((size_t)(receiver->bytesRcvd + 1), sizeof(char));
-
-        if (receiver->backup_buf == NULL)
-            mct_vlog(LOG_WARNING,
-                     "Can't allocate memory for backup buf, there will be atleast"
-                     "one corrupted message for fd[%d] \n", receiver->fd);
-        else
-            memcpy(receiver->backup_buf, receiver->buf, (size_t)receiver->bytesRcvd);
-    }
+    mct_receiver_normalize(receiver);
 
     return MCT_RETURN_OK;
 }
@@ -2222,6 +2404,9 @@ MctReturnValue mct_buffer_init_static_server(MctBuffer *buf, const unsigned char
     buf->min_size = size;
     buf->max_size = size;
     buf->step_size = 0;
+    buf->first = NULL;
+    buf->last = NULL;
+    buf->count = 0;
 
     /* Init pointers */
     head = (MctBufferHead *)buf->shm;
@@ -2251,6 +2436,9 @@ MctReturnValue mct_buffer_init_static_client(MctBuffer *buf, const unsigned char
     buf->min_size = size;
     buf->max_size = size;
     buf->step_size = 0;
+    buf->first = NULL;
+    buf->last = NULL;
+    buf->count = 0;
 
     /* Init pointers */
     buf->mem = (unsigned char *)(buf->shm + sizeof(MctBufferHead));
@@ -2263,10 +2451,340 @@ MctReturnValue mct_buffer_init_static_client(MctBuffer *buf, const unsigned char
     return MCT_RETURN_OK; /* OK */
 }
 
+static MctBufferSegment *mct_buffer_segment_create(uint32_t size)
+{
+    MctBufferSegment *seg = malloc(sizeof(MctBufferSegment) + size);
+
+    if (seg == NULL) {
+        mct_vlog(LOG_WARNING, "%s: Buffer: Cannot allocate %u bytes\n", __func__, size);
+        return NULL;
+    }
+
+    seg->next = NULL;
+    seg->mem = (unsigned char *)(seg + 1);
+    seg->size = size;
+    seg->read = 0;
+    seg->write = 0;
+    seg->count = 0;
+    memset(seg->priority_count, 0, sizeof(seg->priority_count));
+
+    return seg;
+}
+
+/* append a segment of step size, or larger if the entry does not fit */
+static int mct_buffer_segment_append(MctBuffer *buf, uint32_t needed)
+{
+    MctBufferSegment *seg = NULL;
+    uint32_t size = buf->step_size;
+
+    if (size < needed)
+        size = needed;
+
+    /* check size */
+    if ((buf->step_size == 0) || (buf->size + size > buf->max_size))
+        /* max size reached, do not increase */
+        return MCT_RETURN_ERROR;
+
+    seg = mct_buffer_segment_create(size);
+
+    if (seg == NULL)
+        return MCT_RETURN_ERROR;
+
+    buf->last->next = seg;
+    buf->last = seg;
+    buf->size += size;
+
+    mct_vlog(LOG_DEBUG, "%s: Buffer: Size increased to %u bytes\n", __func__, buf->size);
+
+    return MCT_RETURN_OK;
+}
+
+/* release leading segments without entries, the last one is kept and rewound */
+static void mct_buffer_segment_release(MctBuffer *buf)
+{
+    MctBufferSegment *seg = NULL;
+
+    while ((buf->first->count == 0) && (buf->first->next != NULL)) {
+        seg = buf->first;
+        buf->first = seg->next;
+        buf->size -= seg->size;
+        free(seg);
+    }
+
+    if (buf->first->count == 0) {
+        buf->first->read = 0;
+        buf->first->write = 0;
+    }
+}
+
+/* release all segments but a single one of min size */
+static int mct_buffer_segment_minimize(MctBuffer *buf)
+{
+    MctBufferSegment *seg = NULL;
+
+    if ((buf->first == buf->last) && (buf->first->size == buf->min_size)) {
+        /* already minimized */
+        buf->first->read = 0;
+        buf->first->write = 0;
+        buf->first->count = 0;
+        memset(buf->first->priority_count, 0, sizeof(buf->first->priority_count));
+        buf->count = 0;
+        memset(buf->priority_count, 0, sizeof(buf->priority_count));
+        return MCT_RETURN_OK;
+    }
+
+    seg = mct_buffer_segment_create(buf->min_size);
+
+    if (seg == NULL)
+        return MCT_RETURN_ERROR;
+
+    while (buf->first != NULL) {
+        MctBufferSegment *next = buf->first->next;
+        free(buf->first);
+        buf->first = next;
+    }
+
+    buf->first = seg;
+    buf->last = seg;
+    buf->size = seg->size;
+    buf->count = 0;
+    memset(buf->priority_count, 0, sizeof(buf->priority_count));
+
+    mct_vlog(LOG_DEBUG, "%s: Buffer: Buffer minimized to Size %u bytes\n", __func__, buf->size);
+
+    return MCT_RETURN_OK;
+}
+
+static int mct_buffer_push3_segmented(MctBuffer *buf,
+                                      unsigned char priority,
+                                      const unsigned char *data1,
+                                      unsigned int size1,
+                                      const unsigned char *data2,
+                                      unsigned int size2,
+                                      const unsigned char *data3,
+                                      unsigned int size3)
+{
+    MctBufferSegment *seg = buf->last;
+    MctBufferBlockHead head;
+    uint32_t needed = (uint32_t)sizeof(MctBufferBlockHead) + size1 + size2 + size3;
+    unsigned char *ptr = NULL;
+
+    /* entries are not split, a new segment is started if the entry does not fit */
+    if (seg->size - seg->write < needed) {
+        if (mct_buffer_segment_append(buf, needed) != MCT_RETURN_OK)
+            return MCT_RETURN_ERROR;
+
+        seg = buf->last;
+    }
+
+    /* set header */
+    strncpy(head.head, MCT_BUFFER_HEAD, 4);
+    head.head[3] = 0;
+    head.status = 2;
+    head.priority = priority;
+    head.size = (int)(size1 + size2 + size3);
+
+    /* write data */
+    ptr = seg->mem + seg->write;
+    memcpy(ptr, &head, sizeof(MctBufferBlockHead));
+    ptr += sizeof(MctBufferBlockHead);
+
+    if (size1) {
+        memcpy(ptr, data1, size1);
+        ptr += size1;
+    }
+
+    if (size2) {
+        memcpy(ptr, data2, size2);
+        ptr += size2;
+    }
+
+    if (size3)
+        memcpy(ptr, data3, size3);
+
+    seg->write += needed;
+    seg->count++;
+    seg->priority_count[priority]++;
+    buf->count++;
+    buf->priority_count[priority]++;
+
+    return MCT_RETURN_OK;
+}
+
+/* get and check header of the entry at offset */
+static int mct_buffer_segment_head(MctBufferSegment *seg, uint32_t offset, MctBufferBlockHead *head)
+{
+    char head_compare[] = MCT_BUFFER_HEAD;
+
+    if (seg->write - offset < sizeof(MctBufferBlockHead)) {
+        mct_vlog(LOG_ERR,
+                 "%s: Buffer: Used size is smaller than buffer block header size\n", __func__);
+        return MCT_RETURN_ERROR;
+    }
+
+    memcpy(head, seg->mem + offset, sizeof(MctBufferBlockHead));
+
+    if ((memcmp((unsigned char *)(head->head), head_compare, sizeof(head_compare)) != 0) ||
+        (head->status != 2) || (head->priority >= MCT_BUFFER_PRIORITY_MAX) || (head->size < 0) ||
+        (seg->write - offset - sizeof(MctBufferBlockHead) < (uint32_t)head->size)) {
+        mct_vlog(LOG_ERR, "%s: Buffer: Header check failed\n", __func__);
+        return MCT_RETURN_ERROR;
+    }
+
+    return MCT_RETURN_OK;
+}
+
+/* drop all entries of a priority from a segment and give the space back,
+ * returns the link to the segment behind it or NULL on error */
+static MctBufferSegment **mct_buffer_segment_evict(MctBuffer *buf,
+                                                  MctBufferSegment **link,
+                                                  unsigned char priority,
+                                                  unsigned int *evicted)
+{
+    MctBufferSegment *seg = *link;
+    MctBufferSegment *shrunk = NULL;
+    MctBufferBlockHead head;
+    uint32_t src = seg->read;
+    uint32_t dst = 0;
+    uint32_t len = 0;
+
+    while (src < seg->write) {
+        if (mct_buffer_segment_head(seg, src, &head) != MCT_RETURN_OK) {
+            mct_buffer_reset(buf);
+            return NULL;
+        }
+
+        len = (uint32_t)sizeof(MctBufferBlockHead) + (uint32_t)head.size;
+
+        if (head.priority == priority) {
+            seg->count--;
+            seg->priority_count[priority]--;
+            buf->count--;
+            buf->priority_count[priority]--;
+            evicted[priority]++;
+        }
+        else {
+            if (dst != src)
+                memmove(seg->mem + dst, seg->mem + src, len);
+
+            dst += len;
+        }
+
+        src += len;
+    }
+
+    seg->read = 0;
+    seg->write = dst;
+
+    /* the newest segment is written behind the remaining entries */
+    if (seg == buf->last)
+        return &seg->next;
+
+    if (seg->count == 0) {
+        *link = seg->next;
+        buf->size -= seg->size;
+        free(seg);
+        return link;
+    }
+
+    shrunk = realloc(seg, sizeof(MctBufferSegment) + dst);
+
+    if (shrunk != NULL) {
+        shrunk->mem = (unsigned char *)(shrunk + 1);
+        buf->size -= shrunk->size - dst;
+        shrunk->size = dst;
+        *link = shrunk;
+    }
+
+    return &(*link)->next;
+}
+
+static int mct_buffer_get_segmented(MctBuffer *buf, unsigned char *data, int max_size, int delete)
+{
+    MctBufferSegment *seg = NULL;
+    MctBufferBlockHead head;
+
+    /* check if data is in there */
+    if (buf->count <= 0)
+        return MCT_RETURN_ERROR;
+
+    mct_buffer_segment_release(buf);
+    seg = buf->first;
+
+    if (mct_buffer_segment_head(seg, seg->read, &head) != MCT_RETURN_OK) {
+        mct_buffer_reset(buf);
+        return MCT_RETURN_ERROR;
+    }
+
+    if ((data != NULL) && max_size) {
+        if (head.size > max_size) {
+            mct_vlog(LOG_WARNING,
+                     "%s: Buffer: Max size is smaller than read header size. Max size: %d\n",
+                     __func__, max_size);
+            return MCT_RETURN_ERROR;
+        }
+
+        memcpy(data, seg->mem + seg->read + sizeof(MctBufferBlockHead), (size_t)head.size);
+    }
+
+    if (delete) {
+        seg->read += (uint32_t)sizeof(MctBufferBlockHead) + (uint32_t)head.size;
+        seg->count--;
+        seg->priority_count[head.priority]--;
+        buf->count--;
+        buf->priority_count[head.priority]--;
+
+        if (buf->count == 0)
+            /* try to minimize size */
+            mct_buffer_segment_minimize(buf);
+        else
+            mct_buffer_segment_release(buf);
+    }
+
+    return head.size;
+}
+
+static int mct_buffer_get_vector_segmented(MctBuffer *buf, struct iovec *iov,
+                                           int max_count, int max_size)
+{
+    MctBufferSegment *seg = NULL;
+    MctBufferBlockHead head;
+    uint32_t offset = 0;
+    int num = 0;
+    int total = 0;
+
+    if (buf->count <= 0)
+        return 0;
+
+    mct_buffer_segment_release(buf);
+
+    for (seg = buf->first; (seg != NULL) && (num < max_count); seg = seg->next) {
+        offset = seg->read;
+
+        while ((offset < seg->write) && (num < max_count)) {
+            if (mct_buffer_segment_head(seg, offset, &head) != MCT_RETURN_OK)
+                return (num > 0) ? num : MCT_RETURN_ERROR;
+
+            if ((num > 0) && (total + head.size > max_size))
+                return num;
+
+            iov[2 * num].iov_base = seg->mem + offset + sizeof(MctBufferBlockHead);
+            iov[2 * num].iov_len = (size_t)head.size;
+            iov[2 * num + 1].iov_base = NULL;
+            iov[2 * num + 1].iov_len = 0;
+
+            offset += (uint32_t)sizeof(MctBufferBlockHead) + (uint32_t)head.size;
+            total += head.size;
+            num++;
+        }
+    }
+
+    return num;
+}
+
 MctReturnValue mct_buffer_init_dynamic(MctBuffer *buf, uint32_t min_size, uint32_t max_size, uint32_t step_size)
 {
     /*Do not MCT_SEM_LOCK inside here! */
-    MctBufferHead *head;
 
     /* catch null pointer */
     if (buf == NULL)
@@ -2286,39 +2804,27 @@ MctReturnValue mct_buffer_init_dynamic(MctBuffer *buf, uint32_t min_size, uint32
     buf->min_size = min_size;
     buf->max_size = max_size;
     buf->step_size = step_size;
+    buf->shm = NULL;
+    buf->mem = NULL;
+    buf->count = 0;
+    memset(buf->priority_count, 0, sizeof(buf->priority_count));
 
-    /* allocat memory */
-    buf->shm = malloc(buf->min_size);
+    /* allocate first segment */
+    buf->first = mct_buffer_segment_create(buf->min_size);
 
-    if (buf->shm == NULL) {
+    if (buf->first == NULL) {
         mct_vlog(LOG_EMERG,
                  "%s: Buffer: Cannot allocate %u bytes\n",
                  __func__, buf->min_size);
         return MCT_RETURN_ERROR;
     }
 
-    /* Init pointers */
-    head = (MctBufferHead *)buf->shm;
-    head->read = 0;
-    head->write = 0;
-    head->count = 0;
-    buf->mem = (unsigned char *)(buf->shm + sizeof(MctBufferHead));
-
-    if (buf->min_size < (uint32_t)sizeof(MctBufferHead)) {
-        mct_vlog(LOG_ERR,
-                 "%s: min_size is too small [%u]\n",
-                 __func__, buf->min_size);
-        return MCT_RETURN_WRONG_PARAMETER;
-    }
-
-    buf->size = (uint32_t)(buf->min_size - sizeof(MctBufferHead));
+    buf->last = buf->first;
+    buf->size = buf->min_size;
 
     mct_vlog(LOG_DEBUG,
              "%s: Buffer: Size %u, Start address %lX\n",
-             __func__, buf->size, (unsigned long)buf->mem);
-
-    /* clear memory */
-    memset(buf->mem, 0, (size_t)buf->size);
+             __func__, buf->size, (unsigned long)buf->first->mem);
 
     return MCT_RETURN_OK; /* OK */
 }
@@ -2344,15 +2850,21 @@ MctReturnValue mct_buffer_free_dynamic(MctBuffer *buf)
     if (buf == NULL)
         return MCT_RETURN_WRONG_PARAMETER;
 
-    if (buf->shm == NULL) {
+    if (buf->first == NULL) {
         /* buffer not initialized */
         mct_vlog(LOG_WARNING, "%s: Buffer: Buffer not initialized\n", __func__);
         return MCT_RETURN_ERROR; /* ERROR */
     }
 
-    free(buf->shm);
-    buf->shm = NULL;
-    buf->mem = NULL;
+    while (buf->first != NULL) {
+        MctBufferSegment *next = buf->first->next;
+        free(buf->first);
+        buf->first = next;
+    }
+
+    buf->last = NULL;
+    buf->count = 0;
+    memset(buf->priority_count, 0, sizeof(buf->priority_count));
 
     return MCT_RETURN_OK;
 }
@@ -2419,6 +2931,17 @@ int mct_buffer_check_size(MctBuffer *buf, int needed)
     if (buf == NULL)
         return MCT_RETURN_WRONG_PARAMETER;
 
+    if (buf->first != NULL) {
+        uint32_t entry = (uint32_t)sizeof(MctBufferBlockHead) + (uint32_t)needed;
+
+        /* fits into newest segment or into a new one */
+        if ((buf->last->size - buf->last->write >= entry) ||
+            (buf->size + ((entry > buf->step_size) ? entry : buf->step_size) <= buf->max_size))
+            return MCT_RETURN_OK;
+
+        return MCT_RETURN_ERROR;
+    }
+
     if ((buf->size + sizeof(MctBufferHead) + needed) > buf->max_size)
         return MCT_RETURN_ERROR;
 
@@ -2436,6 +2959,10 @@ int mct_buffer_increase_size(MctBuffer *buf)
         return MCT_RETURN_WRONG_PARAMETER;
     }
 
+    /* segmented buffer: append a segment, nothing is copied */
+    if (buf->first != NULL)
+        return mct_buffer_segment_append(buf, 0);
+
     /* check size */
     if (buf->step_size == 0)
         /* cannot increase size */
@@ -2501,6 +3028,9 @@ int mct_buffer_minimize_size(MctBuffer *buf)
         return MCT_RETURN_WRONG_PARAMETER;
     }
 
+    if (buf->first != NULL)
+        return mct_buffer_segment_minimize(buf);
+
     if ((buf->size + sizeof(MctBufferHead)) == buf->min_size)
         /* already minimized */
         return MCT_RETURN_OK;
@@ -2550,6 +3080,25 @@ int mct_buffer_reset(MctBuffer *buf)
              "%s: Buffer: Buffer reset triggered. Size: %u, Start address: %lX\n",
              __func__, buf->size, (unsigned long)buf->mem);
 
+    if (buf->first != NULL) {
+        /* drop all entries, keep the newest segment */
+        while (buf->first != buf->last) {
+            MctBufferSegment *next = buf->first->next;
+            buf->size -= buf->first->size;
+            free(buf->first);
+            buf->first = next;
+        }
+
+        buf->first->read = 0;
+        buf->first->write = 0;
+        buf->first->count = 0;
+        memset(buf->first->priority_count, 0, sizeof(buf->first->priority_count));
+        buf->count = 0;
+        memset(buf->priority_count, 0, sizeof(buf->priority_count));
+
+        return MCT_RETURN_OK;
+    }
+
     /* reset pointers and counters */
     ((int *)(buf->shm))[0] = 0;  /* pointer to write memory */
     ((int *)(buf->shm))[1] = 0;  /* pointer to read memory */
@@ -2573,6 +3122,18 @@ int mct_buffer_push3(MctBuffer *buf,
                      unsigned int size2,
                      const unsigned char *data3,
                      unsigned int size3)
+{
+    return mct_buffer_push3_priority(buf, 0, data1, size1, data2, size2, data3, size3);
+}
+
+MctReturnValue mct_buffer_push3_priority(MctBuffer *buf,
+                                         unsigned char priority,
+                                         const unsigned char *data1,
+                                         unsigned int size1,
+                                         const unsigned char *data2,
+                                         unsigned int size2,
+                                         const unsigned char *data3,
+                                         unsigned int size3)
 {
     int free_size;
     int write, read, count;
@@ -2582,6 +3143,12 @@ int mct_buffer_push3(MctBuffer *buf,
     if (buf == NULL)
         return MCT_RETURN_WRONG_PARAMETER;
 
+    if (priority >= MCT_BUFFER_PRIORITY_MAX)
+        return MCT_RETURN_WRONG_PARAMETER;
+
+    if (buf->first != NULL)
+        return mct_buffer_push3_segmented(buf, priority, data1, size1, data2, size2, data3, size3);
+
     if (buf->shm == NULL) {
         /* buffer not initialised */
         mct_vlog(LOG_ERR, "%s: Buffer: Buffer not initialized\n", __func__);
@@ -2635,6 +3202,7 @@ int mct_buffer_push3(MctBuffer *buf,
     strncpy(head.head, MCT_BUFFER_HEAD, 4);
     head.head[3] = 0;
     head.status = 2;
+    head.priority = priority;
     head.size = (int)(size1 + size2 + size3);
 
     /* write data */
@@ -2657,6 +3225,40 @@ int mct_buffer_push3(MctBuffer *buf,
 
 }
 
+MctReturnValue mct_buffer_evict(MctBuffer *buf, unsigned char priority, int needed,
+                                unsigned int *evicted)
+{
+    MctBufferSegment **link = NULL;
+    int p = 0;
+
+    /* catch null pointer */
+    if ((buf == NULL) || (evicted == NULL))
+        return MCT_RETURN_WRONG_PARAMETER;
+
+    /* only entries of dynamic ringbuffers can be removed out of order */
+    if (buf->first == NULL)
+        return MCT_RETURN_ERROR;
+
+    for (p = MCT_BUFFER_PRIORITY_MAX - 1; p > (int)priority; p--) {
+        link = &buf->first;
+
+        while ((buf->priority_count[p] > 0) && (*link != NULL)) {
+            if (mct_buffer_check_size(buf, needed) == MCT_RETURN_OK)
+                return MCT_RETURN_OK;
+
+            if ((*link)->priority_count[p] > 0)
+                link = mct_buffer_segment_evict(buf, link, (unsigned char)p, evicted);
+            else
+                link = &(*link)->next;
+
+            if (link == NULL)
+                return MCT_RETURN_ERROR;
+        }
+    }
+
+    return mct_buffer_check_size(buf, needed);
+}
+
 int mct_buffer_get(MctBuffer *buf, unsigned char *data, int max_size, int delete)
 {
     int used_size;
@@ -2668,6 +3270,9 @@ int mct_buffer_get(MctBuffer *buf, unsigned char *data, int max_size, int delete
     if (buf == NULL)
         return MCT_RETURN_WRONG_PARAMETER;
 
+    if (buf->first != NULL)
+        return mct_buffer_get_segmented(buf, data, max_size, delete);
+
     if (buf->shm == NULL) {
         /* shm not initialised */
         mct_vlog(LOG_ERR, "%s: Buffer: SHM not initialized\n", __func__);
@@ -2792,6 +3397,84 @@ int mct_buffer_remove(MctBuffer *buf)
     return mct_buffer_get(buf, 0, 0, 1);
 }
 
+int mct_buffer_get_vector(MctBuffer *buf, struct iovec *iov, int max_count, int max_size)
+{
+    int used_size;
+    int write, read, count;
+    int num = 0;
+    int total = 0;
+    int part = 0;
+    char head_compare[] = MCT_BUFFER_HEAD;
+    MctBufferBlockHead head;
+
+    /* catch null pointer */
+    if ((buf == NULL) || (iov == NULL) || (max_count <= 0))
+        return MCT_RETURN_WRONG_PARAMETER;
+
+    if (buf->first != NULL)
+        return mct_buffer_get_vector_segmented(buf, iov, max_count, max_size);
+
+    if (buf->shm == NULL)
+        return MCT_RETURN_ERROR;
+
+    write = ((int *)(buf->shm))[0];
+    read = ((int *)(buf->shm))[1];
+    count = ((int *)(buf->shm))[2];
+
+    /* check pointers */
+    if (((unsigned int)read > buf->size) || ((unsigned int)write > buf->size) || (count < 0)) {
+        mct_vlog(LOG_ERR,
+                 "%s: Buffer: Pointer out of range. Read: %d, Write: %d, Count: %d, Size: %u\n",
+                 __func__, read, write, count, buf->size);
+        return MCT_RETURN_ERROR;
+    }
+
+    if (count == 0)
+        return 0;
+
+    /* calculate used size */
+    if (write > read)
+        used_size = write - read;
+    else
+        used_size = (int)buf->size - read + write;
+
+    while ((num < count) && (num < max_count)) {
+        if (used_size < (int)sizeof(MctBufferBlockHead))
+            break;
+
+        mct_buffer_read_block(buf, &read, (unsigned char *)&head, sizeof(MctBufferBlockHead));
+
+        if ((memcmp((unsigned char *)(head.head), head_compare, sizeof(head_compare)) != 0) ||
+            (head.status != 2) || (head.size < 0) ||
+            (used_size < ((int)sizeof(MctBufferBlockHead) + head.size))) {
+            mct_vlog(LOG_ERR, "%s: Buffer: Header check failed\n", __func__);
+            return (num > 0) ? num : MCT_RETURN_ERROR;
+        }
+
+        if ((num > 0) && (total + head.size > max_size))
+            break;
+
+        if ((unsigned int)read == buf->size)
+            read = 0;
+
+        /* size of the part before the end of the ringbuffer */
+        part = ((unsigned int)(read + head.size) <= buf->size) ?
+            head.size : ((int)buf->size - read);
+
+        iov[2 * num].iov_base = buf->mem + read;
+        iov[2 * num].iov_len = (size_t)part;
+        iov[2 * num + 1].iov_base = buf->mem;
+        iov[2 * num + 1].iov_len = (size_t)(head.size - part);
+
+        read = (part == head.size) ? (read + head.size) : (head.size - part);
+        used_size -= (int)sizeof(MctBufferBlockHead) + head.size;
+        total += head.size;
+        num++;
+    }
+
+    return num;
+}
+
 void mct_buffer_info(MctBuffer *buf)
 {
     /* check nullpointer */
@@ -2815,6 +3498,17 @@ void mct_buffer_status(MctBuffer *buf)
         return;
     }
 
+    if (buf->first != NULL) {
+        MctBufferSegment *seg = NULL;
+
+        for (seg = buf->first; seg != NULL; seg = seg->next)
+            mct_vlog(LOG_DEBUG,
+                     "Buffer: Segment Size: %u, Write: %u, Read: %u, Count: %d\n",
+                     seg->size, seg->write, seg->read, seg->count);
+
+        return;
+    }
+
     /* check if buffer available */
     if (buf->shm == NULL)
         return;
@@ -2845,6 +3539,16 @@ int mct_buffer_get_used_size(MctBuffer *buf)
     if (buf == NULL)
         return MCT_RETURN_WRONG_PARAMETER;
 
+    if (buf->first != NULL) {
+        MctBufferSegment *seg = NULL;
+        int used = 0;
+
+        for (seg = buf->first; seg != NULL; seg = seg->next)
+            used += (int)(seg->write - seg->read);
+
+        return used;
+    }
+
     /* check if buffer available */
     if (buf->shm == NULL)
         return MCT_RETURN_OK;
@@ -2868,6 +3572,9 @@ int mct_buffer_get_message_count(MctBuffer *buf)
     if (buf == NULL)
         return MCT_RETURN_WRONG_PARAMETER;
 
+    if (buf->first != NULL)
+        return buf->count;
+
     /* check if buffer available */
     if (buf->shm == NULL)
         return MCT_RETURN_OK;
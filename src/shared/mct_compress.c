@@ -0,0 +1,365 @@
+#include "mct_compress.h"
+#include <string.h>
+
+/* internal defines */
+#define MCT_COMPRESS_HASH_LOG      12
+#define MCT_COMPRESS_HASH_SIZE     (1 << MCT_COMPRESS_HASH_LOG)
+#define MCT_COMPRESS_MIN_MATCH     4
+#define MCT_COMPRESS_MAX_OFFSET    65535
+/* the LZ4 block format ends with literals: the last match starts at least
+ * 12 bytes and ends at least 5 bytes before the end of the input */
+#define MCT_COMPRESS_MF_LIMIT      12
+#define MCT_COMPRESS_LAST_LITERALS 5
+
+static const char mct_block_pattern[MCT_BLOCK_PATTERN_SIZE] = MCT_BLOCK_PATTERN;
+
+static uint32_t mct_compress_read32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+static uint32_t mct_compress_hash(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - MCT_COMPRESS_HASH_LOG);
+}
+
+/**
+ * mct_compress_length
+ *
+ * Write the continuation bytes of a literal or match length.
+ *
+ * @param op       Output position
+ * @param len      Length minus the 15 already stored in the token
+ * @return         Output position after the length
+ */
+static uint8_t *mct_compress_length(uint8_t *op, int len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+
+    *op++ = (uint8_t)len;
+
+    return op;
+}
+
+/**
+ * mct_compress_sequence
+ *
+ * Write one sequence of literals, optionally followed by a match.
+ *
+ * @param op        Output position
+ * @param end       End of output
+ * @param literals  Start of literals
+ * @param lit_len   Number of literals
+ * @param offset    Offset of match, 0 for the last sequence without match
+ * @param match_len Length of match
+ * @return          Output position after the sequence, NULL if output is full
+ */
+static uint8_t *mct_compress_sequence(uint8_t *op,
+                                      uint8_t *end,
+                                      const uint8_t *literals,
+                                      int lit_len,
+                                      int offset,
+                                      int match_len)
+{
+    uint8_t *token = op;
+    int ml = match_len - MCT_COMPRESS_MIN_MATCH;
+    int needed = 1 + lit_len;
+
+    /* token, literal length, literals, offset, match length */
+    if (lit_len >= 15)
+        needed += (lit_len - 15) / 255 + 1;
+
+    if (offset != 0) {
+        needed += 2;
+
+        if (ml >= 15)
+            needed += (ml - 15) / 255 + 1;
+    }
+
+    if (end - op < needed)
+        return NULL;
+
+    op++;
+    *token = (uint8_t)((lit_len >= 15 ? 15 : lit_len) << 4);
+
+    if (lit_len >= 15)
+        op = mct_compress_length(op, lit_len - 15);
+
+    memcpy(op, literals, (size_t)lit_len);
+    op += lit_len;
+
+    if (offset == 0)
+        return op;
+
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+
+    *token |= (uint8_t)(ml >= 15 ? 15 : ml);
+
+    if (ml >= 15)
+        op = mct_compress_length(op, ml - 15);
+
+    return op;
+}
+
+int mct_compress_bound(int size)
+{
+    return size + size / 255 + 16;
+}
+
+int mct_compress(const uint8_t *src, int size, uint8_t *dst, int capacity)
+{
+    uint32_t table[MCT_COMPRESS_HASH_SIZE];
+    uint8_t *op = dst;
+    uint8_t *end = dst + capacity;
+    int ip = 0;
+    int anchor = 0;
+    int limit = size - MCT_COMPRESS_MF_LIMIT;
+    int match_limit = size - MCT_COMPRESS_LAST_LITERALS;
+
+    if ((src == NULL) || (dst == NULL) || (size < 0) || (capacity <= 0))
+        return 0;
+
+    memset(table, 0, sizeof(table));
+
+    while (ip < limit) {
+        uint32_t v = mct_compress_read32(src + ip);
+        uint32_t h = mct_compress_hash(v);
+        int ref = (int)table[h];
+        int len = MCT_COMPRESS_MIN_MATCH;
+
+        table[h] = (uint32_t)ip;
+
+        if ((ref >= ip) || (ip - ref > MCT_COMPRESS_MAX_OFFSET) ||
+            (mct_compress_read32(src + ref) != v)) {
+            ip++;
+            continue;
+        }
+
+        /* extend match backwards into pending literals */
+        while ((ip > anchor) && (ref > 0) && (src[ip - 1] == src[ref - 1])) {
+            ip--;
+            ref--;
+            len++;
+        }
+
+        /* extend match forwards */
+        while ((ip + len < match_limit) && (src[ip + len] == src[ref + len]))
+            len++;
+
+        op = mct_compress_sequence(op, end, src + anchor, ip - anchor, ip - ref, len);
+
+        if (op == NULL)
+            return 0;
+
+        ip += len;
+        anchor = ip;
+
+        /* position inside the match helps the next search */
+        if (ip - 2 < limit)
+            table[mct_compress_hash(mct_compress_read32(src + ip - 2))] = (uint32_t)(ip - 2);
+    }
+
+    op = mct_compress_sequence(op, end, src + anchor, size - anchor, 0, 0);
+
+    if (op == NULL)
+        return 0;
+
+    return (int)(op - dst);
+}
+
+int mct_decompress(const uint8_t *src, int size, uint8_t *dst, int capacity)
+{
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + size;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + capacity;
+
+    if ((src == NULL) || (dst == NULL) || (size <= 0) || (capacity < 0))
+        return -1;
+
+    while (ip < iend) {
+        unsigned int token = *ip++;
+        size_t len = token >> 4;
+        size_t offset;
+
+        if (len == 15) {
+            unsigned int b;
+
+            do {
+                if (ip >= iend)
+                    return -1;
+
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+
+        if (((size_t)(iend - ip) < len) || ((size_t)(oend - op) < len))
+            return -1;
+
+        memcpy(op, ip, len);
+        ip += len;
+        op += len;
+
+        /* last sequence has no match */
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return -1;
+
+        offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+
+        if ((offset == 0) || (offset > (size_t)(op - dst)))
+            return -1;
+
+        len = token & 0x0F;
+
+        if (len == 15) {
+            unsigned int b;
+
+            do {
+                if (ip >= iend)
+                    return -1;
+
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+
+        len += MCT_COMPRESS_MIN_MATCH;
+
+        if ((size_t)(oend - op) < len)
+            return -1;
+
+        if (offset >= len) {
+            memcpy(op, op - offset, len);
+            op += len;
+        }
+        else {
+            /* overlapping match repeats the last offset bytes */
+            while (len--) {
+                *op = *(op - offset);
+                op++;
+            }
+        }
+    }
+
+    return (int)(op - dst);
+}
+
+/**
+ * mct_block_message_size
+ *
+ * Get the size of the MCT message with storage header at the start of a
+ * buffer.
+ *
+ * @param src       Buffer
+ * @param size      Size of buffer
+ * @return          Size of message, size of buffer if no complete message is found
+ */
+static int mct_block_message_size(const uint8_t *src, int size)
+{
+    const MctStandardHeader *standardheader = NULL;
+    int len = 0;
+
+    if (size < (int)(sizeof(MctStorageHeader) + sizeof(MctStandardHeader)))
+        return size;
+
+    standardheader = (const MctStandardHeader *)(src + sizeof(MctStorageHeader));
+    len = (int)sizeof(MctStorageHeader) + MCT_BETOH_16(standardheader->len);
+
+    if ((len <= (int)sizeof(MctStorageHeader)) || (len > size))
+        return size;
+
+    return len;
+}
+
+int mct_block_split(const uint8_t *src, int size)
+{
+    int offset = 0;
+
+    if ((src == NULL) || (size <= 0))
+        return 0;
+
+    offset = mct_block_message_size(src, size);
+
+    while (offset < size) {
+        int len = mct_block_message_size(src + offset, size - offset);
+
+        if (offset + len > MCT_BLOCK_SIZE)
+            break;
+
+        offset += len;
+    }
+
+    /* no message boundary found */
+    if (offset > (int)MCT_BLOCK_SIZE_MAX)
+        offset = MCT_BLOCK_SIZE;
+
+    return offset;
+}
+
+int mct_block_encode(const uint8_t *src, int size, uint8_t *dst)
+{
+    MctBlockHeader header;
+    const MctStorageHeader *storageheader = NULL;
+    int offset = 0;
+    int len = 0;
+    uint32_t count = 0;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.pattern, mct_block_pattern, MCT_BLOCK_PATTERN_SIZE);
+
+    /* collect time range and number of messages */
+    while (offset < size) {
+        len = mct_block_message_size(src + offset, size - offset);
+
+        if (len >= (int)sizeof(MctStorageHeader)) {
+            storageheader = (const MctStorageHeader *)(src + offset);
+
+            if (count == 0) {
+                header.first_seconds = MCT_HTOLE_32(storageheader->seconds);
+                header.first_microseconds = (int32_t)MCT_HTOLE_32(storageheader->microseconds);
+            }
+
+            header.last_seconds = MCT_HTOLE_32(storageheader->seconds);
+            header.last_microseconds = (int32_t)MCT_HTOLE_32(storageheader->microseconds);
+        }
+
+        offset += len;
+        count++;
+    }
+
+    len = mct_compress(src, size, dst + sizeof(header), mct_compress_bound(size));
+
+    /* store data which does not compress */
+    if ((len <= 0) || (len >= size)) {
+        memcpy(dst + sizeof(header), src, (size_t)size);
+        len = size;
+    }
+
+    header.size = MCT_HTOLE_32((uint32_t)len);
+    header.raw_size = MCT_HTOLE_32((uint32_t)size);
+    header.count = MCT_HTOLE_32(count);
+    memcpy(dst, &header, sizeof(header));
+
+    return (int)sizeof(header) + len;
+}
+
+int mct_block_is_header(const void *src)
+{
+    if (src == NULL)
+        return 0;
+
+    return memcmp(src, mct_block_pattern, MCT_BLOCK_PATTERN_SIZE) == 0;
+}
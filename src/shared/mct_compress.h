@@ -0,0 +1,111 @@
+#ifndef _MCT_COMPRESS_H_
+#define _MCT_COMPRESS_H_
+
+#include <stdint.h>
+#include "mct_common.h"
+
+/* Compressed MCT files consist of blocks, each holding complete MCT messages
+ * with storage header. Every block starts with a MctBlockHeader followed by
+ * the block data, compressed with the LZ4 block format or stored as is if it
+ * does not compress. The block headers also record the time range of the
+ * messages, but mct_file_open decodes all blocks and does not seek by it,
+ * selecting blocks by time is done with the index files of mct_index.h. */
+
+/* pattern of block header */
+#define MCT_BLOCK_PATTERN      { 'D', 'L', 'Z', 0x01 }
+#define MCT_BLOCK_PATTERN_SIZE 4
+
+/* blocks are cut at message boundaries once they exceed this size */
+#define MCT_BLOCK_SIZE         (64 * 1024)
+/* largest block data accepted by readers, a single message may exceed MCT_BLOCK_SIZE */
+#define MCT_BLOCK_SIZE_MAX     (MCT_BLOCK_SIZE + sizeof(MctStorageHeader) + UINT16_MAX)
+
+/**
+ * The header of each block of a compressed MCT file.
+ * All values are little endian.
+ */
+typedef struct
+{
+    char pattern[MCT_BLOCK_PATTERN_SIZE]; /**< This pattern should be DLZ0x01 */
+    uint32_t size;                        /**< size of block data in file */
+    uint32_t raw_size;                    /**< size of messages, equal to size if stored uncompressed */
+    uint32_t count;                       /**< number of messages in block */
+    uint32_t first_seconds;               /**< time of first message, seconds since 1.1.1970 */
+    int32_t first_microseconds;           /**< time of first message, microseconds */
+    uint32_t last_seconds;                /**< time of last message, seconds since 1.1.1970 */
+    int32_t last_microseconds;            /**< time of last message, microseconds */
+} MCT_PACKED MctBlockHeader;
+
+/**
+ * mct_compress_bound
+ *
+ * Maximum size of compressed data for input of the given size.
+ *
+ * @param size      Size of input
+ * @return          Size of output buffer which is always sufficient
+ */
+int mct_compress_bound(int size);
+
+/**
+ * mct_compress
+ *
+ * Compress a buffer with the LZ4 block format.
+ *
+ * @param src       Input
+ * @param size      Size of input
+ * @param dst       Output
+ * @param capacity  Size of output buffer
+ * @return          Size of compressed data, 0 if it does not fit into output
+ */
+int mct_compress(const uint8_t *src, int size, uint8_t *dst, int capacity);
+
+/**
+ * mct_decompress
+ *
+ * Decompress a buffer in LZ4 block format. Corrupted input is detected
+ * and never read or written beyond the given buffers.
+ *
+ * @param src       Input
+ * @param size      Size of input
+ * @param dst       Output
+ * @param capacity  Size of output buffer
+ * @return          Size of decompressed data, -1 on corrupted input
+ */
+int mct_decompress(const uint8_t *src, int size, uint8_t *dst, int capacity);
+
+/**
+ * mct_block_encode
+ *
+ * Build a block of a compressed MCT file from complete MCT messages with
+ * storage header.
+ *
+ * @param src       Messages
+ * @param size      Size of messages
+ * @param dst       Output, at least sizeof(MctBlockHeader) + mct_compress_bound(size)
+ * @return          Size of block including header
+ */
+int mct_block_encode(const uint8_t *src, int size, uint8_t *dst);
+
+/**
+ * mct_block_split
+ *
+ * Get the size of the leading messages of a buffer that make up one block,
+ * i.e. as many complete messages as fit into MCT_BLOCK_SIZE, at least one.
+ *
+ * @param src       Messages
+ * @param size      Size of messages
+ * @return          Size of the messages of the first block
+ */
+int mct_block_split(const uint8_t *src, int size);
+
+/**
+ * mct_block_is_header
+ *
+ * Check if a buffer starts with a block header.
+ *
+ * @param src       Buffer of at least MCT_BLOCK_PATTERN_SIZE bytes
+ * @return          1 if a block header is found, 0 otherwise
+ */
+int mct_block_is_header(const void *src);
+
+#endif
@@ -0,0 +1,338 @@
+#include "mct_index.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "mct_common_cfg.h"
+
+static const char mct_index_pattern[MCT_INDEX_PATTERN_SIZE] = MCT_INDEX_PATTERN;
+
+/**
+ * mct_index_id_bit
+ *
+ * Get the bit of an application id, context id or pair of both in the
+ * id bitmap. An empty id stands for any id.
+ *
+ * @param apid      Application id or NULL
+ * @param ctid      Context id or NULL
+ * @return          Bit in id bitmap
+ */
+static unsigned int mct_index_id_bit(const char *apid, const char *ctid)
+{
+    uint8_t key[2 * MCT_ID_SIZE] = { 0 };
+    uint32_t hash = 2166136261U;
+    unsigned int i;
+
+    if (apid != NULL)
+        memcpy(key, apid, MCT_ID_SIZE);
+
+    if (ctid != NULL)
+        memcpy(key + MCT_ID_SIZE, ctid, MCT_ID_SIZE);
+
+    for (i = 0; i < sizeof(key); i++) {
+        hash ^= key[i];
+        hash *= 16777619U;
+    }
+
+    return hash % MCT_INDEX_ID_BITS;
+}
+
+static void mct_index_set_bit(MctIndexEntry *entry, unsigned int bit)
+{
+    entry->ids[bit / 8] |= (uint8_t)(1 << (bit % 8));
+}
+
+static int mct_index_get_bit(const MctIndexEntry *entry, unsigned int bit)
+{
+    return (entry->ids[bit / 8] >> (bit % 8)) & 1;
+}
+
+/**
+ * mct_index_time_before
+ *
+ * Compare two storage times.
+ *
+ * @return          1 if the first time is before the second one, 0 otherwise
+ */
+static int mct_index_time_before(uint32_t seconds1, int32_t microseconds1,
+                                 uint32_t seconds2, int32_t microseconds2)
+{
+    return (seconds1 < seconds2) ||
+           ((seconds1 == seconds2) && (microseconds1 < microseconds2));
+}
+
+/**
+ * mct_index_entry_convert
+ *
+ * Convert an index entry between host and little endian byte order.
+ *
+ * @param dst       Converted entry
+ * @param src       Entry
+ */
+static void mct_index_entry_convert(MctIndexEntry *dst, const MctIndexEntry *src)
+{
+    if (dst != src)
+        memcpy(dst, src, sizeof(*dst));
+
+    dst->flags = MCT_HTOLE_32(src->flags);
+    dst->offset = MCT_HTOLE_32(src->offset);
+    dst->size = MCT_HTOLE_32(src->size);
+    dst->raw_size = MCT_HTOLE_32(src->raw_size);
+    dst->count = MCT_HTOLE_32(src->count);
+    dst->min_seconds = MCT_HTOLE_32(src->min_seconds);
+    dst->min_microseconds = (int32_t)MCT_HTOLE_32((uint32_t)src->min_microseconds);
+    dst->max_seconds = MCT_HTOLE_32(src->max_seconds);
+    dst->max_microseconds = (int32_t)MCT_HTOLE_32((uint32_t)src->max_microseconds);
+    dst->min_tmsp = MCT_HTOLE_32(src->min_tmsp);
+    dst->max_tmsp = MCT_HTOLE_32(src->max_tmsp);
+}
+
+void mct_index_entry_init(MctIndexEntry *entry, uint32_t offset, uint32_t flags)
+{
+    if (entry == NULL)
+        return;
+
+    memset(entry, 0, sizeof(*entry));
+    memcpy(entry->pattern, mct_index_pattern, MCT_INDEX_PATTERN_SIZE);
+    entry->flags = flags;
+    entry->offset = offset;
+    entry->min_tmsp = UINT32_MAX;
+}
+
+void mct_index_entry_add(MctIndexEntry *entry,
+                         const MctStorageHeader *storage,
+                         const uint8_t *header,
+                         int size)
+{
+    const MctStandardHeader *standardheader = (const MctStandardHeader *)header;
+    const MctExtendedHeader *extendedheader = NULL;
+    uint32_t tmsp = 0;
+    int extra = 0;
+
+    if ((entry == NULL) || (storage == NULL) || (header == NULL) ||
+        (size < (int)sizeof(MctStandardHeader)))
+        return;
+
+    if ((entry->count == 0) ||
+        mct_index_time_before(storage->seconds, storage->microseconds,
+                              entry->min_seconds, entry->min_microseconds)) {
+        entry->min_seconds = storage->seconds;
+        entry->min_microseconds = storage->microseconds;
+    }
+
+    if ((entry->count == 0) ||
+        mct_index_time_before(entry->max_seconds, entry->max_microseconds,
+                              storage->seconds, storage->microseconds)) {
+        entry->max_seconds = storage->seconds;
+        entry->max_microseconds = storage->microseconds;
+    }
+
+    entry->count++;
+
+    extra = (int)sizeof(MctStandardHeader) +
+        (MCT_IS_HTYP_WEID(standardheader->htyp) ? (int)MCT_SIZE_WEID : 0) +
+        (MCT_IS_HTYP_WSID(standardheader->htyp) ? (int)MCT_SIZE_WSID : 0);
+
+    if (MCT_IS_HTYP_WTMS(standardheader->htyp) && (size >= extra + (int)MCT_SIZE_WTMS)) {
+        memcpy(&tmsp, header + extra, sizeof(tmsp));
+        tmsp = MCT_BETOH_32(tmsp);
+
+        if (tmsp < entry->min_tmsp)
+            entry->min_tmsp = tmsp;
+
+        if (tmsp > entry->max_tmsp)
+            entry->max_tmsp = tmsp;
+    }
+
+    extra = (int)sizeof(MctStandardHeader) +
+        (int)MCT_STANDARD_HEADER_EXTRA_SIZE(standardheader->htyp);
+
+    if (!MCT_IS_HTYP_UEH(standardheader->htyp) ||
+        (size < extra + (int)sizeof(MctExtendedHeader))) {
+        /* such messages pass every filter */
+        entry->flags |= MCT_INDEX_FLAG_NO_UEH;
+        return;
+    }
+
+    extendedheader = (const MctExtendedHeader *)(header + extra);
+    mct_index_set_bit(entry, mct_index_id_bit(extendedheader->apid, extendedheader->ctid));
+    mct_index_set_bit(entry, mct_index_id_bit(extendedheader->apid, NULL));
+    mct_index_set_bit(entry, mct_index_id_bit(NULL, extendedheader->ctid));
+}
+
+void mct_index_entry_merge(MctIndexEntry *entry, const MctIndexEntry *block)
+{
+    unsigned int i;
+
+    if ((entry == NULL) || (block == NULL) || (block->count == 0))
+        return;
+
+    if ((entry->count == 0) ||
+        mct_index_time_before(block->min_seconds, block->min_microseconds,
+                              entry->min_seconds, entry->min_microseconds)) {
+        entry->min_seconds = block->min_seconds;
+        entry->min_microseconds = block->min_microseconds;
+    }
+
+    if ((entry->count == 0) ||
+        mct_index_time_before(entry->max_seconds, entry->max_microseconds,
+                              block->max_seconds, block->max_microseconds)) {
+        entry->max_seconds = block->max_seconds;
+        entry->max_microseconds = block->max_microseconds;
+    }
+
+    if (block->min_tmsp < entry->min_tmsp)
+        entry->min_tmsp = block->min_tmsp;
+
+    if (block->max_tmsp > entry->max_tmsp)
+        entry->max_tmsp = block->max_tmsp;
+
+    for (i = 0; i < sizeof(entry->ids); i++)
+        entry->ids[i] |= block->ids[i];
+
+    entry->flags |= block->flags & MCT_INDEX_FLAG_NO_UEH;
+    entry->size += block->size;
+    entry->raw_size += block->raw_size;
+    entry->count += block->count;
+}
+
+int mct_index_entry_write(const MctIndexEntry *entry, FILE *file)
+{
+    MctIndexEntry le;
+
+    if ((entry == NULL) || (file == NULL))
+        return -1;
+
+    mct_index_entry_convert(&le, entry);
+
+    if ((fwrite(&le, sizeof(le), 1, file) != 1) || (fflush(file) != 0))
+        return -1;
+
+    return 0;
+}
+
+int mct_index_entry_read(MctIndexEntry *entry, FILE *file)
+{
+    if ((entry == NULL) || (file == NULL))
+        return -1;
+
+    if ((fread(entry, sizeof(*entry), 1, file) != 1) ||
+        (memcmp(entry->pattern, mct_index_pattern, MCT_INDEX_PATTERN_SIZE) != 0))
+        return -1;
+
+    mct_index_entry_convert(entry, entry);
+
+    return 0;
+}
+
+int mct_index_entry_match(const MctIndexEntry *entry,
+                          uint32_t start,
+                          uint32_t end,
+                          MctFilter *filter)
+{
+    int num;
+
+    if (entry == NULL)
+        return 1;
+
+    if (entry->count == 0)
+        return 0;
+
+    if (((start != 0) && (entry->max_seconds < start)) ||
+        ((end != 0) && (entry->min_seconds > end)))
+        return 0;
+
+    if ((filter == NULL) || (filter->counter == 0) ||
+        (entry->flags & MCT_INDEX_FLAG_NO_UEH))
+        return 1;
+
+    for (num = 0; num < filter->counter; num++) {
+        const char *apid = (filter->apid[num][0] != 0) ? filter->apid[num] : NULL;
+        const char *ctid = (filter->ctid[num][0] != 0) ? filter->ctid[num] : NULL;
+
+        if (((apid == NULL) && (ctid == NULL)) ||
+            mct_index_get_bit(entry, mct_index_id_bit(apid, ctid)))
+            return 1;
+    }
+
+    return 0;
+}
+
+MctReturnValue mct_index_load(MctIndex *index, const char *filename)
+{
+    char name[PATH_MAX + 1];
+    struct stat s;
+    MctIndexEntry entry;
+    MctIndexEntry *blocks = NULL;
+    FILE *file = NULL;
+    uint32_t covered = 0;
+    int chained = 1;
+
+    if ((index == NULL) || (filename == NULL))
+        return MCT_RETURN_WRONG_PARAMETER;
+
+    memset(index, 0, sizeof(*index));
+
+    if (stat(filename, &s) != 0)
+        return MCT_RETURN_ERROR;
+
+    snprintf(name, sizeof(name), "%s%s", filename, MCT_INDEX_FILE_SUFFIX);
+    file = fopen(name, "rb");
+
+    if (file == NULL)
+        return MCT_RETURN_ERROR;
+
+    while (mct_index_entry_read(&entry, file) == 0) {
+        index->has_summary = 0;
+
+        if (entry.flags & MCT_INDEX_FLAG_SUMMARY) {
+            /* a summary is only valid for the size of the log file it was
+             * written for */
+            index->summary = entry;
+            index->has_summary = (entry.size == (uint32_t)s.st_size);
+            continue;
+        }
+
+        /* blocks after a gap, e.g. of messages lost on a crash, or beyond
+         * the end of the log file are not used */
+        if (!chained || (entry.offset != covered) ||
+            (entry.size > (uint32_t)s.st_size - covered)) {
+            chained = 0;
+            continue;
+        }
+
+        if (index->num_blocks % MCT_COMMON_INDEX_ALLOC == 0) {
+            blocks = realloc(index->blocks,
+                             ((size_t)index->num_blocks + MCT_COMMON_INDEX_ALLOC) *
+                             sizeof(MctIndexEntry));
+
+            if (blocks == NULL)
+                break;
+
+            index->blocks = blocks;
+        }
+
+        index->blocks[index->num_blocks++] = entry;
+        covered += entry.size;
+    }
+
+    fclose(file);
+
+    if ((index->num_blocks == 0) && !index->has_summary) {
+        mct_index_free(index);
+        return MCT_RETURN_ERROR;
+    }
+
+    return MCT_RETURN_OK;
+}
+
+void mct_index_free(MctIndex *index)
+{
+    if (index == NULL)
+        return;
+
+    free(index->blocks);
+    index->blocks = NULL;
+    index->num_blocks = 0;
+    index->has_summary = 0;
+}
@@ -0,0 +1,164 @@
+#ifndef _MCT_INDEX_H_
+#define _MCT_INDEX_H_
+
+#include <stdint.h>
+#include "mct_common.h"
+
+/* A sidecar index file is written next to a log file, named like the log
+ * file with MCT_INDEX_FILE_SUFFIX appended. It is a sequence of
+ * MctIndexEntry records. Each entry describes one block of consecutive
+ * messages of the log file: its position, the range of storage times and
+ * timestamps and the application and context ids of its messages. Entries
+ * are appended while the log file is written. When the log file is closed,
+ * an entry summarizing the whole file is appended.
+ *
+ * Readers only trust blocks which follow each other without gap from the
+ * start of the log file, and a summary which is the last entry and covers
+ * the whole log file. Anything else, e.g. after a crash, is read as usual. */
+
+#define MCT_INDEX_FILE_SUFFIX   ".idx"
+
+/* pattern of index entry */
+#define MCT_INDEX_PATTERN       { 'D', 'L', 'I', 0x01 }
+#define MCT_INDEX_PATTERN_SIZE  4
+
+/* blocks of uncompressed log files are cut at message boundaries once they
+ * exceed this size, compressed log files are indexed per compressed block */
+#define MCT_INDEX_BLOCK_SIZE    (64 * 1024)
+
+/* size of the bitmap of application and context ids */
+#define MCT_INDEX_ID_BITS       512
+
+#define MCT_INDEX_FLAG_SUMMARY  0x01 /* entry summarizes the whole log file */
+#define MCT_INDEX_FLAG_NO_UEH   0x02 /* block has messages without extended header */
+
+/**
+ * One entry of an index file.
+ * All values are little endian.
+ */
+typedef struct
+{
+    char pattern[MCT_INDEX_PATTERN_SIZE];  /**< This pattern should be DLI0x01 */
+    uint32_t flags;                        /**< MCT_INDEX_FLAG_* */
+    uint32_t offset;                       /**< position of block in log file */
+    uint32_t size;                         /**< size of block in log file */
+    uint32_t raw_size;                     /**< size of messages, differs from size if compressed */
+    uint32_t count;                        /**< number of messages in block */
+    uint32_t min_seconds;                  /**< earliest storage time, seconds since 1.1.1970 */
+    int32_t min_microseconds;              /**< earliest storage time, microseconds */
+    uint32_t max_seconds;                  /**< latest storage time, seconds since 1.1.1970 */
+    int32_t max_microseconds;              /**< latest storage time, microseconds */
+    uint32_t min_tmsp;                     /**< smallest timestamp in 0.1 milliseconds */
+    uint32_t max_tmsp;                     /**< largest timestamp in 0.1 milliseconds */
+    uint8_t ids[MCT_INDEX_ID_BITS / 8];    /**< hashed application ids, context ids and pairs of both */
+} MCT_PACKED MctIndexEntry;
+
+/**
+ * Blocks and summary of a log file read from its index file.
+ */
+typedef struct
+{
+    MctIndexEntry *blocks;  /**< blocks following each other from the start of the log file */
+    int num_blocks;         /**< number of blocks */
+    MctIndexEntry summary;  /**< summary of the whole log file */
+    int has_summary;        /**< summary is valid */
+} MctIndex;
+
+/**
+ * mct_index_entry_init
+ *
+ * Initialize an empty index entry. The entry is kept in host byte order
+ * while messages are added.
+ *
+ * @param entry     Index entry
+ * @param offset    Position of block in log file
+ * @param flags     MCT_INDEX_FLAG_*
+ */
+void mct_index_entry_init(MctIndexEntry *entry, uint32_t offset, uint32_t flags);
+
+/**
+ * mct_index_entry_add
+ *
+ * Add a message to an index entry.
+ *
+ * @param entry     Index entry
+ * @param storage   Storage header of message
+ * @param header    Standard header of message, followed by the extra and extended headers
+ * @param size      Size of header buffer
+ */
+void mct_index_entry_add(MctIndexEntry *entry,
+                         const MctStorageHeader *storage,
+                         const uint8_t *header,
+                         int size);
+
+/**
+ * mct_index_entry_merge
+ *
+ * Add the messages of an index entry to another one, e.g. a block to the
+ * summary of a log file.
+ *
+ * @param entry     Index entry
+ * @param block     Index entry to be added
+ */
+void mct_index_entry_merge(MctIndexEntry *entry, const MctIndexEntry *block);
+
+/**
+ * mct_index_entry_write
+ *
+ * Append an index entry to an index file.
+ *
+ * @param entry     Index entry in host byte order
+ * @param file      Index file
+ * @return          0 on success, -1 on error
+ */
+int mct_index_entry_write(const MctIndexEntry *entry, FILE *file);
+
+/**
+ * mct_index_entry_read
+ *
+ * Read the next entry of an index file.
+ *
+ * @param entry     Index entry in host byte order
+ * @param file      Index file
+ * @return          0 on success, -1 at the end of the index file or on a corrupted entry
+ */
+int mct_index_entry_read(MctIndexEntry *entry, FILE *file);
+
+/**
+ * mct_index_entry_match
+ *
+ * Check if an index entry may contain messages of a time range which pass
+ * a filter.
+ *
+ * @param entry     Index entry in host byte order
+ * @param start     Start of time range, seconds since 1.1.1970, 0 for none
+ * @param end       End of time range, seconds since 1.1.1970, 0 for none
+ * @param filter    Filter, NULL for none
+ * @return          1 if the block may contain such messages, 0 if not
+ */
+int mct_index_entry_match(const MctIndexEntry *entry,
+                          uint32_t start,
+                          uint32_t end,
+                          MctFilter *filter);
+
+/**
+ * mct_index_load
+ *
+ * Read the index file of a log file, if it exists.
+ *
+ * @param index     Index
+ * @param filename  Name of log file
+ * @return          MCT_RETURN_OK on success, MCT_RETURN_ERROR if no usable index exists
+ */
+MctReturnValue mct_index_load(MctIndex *index, const char *filename);
+
+/**
+ * mct_index_free
+ *
+ * Free an index read by mct_index_load.
+ *
+ * @param index     Index
+ */
+void mct_index_free(MctIndex *index);
+
+#endif
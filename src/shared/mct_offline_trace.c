@@ -4,6 +4,7 @@
 #include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
@@ -11,6 +12,7 @@
 
 #include <mct_offline_trace.h>
 #include "mct_common.h"
+#include "mct_compress.h"
 
 unsigned int mct_offline_trace_storage_dir_info(char *path, char *file_name, char *newest, char *oldest)
 {
@@ -315,6 +317,67 @@ MctReturnValue mct_offline_trace_check_size(MctOfflineTrace *trace)
     return MCT_RETURN_OK; /* OK */
 }
 
+/**
+ * mct_offline_trace_rotate
+ *
+ * Close the current trace file and create a new one if adding the given
+ * size would exceed the maximum file size.
+ *
+ * @param trace pointer to offline trace structure
+ * @param size size in bytes to be written
+ */
+static void mct_offline_trace_rotate(MctOfflineTrace *trace, int size)
+{
+    if ((lseek(trace->ohandle, 0, SEEK_CUR) + size) >= trace->fileSize) {
+        /* close old file */
+        close(trace->ohandle);
+        trace->ohandle = -1;
+
+        /* check complete offline trace size, remove old logs if needed */
+        mct_offline_trace_check_size(trace);
+
+        /* create new file */
+        mct_offline_trace_create_new_file(trace);
+    }
+}
+
+/**
+ * mct_offline_trace_flush_block
+ *
+ * Compress the collected messages and write them as one block.
+ *
+ * @param trace pointer to offline trace structure
+ * @return negative value if there was an error
+ */
+static MctReturnValue mct_offline_trace_flush_block(MctOfflineTrace *trace)
+{
+    unsigned char *block = NULL;
+    int size = 0;
+
+    if (trace->blockSize == 0)
+        return MCT_RETURN_OK;
+
+    block = malloc(sizeof(MctBlockHeader) + (size_t)mct_compress_bound(trace->blockSize));
+
+    if (block == NULL)
+        return MCT_RETURN_ERROR;
+
+    size = mct_block_encode(trace->block, trace->blockSize, block);
+    trace->blockSize = 0;
+
+    mct_offline_trace_rotate(trace, size);
+
+    if ((trace->ohandle < 0) || (write(trace->ohandle, block, (size_t)size) != size)) {
+        printf("Offline trace write failed!\n");
+        free(block);
+        return MCT_RETURN_ERROR;
+    }
+
+    free(block);
+
+    return MCT_RETURN_OK;
+}
+
 MctReturnValue mct_offline_trace_init(MctOfflineTrace *trace,
                                       const char *directory,
                                       int fileSize,
@@ -328,12 +391,113 @@ MctReturnValue mct_offline_trace_init(MctOfflineTrace *trace,
     trace->fileSize = fileSize;
     trace->maxSize = maxSize;
     trace->filenameTimestampBased = filenameTimestampBased;
+    trace->block = NULL;
+    trace->blockSize = 0;
+
+    if (trace->compression) {
+        trace->block = malloc(MCT_BLOCK_SIZE_MAX);
+
+        if (trace->block == NULL)
+            return MCT_RETURN_ERROR;
+    }
+
     /* check complete offlien trace size, remove old logs if needed */
     mct_offline_trace_check_size(trace);
 
     return mct_offline_trace_create_new_file(trace);
 }
 
+/**
+ * mct_offline_trace_add_to_block
+ *
+ * Append a message to the collected messages of the next compressed block,
+ * the collected messages are written first if the message does not fit.
+ *
+ * @param trace pointer to offline trace structure
+ * @param data1 pointer to first data block, null if not used
+ * @param size1 size in bytes of first data block
+ * @param data2 pointer to second data block, null if not used
+ * @param size2 size in bytes of second data block
+ * @param data3 pointer to third data block, null if not used
+ * @param size3 size in bytes of third data block
+ * @return negative value if there was an error
+ */
+static MctReturnValue mct_offline_trace_add_to_block(MctOfflineTrace *trace,
+                                                     const void *data1,
+                                                     int size1,
+                                                     const void *data2,
+                                                     int size2,
+                                                     const void *data3,
+                                                     int size3)
+{
+    if ((trace->blockSize > 0) &&
+        (trace->blockSize + size1 + size2 + size3 > MCT_BLOCK_SIZE) &&
+        (mct_offline_trace_flush_block(trace) < MCT_RETURN_OK))
+        return MCT_RETURN_ERROR;
+
+    if (data1) {
+        memcpy(trace->block + trace->blockSize, data1, (size_t)size1);
+        trace->blockSize += size1;
+    }
+
+    if (data2) {
+        memcpy(trace->block + trace->blockSize, data2, (size_t)size2);
+        trace->blockSize += size2;
+    }
+
+    if (data3) {
+        memcpy(trace->block + trace->blockSize, data3, (size_t)size3);
+        trace->blockSize += size3;
+    }
+
+    return MCT_RETURN_OK;
+}
+
+/**
+ * mct_offline_trace_writev
+ *
+ * Write a vector of buffers to the current trace file, rewriting
+ * partially written data.
+ *
+ * @param trace pointer to offline trace structure
+ * @param iov buffers to be written in order
+ * @param iovcnt number of buffers
+ * @return negative value if there was an error
+ */
+static MctReturnValue mct_offline_trace_writev(MctOfflineTrace *trace,
+                                               const struct iovec *iov,
+                                               int iovcnt)
+{
+    int idx = 0;
+    size_t offset = 0;
+    ssize_t ret = 0;
+
+    while (idx < iovcnt) {
+        if (offset > 0)
+            ret = write(trace->ohandle,
+                        (const uint8_t *)iov[idx].iov_base + offset,
+                        iov[idx].iov_len - offset);
+        else
+            ret = writev(trace->ohandle,
+                         &iov[idx],
+                         (iovcnt - idx) < IOV_MAX ? (iovcnt - idx) : IOV_MAX);
+
+        if (ret < 0) {
+            printf("Offline trace write failed!\n");
+            return MCT_RETURN_ERROR;
+        }
+
+        offset += (size_t)ret;
+
+        while ((idx < iovcnt) && (offset >= iov[idx].iov_len)) {
+            offset -= iov[idx].iov_len;
+            idx++;
+        }
+    }
+
+    return MCT_RETURN_OK;
+}
+
 MctReturnValue mct_offline_trace_write(MctOfflineTrace *trace,
                                        unsigned char *data1,
                                        int size1,
@@ -346,18 +510,12 @@ MctReturnValue mct_offline_trace_write(MctOfflineTrace *trace,
     if (trace->ohandle <= 0)
         return MCT_RETURN_ERROR;
 
-    /* check file size here */
-    if ((lseek(trace->ohandle, 0, SEEK_CUR) + size1 + size2 + size3) >= trace->fileSize) {
-        /* close old file */
-        close(trace->ohandle);
-        trace->ohandle = -1;
-
-        /* check complete offline trace size, remove old logs if needed */
-        mct_offline_trace_check_size(trace);
+    /* collect messages in a block, compressed when the block is full */
+    if (trace->block != NULL)
+        return mct_offline_trace_add_to_block(trace, data1, size1, data2, size2, data3, size3);
 
-        /* create new file */
-        mct_offline_trace_create_new_file(trace);
-    }
+    /* check file size here */
+    mct_offline_trace_rotate(trace, size1 + size2 + size3);
 
     /* write data into log file */
     if (data1 && (trace->ohandle >= 0)) {
@@ -384,14 +542,76 @@ MctReturnValue mct_offline_trace_write(MctOfflineTrace *trace,
     return MCT_RETURN_OK; /* OK */
 }
 
+MctReturnValue mct_offline_trace_write_vector(MctOfflineTrace *trace,
+                                              const struct iovec *iov,
+                                              int count)
+{
+    off_t position = 0;
+    int size = 0;
+    int first = 0;
+    int i = 0;
+
+    if ((trace->ohandle <= 0) || (iov == NULL))
+        return MCT_RETURN_ERROR;
+
+    if (trace->block != NULL) {
+        for (i = 0; i < count; i++)
+            if (mct_offline_trace_add_to_block(trace,
+                                               iov[3 * i].iov_base, (int)iov[3 * i].iov_len,
+                                               iov[3 * i + 1].iov_base, (int)iov[3 * i + 1].iov_len,
+                                               iov[3 * i + 2].iov_base, (int)iov[3 * i + 2].iov_len) <
+                MCT_RETURN_OK)
+                return MCT_RETURN_ERROR;
+
+        return MCT_RETURN_OK;
+    }
+
+    position = lseek(trace->ohandle, 0, SEEK_CUR);
+
+    /* messages are written with one call per trace file, a message is
+     * never split across files */
+    for (i = 0; i < count; i++) {
+        size = (int)(iov[3 * i].iov_len + iov[3 * i + 1].iov_len + iov[3 * i + 2].iov_len);
+
+        if (position + size >= trace->fileSize) {
+            if ((i > first) &&
+                (mct_offline_trace_writev(trace, &iov[3 * first], 3 * (i - first)) < MCT_RETURN_OK))
+                return MCT_RETURN_ERROR;
+
+            first = i;
+            mct_offline_trace_rotate(trace, size);
+
+            if (trace->ohandle < 0)
+                return MCT_RETURN_ERROR;
+
+            position = lseek(trace->ohandle, 0, SEEK_CUR);
+        }
+
+        position += size;
+    }
+
+    if ((count > first) &&
+        (mct_offline_trace_writev(trace, &iov[3 * first], 3 * (count - first)) < MCT_RETURN_OK))
+        return MCT_RETURN_ERROR;
+
+    return MCT_RETURN_OK;
+}
+
 MctReturnValue mct_offline_trace_free(MctOfflineTrace *trace)
 {
 
     if (trace->ohandle <= 0)
         return MCT_RETURN_ERROR;
 
+    if (trace->block != NULL) {
+        mct_offline_trace_flush_block(trace);
+        free(trace->block);
+        trace->block = NULL;
+    }
+
     /* close last used log file */
-    close(trace->ohandle);
+    if (trace->ohandle >= 0)
+        close(trace->ohandle);
 
     return MCT_RETURN_OK; /* OK */
 }
@@ -0,0 +1,165 @@
+#include "mct_pattern.h"
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#   define MCT_PATTERN_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#   define MCT_PATTERN_USE_NEON
+#endif
+
+#if defined(MCT_PATTERN_USE_SSE2) || defined(MCT_PATTERN_USE_NEON)
+#   define MCT_PATTERN_USE_SIMD
+#endif
+
+/* internal defines */
+#define MCT_PATTERN_BLOCK_SIZE 16
+
+#ifdef MCT_PATTERN_USE_SIMD
+#   ifdef MCT_PATTERN_USE_SSE2
+/* one mask bit per byte */
+#       define MCT_PATTERN_MASK_BITS  1
+#       define MCT_PATTERN_MASK_LANE  0x1ULL
+#   else
+/* one mask nibble per byte */
+#       define MCT_PATTERN_MASK_BITS  4
+#       define MCT_PATTERN_MASK_LANE  0xFULL
+#   endif
+
+/**
+ * mct_pattern_block_mask
+ *
+ * Compute the candidate mask of one block: a lane is set if the first
+ * pattern byte matches at that position and the last pattern byte matches
+ * at position + (pattern_len - 1).
+ *
+ * @param first   Start of block, compared with first pattern byte
+ * @param last    Start of block + pattern_len - 1, compared with last byte
+ * @param pfirst  First pattern byte
+ * @param plast   Last pattern byte
+ * @return        Candidate mask, MCT_PATTERN_MASK_BITS bits per byte
+ */
+static inline uint64_t mct_pattern_block_mask(const uint8_t *first,
+                                              const uint8_t *last,
+                                              uint8_t pfirst,
+                                              uint8_t plast)
+{
+#ifdef MCT_PATTERN_USE_SSE2
+    __m128i f = _mm_loadu_si128((const __m128i *)first);
+    __m128i l = _mm_loadu_si128((const __m128i *)last);
+    __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(f, _mm_set1_epi8((char)pfirst)),
+                               _mm_cmpeq_epi8(l, _mm_set1_epi8((char)plast)));
+
+    return (uint64_t)(uint32_t)_mm_movemask_epi8(eq);
+#else
+    uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(first), vdupq_n_u8(pfirst)),
+                             vceqq_u8(vld1q_u8(last), vdupq_n_u8(plast)));
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+#endif
+}
+#endif
+
+int mct_pattern_find(const void *buf,
+                     size_t len,
+                     const void *pattern,
+                     size_t pattern_len)
+{
+    const uint8_t *data = (const uint8_t *)buf;
+    const uint8_t *pat = (const uint8_t *)pattern;
+    const uint8_t *found = NULL;
+    size_t last = 0;
+    size_t i = 0;
+
+    if ((buf == NULL) || (pattern == NULL) || (pattern_len == 0) ||
+        (len < pattern_len) || (len > INT_MAX))
+        return -1;
+
+    last = pattern_len - 1;
+
+#ifdef MCT_PATTERN_USE_SIMD
+    for (; i + last + MCT_PATTERN_BLOCK_SIZE <= len; i += MCT_PATTERN_BLOCK_SIZE) {
+        uint64_t mask = mct_pattern_block_mask(data + i, data + i + last,
+                                               pat[0], pat[last]);
+
+        while (mask != 0) {
+            unsigned int bit = (unsigned int)__builtin_ctzll(mask);
+            size_t pos = i + bit / MCT_PATTERN_MASK_BITS;
+
+            if (memcmp(data + pos, pat, pattern_len) == 0)
+                return (int)pos;
+
+            mask &= ~(MCT_PATTERN_MASK_LANE << (bit - bit % MCT_PATTERN_MASK_BITS));
+        }
+    }
+#endif
+
+    /* remaining bytes */
+    while (i + pattern_len <= len) {
+        found = memchr(data + i, pat[0], len - pattern_len + 1 - i);
+
+        if (found == NULL)
+            break;
+
+        i = (size_t)(found - data);
+
+        if (memcmp(found, pat, pattern_len) == 0)
+            return (int)i;
+
+        i++;
+    }
+
+    return -1;
+}
+
+int mct_pattern_find_last(const void *buf,
+                          size_t len,
+                          const void *pattern,
+                          size_t pattern_len)
+{
+    const uint8_t *data = (const uint8_t *)buf;
+    const uint8_t *pat = (const uint8_t *)pattern;
+    size_t last = 0;
+    size_t end = 0; /* number of remaining candidate positions */
+
+    if ((buf == NULL) || (pattern == NULL) || (pattern_len == 0) ||
+        (len < pattern_len) || (len > INT_MAX))
+        return -1;
+
+    last = pattern_len - 1;
+    end = len - last;
+
+#ifdef MCT_PATTERN_USE_SIMD
+    while (end >= MCT_PATTERN_BLOCK_SIZE) {
+        size_t i = end - MCT_PATTERN_BLOCK_SIZE;
+        uint64_t mask = mct_pattern_block_mask(data + i, data + i + last,
+                                               pat[0], pat[last]);
+
+        while (mask != 0) {
+            unsigned int bit = 63U - (unsigned int)__builtin_clzll(mask);
+            size_t pos = i + bit / MCT_PATTERN_MASK_BITS;
+
+            if (memcmp(data + pos, pat, pattern_len) == 0)
+                return (int)pos;
+
+            mask &= ~(MCT_PATTERN_MASK_LANE << (bit - bit % MCT_PATTERN_MASK_BITS));
+        }
+
+        end = i;
+    }
+#endif
+
+    /* remaining bytes */
+    while (end > 0) {
+        end--;
+
+        if ((data[end] == pat[0]) && (memcmp(data + end, pat, pattern_len) == 0))
+            return (int)end;
+    }
+
+    return -1;
+}
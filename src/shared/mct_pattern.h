@@ -0,0 +1,41 @@
+#ifndef _MCT_PATTERN_H_
+#define _MCT_PATTERN_H_
+
+#include <stddef.h>
+
+/**
+ * mct_pattern_find
+ *
+ * Search the first occurrence of a sync pattern (e.g. "DUH\1", "DLS\1" or
+ * "DLT\1") in a buffer. Only occurrences lying completely inside the buffer
+ * are reported. The buffer is scanned in blocks of 16 bytes with SSE2 or
+ * NEON if available.
+ *
+ * @param buf          Buffer to be searched
+ * @param len          Length of buffer
+ * @param pattern      Pattern to search for
+ * @param pattern_len  Length of pattern
+ * @return             Offset of pattern in buffer, -1 if not found
+ */
+int mct_pattern_find(const void *buf,
+                     size_t len,
+                     const void *pattern,
+                     size_t pattern_len);
+
+/**
+ * mct_pattern_find_last
+ *
+ * Search the last occurrence of a sync pattern in a buffer.
+ * Only occurrences lying completely inside the buffer are reported.
+ *
+ * @param buf          Buffer to be searched
+ * @param len          Length of buffer
+ * @param pattern      Pattern to search for
+ * @param pattern_len  Length of pattern
+ * @return             Offset of pattern in buffer, -1 if not found
+ */
+int mct_pattern_find_last(const void *buf,
+                          size_t len,
+                          const void *pattern,
+                          size_t pattern_len);
+#endif
@@ -38,7 +38,8 @@ const char *const mct_user_service_names[] = {
     "MCT_SERVICE_ID_SET_BLOCK_MODE",
     "MCT_SERVICE_ID_GET_BLOCK_MODE",
     "MCT_SERVICE_ID_SET_FILTER_LEVEL",
-    "MCT_SERVICE_ID_GET_FILTER_STATUS"
+    "MCT_SERVICE_ID_GET_FILTER_STATUS",
+    "MCT_SERVICE_ID_GET_METRICS"
 };
 
 const char *mct_get_service_name(unsigned int id)
@@ -7,6 +7,8 @@
 #include "mct_user_shared.h"
 #include "mct_user_shared_cfg.h"
 
+const char mctUserHeader[MCT_ID_SIZE] = { 'D', 'U', 'H', 1 };
+
 MctReturnValue mct_user_set_userheader(MctUserHeader *userheader, uint32_t mtype)
 {
     if (userheader == 0)
@@ -15,6 +15,11 @@ typedef struct
     uint32_t message;               /**< messsage info */
 } MCT_PACKED MctUserHeader;
 
+/**
+ * The definition of the user header pattern containing the characters "DUH" + 0x01.
+ */
+extern const char mctUserHeader[MCT_ID_SIZE];
+
 /**
  * This is the internal message content to exchange control msg register app information between application and daemon.
  */
@@ -0,0 +1,348 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include <vector>
+
+extern "C"
+{
+#include "mct_common.h"
+}
+
+/* entry i carries its index and is filled with it, so order and content can be checked */
+static void push_entry(MctBuffer *buf, int i, int size, unsigned char priority)
+{
+    std::vector<unsigned char> data(size, (unsigned char)i);
+
+    memcpy(data.data(), &i, sizeof(i));
+    ASSERT_EQ(MCT_RETURN_OK,
+              mct_buffer_push3_priority(buf, priority, data.data(), (unsigned int)size,
+                                        NULL, 0, NULL, 0));
+}
+
+static int entry_index(const unsigned char *data, int size)
+{
+    int i = 0;
+
+    memcpy(&i, data, sizeof(i));
+
+    for (int j = (int)sizeof(i); j < size; j++)
+        if (data[j] != (unsigned char)i)
+            return -1;
+
+    return i;
+}
+
+static int segment_count(MctBuffer *buf)
+{
+    int count = 0;
+
+    for (MctBufferSegment *seg = buf->first; seg != NULL; seg = seg->next)
+        count++;
+
+    return count;
+}
+
+/* Begin Method: mct_common::mct_buffer_init_dynamic */
+TEST(t_mct_buffer_init_dynamic, normal)
+{
+    MctBuffer buf;
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 1024, 64));
+    EXPECT_EQ(64u, buf.size);
+    EXPECT_EQ(buf.first, buf.last);
+    EXPECT_EQ(0, mct_buffer_get_message_count(&buf));
+    EXPECT_EQ(0, mct_buffer_get_used_size(&buf));
+    EXPECT_EQ(1024u, mct_buffer_get_total_size(&buf));
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+
+TEST(t_mct_buffer_init_dynamic, nullpointer)
+{
+    MctBuffer buf;
+
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER, mct_buffer_init_dynamic(NULL, 64, 1024, 64));
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER, mct_buffer_init_dynamic(&buf, 0, 1024, 64));
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER, mct_buffer_init_dynamic(&buf, 2048, 1024, 64));
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER, mct_buffer_init_dynamic(&buf, 64, 1024, 2048));
+}
+/* End Method: mct_common::mct_buffer_init_dynamic */
+
+/* Begin Method: mct_common::mct_buffer_push3_priority */
+TEST(t_mct_buffer_push3_priority, segments_keep_order)
+{
+    MctBuffer buf;
+    unsigned char data[64];
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 4096, 64));
+
+    for (int i = 0; i < 40; i++)
+        push_entry(&buf, i, 8 + i % 16, 0);
+
+    EXPECT_EQ(40, mct_buffer_get_message_count(&buf));
+    EXPECT_GT(segment_count(&buf), 1);
+
+    for (int i = 0; i < 40; i++) {
+        int size = mct_buffer_pull(&buf, data, sizeof(data));
+
+        ASSERT_EQ(8 + i % 16, size);
+        EXPECT_EQ(i, entry_index(data, size));
+    }
+
+    /* an empty buffer shrinks back to a single segment of min size */
+    EXPECT_EQ(0, mct_buffer_get_message_count(&buf));
+    EXPECT_EQ(1, segment_count(&buf));
+    EXPECT_EQ(64u, buf.size);
+    EXPECT_GE(0, mct_buffer_pull(&buf, data, sizeof(data)));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+
+TEST(t_mct_buffer_push3_priority, entry_larger_than_step)
+{
+    MctBuffer buf;
+    struct iovec iov[2];
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 1024, 64));
+
+    push_entry(&buf, 1, 200, 0);
+
+    /* entries are never split over segments */
+    ASSERT_EQ(1, mct_buffer_get_vector(&buf, iov, 1, 1024));
+    EXPECT_EQ(200u, iov[0].iov_len);
+    EXPECT_EQ(0u, iov[1].iov_len);
+    EXPECT_EQ(1, entry_index((unsigned char *)iov[0].iov_base, 200));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+
+TEST(t_mct_buffer_push3_priority, max_size)
+{
+    MctBuffer buf;
+    unsigned char data[32] = { 0 };
+    int count = 0;
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 512, 64));
+
+    while (mct_buffer_check_size(&buf, sizeof(data)) == MCT_RETURN_OK) {
+        ASSERT_EQ(MCT_RETURN_OK, mct_buffer_push3(&buf, data, sizeof(data), NULL, 0, NULL, 0));
+        count++;
+    }
+
+    EXPECT_GT(count, 0);
+    EXPECT_LE(buf.size, 512u);
+    EXPECT_EQ(MCT_RETURN_ERROR, mct_buffer_push3(&buf, data, sizeof(data), NULL, 0, NULL, 0));
+    EXPECT_EQ(count, mct_buffer_get_message_count(&buf));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+
+TEST(t_mct_buffer_push3_priority, nullpointer)
+{
+    MctBuffer buf;
+    unsigned char data[4] = { 0 };
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 512, 64));
+
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER,
+              mct_buffer_push3_priority(NULL, 0, data, sizeof(data), NULL, 0, NULL, 0));
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER,
+              mct_buffer_push3_priority(&buf, MCT_BUFFER_PRIORITY_MAX, data, sizeof(data),
+                                        NULL, 0, NULL, 0));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+/* End Method: mct_common::mct_buffer_push3_priority */
+
+/* Begin Method: mct_common::mct_buffer_evict */
+TEST(t_mct_buffer_evict, least_important_oldest_first)
+{
+    MctBuffer buf;
+    unsigned int evicted[MCT_BUFFER_PRIORITY_MAX] = { 0 };
+    std::vector<unsigned char> priority;
+    unsigned char data[32];
+    int count = 0;
+    int skipped = 0;
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 128, 2048, 128));
+
+    /* fill buffer with a mix of priorities */
+    while (mct_buffer_check_size(&buf, sizeof(data)) == MCT_RETURN_OK) {
+        unsigned char p = (count % 3 == 0) ? 1 : ((count % 3 == 1) ? 5 : 3);
+
+        push_entry(&buf, count, sizeof(data), p);
+        priority.push_back(p);
+        count++;
+    }
+
+    ASSERT_EQ(MCT_RETURN_ERROR, mct_buffer_check_size(&buf, sizeof(data)));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_evict(&buf, 0, sizeof(data), evicted));
+    EXPECT_GT(evicted[5], 0u);
+    EXPECT_EQ(0u, evicted[3]);
+    EXPECT_EQ(0u, evicted[1]);
+    EXPECT_EQ(count - (int)evicted[5], mct_buffer_get_message_count(&buf));
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_check_size(&buf, sizeof(data)));
+
+    /* remaining entries keep their order, the oldest priority 5 entries are gone */
+    for (int i = 0; i < count; i++) {
+        if ((priority[i] == 5) && (skipped < (int)evicted[5])) {
+            skipped++;
+            continue;
+        }
+
+        int size = mct_buffer_pull(&buf, data, sizeof(data));
+
+        ASSERT_EQ((int)sizeof(data), size);
+        EXPECT_EQ(i, entry_index(data, size));
+    }
+
+    EXPECT_EQ(0, mct_buffer_get_message_count(&buf));
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+
+TEST(t_mct_buffer_evict, counters)
+{
+    MctBuffer buf;
+    unsigned int evicted[MCT_BUFFER_PRIORITY_MAX] = { 0 };
+    int total = 0;
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 1024, 64));
+
+    for (int i = 0; i < 20; i++)
+        push_entry(&buf, i, 16, (unsigned char)(i % MCT_BUFFER_PRIORITY_MAX));
+
+    /* asking for the whole buffer removes everything less important than 2 */
+    EXPECT_EQ(MCT_RETURN_ERROR, mct_buffer_evict(&buf, 2, 2048, evicted));
+
+    for (int p = 0; p < MCT_BUFFER_PRIORITY_MAX; p++) {
+        int pushed = 20 / MCT_BUFFER_PRIORITY_MAX + ((p < 20 % MCT_BUFFER_PRIORITY_MAX) ? 1 : 0);
+
+        if (p <= 2) {
+            EXPECT_EQ(0u, evicted[p]);
+            EXPECT_EQ(pushed, buf.priority_count[p]);
+        } else {
+            EXPECT_EQ((unsigned int)pushed, evicted[p]);
+            EXPECT_EQ(0, buf.priority_count[p]);
+        }
+
+        total += buf.priority_count[p];
+    }
+
+    EXPECT_EQ(total, mct_buffer_get_message_count(&buf));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+
+TEST(t_mct_buffer_evict, keeps_equal_priority)
+{
+    MctBuffer buf;
+    unsigned int evicted[MCT_BUFFER_PRIORITY_MAX] = { 0 };
+    unsigned char data[32] = { 0 };
+    int count = 0;
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 512, 64));
+
+    while (mct_buffer_check_size(&buf, sizeof(data)) == MCT_RETURN_OK) {
+        push_entry(&buf, count, sizeof(data), 2);
+        count++;
+    }
+
+    EXPECT_EQ(MCT_RETURN_ERROR, mct_buffer_evict(&buf, 2, sizeof(data), evicted));
+    EXPECT_EQ(MCT_RETURN_ERROR, mct_buffer_evict(&buf, 4, sizeof(data), evicted));
+
+    for (int p = 0; p < MCT_BUFFER_PRIORITY_MAX; p++)
+        EXPECT_EQ(0u, evicted[p]);
+
+    EXPECT_EQ(count, mct_buffer_get_message_count(&buf));
+
+    /* a more important entry makes room */
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_evict(&buf, 1, sizeof(data), evicted));
+    EXPECT_GT(evicted[2], 0u);
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+
+TEST(t_mct_buffer_evict, nullpointer)
+{
+    MctBuffer buf;
+    unsigned int evicted[MCT_BUFFER_PRIORITY_MAX] = { 0 };
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 512, 64));
+
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER, mct_buffer_evict(NULL, 0, 16, evicted));
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER, mct_buffer_evict(&buf, 0, 16, NULL));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+/* End Method: mct_common::mct_buffer_evict */
+
+/* Begin Method: mct_common::mct_buffer_get_vector */
+TEST(t_mct_buffer_get_vector, limits)
+{
+    MctBuffer buf;
+    struct iovec iov[2 * 16];
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 4096, 64));
+
+    for (int i = 0; i < 10; i++)
+        push_entry(&buf, i, 20, 0);
+
+    EXPECT_EQ(4, mct_buffer_get_vector(&buf, iov, 4, 4096));
+    EXPECT_EQ(10, mct_buffer_get_vector(&buf, iov, 16, 4096));
+    EXPECT_EQ(3, mct_buffer_get_vector(&buf, iov, 16, 60));
+
+    /* the first entry is always included */
+    EXPECT_EQ(1, mct_buffer_get_vector(&buf, iov, 16, 1));
+
+    for (int i = 0; i < mct_buffer_get_vector(&buf, iov, 16, 4096); i++) {
+        ASSERT_EQ(20u, iov[2 * i].iov_len);
+        EXPECT_EQ(i, entry_index((unsigned char *)iov[2 * i].iov_base, 20));
+    }
+
+    /* entries stay until they are removed */
+    EXPECT_EQ(10, mct_buffer_get_message_count(&buf));
+    EXPECT_EQ(20, mct_buffer_remove(&buf));
+    EXPECT_EQ(20, mct_buffer_remove(&buf));
+
+    ASSERT_EQ(8, mct_buffer_get_vector(&buf, iov, 16, 4096));
+    EXPECT_EQ(2, entry_index((unsigned char *)iov[0].iov_base, 20));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+
+TEST(t_mct_buffer_get_vector, empty)
+{
+    MctBuffer buf;
+    struct iovec iov[2];
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 512, 64));
+
+    EXPECT_EQ(0, mct_buffer_get_vector(&buf, iov, 1, 512));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+/* End Method: mct_common::mct_buffer_get_vector */
+
+/* Begin Method: mct_common::mct_buffer_copy */
+TEST(t_mct_buffer_copy, keeps_entry)
+{
+    MctBuffer buf;
+    unsigned char data[16];
+
+    ASSERT_EQ(MCT_RETURN_OK, mct_buffer_init_dynamic(&buf, 64, 512, 64));
+
+    push_entry(&buf, 7, sizeof(data), 0);
+
+    EXPECT_EQ((int)sizeof(data), mct_buffer_copy(&buf, data, sizeof(data)));
+    EXPECT_EQ(7, entry_index(data, sizeof(data)));
+    EXPECT_EQ(1, mct_buffer_get_message_count(&buf));
+
+    /* too small destination */
+    EXPECT_GT(0, mct_buffer_copy(&buf, data, 4));
+    EXPECT_EQ(1, mct_buffer_get_message_count(&buf));
+
+    EXPECT_EQ((int)sizeof(data), mct_buffer_remove(&buf));
+    EXPECT_EQ(0, mct_buffer_get_message_count(&buf));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_buffer_free_dynamic(&buf));
+}
+/* End Method: mct_common::mct_buffer_copy */
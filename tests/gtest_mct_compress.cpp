@@ -0,0 +1,395 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+extern "C"
+{
+#include "mct_compress.h"
+}
+
+typedef std::vector<uint8_t> Bytes;
+
+static Bytes random_bytes(size_t size, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    Bytes data(size);
+
+    for (size_t i = 0; i < size; i++)
+        data[i] = (uint8_t)rng();
+
+    return data;
+}
+
+/* text like log payload, compresses well */
+static Bytes text_bytes(size_t size)
+{
+    static const char words[] = "Sensor value temperature 42 pressure 1013 state OK; ";
+    Bytes data(size);
+
+    for (size_t i = 0; i < size; i++)
+        data[i] = (uint8_t)words[(i * 7 / 5) % (sizeof(words) - 1)];
+
+    return data;
+}
+
+/* compress, check the bound and decompress again */
+static void round_trip(const Bytes &data)
+{
+    int size = (int)data.size();
+    Bytes input(data.begin(), data.end());
+    Bytes compressed(mct_compress_bound(size));
+    Bytes decompressed(data.size() + 1);
+    int len = 0;
+
+    /* an empty vector has no buffer */
+    input.push_back(0);
+    len = mct_compress(input.data(), size, compressed.data(), (int)compressed.size());
+
+    ASSERT_GT(len, 0);
+    ASSERT_LE(len, mct_compress_bound(size));
+    ASSERT_EQ(size, mct_decompress(compressed.data(), len, decompressed.data(),
+                                   (int)decompressed.size()));
+    decompressed.resize(data.size());
+    EXPECT_TRUE(data == decompressed);
+
+    /* the exact output size is sufficient */
+    EXPECT_EQ(len, mct_compress(input.data(), size, compressed.data(), len));
+    EXPECT_EQ(0, mct_compress(input.data(), size, compressed.data(), len - 1));
+}
+
+static int compressed_size(const Bytes &data)
+{
+    Bytes compressed(mct_compress_bound((int)data.size()));
+
+    return mct_compress(data.data(), (int)data.size(), compressed.data(), (int)compressed.size());
+}
+
+/* Begin Method: mct_compress::mct_compress */
+TEST(t_mct_compress, round_trip_sizes)
+{
+    /* inputs around the limits of the last literals and match search */
+    for (size_t size = 0; size <= 40; size++) {
+        SCOPED_TRACE(size);
+        round_trip(random_bytes(size, (unsigned int)size));
+        round_trip(Bytes(size, 'a'));
+        round_trip(text_bytes(size));
+    }
+}
+
+TEST(t_mct_compress, round_trip_random)
+{
+    Bytes data = random_bytes(100000, 1);
+
+    round_trip(data);
+
+    /* incompressible input only grows by the bound */
+    EXPECT_LE(compressed_size(data), mct_compress_bound((int)data.size()));
+    EXPECT_GE(compressed_size(data), (int)data.size());
+}
+
+TEST(t_mct_compress, round_trip_compressible)
+{
+    Bytes data = text_bytes(MCT_BLOCK_SIZE);
+
+    round_trip(data);
+    EXPECT_LT(compressed_size(data), (int)data.size() / 4);
+}
+
+TEST(t_mct_compress, round_trip_long_match)
+{
+    /* matches and literals longer than 15 + 255 need several length bytes,
+     * a match with offset 1 overlaps its own output */
+    Bytes data = random_bytes(1000, 2);
+    Bytes zeros(100000, 0);
+
+    data.insert(data.end(), zeros.begin(), zeros.end());
+    round_trip(data);
+    EXPECT_LT(compressed_size(data), 2000);
+}
+
+TEST(t_mct_compress, round_trip_far_repeat)
+{
+    /* a repetition beyond the maximum offset must not be referenced */
+    Bytes data = random_bytes(70000, 3);
+    Bytes copy = data;
+
+    data.insert(data.end(), copy.begin(), copy.end());
+    round_trip(data);
+
+    /* a near one is */
+    data = random_bytes(1000, 4);
+    copy = data;
+    data.insert(data.end(), copy.begin(), copy.end());
+    round_trip(data);
+    EXPECT_LT(compressed_size(data), 1100);
+}
+
+TEST(t_mct_compress, round_trip_mixed)
+{
+    Bytes data;
+
+    for (int i = 0; i < 200; i++) {
+        Bytes part = (i % 2) ? random_bytes((size_t)(i * 13 % 500), (unsigned int)i) :
+            text_bytes((size_t)(i * 29 % 700));
+
+        data.insert(data.end(), part.begin(), part.end());
+    }
+
+    round_trip(data);
+}
+
+TEST(t_mct_compress, capacity_too_small)
+{
+    Bytes data = random_bytes(1000, 5);
+    Bytes compressed(mct_compress_bound(1000));
+    Bytes text = text_bytes(1000);
+    int len = compressed_size(text);
+
+    EXPECT_EQ(0, mct_compress(data.data(), 1000, compressed.data(), 500));
+    EXPECT_EQ(0, mct_compress(data.data(), 1000, compressed.data(), 1000));
+    EXPECT_EQ(0, mct_compress(text.data(), 1000, compressed.data(), len - 1));
+    EXPECT_EQ(len, mct_compress(text.data(), 1000, compressed.data(), len));
+}
+
+TEST(t_mct_compress, nullpointer)
+{
+    uint8_t buf[32];
+
+    EXPECT_EQ(0, mct_compress(NULL, 10, buf, sizeof(buf)));
+    EXPECT_EQ(0, mct_compress(buf, 10, NULL, sizeof(buf)));
+    EXPECT_EQ(0, mct_compress(buf, -1, buf, sizeof(buf)));
+    EXPECT_EQ(0, mct_compress(buf, 10, buf, 0));
+}
+/* End Method: mct_compress::mct_compress */
+
+/* Begin Method: mct_compress::mct_decompress */
+TEST(t_mct_decompress, capacity)
+{
+    Bytes data = text_bytes(5000);
+    Bytes compressed(mct_compress_bound(5000));
+    Bytes decompressed(5000);
+    int len = mct_compress(data.data(), 5000, compressed.data(), (int)compressed.size());
+
+    ASSERT_GT(len, 0);
+    EXPECT_EQ(5000, mct_decompress(compressed.data(), len, decompressed.data(), 5000));
+    EXPECT_EQ(-1, mct_decompress(compressed.data(), len, decompressed.data(), 4999));
+    EXPECT_EQ(-1, mct_decompress(compressed.data(), len, decompressed.data(), 0));
+}
+
+TEST(t_mct_decompress, truncated)
+{
+    Bytes data = text_bytes(3000);
+    Bytes compressed(mct_compress_bound(3000));
+    Bytes decompressed(3000);
+    int len = mct_compress(data.data(), 3000, compressed.data(), (int)compressed.size());
+
+    ASSERT_GT(len, 0);
+
+    /* a cut input never yields the whole output */
+    for (int cut = 1; cut < len; cut++) {
+        int ret = mct_decompress(compressed.data(), cut, decompressed.data(), 3000);
+
+        ASSERT_LT(ret, 3000) << "cut " << cut;
+    }
+}
+
+TEST(t_mct_decompress, corrupted)
+{
+    uint8_t out[64];
+
+    /* one literal followed by a match with offset 0 */
+    const uint8_t zero_offset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+    /* match reaching before the start of the output */
+    const uint8_t far_offset[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+    /* more literals announced than present */
+    const uint8_t short_literals[] = { 0x50, 'a', 'b' };
+    /* length continuation missing */
+    const uint8_t short_length[] = { 0xF0 };
+    /* incomplete offset */
+    const uint8_t short_offset[] = { 0x10, 'a', 0x01 };
+
+    EXPECT_EQ(-1, mct_decompress(zero_offset, sizeof(zero_offset), out, sizeof(out)));
+    EXPECT_EQ(-1, mct_decompress(far_offset, sizeof(far_offset), out, sizeof(out)));
+    EXPECT_EQ(-1, mct_decompress(short_literals, sizeof(short_literals), out, sizeof(out)));
+    EXPECT_EQ(-1, mct_decompress(short_length, sizeof(short_length), out, sizeof(out)));
+    EXPECT_EQ(-1, mct_decompress(short_offset, sizeof(short_offset), out, sizeof(out)));
+
+    /* the same match with a valid offset repeats the literal */
+    const uint8_t valid[] = { 0x10, 'a', 0x01, 0x00, 0x10, 'b' };
+
+    ASSERT_EQ(6, mct_decompress(valid, sizeof(valid), out, sizeof(out)));
+    EXPECT_EQ(0, memcmp(out, "aaaaab", 6));
+}
+
+TEST(t_mct_decompress, garbage)
+{
+    Bytes out(MCT_BLOCK_SIZE + 16, 0);
+
+    /* random input stays inside the output buffer, the guard bytes are untouched */
+    for (unsigned int seed = 0; seed < 2000; seed++) {
+        Bytes data = random_bytes(1 + seed % 300, seed);
+        int ret = mct_decompress(data.data(), (int)data.size(), out.data(), MCT_BLOCK_SIZE);
+
+        ASSERT_LE(ret, MCT_BLOCK_SIZE);
+        ASSERT_GE(ret, -1);
+    }
+
+    for (size_t i = MCT_BLOCK_SIZE; i < out.size(); i++)
+        EXPECT_EQ(0, out[i]);
+}
+
+TEST(t_mct_decompress, nullpointer)
+{
+    uint8_t buf[32] = { 0 };
+
+    EXPECT_EQ(-1, mct_decompress(NULL, 10, buf, sizeof(buf)));
+    EXPECT_EQ(-1, mct_decompress(buf, 10, NULL, sizeof(buf)));
+    EXPECT_EQ(-1, mct_decompress(buf, 0, buf, sizeof(buf)));
+}
+/* End Method: mct_compress::mct_decompress */
+
+/* append a message with storage header of the given time and payload size */
+static void add_message(Bytes &messages, uint32_t seconds, int32_t microseconds, int size)
+{
+    MctStorageHeader storageheader;
+    MctStandardHeader standardheader;
+    Bytes payload = text_bytes((size_t)size);
+
+    mct_set_storageheader(&storageheader, "ECU1");
+    storageheader.seconds = seconds;
+    storageheader.microseconds = microseconds;
+
+    standardheader.htyp = MCT_HTYP_PROTOCOL_VERSION1;
+    standardheader.mcnt = 0;
+    standardheader.len = MCT_HTOBE_16((uint16_t)(sizeof(standardheader) + size));
+
+    messages.insert(messages.end(), (uint8_t *)&storageheader,
+                    (uint8_t *)&storageheader + sizeof(storageheader));
+    messages.insert(messages.end(), (uint8_t *)&standardheader,
+                    (uint8_t *)&standardheader + sizeof(standardheader));
+    messages.insert(messages.end(), payload.begin(), payload.end());
+}
+
+static int message_size(int size)
+{
+    return (int)(sizeof(MctStorageHeader) + sizeof(MctStandardHeader)) + size;
+}
+
+/* Begin Method: mct_compress::mct_block_encode */
+TEST(t_mct_block_encode, normal)
+{
+    Bytes messages;
+    MctBlockHeader header;
+
+    for (int i = 0; i < 100; i++)
+        add_message(messages, 1000 + (uint32_t)i, i * 10, 50 + i);
+
+    Bytes block(sizeof(MctBlockHeader) + mct_compress_bound((int)messages.size()));
+    int len = mct_block_encode(messages.data(), (int)messages.size(), block.data());
+
+    memcpy(&header, block.data(), sizeof(header));
+
+    EXPECT_TRUE(mct_block_is_header(block.data()));
+    EXPECT_EQ((int)(sizeof(header) + MCT_LETOH_32(header.size)), len);
+    EXPECT_EQ(messages.size(), MCT_LETOH_32(header.raw_size));
+    EXPECT_LT(MCT_LETOH_32(header.size), MCT_LETOH_32(header.raw_size));
+    EXPECT_EQ(100u, MCT_LETOH_32(header.count));
+    EXPECT_EQ(1000u, MCT_LETOH_32(header.first_seconds));
+    EXPECT_EQ(0, (int32_t)MCT_LETOH_32(header.first_microseconds));
+    EXPECT_EQ(1099u, MCT_LETOH_32(header.last_seconds));
+    EXPECT_EQ(990, (int32_t)MCT_LETOH_32(header.last_microseconds));
+
+    Bytes decompressed(messages.size());
+
+    ASSERT_EQ((int)messages.size(),
+              mct_decompress(block.data() + sizeof(header), (int)MCT_LETOH_32(header.size),
+                             decompressed.data(), (int)decompressed.size()));
+    EXPECT_TRUE(messages == decompressed);
+}
+
+TEST(t_mct_block_encode, stored)
+{
+    /* data which does not compress is stored as is */
+    Bytes messages = random_bytes(1000, 6);
+    MctBlockHeader header;
+    Bytes block(sizeof(MctBlockHeader) + mct_compress_bound(1000));
+    int len = mct_block_encode(messages.data(), 1000, block.data());
+
+    memcpy(&header, block.data(), sizeof(header));
+
+    EXPECT_EQ((int)sizeof(header) + 1000, len);
+    EXPECT_EQ(1000u, MCT_LETOH_32(header.size));
+    EXPECT_EQ(1000u, MCT_LETOH_32(header.raw_size));
+    EXPECT_EQ(0, memcmp(block.data() + sizeof(header), messages.data(), 1000));
+}
+/* End Method: mct_compress::mct_block_encode */
+
+/* Begin Method: mct_compress::mct_block_split */
+TEST(t_mct_block_split, message_boundary)
+{
+    Bytes messages;
+    std::vector<int> boundaries;
+    int offset = 0;
+    int blocks = 0;
+
+    for (int i = 0; i < 1000; i++) {
+        add_message(messages, (uint32_t)i, 0, 100 + i % 200);
+        boundaries.push_back((int)messages.size());
+    }
+
+    /* blocks end at message boundaries and do not exceed the block size */
+    while (offset < (int)messages.size()) {
+        int len = mct_block_split(messages.data() + offset, (int)messages.size() - offset);
+
+        ASSERT_GT(len, 0);
+        ASSERT_LE(len, MCT_BLOCK_SIZE);
+        EXPECT_TRUE(std::find(boundaries.begin(), boundaries.end(), offset + len) !=
+                    boundaries.end());
+
+        offset += len;
+        blocks++;
+    }
+
+    EXPECT_EQ((int)messages.size(), offset);
+    EXPECT_GT(blocks, 1);
+}
+
+TEST(t_mct_block_split, large_message)
+{
+    Bytes messages;
+
+    /* a message larger than a block makes up a block of its own */
+    add_message(messages, 1, 0, MCT_BLOCK_SIZE - 100);
+    add_message(messages, 2, 0, 100);
+
+    EXPECT_EQ(message_size(MCT_BLOCK_SIZE - 100),
+              mct_block_split(messages.data(), (int)messages.size()));
+}
+
+TEST(t_mct_block_split, no_boundary)
+{
+    Bytes data = random_bytes(3 * MCT_BLOCK_SIZE, 7);
+
+    memset(data.data(), 0, 32);
+
+    /* without message boundaries the data is cut at the block size */
+    EXPECT_EQ(MCT_BLOCK_SIZE, mct_block_split(data.data(), (int)data.size()));
+    EXPECT_EQ(100, mct_block_split(data.data(), 100));
+    EXPECT_EQ(0, mct_block_split(data.data(), 0));
+    EXPECT_EQ(0, mct_block_split(NULL, 100));
+}
+/* End Method: mct_compress::mct_block_split */
+
+/* Begin Method: mct_compress::mct_block_is_header */
+TEST(t_mct_block_is_header, normal)
+{
+    const uint8_t header[] = { 'D', 'L', 'Z', 0x01 };
+    const uint8_t storage[] = { 'D', 'L', 'T', 0x01 };
+
+    EXPECT_EQ(1, mct_block_is_header(header));
+    EXPECT_EQ(0, mct_block_is_header(storage));
+    EXPECT_EQ(0, mct_block_is_header(NULL));
+}
+/* End Method: mct_compress::mct_block_is_header */
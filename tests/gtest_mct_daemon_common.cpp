@@ -0,0 +1,302 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "mct_daemon_common.h"
+#include "mct_daemon_common_cfg.h"
+}
+
+class t_mct_daemon_user_list : public ::testing::Test
+{
+protected:
+    MctDaemon daemon;
+    char ecu[MCT_ID_SIZE + 1];
+
+    void SetUp() override
+    {
+        memset(&daemon, 0, sizeof(daemon));
+        strcpy(ecu, "ECU1");
+        mct_set_id(daemon.ecuid, ecu);
+        ASSERT_EQ(MCT_RETURN_OK, mct_daemon_init_user_information(&daemon, 0));
+    }
+
+    void TearDown() override
+    {
+        mct_daemon_contexts_clear(&daemon, ecu, 0);
+        mct_daemon_applications_clear(&daemon, ecu, 0);
+        free(daemon.user_list);
+    }
+
+    MctDaemonRegisteredUsers *users()
+    {
+        return mct_daemon_find_users_list(&daemon, ecu, 0);
+    }
+
+    MctDaemonApplication *add_app(const std::string &apid)
+    {
+        std::vector<char> id(apid.begin(), apid.end());
+        id.push_back('\0');
+        return mct_daemon_application_add(&daemon, id.data(), 0, NULL, MCT_FD_INIT, ecu, 0);
+    }
+
+    MctDaemonApplication *find_app(const std::string &apid)
+    {
+        std::vector<char> id(apid.begin(), apid.end());
+        id.push_back('\0');
+        return mct_daemon_application_find(&daemon, id.data(), ecu, 0);
+    }
+
+    MctDaemonContext *add_ctx(const std::string &apid, const std::string &ctid)
+    {
+        std::vector<char> app(apid.begin(), apid.end());
+        std::vector<char> ctx(ctid.begin(), ctid.end());
+        app.push_back('\0');
+        ctx.push_back('\0');
+        return mct_daemon_context_add(&daemon, app.data(), ctx.data(), MCT_LOG_INFO,
+                                      MCT_TRACE_STATUS_OFF, 0, MCT_FD_INIT, NULL, ecu, 0);
+    }
+
+    MctDaemonContext *find_ctx(const std::string &apid, const std::string &ctid)
+    {
+        std::vector<char> app(apid.begin(), apid.end());
+        std::vector<char> ctx(ctid.begin(), ctid.end());
+        app.push_back('\0');
+        ctx.push_back('\0');
+        return mct_daemon_context_find(&daemon, app.data(), ctx.data(), ecu, 0);
+    }
+};
+
+static std::string app_id(int i)
+{
+    char id[8];
+
+    snprintf(id, sizeof(id), "A%03d", i);
+    return id;
+}
+
+static std::string id_of(const char *id)
+{
+    return std::string(id, strnlen(id, MCT_ID_SIZE));
+}
+
+/* Begin Method: mct_daemon_common::mct_daemon_application_add */
+TEST_F(t_mct_daemon_user_list, application_add_find)
+{
+    for (int i = 0; i < 500; i++)
+        ASSERT_NE((MctDaemonApplication *)NULL, add_app(app_id(i)));
+
+    EXPECT_EQ(500, users()->num_applications);
+
+    /* index grows and stays at most half full */
+    EXPECT_GT(users()->application_index.size, MCT_DAEMON_INDEX_MIN_SIZE);
+    EXPECT_EQ(0, users()->application_index.size & (users()->application_index.size - 1));
+    EXPECT_LE(users()->application_index.count * 2, users()->application_index.size);
+    EXPECT_EQ(500, users()->application_index.count);
+
+    for (int i = 0; i < 500; i++) {
+        MctDaemonApplication *app = find_app(app_id(i));
+
+        ASSERT_NE((MctDaemonApplication *)NULL, app);
+        EXPECT_EQ(app_id(i), id_of(app->apid));
+    }
+
+    EXPECT_EQ((MctDaemonApplication *)NULL, find_app("A999"));
+    EXPECT_EQ((MctDaemonApplication *)NULL, find_app(""));
+}
+
+TEST_F(t_mct_daemon_user_list, application_add_twice)
+{
+    MctDaemonApplication *app = add_app("APP1");
+
+    ASSERT_NE((MctDaemonApplication *)NULL, app);
+    EXPECT_EQ(app, add_app("APP1"));
+    EXPECT_EQ(1, users()->num_applications);
+}
+
+TEST_F(t_mct_daemon_user_list, application_short_ids)
+{
+    /* ids shorter than four characters are padded, not confused with each other */
+    ASSERT_NE((MctDaemonApplication *)NULL, add_app("A"));
+    ASSERT_NE((MctDaemonApplication *)NULL, add_app("AB"));
+    ASSERT_NE((MctDaemonApplication *)NULL, add_app("ABC"));
+
+    EXPECT_EQ(3, users()->num_applications);
+    EXPECT_EQ("AB", id_of(find_app("AB")->apid));
+    EXPECT_EQ("ABC", id_of(find_app("ABC")->apid));
+    EXPECT_EQ((MctDaemonApplication *)NULL, find_app("ABCD"));
+
+    /* only four characters are significant */
+    ASSERT_NE((MctDaemonApplication *)NULL, add_app("LONG"));
+    EXPECT_EQ(find_app("LONG"), find_app("LONGER"));
+}
+/* End Method: mct_daemon_common::mct_daemon_application_add */
+
+/* Begin Method: mct_daemon_common::mct_daemon_application_del */
+TEST_F(t_mct_daemon_user_list, application_del_moves_last)
+{
+    for (int i = 0; i < 5; i++)
+        ASSERT_NE((MctDaemonApplication *)NULL, add_app(app_id(i)));
+
+    ASSERT_EQ(0, mct_daemon_application_del(&daemon, find_app(app_id(1)), ecu, 0));
+
+    EXPECT_EQ(4, users()->num_applications);
+    EXPECT_EQ((MctDaemonApplication *)NULL, find_app(app_id(1)));
+
+    /* the last application fills the gap and is found at its new position */
+    EXPECT_EQ(app_id(4), id_of(users()->applications[1].apid));
+    EXPECT_EQ(&users()->applications[1], find_app(app_id(4)));
+    EXPECT_EQ(&users()->applications[0], find_app(app_id(0)));
+
+    /* deleting the last one moves nothing */
+    ASSERT_EQ(0, mct_daemon_application_del(&daemon, find_app(app_id(3)), ecu, 0));
+    EXPECT_EQ(3, users()->num_applications);
+    EXPECT_EQ(&users()->applications[2], find_app(app_id(2)));
+
+    /* deleted ids can be added again */
+    ASSERT_NE((MctDaemonApplication *)NULL, add_app(app_id(1)));
+    EXPECT_EQ(&users()->applications[3], find_app(app_id(1)));
+    EXPECT_EQ(4, users()->application_index.count);
+}
+
+TEST_F(t_mct_daemon_user_list, application_del_random)
+{
+    std::mt19937 rng(42);
+    std::set<int> registered;
+
+    /* interleaved adds and deletes keep every probe sequence intact */
+    for (int round = 0; round < 20000; round++) {
+        int i = (int)(rng() % 1000);
+
+        if (registered.count(i)) {
+            ASSERT_EQ(0, mct_daemon_application_del(&daemon, find_app(app_id(i)), ecu, 0));
+            registered.erase(i);
+        } else {
+            ASSERT_NE((MctDaemonApplication *)NULL, add_app(app_id(i)));
+            registered.insert(i);
+        }
+    }
+
+    EXPECT_EQ((int)registered.size(), users()->num_applications);
+    EXPECT_EQ((int)registered.size(), users()->application_index.count);
+
+    for (int i = 0; i < 1000; i++) {
+        MctDaemonApplication *app = find_app(app_id(i));
+
+        if (registered.count(i)) {
+            ASSERT_NE((MctDaemonApplication *)NULL, app);
+            EXPECT_EQ(app_id(i), id_of(app->apid));
+        } else {
+            EXPECT_EQ((MctDaemonApplication *)NULL, app);
+        }
+    }
+}
+
+TEST_F(t_mct_daemon_user_list, application_del_all)
+{
+    for (int i = 0; i < 100; i++)
+        ASSERT_NE((MctDaemonApplication *)NULL, add_app(app_id(i)));
+
+    for (int i = 0; i < 100; i++)
+        ASSERT_EQ(0, mct_daemon_application_del(&daemon, find_app(app_id(i)), ecu, 0));
+
+    EXPECT_EQ(0, users()->num_applications);
+    EXPECT_EQ(0, users()->application_index.count);
+
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ((MctDaemonApplication *)NULL, find_app(app_id(i)));
+}
+/* End Method: mct_daemon_common::mct_daemon_application_del */
+
+/* Begin Method: mct_daemon_common::mct_daemon_context_add */
+TEST_F(t_mct_daemon_user_list, context_add_find)
+{
+    char ctid[8];
+
+    for (int a = 0; a < 10; a++) {
+        ASSERT_NE((MctDaemonApplication *)NULL, add_app(app_id(a)));
+
+        for (int c = 0; c < 50; c++) {
+            snprintf(ctid, sizeof(ctid), "C%03d", c);
+            ASSERT_NE((MctDaemonContext *)NULL, add_ctx(app_id(a), ctid));
+        }
+    }
+
+    EXPECT_EQ(500, users()->num_contexts);
+    EXPECT_EQ(500, users()->context_index.count);
+    EXPECT_EQ(50, find_app(app_id(3))->num_contexts);
+
+    for (int a = 0; a < 10; a++) {
+        for (int c = 0; c < 50; c++) {
+            snprintf(ctid, sizeof(ctid), "C%03d", c);
+            MctDaemonContext *context = find_ctx(app_id(a), ctid);
+
+            ASSERT_NE((MctDaemonContext *)NULL, context);
+            EXPECT_EQ(app_id(a), id_of(context->apid));
+            EXPECT_EQ(ctid, id_of(context->ctid));
+        }
+    }
+
+    /* same context id of another application */
+    EXPECT_NE(find_ctx(app_id(1), "C000"), find_ctx(app_id(2), "C000"));
+    EXPECT_EQ((MctDaemonContext *)NULL, find_ctx(app_id(1), "C999"));
+    EXPECT_EQ((MctDaemonContext *)NULL, find_ctx(app_id(99), "C000"));
+}
+
+TEST_F(t_mct_daemon_user_list, context_add_without_application)
+{
+    EXPECT_EQ((MctDaemonContext *)NULL, add_ctx("NONE", "CTX1"));
+    EXPECT_EQ(0, users()->num_contexts);
+}
+/* End Method: mct_daemon_common::mct_daemon_context_add */
+
+/* Begin Method: mct_daemon_common::mct_daemon_context_del */
+TEST_F(t_mct_daemon_user_list, context_del_moves_last)
+{
+    ASSERT_NE((MctDaemonApplication *)NULL, add_app("APP1"));
+    ASSERT_NE((MctDaemonContext *)NULL, add_ctx("APP1", "CTX1"));
+    ASSERT_NE((MctDaemonContext *)NULL, add_ctx("APP1", "CTX2"));
+    ASSERT_NE((MctDaemonContext *)NULL, add_ctx("APP1", "CTX3"));
+
+    ASSERT_EQ(0, mct_daemon_context_del(&daemon, find_ctx("APP1", "CTX1"), ecu, 0));
+
+    EXPECT_EQ(2, users()->num_contexts);
+    EXPECT_EQ(2, find_app("APP1")->num_contexts);
+    EXPECT_EQ((MctDaemonContext *)NULL, find_ctx("APP1", "CTX1"));
+    EXPECT_EQ(&users()->contexts[0], find_ctx("APP1", "CTX3"));
+    EXPECT_EQ(&users()->contexts[1], find_ctx("APP1", "CTX2"));
+
+    ASSERT_NE((MctDaemonContext *)NULL, add_ctx("APP1", "CTX1"));
+    EXPECT_EQ(&users()->contexts[2], find_ctx("APP1", "CTX1"));
+    EXPECT_EQ(3, users()->context_index.count);
+}
+/* End Method: mct_daemon_common::mct_daemon_context_del */
+
+/* Begin Method: mct_daemon_common::mct_daemon_user_list_sort */
+TEST_F(t_mct_daemon_user_list, sort)
+{
+    for (int i = 99; i >= 0; i--) {
+        ASSERT_NE((MctDaemonApplication *)NULL, add_app(app_id(i)));
+        ASSERT_NE((MctDaemonContext *)NULL, add_ctx(app_id(i), "CTX2"));
+        ASSERT_NE((MctDaemonContext *)NULL, add_ctx(app_id(i), "CTX1"));
+    }
+
+    EXPECT_FALSE(users()->sorted);
+
+    mct_daemon_user_list_sort(users());
+
+    EXPECT_TRUE(users()->sorted);
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(app_id(i), id_of(users()->applications[i].apid));
+        EXPECT_EQ(&users()->applications[i], find_app(app_id(i)));
+        EXPECT_EQ(&users()->contexts[2 * i], find_ctx(app_id(i), "CTX1"));
+        EXPECT_EQ(&users()->contexts[2 * i + 1], find_ctx(app_id(i), "CTX2"));
+    }
+}
+/* End Method: mct_daemon_common::mct_daemon_user_list_sort */
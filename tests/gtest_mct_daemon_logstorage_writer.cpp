@@ -0,0 +1,377 @@
+#include <gtest/gtest.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "mct_common.h"
+#include "mct_protocol.h"
+#include "mct_config_file_parser.h"
+#include "mct_offline_logstorage.h"
+#include "mct_daemon_logstorage_writer.h"
+}
+
+/* size of a queued record without filters, see MctDaemonLogStorageRecord */
+#define RECORD_SIZE(payload) (((24 + (payload)) + 31) & ~31)
+
+static void default_uconfig(MctLogStorageUserConfig *uconfig)
+{
+    memset(uconfig, 0, sizeof(MctLogStorageUserConfig));
+    uconfig->logfile_delimiter = '_';
+    uconfig->logfile_maxcounter = UINT_MAX;
+}
+
+/* the messages only exercise the queue, a device which is not connected drops them */
+class t_mct_daemon_logstorage_writer : public ::testing::Test
+{
+protected:
+    MctLogStorage handle;
+    MctLogStorageUserConfig uconfig;
+    MctDaemonLogStorageWriter writer;
+    unsigned char data[256];
+
+    void SetUp() override
+    {
+        memset(&handle, 0, sizeof(handle));
+        memset(&writer, 0, sizeof(writer));
+        memset(data, 0, sizeof(data));
+        default_uconfig(&uconfig);
+    }
+
+    void TearDown() override
+    {
+        mct_daemon_logstorage_writer_free(&writer);
+    }
+
+    int push(int payload)
+    {
+        return mct_daemon_logstorage_writer_push(&writer, NULL, 0, data, 0, data, 0, data, payload);
+    }
+};
+
+/* Begin Method: mct_daemon_logstorage_writer::mct_daemon_logstorage_writer_init */
+TEST_F(t_mct_daemon_logstorage_writer, init)
+{
+    ASSERT_EQ(MCT_RETURN_OK,
+              mct_daemon_logstorage_writer_init(&writer, &handle, &uconfig, 1000,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_DROP));
+    EXPECT_EQ(1024u, writer.size);
+    EXPECT_EQ(1, writer.started);
+    EXPECT_EQ(0u, mct_daemon_logstorage_writer_get_queue_depth(&writer));
+}
+
+TEST_F(t_mct_daemon_logstorage_writer, init_nullpointer)
+{
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER,
+              mct_daemon_logstorage_writer_init(NULL, &handle, &uconfig, 1024,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_DROP));
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER,
+              mct_daemon_logstorage_writer_init(&writer, NULL, &uconfig, 1024,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_DROP));
+    EXPECT_EQ(MCT_RETURN_WRONG_PARAMETER,
+              mct_daemon_logstorage_writer_init(&writer, &handle, &uconfig, 0,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_DROP));
+
+    /* a writer which was never started is ignored */
+    EXPECT_EQ(0u, mct_daemon_logstorage_writer_get_queue_depth(&writer));
+    EXPECT_EQ(MCT_RETURN_OK, mct_daemon_logstorage_writer_wait(&writer, 10));
+}
+/* End Method: mct_daemon_logstorage_writer::mct_daemon_logstorage_writer_init */
+
+/* Begin Method: mct_daemon_logstorage_writer::mct_daemon_logstorage_writer_push */
+TEST_F(t_mct_daemon_logstorage_writer, push_flush_drain)
+{
+    ASSERT_EQ(MCT_RETURN_OK,
+              mct_daemon_logstorage_writer_init(&writer, &handle, &uconfig, 4096,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_DROP));
+
+    EXPECT_EQ(MCT_RETURN_OK, push(8));
+    EXPECT_EQ(MCT_RETURN_OK, push(40));
+
+    /* nothing is handed over before the flush */
+    EXPECT_EQ((uint32_t)(RECORD_SIZE(8) + RECORD_SIZE(40)),
+              mct_daemon_logstorage_writer_get_queue_depth(&writer));
+    EXPECT_EQ(writer.head, writer.tail);
+    usleep(10000);
+    EXPECT_EQ((uint32_t)(RECORD_SIZE(8) + RECORD_SIZE(40)),
+              mct_daemon_logstorage_writer_get_queue_depth(&writer));
+
+    mct_daemon_logstorage_writer_flush(&writer);
+    mct_daemon_logstorage_writer_drain(&writer);
+
+    EXPECT_EQ(0u, mct_daemon_logstorage_writer_get_queue_depth(&writer));
+    EXPECT_EQ(writer.next, writer.tail);
+    EXPECT_EQ(0u, writer.dropped);
+}
+
+TEST_F(t_mct_daemon_logstorage_writer, push_drop_when_full)
+{
+    int queued = 0;
+
+    ASSERT_EQ(MCT_RETURN_OK,
+              mct_daemon_logstorage_writer_init(&writer, &handle, &uconfig, 1024,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_DROP));
+
+    /* without a flush the writer thread cannot make room */
+    while (push(40) == MCT_RETURN_OK)
+        queued++;
+
+    EXPECT_EQ(1024 / RECORD_SIZE(40), queued);
+    EXPECT_EQ(1u, writer.dropped);
+    EXPECT_EQ(MCT_RETURN_BUFFER_FULL, push(40));
+    EXPECT_EQ(2u, writer.dropped);
+    EXPECT_EQ(1024u, mct_daemon_logstorage_writer_get_queue_depth(&writer));
+
+    mct_daemon_logstorage_writer_drain(&writer);
+
+    EXPECT_EQ(0u, mct_daemon_logstorage_writer_get_queue_depth(&writer));
+    EXPECT_EQ(MCT_RETURN_OK, push(40));
+    EXPECT_EQ(2u, writer.dropped);
+}
+
+TEST_F(t_mct_daemon_logstorage_writer, push_too_large)
+{
+    ASSERT_EQ(MCT_RETURN_OK,
+              mct_daemon_logstorage_writer_init(&writer, &handle, &uconfig, 128,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_WAIT));
+
+    /* a record larger than the queue never fits, not even when waiting */
+    EXPECT_EQ(MCT_RETURN_BUFFER_FULL, push(200));
+    EXPECT_EQ(1u, writer.dropped);
+    EXPECT_EQ(0, writer.stalled);
+}
+
+TEST_F(t_mct_daemon_logstorage_writer, push_wraps_around)
+{
+    ASSERT_EQ(MCT_RETURN_OK,
+              mct_daemon_logstorage_writer_init(&writer, &handle, &uconfig, 1024,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_DROP));
+
+    /* records of odd sizes leave padding at the end of the queue */
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(MCT_RETURN_OK, push(1 + (i * 37) % 200));
+
+        if (i % 3 == 0)
+            mct_daemon_logstorage_writer_drain(&writer);
+    }
+
+    mct_daemon_logstorage_writer_drain(&writer);
+
+    EXPECT_GT(writer.tail, (uint64_t)writer.size);
+    EXPECT_EQ(0u, mct_daemon_logstorage_writer_get_queue_depth(&writer));
+    EXPECT_EQ(0u, writer.dropped);
+}
+
+TEST_F(t_mct_daemon_logstorage_writer, push_wait_when_full)
+{
+    ASSERT_EQ(MCT_RETURN_OK,
+              mct_daemon_logstorage_writer_init(&writer, &handle, &uconfig, 1024,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_WAIT));
+
+    /* a full queue is handed over and the writer thread makes room */
+    for (int i = 0; i < 10000; i++)
+        ASSERT_EQ(MCT_RETURN_OK, push(1 + i % 100));
+
+    EXPECT_EQ(MCT_RETURN_OK, mct_daemon_logstorage_writer_wait(&writer, 1000));
+    EXPECT_EQ(0u, writer.dropped);
+    EXPECT_EQ(0, writer.stalled);
+}
+/* End Method: mct_daemon_logstorage_writer::mct_daemon_logstorage_writer_push */
+
+/* Begin Method: mct_daemon_logstorage_writer::mct_daemon_logstorage_writer_sync */
+TEST_F(t_mct_daemon_logstorage_writer, sync)
+{
+    ASSERT_EQ(MCT_RETURN_OK,
+              mct_daemon_logstorage_writer_init(&writer, &handle, &uconfig, 1024,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_DROP));
+
+    while (push(40) == MCT_RETURN_OK) {
+    }
+
+    /* a periodic sync does not wait for room, a sync on demand does */
+    EXPECT_EQ(MCT_RETURN_BUFFER_FULL,
+              mct_daemon_logstorage_writer_sync(&writer, MCT_LOGSTORAGE_SYNC_ON_TIMER));
+    EXPECT_EQ(MCT_RETURN_OK,
+              mct_daemon_logstorage_writer_sync(&writer, MCT_LOGSTORAGE_SYNC_ON_DEMAND));
+
+    mct_daemon_logstorage_writer_drain(&writer);
+
+    EXPECT_EQ(MCT_RETURN_OK,
+              mct_daemon_logstorage_writer_sync(&writer, MCT_LOGSTORAGE_SYNC_ON_TIMER));
+    EXPECT_EQ(MCT_RETURN_OK, mct_daemon_logstorage_writer_wait(&writer, 1000));
+    EXPECT_EQ(0u, mct_daemon_logstorage_writer_get_queue_depth(&writer));
+}
+/* End Method: mct_daemon_logstorage_writer::mct_daemon_logstorage_writer_sync */
+
+/* messages pass the queue to the log files of a device in a temporary directory */
+class t_mct_daemon_logstorage_writer_device : public ::testing::Test
+{
+protected:
+    char path[PATH_MAX];
+    MctLogStorage handle;
+    MctDaemonLogStorageWriter writer;
+
+    void SetUp() override
+    {
+        FILE *conf = NULL;
+        std::string name;
+
+        strcpy(path, "/tmp/gtest_mct_writer_XXXXXX");
+        ASSERT_NE((char *)NULL, mkdtemp(path));
+
+        name = std::string(path) + "/" + MCT_OFFLINE_LOGSTORAGE_CONFIG_FILE_NAME;
+        conf = fopen(name.c_str(), "w");
+        ASSERT_NE((FILE *)NULL, conf);
+        fprintf(conf,
+                "[FILTER1]\n"
+                "LogAppName=TEST\n"
+                "ContextName=.*\n"
+                "LogLevel=MCT_LOG_VERBOSE\n"
+                "File=writer\n"
+                "FileSize=100000000\n"
+                "NOFiles=1\n");
+        fclose(conf);
+
+        memset(&handle, 0, sizeof(handle));
+        memset(&writer, 0, sizeof(writer));
+        default_uconfig(&handle.uconfig);
+        ASSERT_EQ(0, mct_logstorage_device_connected(&handle, path));
+        ASSERT_EQ(MCT_OFFLINE_LOGSTORAGE_CONFIG_DONE, handle.config_status);
+    }
+
+    void TearDown() override
+    {
+        std::string cmd = std::string("rm -rf ") + path;
+
+        mct_daemon_logstorage_writer_free(&writer);
+        mct_logstorage_device_disconnected(&handle, MCT_LOGSTORAGE_SYNC_ON_DEVICE_DISCONNECT);
+        ASSERT_EQ(0, system(cmd.c_str()));
+    }
+
+    /* queue log message i of application TEST, its payload repeats i */
+    int push(int i, int size)
+    {
+        MctStorageHeader storageheader;
+        unsigned char header[sizeof(MctStandardHeader) + MCT_ID_SIZE + sizeof(MctExtendedHeader)];
+        MctStandardHeader *standard = (MctStandardHeader *)header;
+        MctExtendedHeader *extended =
+            (MctExtendedHeader *)(header + sizeof(MctStandardHeader) + MCT_ID_SIZE);
+        MctLogStorageFilterConfig *config[MCT_CONFIG_FILE_SECTIONS_MAX] = { 0 };
+        std::vector<unsigned char> payload(size, (unsigned char)i);
+        int disable_nw = 0;
+        int num = 0;
+
+        memcpy(payload.data(), &i, sizeof(i));
+        mct_set_storageheader(&storageheader, "ECU1");
+
+        standard->htyp = MCT_HTYP_UEH | MCT_HTYP_WEID | MCT_HTYP_PROTOCOL_VERSION1;
+        standard->mcnt = (uint8_t)i;
+        standard->len = MCT_HTOBE_16((uint16_t)(sizeof(header) + size));
+        memcpy(header + sizeof(MctStandardHeader), "ECU1", MCT_ID_SIZE);
+        extended->msin = MCT_MSIN_VERB | (MCT_TYPE_LOG << MCT_MSIN_MSTP_SHIFT) |
+            (MCT_LOG_INFO << MCT_MSIN_MTIN_SHIFT);
+        extended->noar = 0;
+        memcpy(extended->apid, "TEST", MCT_ID_SIZE);
+        memcpy(extended->ctid, "CTX1", MCT_ID_SIZE);
+
+        num = mct_logstorage_route(&handle, config, header, sizeof(header), &disable_nw);
+
+        if (num != 1)
+            return MCT_RETURN_ERROR;
+
+        return mct_daemon_logstorage_writer_push(&writer, config, num,
+                                                 (unsigned char *)&storageheader,
+                                                 sizeof(storageheader),
+                                                 header, sizeof(header),
+                                                 payload.data(), size);
+    }
+
+    /* read all log files of the device */
+    std::vector<unsigned char> read_files()
+    {
+        std::vector<unsigned char> content;
+        struct dirent *entry = NULL;
+        DIR *dir = opendir(path);
+
+        if (dir == NULL)
+            return content;
+
+        while ((entry = readdir(dir)) != NULL) {
+            std::string name = entry->d_name;
+            unsigned char buffer[4096];
+            size_t len = 0;
+
+            if ((name.size() < 4) || (name.compare(name.size() - 4, 4, ".mct") != 0))
+                continue;
+
+            FILE *file = fopen((std::string(path) + "/" + name).c_str(), "rb");
+
+            if (file == NULL)
+                continue;
+
+            while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0)
+                content.insert(content.end(), buffer, buffer + len);
+
+            fclose(file);
+        }
+
+        closedir(dir);
+
+        return content;
+    }
+};
+
+TEST_F(t_mct_daemon_logstorage_writer_device, order)
+{
+    const size_t header = sizeof(MctStorageHeader) + sizeof(MctStandardHeader) + MCT_ID_SIZE +
+        sizeof(MctExtendedHeader);
+    std::vector<unsigned char> content;
+    size_t offset = 0;
+    int count = 0;
+
+    ASSERT_EQ(MCT_RETURN_OK,
+              mct_daemon_logstorage_writer_init(&writer, &handle, &handle.uconfig, 4096,
+                                                MCT_DAEMON_LOGSTORAGE_QUEUE_WAIT));
+
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_EQ(MCT_RETURN_OK, push(i, 4 + (i * 13) % 300));
+
+        if (i % 7 == 0)
+            mct_daemon_logstorage_writer_flush(&writer);
+    }
+
+    mct_daemon_logstorage_writer_drain(&writer);
+    EXPECT_EQ(0u, writer.dropped);
+    EXPECT_EQ(0, writer.failed);
+
+    mct_daemon_logstorage_writer_free(&writer);
+    mct_logstorage_device_disconnected(&handle, MCT_LOGSTORAGE_SYNC_ON_DEVICE_DISCONNECT);
+
+    /* every message arrives once, in the order it was queued */
+    content = read_files();
+
+    while (offset + header <= content.size()) {
+        MctStandardHeader *standard =
+            (MctStandardHeader *)(content.data() + offset + sizeof(MctStorageHeader));
+        size_t len = sizeof(MctStorageHeader) + MCT_BETOH_16(standard->len);
+        int size = (int)(len - header);
+        int index = -1;
+
+        ASSERT_LE(offset + len, content.size());
+        memcpy(&index, content.data() + offset + header, sizeof(index));
+        EXPECT_EQ(count, index);
+        EXPECT_EQ(4 + (count * 13) % 300, size);
+
+        offset += len;
+        count++;
+    }
+
+    EXPECT_EQ(content.size(), offset);
+    EXPECT_EQ(5000, count);
+}